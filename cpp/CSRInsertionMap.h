@@ -0,0 +1,150 @@
+// Copyright (C) 2023 The DOLFINx_Contact authors
+//
+// This file is part of DOLFINx_Contact
+//
+// SPDX-License-Identifier:    MIT
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <dolfinx/graph/AdjacencyList.h>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace dolfinx_contact
+{
+
+/// @brief Positions of the entries of the contact element matrices of a
+/// contact pair in the values of a CSR matrix
+///
+/// The element matrices of the ith facet of a contact pair consist of the
+/// block coupling the cell of the facet to itself, followed by three blocks
+/// per linked cell, coupling the cell to the linked cell, the linked cell
+/// to the cell and the linked cell to itself (see
+/// `Contact::assemble_matrix`). For each block, the map stores the position
+/// of every entry in the values of the matrix, such that the block can be
+/// added without searching the rows of the matrix.
+///
+/// The values of the matrix may be split into two arrays, e.g. the values in
+/// the owned and the ghost columns of a distributed PETSc matrix. Positions
+/// smaller than `num_values()[0]` refer to the first array, and the
+/// remaining positions to the second array, shifted by `num_values()[0]`.
+///
+/// The map is only valid as long as the contact partners of the pair (the
+/// facet map) and the sparsity pattern of the matrix are unchanged. To
+/// detect changes of the latter, the map stores an identifier of the matrix
+/// and the state of its sparsity pattern it was created for (see
+/// `pattern_state()`), and in debug builds a hash of the pattern (see
+/// `pattern()`).
+class CSRInsertionMap
+{
+public:
+  /// Create an insertion map
+  /// @param[in] facet_map The facet map of the contact pair the map was
+  /// created for
+  /// @param[in] facet_blocks The blocks of the ith facet are
+  /// `blocks[facet_blocks[i]:facet_blocks[i+1]]`
+  /// @param[in] blocks The position of the entries of each block in
+  /// `offsets`, in units of `block_size`. A negative value marks a block
+  /// that can not be added directly, e.g. as it has rows owned by another
+  /// process
+  /// @param[in] offsets The positions of the entries of the blocks in the
+  /// values of the matrix. The entries of a block are ordered row-major
+  /// @param[in] block_size The number of entries in each block
+  /// @param[in] num_values The number of values in each value array of the
+  /// matrix
+  /// @param[in] pattern_state An identifier of the matrix and the state of
+  /// its sparsity pattern, which changes whenever the pattern changes
+  /// @param[in] pattern A hash of the sparsity pattern of the matrix, or
+  /// zero if it is not computed
+  CSRInsertionMap(
+      std::shared_ptr<const dolfinx::graph::AdjacencyList<std::int32_t>>
+          facet_map,
+      std::vector<std::int32_t> facet_blocks, std::vector<std::int64_t> blocks,
+      std::vector<std::int64_t> offsets, std::size_t block_size,
+      std::array<std::int64_t, 2> num_values,
+      std::array<std::int64_t, 2> pattern_state, std::uint64_t pattern)
+      : _facet_map(facet_map), _facet_blocks(std::move(facet_blocks)),
+        _blocks(std::move(blocks)), _offsets(std::move(offsets)),
+        _block_size(block_size), _num_values(num_values),
+        _pattern_state(pattern_state), _pattern(pattern)
+  {
+  }
+
+  /// Return the facet map of the contact pair the map was created for
+  std::shared_ptr<const dolfinx::graph::AdjacencyList<std::int32_t>>
+  facet_map() const
+  {
+    return _facet_map;
+  }
+
+  /// Return the number of values in each value array of the matrix the map
+  /// was created for
+  std::array<std::int64_t, 2> num_values() const { return _num_values; }
+
+  /// Return the identifier and the sparsity pattern state of the matrix the
+  /// map was created for
+  std::array<std::int64_t, 2> pattern_state() const { return _pattern_state; }
+
+  /// Return the hash of the sparsity pattern of the matrix the map was
+  /// created for (zero if it was not computed)
+  std::uint64_t pattern() const { return _pattern; }
+
+  /// Return the number of blocks that are added directly
+  std::size_t num_direct_blocks() const
+  {
+    return _offsets.size() / std::max(_block_size, std::size_t(1));
+  }
+
+  /// Return the number of blocks
+  std::size_t num_blocks() const { return _blocks.size(); }
+
+  /// Add a block of the element matrices of a facet to the values of the
+  /// matrix
+  /// @param[in] facet The index of the facet in the contact pair
+  /// @param[in] block The index of the block in the element matrices of the
+  /// facet
+  /// @param[in] Ae The block, flattened row-major
+  /// @param[in,out] values0 The first value array of the matrix
+  /// @param[in,out] values1 The second value array of the matrix
+  /// @returns False if the block has to be added to the matrix by other
+  /// means, in which case the values are unchanged
+  template <typename T>
+  bool add(std::size_t facet, std::size_t block, std::span<const T> Ae,
+           std::span<T> values0, std::span<T> values1) const
+  {
+    assert(_facet_blocks[facet] + block
+           < (std::size_t)_facet_blocks[facet + 1]);
+    const std::int64_t pos = _blocks[_facet_blocks[facet] + block];
+    if (pos < 0)
+      return false;
+
+    assert(Ae.size() == _block_size);
+    const std::int64_t* offsets = _offsets.data() + pos * _block_size;
+    for (std::size_t k = 0; k < _block_size; ++k)
+    {
+      if (offsets[k] < _num_values[0])
+        values0[offsets[k]] += Ae[k];
+      else
+        values1[offsets[k] - _num_values[0]] += Ae[k];
+    }
+    return true;
+  }
+
+private:
+  std::shared_ptr<const dolfinx::graph::AdjacencyList<std::int32_t>>
+      _facet_map;
+  std::vector<std::int32_t> _facet_blocks;
+  std::vector<std::int64_t> _blocks;
+  std::vector<std::int64_t> _offsets;
+  std::size_t _block_size;
+  std::array<std::int64_t, 2> _num_values;
+  std::array<std::int64_t, 2> _pattern_state;
+  std::uint64_t _pattern;
+};
+
+} // namespace dolfinx_contact
@@ -8,6 +8,7 @@
 #include "error_handling.h"
 #include "utils.h"
 #include <dolfinx/common/log.h>
+#include <dolfinx/mesh/utils.h>
 using namespace dolfinx_contact;
 
 namespace
@@ -72,6 +73,398 @@ void compute_linked_cells(
                      linked_cells.end());
 }
 
+/// Compute the cells on the parent mesh linked to each facet on the
+/// quadrature surface
+/// @param[in] facet_map Map from each quadrature point on each facet to the
+/// linked facet on the submesh (-1 if none)
+/// @param[in] num_facets Number of facets to compute linked cells for
+/// @param[in] sub_to_parent Map from each facet of on the submesh (local to
+/// process) to the tuple (submesh_cell_index, local_facet_index)
+/// @param[in] parent_cells Map from submesh cell (local to process) to parent
+/// mesh cell (local to process)
+/// @returns For each facet the unique list of linked cells (sorted)
+dolfinx::graph::AdjacencyList<std::int32_t> compute_linked_cells(
+    const std::shared_ptr<const dolfinx::graph::AdjacencyList<std::int32_t>>&
+        facet_map,
+    std::size_t num_facets,
+    const std::shared_ptr<const dolfinx::graph::AdjacencyList<std::int32_t>>&
+        sub_to_parent,
+    const std::span<const std::int32_t>& parent_cells)
+{
+  std::vector<std::int32_t> data;
+  std::vector<std::int32_t> offsets(1, 0);
+  offsets.reserve(num_facets + 1);
+  std::vector<std::int32_t> linked_cells;
+  for (std::size_t i = 0; i < num_facets; ++i)
+  {
+    if (facet_map)
+    {
+      compute_linked_cells(linked_cells, facet_map->links((int)i),
+                           sub_to_parent, parent_cells);
+      data.insert(data.end(), linked_cells.begin(), linked_cells.end());
+    }
+    offsets.push_back((std::int32_t)data.size());
+  }
+  return dolfinx::graph::AdjacencyList<std::int32_t>(std::move(data),
+                                                     std::move(offsets));
+}
+
+/// Colour a set of facets such that no two facets of the same colour share a
+/// degree of freedom, taking into account the cells linked to each facet.
+/// Facets of the same colour can then be assembled concurrently.
+/// @param[in] facets The facets as (cell, local_facet) pairs on the parent
+/// mesh. Flattened row-major
+/// @param[in] linked_cells The cells linked to each facet
+/// @param[in] dofmap The dofmap
+/// @returns For each colour the list of facets (position in `facets`)
+std::vector<std::vector<std::int32_t>>
+colour_facets(std::span<const std::int32_t> facets,
+              const dolfinx::graph::AdjacencyList<std::int32_t>& linked_cells,
+              const dolfinx::fem::DofMap& dofmap)
+{
+  auto index_map = dofmap.index_map;
+  assert(index_map);
+  const std::int32_t num_dofs
+      = index_map->size_local() + index_map->num_ghosts();
+
+  // Colours of the facets containing each dof
+  std::vector<std::vector<std::int32_t>> dof_colours(num_dofs);
+
+  // forbidden[c] == i if colour c is used by a neighbour of facet i
+  std::vector<std::int64_t> forbidden;
+  std::vector<std::vector<std::int32_t>> colours;
+  for (std::size_t i = 0; i < facets.size() / 2; ++i)
+  {
+    auto for_each_dof = [&](auto&& f)
+    {
+      for (std::int32_t dof : dofmap.cell_dofs(facets[2 * i]))
+        f(dof);
+      for (std::int32_t cell : linked_cells.links((int)i))
+        for (std::int32_t dof : dofmap.cell_dofs(cell))
+          f(dof);
+    };
+
+    // Pick the smallest colour not used by any facet sharing a dof
+    for_each_dof(
+        [&](std::int32_t dof)
+        {
+          for (std::int32_t c : dof_colours[dof])
+            forbidden[c] = (std::int64_t)i;
+        });
+    auto it = std::find_if(forbidden.begin(), forbidden.end(),
+                           [i](auto c) { return c != (std::int64_t)i; });
+    const std::int32_t colour = std::distance(forbidden.begin(), it);
+    if (it == forbidden.end())
+    {
+      forbidden.push_back(-1);
+      colours.emplace_back();
+    }
+    colours[colour].push_back((std::int32_t)i);
+
+    for_each_dof(
+        [&](std::int32_t dof)
+        {
+          std::vector<std::int32_t>& dc = dof_colours[dof];
+          if (std::find(dc.begin(), dc.end(), colour) == dc.end())
+            dc.push_back(colour);
+        });
+  }
+  return colours;
+}
+
+/// Compute the offsets of the linked cell blocks of each facet
+/// @param[in] linked_cells The cells linked to each facet
+/// @param[in] block_size Number of values per linked cell
+/// @param[in] max_links The maximum number of linked cells
+/// @param[in] ragged If true, only the blocks of the cells linked to a facet
+/// are stored. Otherwise all facets are padded to `max_links` blocks.
+/// @returns The values of the ith facet are stored in
+/// `[offsets[i], offsets[i+1])`
+std::vector<std::int32_t> link_block_offsets(
+    const dolfinx::graph::AdjacencyList<std::int32_t>& linked_cells,
+    std::size_t block_size, std::size_t max_links, bool ragged)
+{
+  const std::int32_t num_facets = linked_cells.num_nodes();
+  std::vector<std::int32_t> offsets(num_facets + 1, 0);
+  for (std::int32_t i = 0; i < num_facets; ++i)
+  {
+    const std::size_t num_blocks
+        = ragged ? linked_cells.links(i).size() : max_links;
+    assert(linked_cells.links(i).size() <= max_links);
+    offsets[i + 1] = offsets[i] + (std::int32_t)(num_blocks * block_size);
+  }
+  return offsets;
+}
+
+/// Compute the offsets of coefficients with a constant number of values per
+/// facet
+std::vector<std::int32_t> uniform_offsets(std::size_t num_facets, int cstride)
+{
+  std::vector<std::int32_t> offsets(num_facets + 1);
+  for (std::size_t i = 0; i < offsets.size(); ++i)
+    offsets[i] = (std::int32_t)i * cstride;
+  return offsets;
+}
+
+/// Return the sequential AIJ matrices holding the rows of a PETSc AIJ matrix
+/// owned by the process: the entries in the owned columns, the entries in
+/// the remaining columns (nullptr for a sequential matrix) and the global
+/// index of each column of the latter
+std::tuple<Mat, Mat, const PetscInt*> aij_blocks(Mat A)
+{
+  PetscBool mpi, seq;
+  PetscObjectTypeCompare((PetscObject)A, MATMPIAIJ, &mpi);
+  PetscObjectTypeCompare((PetscObject)A, MATSEQAIJ, &seq);
+  if (mpi)
+  {
+    Mat Ad, Ao;
+    const PetscInt* colmap;
+    MatMPIAIJGetSeqAIJ(A, &Ad, &Ao, &colmap);
+    return {Ad, Ao, colmap};
+  }
+  else if (seq)
+    return {A, nullptr, nullptr};
+  else
+  {
+    throw std::invalid_argument(
+        "Direct insertion is only supported for AIJ matrices.");
+  }
+}
+
+/// Return the number of values stored in a sequential AIJ matrix (zero for
+/// nullptr)
+std::int64_t aij_num_values(Mat A)
+{
+  if (!A)
+    return 0;
+  MatInfo info;
+  MatGetInfo(A, MAT_LOCAL, &info);
+  return (std::int64_t)info.nz_used;
+}
+
+/// Return the id of a PETSc matrix and the state of its sparsity pattern,
+/// which PETSc increments whenever the pattern changes
+std::array<std::int64_t, 2> aij_pattern_state(Mat A)
+{
+  PetscObjectId id;
+  PetscObjectGetId((PetscObject)A, &id);
+  PetscObjectState state;
+  MatGetNonzeroState(A, &state);
+  return {(std::int64_t)id, (std::int64_t)state};
+}
+
+/// Combine a range of integers into a hash (FNV-1a)
+template <typename T>
+void hash_combine(std::uint64_t& hash, const T* first, const T* last)
+{
+  for (; first != last; ++first)
+  {
+    hash ^= (std::uint64_t)*first;
+    hash *= 1099511628211ull;
+  }
+}
+
+/// Return a hash (FNV-1a) of the sparsity pattern of a PETSc AIJ matrix,
+/// i.e. of the row pointers and column indices of the owned and remaining
+/// columns of the owned rows and the global indices of the latter columns.
+/// Only used to check the pattern state in debug builds, as it costs a pass
+/// over the pattern
+[[maybe_unused]] std::uint64_t aij_pattern(Mat A)
+{
+  auto [Ad, Ao, colmap] = aij_blocks(A);
+  std::uint64_t hash = 14695981039346656037ull;
+
+  for (Mat B : {Ad, Ao})
+  {
+    if (!B)
+      continue;
+    PetscInt num_rows;
+    const PetscInt *rows, *cols;
+    PetscBool done;
+    MatGetRowIJ(B, 0, PETSC_FALSE, PETSC_FALSE, &num_rows, &rows, &cols,
+                &done);
+    hash_combine(hash, rows, rows + num_rows + 1);
+    hash_combine(hash, cols, cols + rows[num_rows]);
+    MatRestoreRowIJ(B, 0, PETSC_FALSE, PETSC_FALSE, &num_rows, &rows, &cols,
+                    &done);
+  }
+  if (Ao)
+  {
+    PetscInt num_rows, num_cols;
+    MatGetSize(Ao, &num_rows, &num_cols);
+    hash_combine(hash, colmap, colmap + num_cols);
+  }
+  return hash;
+}
+
+/// Return an identifier of the sparsity pattern of a CSR matrix, which is
+/// fixed when the matrix is created, i.e. the addresses of its row pointers
+/// and column indices
+std::array<std::int64_t, 2>
+csr_pattern_state(const dolfinx::la::MatrixCSR<PetscScalar>& A)
+{
+  return {(std::int64_t)(std::intptr_t)A.row_ptr().data(),
+          (std::int64_t)(std::intptr_t)A.cols().data()};
+}
+
+/// Return a hash (FNV-1a) of the row pointers and column indices of a CSR
+/// matrix. Only used to check the pattern state in debug builds
+[[maybe_unused]] std::uint64_t
+csr_pattern(const dolfinx::la::MatrixCSR<PetscScalar>& A)
+{
+  std::uint64_t hash = 14695981039346656037ull;
+  const auto& row_ptr = A.row_ptr();
+  const auto& cols = A.cols();
+  hash_combine(hash, row_ptr.data(), row_ptr.data() + row_ptr.size());
+  hash_combine(hash, cols.data(), cols.data() + cols.size());
+  return hash;
+}
+
+/// Call a function with the value arrays of a PETSc AIJ matrix, i.e. the
+/// values of the entries in the owned columns and in the remaining columns
+/// of the owned rows (empty for a sequential matrix)
+/// @param[in] A The matrix
+/// @param[in] num_values The number of values in each array
+/// @param[in] f The function, called as `f(values)`
+template <typename F>
+void with_aij_values(Mat A, std::array<std::int64_t, 2> num_values, F&& f)
+{
+  auto [Ad, Ao, colmap] = aij_blocks(A);
+  PetscScalar* values_d = nullptr;
+  PetscScalar* values_o = nullptr;
+  MatSeqAIJGetArray(Ad, &values_d);
+  if (Ao)
+    MatSeqAIJGetArray(Ao, &values_o);
+
+  f(std::array{std::span(values_d, num_values[0]),
+               std::span(values_o, num_values[1])});
+
+  MatSeqAIJRestoreArray(Ad, &values_d);
+  if (Ao)
+    MatSeqAIJRestoreArray(Ao, &values_o);
+}
+
+/// Add the element matrices of a facet to a matrix
+/// @param[in] mat_set The function for setting the values in the matrix
+/// @param[in] dofmap The dofmap
+/// @param[in] f The facet (position in the active facets of the pair)
+/// @param[in] cell The cell of the facet
+/// @param[in] linked_cells The cells linked to the facet
+/// @param[in] Ae The element matrices, see `kernel_fn`
+/// @param[in] insertion_map If not null, the blocks the insertion map has
+/// positions for are added directly to the value arrays `values`
+/// @param[in] values The value arrays of the matrix
+void add_element_matrices(
+    const mat_set_fn& mat_set, const dolfinx::fem::DofMap& dofmap,
+    std::int32_t f, std::int32_t cell,
+    std::span<const std::int32_t> linked_cells,
+    const std::vector<std::vector<PetscScalar>>& Ae,
+    const CSRInsertionMap* insertion_map,
+    std::array<std::span<PetscScalar>, 2> values)
+{
+  // Add the bth block, directly at its position in the matrix if the
+  // insertion map has one
+  auto add_block = [&](std::size_t b, std::span<const std::int32_t> rows,
+                       std::span<const std::int32_t> cols)
+  {
+    if (!insertion_map
+        or !insertion_map->add(f, b, std::span<const PetscScalar>(Ae[b]),
+                               values[0], values[1]))
+    {
+      mat_set(rows, cols, Ae[b]);
+    }
+  };
+
+  auto dmap_cell = dofmap.cell_dofs(cell);
+  add_block(0, dmap_cell, dmap_cell);
+  for (std::size_t j = 0; j < linked_cells.size(); j++)
+  {
+    if (linked_cells[j] < 0)
+      continue;
+    auto dmap_linked = dofmap.cell_dofs(linked_cells[j]);
+    assert(!dmap_linked.empty());
+    add_block(3 * j + 1, dmap_cell, dmap_linked);
+    add_block(3 * j + 2, dmap_linked, dmap_cell);
+    add_block(3 * j + 3, dmap_linked, dmap_linked);
+  }
+}
+
+/// Add the element vectors of a facet to a vector
+/// @param[in,out] b The vector
+/// @param[in] dofmap The dofmap
+/// @param[in] cell The cell of the facet
+/// @param[in] linked_cells The cells linked to the facet
+/// @param[in] be The element vectors, see `kernel_fn`
+void add_element_vectors(std::span<PetscScalar> b,
+                         const dolfinx::fem::DofMap& dofmap, std::int32_t cell,
+                         std::span<const std::int32_t> linked_cells,
+                         const std::vector<std::vector<PetscScalar>>& be)
+{
+  const int bs = dofmap.bs();
+  auto add_block = [&](std::span<const std::int32_t> dofs,
+                       const std::vector<PetscScalar>& block)
+  {
+    for (std::size_t j = 0; j < dofs.size(); ++j)
+      for (int k = 0; k < bs; ++k)
+        b[bs * dofs[j] + k] += block[bs * j + k];
+  };
+
+  add_block(dofmap.cell_dofs(cell), be[0]);
+  for (std::size_t l = 0; l < linked_cells.size(); ++l)
+  {
+    if (linked_cells[l] >= 0)
+      add_block(dofmap.cell_dofs(linked_cells[l]), be[l + 1]);
+  }
+}
+
+/// Gather the entries of a vector on the cell of a facet and its linked
+/// cells, the layout of the element vectors of `kernel_fn`
+/// @param[in,out] xe The entries, the blocks of the linked cells that are
+/// not in `linked_cells` are zero
+/// @param[in] x The vector
+/// @param[in] dofmap The dofmap
+/// @param[in] cell The cell of the facet
+/// @param[in] linked_cells The cells linked to the facet
+void gather_element_vectors(std::span<PetscScalar> xe,
+                            std::span<const PetscScalar> x,
+                            const dolfinx::fem::DofMap& dofmap,
+                            std::int32_t cell,
+                            std::span<const std::int32_t> linked_cells)
+{
+  const int bs = dofmap.bs();
+  auto gather_block = [&](std::span<const std::int32_t> dofs, std::size_t l)
+  {
+    const std::size_t offset = l * dofs.size() * bs;
+    for (std::size_t j = 0; j < dofs.size(); ++j)
+      for (int k = 0; k < bs; ++k)
+        xe[offset + bs * j + k] = x[bs * dofs[j] + k];
+  };
+
+  std::fill(xe.begin(), xe.end(), 0);
+  gather_block(dofmap.cell_dofs(cell), 0);
+  for (std::size_t l = 0; l < linked_cells.size(); ++l)
+  {
+    if (linked_cells[l] >= 0)
+      gather_block(dofmap.cell_dofs(linked_cells[l]), l + 1);
+  }
+}
+
+/// Convert the quadrature points of each facet of a batch to factors of
+/// the quadrature points, see `batched_kernel_fn`
+/// @param[in,out] q_factors The factors, shape (num_facets, num_q_points)
+/// @param[in] q_indices The quadrature points of each facet to integrate
+/// over
+/// @param[in] num_q_points The number of quadrature points per facet
+void quadrature_factors(std::vector<PetscScalar>& q_factors,
+                        std::span<const std::vector<std::int32_t>> q_indices,
+                        std::size_t num_q_points)
+{
+  q_factors.assign(q_indices.size() * num_q_points, 0);
+  for (std::size_t l = 0; l < q_indices.size(); ++l)
+    for (std::int32_t q : q_indices[l])
+      q_factors[l * num_q_points + q] = 1;
+}
+
 } // namespace
 
 dolfinx_contact::Contact::Contact(
@@ -102,12 +495,18 @@ dolfinx_contact::Contact::Contact(
   _facet_maps.resize(contact_pairs.size());
   // store physical quadrature points for each surface
   _qp_phys.resize(num_surfaces);
+  // search trees for each surface, created on first use
+  _search_trees.resize(num_surfaces);
   // reference points on opposite surface
   _reference_contact_points.resize(contact_pairs.size());
   // shape of reference points on opposite surface
   _reference_contact_shape.resize(contact_pairs.size());
   // store max number of links for each quadrature surface
   _max_links.resize(contact_pairs.size());
+  // search radius and the data used to estimate it for each pair
+  _pair_radius.resize(contact_pairs.size(), -1);
+  _max_gap.resize(contact_pairs.size(), -1);
+  _increments.resize(contact_pairs.size(), 0);
   // Create adjacency list linking facets as (cell, facet) pairs to the index of
   // the surface. The pairs are flattened row-major
   std::vector<std::int32_t> all_facet_pairs;
@@ -208,63 +607,218 @@ std::size_t dolfinx_contact::Contact::coefficients_size(
   };
 }
 
-Mat dolfinx_contact::Contact::create_petsc_matrix(
-    const dolfinx::fem::Form<PetscScalar>& a, const std::string& type)
+dolfinx::la::SparsityPattern dolfinx_contact::Contact::create_sparsity_pattern(
+    const dolfinx::fem::Form<PetscScalar>& a, double halo)
 {
-
   // Build standard sparsity pattern
   dolfinx::la::SparsityPattern pattern
       = dolfinx::fem::create_sparsity_pattern(a);
 
   std::shared_ptr<const dolfinx::fem::DofMap> dofmap
       = a.function_spaces().at(0)->dofmap();
+  std::shared_ptr<const dolfinx::graph::AdjacencyList<int>> facet_map
+      = _submesh.facet_map();
+  assert(facet_map);
+  std::span<const std::int32_t> parent_cells = _submesh.parent_cells();
+  std::shared_ptr<const dolfinx::mesh::Mesh<double>> submesh = _submesh.mesh();
+  const std::size_t gdim = submesh->geometry().dim();
+  const std::size_t num_q_points = _quadrature_rule->num_points(0);
 
-  // Temporary array to hold dofs for sparsity pattern
+  // Temporary arrays to hold facets, cells and dofs for sparsity pattern
+  std::vector<std::int32_t> linked_facets;
+  std::vector<std::int32_t> linked_cells;
   std::vector<std::int32_t> linked_dofs;
+  std::vector<double> points(3 * num_q_points, 0);
 
   // Loop over each contact interface, and create sparsity pattern for the
   // dofs on the opposite surface
+  _pattern_cells.resize(_contact_pairs.size());
   for (std::size_t k = 0; k < _contact_pairs.size(); ++k)
   {
-    const std::array<int, 2>& contact_pair = _contact_pairs[k];
-    std::shared_ptr<const dolfinx::graph::AdjacencyList<int>> facet_map
-        = _submesh.facet_map();
-    assert(facet_map);
-    std::span<const std::int32_t> parent_cells = _submesh.parent_cells();
+    auto [quadrature_mt, candidate_mt] = _contact_pairs[k];
 
-    auto cell_facet_pairs = _cell_facet_pairs->links(contact_pair.front());
-    for (int i = 0; i < (int)(2 * _local_facets[contact_pair.front()]); i += 2)
+    // The halo is found with the closest point search tree of the candidate
+    // surface, which is created if the pair uses ray-tracing
+    std::shared_ptr<FacetTree>& tree = _search_trees[candidate_mt];
+    if (halo >= 0 and !tree)
     {
-      std::int32_t cell = cell_facet_pairs[i];
-      std::span<const int> cell_dofs = dofmap->cell_dofs(cell);
+      const std::vector<std::int32_t> submesh_facets
+          = _submesh.get_submesh_tuples(_cell_facet_pairs->links(candidate_mt));
+      tree = std::make_shared<FacetTree>(
+          *submesh, facet_indices_from_pair(submesh_facets, *submesh));
+    }
 
-      linked_dofs.clear();
-      for (auto link : _facet_maps[k]->links(i / 2))
+    auto cell_facet_pairs = _cell_facet_pairs->links(quadrature_mt);
+    const std::size_t num_facets = _local_facets[quadrature_mt];
+    std::vector<std::int32_t> pattern_cells;
+    std::vector<std::int32_t> pattern_offsets(1, 0);
+    pattern_offsets.reserve(num_facets + 1);
+    for (std::size_t i = 0; i < num_facets; ++i)
+    {
+      std::span<const std::int32_t> links = _facet_maps[k]->links((int)i);
+      linked_facets.assign(links.begin(), links.end());
+      if (halo >= 0)
       {
-        if (link < 0)
-          continue;
-        const int linked_sub_cell = facet_map->links(link).front();
-        const std::int32_t linked_cell = parent_cells[linked_sub_cell];
+        for (std::size_t q = 0; q < num_q_points; ++q)
+        {
+          std::copy_n(std::next(_qp_phys[quadrature_mt].begin(),
+                                (i * num_q_points + q) * gdim),
+                      gdim, std::next(points.begin(), 3 * q));
+        }
+        const std::vector<std::int32_t> halo_facets
+            = tree->compute_facets_within(points, halo);
+        linked_facets.insert(linked_facets.end(), halo_facets.begin(),
+                             halo_facets.end());
+      }
+      compute_linked_cells(linked_cells, linked_facets, facet_map,
+                           parent_cells);
+      pattern_cells.insert(pattern_cells.end(), linked_cells.begin(),
+                           linked_cells.end());
+      pattern_offsets.push_back((std::int32_t)pattern_cells.size());
+
+      linked_dofs.clear();
+      for (std::int32_t linked_cell : linked_cells)
         for (auto dof : dofmap->cell_dofs(linked_cell))
           linked_dofs.push_back(dof);
-      }
 
       // Remove duplicates
       dolfinx::radix_sort(std::span<std::int32_t>(linked_dofs));
       linked_dofs.erase(std::unique(linked_dofs.begin(), linked_dofs.end()),
                         linked_dofs.end());
 
+      std::span<const int> cell_dofs
+          = dofmap->cell_dofs(cell_facet_pairs[2 * i]);
       pattern.insert(cell_dofs, linked_dofs);
       pattern.insert(linked_dofs, cell_dofs);
     }
+    _pattern_cells[k]
+        = std::make_shared<const dolfinx::graph::AdjacencyList<std::int32_t>>(
+            std::move(pattern_cells), std::move(pattern_offsets));
   }
   // Finalise communication
   pattern.finalize();
-
+  return pattern;
+}
+//------------------------------------------------------------------------------------------------
+Mat dolfinx_contact::Contact::create_petsc_matrix(
+    const dolfinx::fem::Form<PetscScalar>& a, const std::string& type,
+    double halo)
+{
+  dolfinx::la::SparsityPattern pattern = create_sparsity_pattern(a, halo);
   return dolfinx::la::petsc::create_matrix(a.mesh()->comm(), pattern, type);
 }
 //------------------------------------------------------------------------------------------------
+bool dolfinx_contact::Contact::sparsity_pattern_fits() const
+{
+  std::shared_ptr<const dolfinx::graph::AdjacencyList<int>> facet_map
+      = _submesh.facet_map();
+  assert(facet_map);
+  std::span<const std::int32_t> parent_cells = _submesh.parent_cells();
+
+  // The cells coupled to each facet by the current facet maps have to be a
+  // subset of the cells coupled to the facet in the sparsity pattern
+  int fits = _pattern_cells.size() == _contact_pairs.size();
+  std::vector<std::int32_t> linked_cells;
+  for (std::size_t k = 0; k < _pattern_cells.size() and fits; ++k)
+  {
+    const std::size_t num_facets = _local_facets[_contact_pairs[k].front()];
+    for (std::size_t i = 0; i < num_facets and fits; ++i)
+    {
+      compute_linked_cells(linked_cells, _facet_maps[k]->links((int)i),
+                           facet_map, parent_cells);
+      std::span<const std::int32_t> cells = _pattern_cells[k]->links((int)i);
+      fits = std::includes(cells.begin(), cells.end(), linked_cells.begin(),
+                           linked_cells.end());
+    }
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, &fits, 1, MPI_INT, MPI_LAND, _mesh->comm());
+  return fits;
+}
+//------------------------------------------------------------------------------------------------
 void dolfinx_contact::Contact::create_distance_map(int pair)
+{
+  dolfinx::common::Timer t("~Contact: compute distance map");
+  prepare_distance_map(pair);
+  compute_pair_distance_map(pair, _num_threads);
+  reduce_max_gaps(std::span(_max_gap.data() + pair, 1));
+}
+//------------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::create_distance_maps()
+{
+  dolfinx::common::Timer t("~Contact: compute distance map");
+  const std::size_t num_pairs = _contact_pairs.size();
+
+  // Data shared between pairs is created up front, such that the pairs only
+  // read shared data. The connectivities of the submesh used by the search
+  // are created with the submesh. The pairs are handed to the threads in a
+  // different order on each process, so all collective communication
+  // happens outside of for_each_pair
+  for (std::size_t pair = 0; pair < num_pairs; ++pair)
+    prepare_distance_map((int)pair);
+
+  for_each_pair(num_pairs,
+                [this](std::size_t, int pair, int num_threads)
+                { compute_pair_distance_map(pair, num_threads); });
+  reduce_max_gaps(_max_gap);
+}
+//------------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::reduce_max_gaps(std::span<double> max_gaps)
+{
+  if (!_automatic_radius)
+    return;
+  MPI_Allreduce(MPI_IN_PLACE, max_gaps.data(), (int)max_gaps.size(),
+                MPI_DOUBLE, MPI_MAX, _mesh->comm());
+}
+//------------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::prepare_distance_map(int pair)
+{
+  auto [quadrature_mt, candidate_mt] = _contact_pairs[pair];
+  std::shared_ptr<const dolfinx::mesh::Mesh<double>> candidate_mesh
+      = _submesh.mesh();
+
+  // The closest point search uses a persistent tree over the candidate
+  // surface, which is refitted when the submesh geometry is updated
+  std::shared_ptr<FacetTree>& tree = _search_trees[candidate_mt];
+  if (_mode[pair] == ContactMode::ClosestPoint and !tree)
+  {
+    const std::vector<std::int32_t> submesh_facets
+        = _submesh.get_submesh_tuples(_cell_facet_pairs->links(candidate_mt));
+    tree = std::make_shared<FacetTree>(
+        *candidate_mesh,
+        facet_indices_from_pair(submesh_facets, *candidate_mesh));
+  }
+
+  // NOTE: More data that should be updated inside this code
+  const dolfinx::fem::CoordinateElement<double>& cmap
+      = candidate_mesh->geometry().cmaps()[0];
+  std::tie(_reference_basis, _reference_shape)
+      = tabulate(cmap, _quadrature_rule);
+
+  // NOTE: This function should be moved somwhere else, or return the actual
+  // points such that we compuld send them in to compute_distance_map.
+  // Compute quadrature points on physical facet _qp_phys_"origin_meshtag"
+  create_q_phys(quadrature_mt);
+
+  // The estimate of the search radius reduces over all processes
+  if (_automatic_radius and _mode[pair] == ContactMode::RayTracing)
+  {
+    const std::size_t num_facets = _local_facets[quadrature_mt];
+    const std::vector<std::int32_t> quadrature_facets
+        = _submesh.get_submesh_tuples(
+            _cell_facet_pairs->links(quadrature_mt).subspan(0,
+                                                            2 * num_facets));
+    const std::vector<std::int32_t> submesh_facets
+        = _submesh.get_submesh_tuples(_cell_facet_pairs->links(candidate_mt));
+    _pair_radius[pair]
+        = estimate_search_radius(pair, quadrature_facets, submesh_facets);
+  }
+  else
+    _pair_radius[pair] = _radius;
+}
+//------------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::compute_pair_distance_map(int pair,
+                                                         int num_threads)
 {
   // Get quadrature mesh info
   auto [quadrature_mt, candidate_mt] = _contact_pairs[pair];
@@ -282,11 +836,22 @@ void dolfinx_contact::Contact::create_distance_map(int pair)
   const std::vector<std::int32_t> submesh_facets
       = _submesh.get_submesh_tuples(_cell_facet_pairs->links(candidate_mt));
 
+  // In incremental mode the search for each quadrature point starts from the
+  // facet it was linked to by the previous search
+  std::span<const std::int32_t> seeds;
+  if (_incremental_search && _facet_maps[pair]
+      && _facet_maps[pair]->array().size()
+             == num_facets * _quadrature_rule->num_points(0))
+  {
+    seeds = _facet_maps[pair]->array();
+  }
+
   // Compute facet map
   [[maybe_unused]] auto [adj, reference_x, shape]
       = dolfinx_contact::compute_distance_map(
           *quadrature_mesh, quadrature_facets, *candidate_mesh, submesh_facets,
-          *_quadrature_rule, _mode[pair], _radius);
+          *_quadrature_rule, _mode[pair], _pair_radius[pair], num_threads,
+          seeds, _search_trees[candidate_mt].get());
 
   _facet_maps[pair]
       = std::make_shared<dolfinx::graph::AdjacencyList<std::int32_t>>(adj);
@@ -294,19 +859,64 @@ void dolfinx_contact::Contact::create_distance_map(int pair)
   _reference_contact_points[pair] = reference_x;
   _reference_contact_shape[pair] = shape;
 
-  // NOTE: More data that should be updated inside this code
-  const dolfinx::fem::CoordinateElement<double>& cmap
-      = candidate_mesh->geometry().cmaps()[0];
-  std::tie(_reference_basis, _reference_shape)
-      = tabulate(cmap, _quadrature_rule);
-
-  // NOTE: This function should be moved somwhere else, or return the actual
-  // points such that we compuld send them in to compute_distance_map.
-  // Compute quadrature points on physical facet _qp_phys_"origin_meshtag"
-  create_q_phys(quadrature_mt);
-
   // Update maximum number of connected cells
   _max_links[pair] = _quadrature_rule->num_points(0);
+
+  // Gap statistics for the next estimate of the search radius. The maximum
+  // over all processes is taken by the caller, see `reduce_max_gaps`
+  if (_automatic_radius and _mode[pair] == ContactMode::RayTracing)
+  {
+    auto [gap, cstride] = pack_gap(pair);
+    const std::size_t gdim = candidate_mesh->geometry().dim();
+    std::span<const std::int32_t> links = _facet_maps[pair]->array();
+    _max_gap[pair] = -1;
+    for (std::size_t i = 0; i < links.size(); ++i)
+    {
+      if (links[i] < 0)
+        continue;
+      double norm = 0;
+      for (std::size_t k = 0; k < gdim; ++k)
+        norm += gap[i * gdim + k] * gap[i * gdim + k];
+      _max_gap[pair] = std::max(_max_gap[pair], std::sqrt(norm));
+    }
+    _increments[pair] = 0;
+  }
+}
+//------------------------------------------------------------------------------------------------
+double dolfinx_contact::Contact::estimate_search_radius(
+    int pair, std::span<const std::int32_t> quadrature_facets,
+    std::span<const std::int32_t> candidate_facets)
+{
+  // Without a previous search (or without any contact found by it) the
+  // search is unbounded
+  if (_max_gap[pair] < 0)
+    return -1;
+
+  // Facets on both surfaces have to be found within the search radius of
+  // each other's midpoints
+  std::shared_ptr<const dolfinx::mesh::Mesh<double>> mesh = _submesh.mesh();
+  const int fdim = mesh->topology()->dim() - 1;
+  double h = 0;
+  for (auto facets : {quadrature_facets, candidate_facets})
+  {
+    const std::vector<std::int32_t> facet_indices
+        = facet_indices_from_pair(facets, *mesh);
+    const std::vector<double> h_facets
+        = dolfinx::mesh::h(*mesh, facet_indices, fdim);
+    if (!h_facets.empty())
+      h = std::max(h, *std::max_element(h_facets.begin(), h_facets.end()));
+  }
+  MPI_Allreduce(MPI_IN_PLACE, &h, 1, MPI_DOUBLE, MPI_MAX, mesh->comm());
+
+  // Both surfaces may have moved by the largest displacement since the
+  // last search. A safety factor accounts for the change in direction of
+  // the rays
+  const double ray_length = 1.5 * (_max_gap[pair] + 2 * _increments[pair]);
+
+  // The candidate facets are searched within twice the radius of the
+  // quadrature facet midpoints, and the rays have to be shorter than the
+  // radius
+  return ray_length + h;
 }
 //------------------------------------------------------------------------------------------------
 std::pair<std::vector<PetscScalar>, int>
@@ -372,6 +982,9 @@ dolfinx_contact::Contact::pack_nx(int pair)
   mdspan2_t K(Kb.data(), tdim, gdim);
   mdspan4_t full_basis(cmap_basisb.data(), basis_shape);
 
+  // The normal is constant over each facet of an affine cell
+  const bool affine = cmap.is_affine();
+
   // Loop over quadrature points
   for (std::size_t i = 0; i < quadrature_facets.size(); i += 2)
   {
@@ -388,6 +1001,12 @@ dolfinx_contact::Contact::pack_nx(int pair)
     }
     for (std::size_t q = 0; q < num_q_points; ++q)
     {
+      if (affine and q > 0)
+      {
+        std::copy_n(std::next(normals.begin(), i / 2 * cstride), gdim,
+                    std::next(normals.begin(), i / 2 * cstride + q * gdim));
+        continue;
+      }
       auto dphi
           = stdex::submdspan(full_basis, std::pair{1, tdim + 1},
                              quadrature_facets[i + 1] * num_q_points + q,
@@ -418,6 +1037,33 @@ dolfinx_contact::Contact::generate_kernel(
       = *std::max_element(_max_links.begin(), _max_links.end());
   return generate_contact_kernel(type, V, _quadrature_rule, max_links);
 }
+//------------------------------------------------------------------------------------------------
+dolfinx_contact::system_kernel_fn<PetscScalar>
+dolfinx_contact::Contact::generate_system_kernel(
+    Kernel type, std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+{
+  const std::size_t max_links
+      = *std::max_element(_max_links.begin(), _max_links.end());
+  return generate_contact_system_kernel(type, V, _quadrature_rule, max_links);
+}
+//------------------------------------------------------------------------------------------------
+dolfinx_contact::action_kernel_fn<PetscScalar>
+dolfinx_contact::Contact::generate_action_kernel(
+    Kernel type, std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+{
+  const std::size_t max_links
+      = *std::max_element(_max_links.begin(), _max_links.end());
+  return generate_contact_action_kernel(type, V, _quadrature_rule, max_links);
+}
+//------------------------------------------------------------------------------------------------
+dolfinx_contact::batched_kernel_fn<PetscScalar>
+dolfinx_contact::Contact::generate_batched_kernel(
+    Kernel type, std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+{
+  const std::size_t max_links
+      = *std::max_element(_max_links.begin(), _max_links.end());
+  return generate_batched_contact_kernel(type, V, _quadrature_rule, max_links);
+}
 
 //------------------------------------------------------------------------------------------------
 void dolfinx_contact::Contact::create_q_phys(int origin_meshtag)
@@ -546,6 +1192,9 @@ dolfinx_contact::Contact::pack_gap(int pair)
   cmap.tabulate(0, reference_x, shape, cmap_basis);
 
   cmdspan4_t full_basis(cmap_basis.data(), basis_shape);
+  // Consecutive quadrature points are often linked to the same candidate
+  // cell, in which case the coordinate dofs are reused
+  std::int32_t cached_cell = -1;
   for (std::size_t i = 0; i < num_facets; ++i)
   {
     int offset = (int)i * cstride;
@@ -565,14 +1214,18 @@ dolfinx_contact::Contact::pack_gap(int pair)
 
       // Copy coordinate dofs of candidate cell
       // Get cell geometry (coordinate dofs)
-      auto x_dofs
-          = stdex::submdspan(x_dofmap, candidate_cells.front(),
-                             MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent);
-      assert(x_dofs.size() == num_dofs_g);
-      for (std::size_t j = 0; j < num_dofs_g; ++j)
+      if (candidate_cells.front() != cached_cell)
       {
-        std::copy_n(std::next(x_g.begin(), 3 * x_dofs[j]), gdim,
-                    std::next(coordinate_dofsb.begin(), j * gdim));
+        cached_cell = candidate_cells.front();
+        auto x_dofs
+            = stdex::submdspan(x_dofmap, cached_cell,
+                               MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent);
+        assert(x_dofs.size() == num_dofs_g);
+        for (std::size_t j = 0; j < num_dofs_g; ++j)
+        {
+          std::copy_n(std::next(x_g.begin(), 3 * x_dofs[j]), gdim,
+                      std::next(coordinate_dofsb.begin(), j * gdim));
+        }
       }
 
       auto basis_q = stdex::submdspan(
@@ -593,6 +1246,25 @@ dolfinx_contact::Contact::pack_gap(int pair)
 std::pair<std::vector<PetscScalar>, int>
 dolfinx_contact::Contact::pack_test_functions(
     int pair, std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+{
+  auto [c, offsets, block_size] = pack_test_functions(pair, V, false);
+  const std::size_t max_links
+      = *std::max_element(_max_links.begin(), _max_links.end());
+  return {std::move(c), int(max_links * block_size)};
+}
+//------------------------------------------------------------------------------------------------
+std::pair<std::vector<PetscScalar>, std::vector<std::int32_t>>
+dolfinx_contact::Contact::pack_test_functions_ragged(
+    int pair, std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+{
+  auto [c, offsets, block_size] = pack_test_functions(pair, V, true);
+  return {std::move(c), std::move(offsets)};
+}
+//------------------------------------------------------------------------------------------------
+std::tuple<std::vector<PetscScalar>, std::vector<std::int32_t>, std::size_t>
+dolfinx_contact::Contact::pack_test_functions(
+    int pair, std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    bool ragged)
 {
   auto [quadrature_mt, candidate_mt] = _contact_pairs[pair];
 
@@ -625,8 +1297,8 @@ dolfinx_contact::Contact::pack_test_functions(
   std::array<std::size_t, 2> shape = _reference_contact_shape[pair];
 
   // Compute values of basis functions for all y = Pi(x) in qp
-  auto V_sub = std::make_shared<dolfinx::fem::FunctionSpace<double>>(
-      _submesh.create_functionspace(V));
+  std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V_sub
+      = _submesh.function_space(V);
 
   std::shared_ptr<const dolfinx::fem::FiniteElement<double>> element
       = V_sub->element();
@@ -642,16 +1314,18 @@ dolfinx_contact::Contact::pack_test_functions(
   const std::size_t num_q_points
       = _quadrature_rule->offset()[1] - _quadrature_rule->offset()[0];
   const std::size_t bs = element->block_size();
-  const auto cstride = int(num_q_points * max_links * b_shape[2] * bs);
-  std::vector<PetscScalar> cb(
-      num_facets * max_links * num_q_points * b_shape[2] * bs, 0.0);
-  stdex::mdspan<PetscScalar,
-                MDSPAN_IMPL_STANDARD_NAMESPACE::dextents<std::size_t, 5>>
-      c(cb.data(), num_facets, max_links, b_shape[2], num_q_points, bs);
+
+  // Values of the test functions of a single linked cell
+  const std::size_t block_size = num_q_points * b_shape[2] * bs;
+  std::vector<std::int32_t> link_offsets = link_block_offsets(
+      compute_linked_cells(candidate_map, num_facets, sub_to_parent,
+                           parent_cells),
+      block_size, max_links, ragged);
+  std::vector<PetscScalar> cb(link_offsets.back(), 0.0);
 
   // return if no facets on process
   if (num_facets == 0)
-    return {std::move(cb), cstride};
+    return {std::move(cb), std::move(link_offsets), block_size};
 
   std::vector<double> basis_valuesb(
       std::reduce(b_shape.cbegin(), b_shape.cend(), 1, std::multiplies{}));
@@ -695,8 +1369,15 @@ dolfinx_contact::Contact::pack_test_functions(
   }
 
   std::vector<std::int32_t> perm(num_q_points);
-  for (std::size_t i = 0; i < c.extent(0); ++i)
+  for (std::size_t i = 0; i < num_facets; ++i)
   {
+    // Test functions of the linked cells of the ith facet, shape (num_links,
+    // ndofs, num_q_points, bs)
+    stdex::mdspan<PetscScalar,
+                  MDSPAN_IMPL_STANDARD_NAMESPACE::dextents<std::size_t, 4>>
+        c(cb.data() + link_offsets[i],
+          (link_offsets[i + 1] - link_offsets[i]) / block_size, b_shape[2],
+          num_q_points, bs);
     std::span<const std::int32_t> f_cells(cells.data() + i * num_q_points,
                                           num_q_points);
     auto [unique_cells, offsets] = sort_cells(f_cells, perm);
@@ -709,18 +1390,18 @@ dolfinx_contact::Contact::pack_test_functions(
           = std::span(perm.data() + offsets[j], offsets[j + 1] - offsets[j]);
 
       assert(perm.size() >= (std::size_t)offsets[j + 1]);
-      for (std::size_t k = 0; k < c.extent(2); ++k)
+      for (std::size_t k = 0; k < c.extent(1); ++k)
         for (std::size_t q = 0; q < indices.size(); ++q)
-          for (std::size_t l = 0; l < c.extent(4); ++l)
+          for (std::size_t l = 0; l < c.extent(3); ++l)
           {
-            c(i, link, k, indices[q], l)
+            c(link, k, indices[q], l)
                 = basis_values(0, i * num_q_points + indices[q], k, 0);
           }
       link += 1;
     }
   }
 
-  return {std::move(cb), cstride};
+  return {std::move(cb), std::move(link_offsets), block_size};
 }
 //------------------------------------------------------------------------------------------------
 void dolfinx_contact::Contact::crop_invalid_points(std::size_t pair,
@@ -770,6 +1451,18 @@ void dolfinx_contact::Contact::crop_invalid_points(std::size_t pair,
 std::pair<std::vector<PetscScalar>, int>
 dolfinx_contact::Contact::pack_u_contact(
     int pair, std::shared_ptr<dolfinx::fem::Function<PetscScalar>> u)
+{
+  const std::size_t num_facets = _local_facets[_contact_pairs[pair].front()];
+  const auto cstride
+      = int(num_q_points() * u->function_space()->element()->block_size());
+  std::vector<PetscScalar> c(num_facets * cstride);
+  pack_u_contact(pair, u, c, strided_positions(num_facets, cstride));
+  return {std::move(c), cstride};
+}
+//------------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::pack_u_contact(
+    int pair, std::shared_ptr<dolfinx::fem::Function<PetscScalar>> u,
+    std::span<PetscScalar> c, std::span<const std::int32_t> positions)
 {
   dolfinx::common::Timer t("Pack contact u");
   auto [quadrature_mt, candidate_mt] = _contact_pairs[pair];
@@ -785,8 +1478,8 @@ dolfinx_contact::Contact::pack_u_contact(
   const std::size_t num_facets = _local_facets[quadrature_mt];
 
   // copy u onto submesh
-  auto V_sub = std::make_shared<dolfinx::fem::FunctionSpace<double>>(
-      _submesh.create_functionspace(u->function_space()));
+  std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V_sub
+      = _submesh.function_space(u->function_space());
   std::shared_ptr<const dolfinx::fem::FiniteElement<double>> element
       = V_sub->element();
   auto topology = candidate_mesh->topology();
@@ -798,16 +1491,20 @@ dolfinx_contact::Contact::pack_u_contact(
   const int bs_dof = sub_dofmap->bs();
   _submesh.copy_function(*u, u_sub);
 
-  // Output vector
+  // Clear output
   const std::size_t num_q_points
       = _quadrature_rule->offset()[1] - _quadrature_rule->offset()[0];
-  std::vector<PetscScalar> c(num_facets * num_q_points * bs_element, 0.0);
-  const auto cstride = int(num_q_points * bs_element);
+  const std::size_t cstride = num_q_points * bs_element;
+  if (positions.size() < num_facets)
+    throw std::invalid_argument("Missing positions of facet data.");
+  for (std::size_t i = 0; i < num_facets; ++i)
+    std::fill_n(std::next(c.begin(), positions[i]), cstride, 0.0);
+
   // return if no facets on process
   if (num_facets == 0)
   {
     t.stop();
-    return {std::move(c), cstride};
+    return;
   }
 
   // Get (cell, local_facet_index) tuples on quadrature submesh
@@ -888,7 +1585,7 @@ dolfinx_contact::Contact::pack_u_contact(
         {
           for (std::size_t m = 0; m < value_size; ++m)
           {
-            c[cstride * i + q * bs_element + k]
+            c[positions[i] + q * bs_element + k]
                 += coefficients[bs_element * l + k]
                    * basis_values(0, num_q_points * i + q, l, m);
           }
@@ -897,7 +1594,6 @@ dolfinx_contact::Contact::pack_u_contact(
     }
   }
   t.stop();
-  return {std::move(c), cstride};
 }
 //------------------------------------------------------------------------------------------------
 std::pair<std::vector<PetscScalar>, int>
@@ -1023,6 +1719,12 @@ dolfinx_contact::Contact::pack_ny(int pair)
   mdspan2_t J(Jb.data(), gdim, tdim);
   mdspan2_t K(Kb.data(), tdim, gdim);
   mdspan4_t full_basis(cmap_basisb.data(), basis_shape);
+
+  // On affine cells the normal only depends on the candidate facet, and is
+  // reused for consecutive points linked to the same facet
+  const bool affine = cmap.is_affine();
+  std::int32_t cached_facet = -1;
+  std::array<double, 3> cached_normal;
   for (int i = 0; i < (int)num_facets; ++i)
   {
     auto facets = candidate_map->links(i);
@@ -1034,6 +1736,14 @@ dolfinx_contact::Contact::pack_ny(int pair)
       if (facets[q] < 0)
         continue;
 
+      std::span<PetscScalar> n_q(normals.data() + i * cstride + q * gdim,
+                                 gdim);
+      if (affine and facets[q] == cached_facet)
+      {
+        std::copy_n(cached_normal.begin(), gdim, n_q.begin());
+        continue;
+      }
+
       auto candidate_cells = f_to_c->links(facets[q]);
       assert(candidate_cells.size() == 1);
       assert(candidate_cells.front() >= 0);
@@ -1066,137 +1776,321 @@ dolfinx_contact::Contact::pack_ny(int pair)
 
       // Push forward normal using covariant Piola
       physical_facet_normal(
-          std::span(normals.data() + i * cstride + q * gdim, gdim), K,
+          n_q, K,
           stdex::submdspan(facet_normals, local_idx,
                            MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent));
+      cached_facet = facets[q];
+      std::copy(n_q.begin(), n_q.end(), cached_normal.begin());
     }
   }
   return {std::move(normals), cstride};
 }
-
 //------------------------------------------------------------------------------------------------
-void dolfinx_contact::Contact::assemble_matrix(
-    mat_set_fn& mat_set, int pair,
-    const dolfinx_contact::kernel_fn<PetscScalar>& kernel,
-    const std::span<const PetscScalar> coeffs, int cstride,
-    const std::span<const PetscScalar>& constants,
-    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+void dolfinx_contact::Contact::pack_contact_data(
+    int pair, std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    std::span<PetscScalar> c, std::size_t cstride, std::size_t offset)
 {
-  std::shared_ptr<const dolfinx::mesh::Mesh<double>> mesh = V->mesh();
-  assert(mesh);
+  auto [quadrature_mt, candidate_mt] = _contact_pairs[pair];
+  const std::shared_ptr<const dolfinx::mesh::Mesh<double>>& submesh
+      = _submesh.mesh();
+  assert(submesh);
 
-  // Extract geometry data
-  const dolfinx::mesh::Geometry<double>& geometry = mesh->geometry();
-  const int gdim = geometry.dim();
-  stdex::mdspan<const std::int32_t,
-                MDSPAN_IMPL_STANDARD_NAMESPACE::dextents<std::size_t, 2>>
-      x_dofmap = geometry.dofmap();
-  std::span<const double> x_g = geometry.x();
-  const dolfinx::fem::CoordinateElement<double>& cmap = geometry.cmaps()[0];
-  const std::size_t num_dofs_g = cmap.dim();
+  const std::size_t num_facets = _local_facets[quadrature_mt];
+  const std::size_t num_q_points = this->num_q_points();
+  const dolfinx::mesh::Geometry<double>& geometry = submesh->geometry();
+  const std::size_t gdim = geometry.dim();
+  auto topology = submesh->topology();
+  const std::size_t tdim = topology->dim();
+  error::check_cell_type(topology->cell_types()[0]);
 
-  if (V->element()->needs_dof_transformations())
+  // Element information for test functions
+  std::shared_ptr<const dolfinx::fem::FiniteElement<double>> element
+      = V->element();
+  assert(element);
+  if (const basix::FiniteElement<double>& b_el = element->basix_element();
+      element->needs_dof_transformations()
+      or b_el.map_type() != basix::maps::type::identity)
   {
-    throw std::invalid_argument(
-        "Function-space requiring dof-transformations is not supported.");
+    throw std::runtime_error("Packing basis (test) functions of space that "
+                             "uses non-indentity maps is not supported");
   }
-
-  // Extract function space data (assuming same test and trial space)
-  std::shared_ptr<const dolfinx::fem::DofMap> dofmap = V->dofmap();
-  const std::size_t ndofs_cell = dofmap->cell_dofs(0).size();
-  const int bs = dofmap->bs();
+  const std::size_t bs = element->block_size();
   const std::size_t max_links
       = *std::max_element(_max_links.begin(), _max_links.end());
-  if (max_links == 0)
+
+  // Sizes of the packed data of each facet
+  const std::size_t vector_size = num_q_points * gdim;
+  const std::array<std::size_t, 2> shape = _reference_contact_shape[pair];
+  std::array<std::size_t, 4> b_shape
+      = element->basix_element().tabulate_shape(0, shape[0]);
+  if (b_shape.back() > 1)
+    throw std::invalid_argument("pack_contact_data assumes values size 1");
+  const std::size_t block_size = num_q_points * b_shape[2] * bs;
+  const std::size_t data_size = 2 * vector_size + max_links * block_size;
+  if (offset + data_size > cstride or c.size() < num_facets * cstride)
+    throw std::invalid_argument("Coefficient array too small for contact data");
+
+  // Clear the data of facets and points without a link
+  for (std::size_t i = 0; i < num_facets; ++i)
   {
-    LOG(WARNING)
-        << "No links between interfaces, compute_linked_cell will be skipped";
+    std::fill_n(std::next(c.begin(), i * cstride + offset), data_size,
+                PetscScalar(0));
   }
 
-  const std::array<int, 2>& contact_pair = _contact_pairs[pair];
-  std::span<const std::int32_t> active_facets
-      = _cell_facet_pairs->links(contact_pair.front());
-  std::shared_ptr<const dolfinx::graph::AdjacencyList<int>> map
-      = _facet_maps[pair];
-  std::shared_ptr<const dolfinx::graph::AdjacencyList<int>> facet_map
-      = _submesh.facet_map();
-  assert(facet_map);
+  // return if no facets on process
+  if (num_facets == 0)
+    return;
 
+  // Get information about submesh geometry and topology
+  std::span<const double> x_g = geometry.x();
+  auto x_dofmap = geometry.dofmap();
+  const dolfinx::fem::CoordinateElement<double>& cmap = geometry.cmaps()[0];
+  const std::size_t num_dofs_g = cmap.dim();
+  auto f_to_c = topology->connectivity(tdim - 1, tdim);
+  auto c_to_f = topology->connectivity(tdim, tdim - 1);
+  if (!f_to_c or !c_to_f)
+    throw std::runtime_error("Missing facet-cell connectivity on submesh");
+  std::shared_ptr<const dolfinx::graph::AdjacencyList<int>> sub_to_parent
+      = _submesh.facet_map();
   std::span<const std::int32_t> parent_cells = _submesh.parent_cells();
-  // Data structures used in assembly
-  std::vector<double> coordinate_dofs(3 * num_dofs_g);
-  std::vector<std::vector<PetscScalar>> Aes(
-      3 * max_links + 1,
-      std::vector<PetscScalar>(bs * ndofs_cell * bs * ndofs_cell));
-  std::vector<std::int32_t> linked_cells;
-  for (std::size_t i = 0; i < 2 * _local_facets[contact_pair.front()]; i += 2)
+  std::shared_ptr<const dolfinx::graph::AdjacencyList<std::int32_t>>
+      candidate_map = _facet_maps[pair];
+  mdspan3_t qp_span(_qp_phys[quadrature_mt].data(), num_facets, num_q_points,
+                    gdim);
+
+  // Tabulate coordinate element (with first derivatives) and test functions
+  // once at all closest points
+  const std::vector<double>& reference_x = _reference_contact_points[pair];
+  const std::array<std::size_t, 4> basis_shape
+      = cmap.tabulate_shape(1, shape[0]);
+  std::vector<double> cmap_basisb(std::reduce(
+      basis_shape.cbegin(), basis_shape.cend(), 1, std::multiplies{}));
+  cmap.tabulate(1, reference_x, shape, cmap_basisb);
+  cmdspan4_t cmap_basis(cmap_basisb.data(), basis_shape);
+  std::vector<double> basis_valuesb(
+      std::reduce(b_shape.cbegin(), b_shape.cend(), 1, std::multiplies{}));
+  element->tabulate(basis_valuesb, reference_x, shape, 0);
+  cmdspan4_t basis_values(basis_valuesb.data(), b_shape);
+
+  // For ray-tracing the normal is the (negative) outward normal at the
+  // quadrature points, which requires the geometry of the quadrature facets
+  const bool raytracing = _mode[pair] == ContactMode::RayTracing;
+  std::vector<std::int32_t> quadrature_facets;
+  std::vector<double> q_basisb;
+  std::array<std::size_t, 4> q_shape = {0, 0, 0, 0};
+  if (raytracing)
   {
-    // Get cell coordinates/geometry
-    assert(std::size_t(active_facets[i]) < x_dofmap.extent(0));
-    auto x_dofs = stdex::submdspan(x_dofmap, active_facets[i],
+    quadrature_facets = _submesh.get_submesh_tuples(
+        _cell_facet_pairs->links(quadrature_mt).subspan(0, 2 * num_facets));
+    const std::vector<double>& q_points = _quadrature_rule->points();
+    const std::array<std::size_t, 2> q_pshape = {q_points.size() / tdim, tdim};
+    q_shape = cmap.tabulate_shape(1, q_pshape[0]);
+    q_basisb.resize(
+        std::reduce(q_shape.cbegin(), q_shape.cend(), 1, std::multiplies{}));
+    cmap.tabulate(1, q_points, q_pshape, q_basisb);
+  }
+  cmdspan4_t q_basis(q_basisb.data(), q_shape);
+
+  // Get facet normals on reference cell
+  basix::cell::type cell_type
+      = dolfinx::mesh::cell_type_to_basix_type(topology->cell_types()[0]);
+  auto [facet_normalsb, n_shape]
+      = basix::cell::facet_outward_normals<double>(cell_type);
+  cmdspan2_t facet_normals(facet_normalsb.data(), n_shape);
+
+  // Working memory for loop
+  std::vector<double> coordinate_dofsb(num_dofs_g * gdim);
+  cmdspan2_t coordinate_dofs(coordinate_dofsb.data(), num_dofs_g, gdim);
+  std::array<double, 9> Jb;
+  std::array<double, 9> Kb;
+  mdspan2_t J(Jb.data(), gdim, tdim);
+  mdspan2_t K(Kb.data(), tdim, gdim);
+  std::array<double, 3> coordb;
+  mdspan2_t coord(coordb.data(), 1, gdim);
+  std::vector<std::int32_t> linked_cells(num_q_points);
+  std::vector<std::int32_t> perm(num_q_points);
+
+  // Geometry of the last visited cell, and the normal of the last visited
+  // candidate facet which is reused for affine cells
+  const bool affine = cmap.is_affine();
+  std::int32_t cached_cell = -1;
+  std::int32_t cached_facet = -1;
+  std::array<double, 3> cached_normal;
+  auto copy_coordinate_dofs = [&](std::int32_t cell)
+  {
+    if (cell == cached_cell)
+      return;
+    cached_cell = cell;
+    auto x_dofs = stdex::submdspan(x_dofmap, cell,
                                    MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent);
-    for (std::size_t j = 0; j < x_dofs.size(); ++j)
+    assert(x_dofs.size() == num_dofs_g);
+    for (std::size_t j = 0; j < num_dofs_g; ++j)
     {
       std::copy_n(std::next(x_g.begin(), 3 * x_dofs[j]), gdim,
-                  std::next(coordinate_dofs.begin(), j * 3));
+                  std::next(coordinate_dofsb.begin(), j * gdim));
     }
-    // Compute what quadrature points to integrate over (which ones has
-    // corresponding facets on other surface)
-    std::vector<std::int32_t> q_indices;
+  };
 
-    if (max_links > 0)
+  for (std::size_t i = 0; i < num_facets; ++i)
+  {
+    std::span<PetscScalar> gap(c.data() + i * cstride + offset, vector_size);
+    std::span<PetscScalar> normals(gap.data() + vector_size, vector_size);
+
+    if (raytracing)
     {
-      assert(map);
-      auto connected_facets = map->links((int)i / 2);
-      q_indices.reserve(connected_facets.size());
-      // NOTE: Should probably be pre-computed
-      for (std::size_t j = 0; j < connected_facets.size(); ++j)
-        if (connected_facets[j] >= 0)
-          q_indices.push_back(j);
-
-      // Compute the unique set of cells linked to the current facet
-      compute_linked_cells(linked_cells, connected_facets, facet_map,
-                           parent_cells);
+      copy_coordinate_dofs(quadrature_facets[2 * i]);
+      const std::int32_t local_idx = quadrature_facets[2 * i + 1];
+      for (std::size_t q = 0; q < num_q_points; ++q)
+      {
+        if (affine and q > 0)
+        {
+          std::copy_n(normals.begin(), gdim,
+                      std::next(normals.begin(), q * gdim));
+          continue;
+        }
+        auto dphi = stdex::submdspan(
+            q_basis, std::pair{std::size_t(1), tdim + 1},
+            local_idx * num_q_points + q,
+            MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent, 0);
+        std::fill(Jb.begin(), Jb.end(), 0);
+        dolfinx::fem::CoordinateElement<double>::compute_jacobian(
+            dphi, coordinate_dofs, J);
+        std::fill(Kb.begin(), Kb.end(), 0);
+        dolfinx::fem::CoordinateElement<double>::compute_jacobian_inverse(J, K);
+        std::span<PetscScalar> n_q = normals.subspan(q * gdim, gdim);
+        physical_facet_normal(
+            n_q, K,
+            stdex::submdspan(facet_normals, local_idx,
+                             MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent));
+        for (auto& n : n_q)
+          n *= -1;
+      }
     }
-    // Fill initial local element matrices with zeros prior to assembly
-    const std::size_t num_linked_cells = linked_cells.size();
-    std::fill(Aes[0].begin(), Aes[0].end(), 0);
-    for (std::size_t j = 0; j < num_linked_cells; j++)
+
+    auto facets = candidate_map->links((int)i);
+    assert(facets.size() == num_q_points);
+    for (std::size_t q = 0; q < num_q_points; ++q)
     {
-      std::fill(Aes[3 * j + 1].begin(), Aes[3 * j + 1].end(), 0);
-      std::fill(Aes[3 * j + 2].begin(), Aes[3 * j + 2].end(), 0);
-      std::fill(Aes[3 * j + 3].begin(), Aes[3 * j + 3].end(), 0);
-    }
+      // Skip quadrature points without a matching facet on the other side
+      if (facets[q] < 0)
+      {
+        linked_cells[q] = -1;
+        continue;
+      }
+      auto facet_pair = sub_to_parent->links(facets[q]);
+      assert(facet_pair.size() == 2);
+      linked_cells[q] = parent_cells[facet_pair[0]];
 
-    kernel(Aes, std::span(coeffs.data() + i / 2 * cstride, cstride),
-           constants.data(), coordinate_dofs.data(), active_facets[i + 1],
-           num_linked_cells, q_indices);
+      auto candidate_cells = f_to_c->links(facets[q]);
+      assert(candidate_cells.size() == 1);
+      copy_coordinate_dofs(candidate_cells.front());
 
-    // FIXME: We would have to handle possible Dirichlet conditions here, if
-    // we think that we can have a case with contact and Dirichlet
-    auto dmap_cell = dofmap->cell_dofs(active_facets[i]);
-    mat_set(dmap_cell, dmap_cell, Aes[0]);
+      // Gap between quadrature point and its closest point
+      auto basis_q = stdex::submdspan(
+          cmap_basis, 0,
+          std::pair{i * num_q_points + q, i * num_q_points + q + 1},
+          MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent, 0);
+      dolfinx::fem::CoordinateElement<double>::push_forward(
+          coord, coordinate_dofs, basis_q);
+      for (std::size_t k = 0; k < gdim; k++)
+        gap[q * gdim + k] = coordb[k] - qp_span(i, q, k);
 
-    for (std::size_t j = 0; j < num_linked_cells; j++)
+      if (raytracing)
+        continue;
+
+      // Normal of the candidate facet at the closest point
+      std::span<PetscScalar> n_q = normals.subspan(q * gdim, gdim);
+      if (affine and facets[q] == cached_facet)
+      {
+        std::copy_n(cached_normal.begin(), gdim, n_q.begin());
+        continue;
+      }
+      auto local_facets = c_to_f->links(candidate_cells.front());
+      auto it = std::find(local_facets.begin(), local_facets.end(), facets[q]);
+      const auto local_idx = std::distance(local_facets.begin(), it);
+      auto dphi = stdex::submdspan(
+          cmap_basis, std::pair{std::size_t(1), tdim + 1},
+          i * num_q_points + q, MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent, 0);
+      std::fill(Jb.begin(), Jb.end(), 0);
+      dolfinx::fem::CoordinateElement<double>::compute_jacobian(
+          dphi, coordinate_dofs, J);
+      std::fill(Kb.begin(), Kb.end(), 0);
+      dolfinx::fem::CoordinateElement<double>::compute_jacobian_inverse(J, K);
+      physical_facet_normal(
+          n_q, K,
+          stdex::submdspan(facet_normals, local_idx,
+                           MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent));
+      cached_facet = facets[q];
+      std::copy(n_q.begin(), n_q.end(), cached_normal.begin());
+    }
+
+    // Test functions of the linked cells, shape (max_links, ndofs,
+    // num_q_points, bs)
+    stdex::mdspan<PetscScalar,
+                  MDSPAN_IMPL_STANDARD_NAMESPACE::dextents<std::size_t, 4>>
+        v(gap.data() + 2 * vector_size, max_links, b_shape[2], num_q_points,
+          bs);
+    auto [unique_cells, cell_offsets] = sort_cells(linked_cells, perm);
+    std::size_t link = 0;
+    for (std::size_t j = 0; j < unique_cells.size(); ++j)
     {
-      if (linked_cells[j] < 0)
+      if (unique_cells[j] < 0)
         continue;
-      auto dmap_linked = dofmap->cell_dofs(linked_cells[j]);
-      assert(!dmap_linked.empty());
-      mat_set(dmap_cell, dmap_linked, Aes[3 * j + 1]);
-      mat_set(dmap_linked, dmap_cell, Aes[3 * j + 2]);
-      mat_set(dmap_linked, dmap_linked, Aes[3 * j + 3]);
+      auto indices = std::span(perm.data() + cell_offsets[j],
+                               cell_offsets[j + 1] - cell_offsets[j]);
+      for (std::size_t k = 0; k < v.extent(1); ++k)
+        for (auto q : indices)
+          for (std::size_t l = 0; l < v.extent(3); ++l)
+            v(link, k, q, l) = basis_values(0, i * num_q_points + q, k, 0);
+      link += 1;
     }
   }
 }
-//------------------------------------------------------------------------------------------------
 
-void dolfinx_contact::Contact::assemble_vector(
-    std::span<PetscScalar> b, int pair,
+//------------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::assemble_matrix(
+    mat_set_fn& mat_set, int pair,
     const dolfinx_contact::kernel_fn<PetscScalar>& kernel,
-    const std::span<const PetscScalar>& coeffs, int cstride,
+    const std::span<const PetscScalar> coeffs, int cstride,
+    const std::span<const PetscScalar>& constants,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+{
+  const std::vector<std::int32_t> coeff_offsets
+      = uniform_offsets(_local_facets[_contact_pairs[pair].front()], cstride);
+  assemble_matrix(mat_set, pair, kernel, coeffs, coeff_offsets, constants, V);
+}
+//------------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::assemble_matrix(
+    mat_set_fn& mat_set, int pair,
+    const dolfinx_contact::kernel_fn<PetscScalar>& kernel,
+    const std::span<const PetscScalar> coeffs,
+    std::span<const std::int32_t> coeff_offsets,
+    const std::span<const PetscScalar>& constants,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+{
+  assemble_pair_matrix(mat_set, pair, kernel, coeffs, coeff_offsets, constants,
+                       V, _num_threads);
+}
+//------------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::assemble_matrix(
+    mat_set_fn& mat_set, int pair,
+    const dolfinx_contact::batched_kernel_fn<PetscScalar>& kernel,
+    const std::span<const PetscScalar> coeffs, int cstride,
     const std::span<const PetscScalar>& constants,
     std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+{
+  const std::vector<std::int32_t> coeff_offsets
+      = uniform_offsets(_local_facets[_contact_pairs[pair].front()], cstride);
+  assemble_pair_matrix_batched(mat_set, pair, kernel, coeffs, coeff_offsets,
+                               constants, V, _num_threads);
+}
+//------------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::assemble_pair(
+    int pair, std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    std::span<const PetscScalar> coeffs,
+    std::span<const std::int32_t> coeff_offsets, std::size_t batch_size,
+    int num_threads_pair, const PairTargets& targets,
+    const std::function<void(FacetBatch&)>& compute)
 {
   /// Check that we support the function space
   if (V->element()->needs_dof_transformations())
@@ -1216,100 +2110,744 @@ void dolfinx_contact::Contact::assemble_vector(
                 MDSPAN_IMPL_STANDARD_NAMESPACE::dextents<std::size_t, 2>>
       x_dofmap = geometry.dofmap();
   std::span<const double> x_g = geometry.x();
-
-  const dolfinx::fem::CoordinateElement<double>& cmap = geometry.cmaps()[0];
-  const std::size_t num_dofs_g = cmap.dim();
+  const std::size_t num_dofs_g = geometry.cmaps()[0].dim();
 
   // Extract function space data (assuming same test and trial space)
   std::shared_ptr<const dolfinx::fem::DofMap> dofmap = V->dofmap();
   const std::size_t ndofs_cell = dofmap->cell_dofs(0).size();
-  const int bs = dofmap->bs();
+  const std::size_t num_dofs = ndofs_cell * dofmap->bs();
+  const std::size_t max_links
+      = *std::max_element(_max_links.begin(), _max_links.end());
+  if (max_links == 0)
+  {
+    LOG(WARNING)
+        << "No links between interfaces, compute_linked_cell will be skipped";
+  }
 
   // Select which side of the contact interface to loop from and get the
   // correct map
   const std::array<int, 2>& contact_pair = _contact_pairs[pair];
   std::span<const std::int32_t> active_facets
       = _cell_facet_pairs->links(contact_pair.front());
-  const std::size_t local_size = 2 * _local_facets[contact_pair.front()];
+  const std::size_t num_facets = _local_facets[contact_pair.front()];
   std::shared_ptr<const dolfinx::graph::AdjacencyList<int>> map
       = _facet_maps[pair];
   std::shared_ptr<const dolfinx::graph::AdjacencyList<int>> facet_map
       = _submesh.facet_map();
   assert(facet_map);
-  std::span<const std::int32_t> parent_cells = _submesh.parent_cells();
-  const std::size_t max_links
-      = *std::max_element(_max_links.begin(), _max_links.end());
-  if (max_links == 0)
+
+  // Compute the unique set of cells linked to each facet
+  const dolfinx::graph::AdjacencyList<std::int32_t> linked_cells
+      = compute_linked_cells(max_links > 0 ? map : nullptr, num_facets,
+                             facet_map, _submesh.parent_cells());
+
+  // Data structures used in assembly, one set per thread, each holding the
+  // data of a batch of facets
+  const std::size_t W = std::max<std::size_t>(batch_size, 1);
+  const std::size_t num_threads = std::max(num_threads_pair, 1);
+  auto tensors = [W](bool used, std::size_t num_blocks, std::size_t size)
   {
-    LOG(WARNING)
-        << "No links between interfaces, compute_linked_cell will be skipped";
-  }
-  // Data structures used in assembly
-  std::vector<double> coordinate_dofs(3 * num_dofs_g);
-  std::vector<std::vector<PetscScalar>> bes(
-      max_links + 1, std::vector<PetscScalar>(bs * ndofs_cell));
-  // Tempoary array to hold cell links
-  std::vector<std::int32_t> linked_cells;
-  for (std::size_t i = 0; i < local_size; i += 2)
+    return std::vector<std::vector<std::vector<PetscScalar>>>(
+        used ? W : 0, std::vector<std::vector<PetscScalar>>(
+                          num_blocks, std::vector<PetscScalar>(size)));
+  };
+  std::vector<std::vector<double>> coordinate_dofs(
+      num_threads, std::vector<double>(W * 3 * num_dofs_g));
+  std::vector<std::vector<std::span<const PetscScalar>>> batch_coeffs(
+      num_threads, std::vector<std::span<const PetscScalar>>(W));
+  std::vector<std::vector<std::size_t>> facet_indices(
+      num_threads, std::vector<std::size_t>(W));
+  std::vector<std::vector<std::size_t>> num_links(
+      num_threads, std::vector<std::size_t>(W));
+  std::vector<std::vector<std::vector<std::int32_t>>> q_indices(
+      num_threads, std::vector<std::vector<std::int32_t>>(W));
+  std::vector<std::vector<std::vector<std::vector<PetscScalar>>>> Aes(
+      num_threads, tensors(targets.mat_set != nullptr, 3 * max_links + 1,
+                           num_dofs * num_dofs));
+  std::vector<std::vector<std::vector<std::vector<PetscScalar>>>> bes(
+      num_threads, tensors(targets.b.has_value(), max_links + 1, num_dofs));
+  std::vector<std::vector<std::vector<PetscScalar>>> xes(
+      num_threads,
+      std::vector<std::vector<PetscScalar>>(
+          targets.x ? W : 0,
+          std::vector<PetscScalar>((max_links + 1) * num_dofs)));
+  std::vector<KernelWorkspace> workspaces(
+      num_threads, KernelWorkspace(ndofs_cell, gdim, max_links));
+
+  // Assemble the contributions of a batch of at most W facets using the data
+  // structures of thread t
+  auto assemble_batch = [&](std::size_t t, std::span<const std::int32_t> batch)
   {
-    // Get cell coordinates/geometry
-    auto x_dofs = stdex::submdspan(x_dofmap, active_facets[i],
-                                   MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent);
-    for (std::size_t j = 0; j < x_dofs.size(); ++j)
+    const std::size_t n = batch.size();
+    assert(n <= W);
+    for (std::size_t l = 0; l < n; ++l)
     {
-      std::copy_n(std::next(x_g.begin(), 3 * x_dofs[j]), gdim,
-                  std::next(coordinate_dofs.begin(), j * 3));
+      const std::int32_t f = batch[l];
+      const std::int32_t cell = active_facets[2 * f];
+      facet_indices[t][l] = active_facets[2 * f + 1];
+      batch_coeffs[t][l] = coeffs.subspan(
+          coeff_offsets[f], coeff_offsets[f + 1] - coeff_offsets[f]);
+
+      // Get cell coordinates/geometry
+      assert(std::size_t(cell) < x_dofmap.extent(0));
+      auto x_dofs = stdex::submdspan(
+          x_dofmap, cell, MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent);
+      for (std::size_t j = 0; j < x_dofs.size(); ++j)
+      {
+        std::copy_n(std::next(x_g.begin(), 3 * x_dofs[j]), 3,
+                    std::next(coordinate_dofs[t].begin(),
+                              (l * num_dofs_g + j) * 3));
+      }
+
+      // Compute what quadrature points to integrate over (which ones has
+      // corresponding facets on other surface)
+      q_indices[t][l].clear();
+      if (max_links > 0)
+      {
+        assert(map);
+        auto connected_facets = map->links(f);
+        for (std::size_t j = 0; j < connected_facets.size(); ++j)
+          if (connected_facets[j] >= 0)
+            q_indices[t][l].push_back(j);
+      }
+
+      // Fill initial local element tensors with zeros prior to assembly
+      const std::size_t num_linked_cells = linked_cells.num_links(f);
+      num_links[t][l] = num_linked_cells;
+      if (targets.mat_set)
+      {
+        for (std::size_t j = 0; j < 3 * num_linked_cells + 1; j++)
+          std::fill(Aes[t][l][j].begin(), Aes[t][l][j].end(), 0);
+      }
+      if (targets.b)
+      {
+        for (std::size_t j = 0; j < num_linked_cells + 1; j++)
+          std::fill(bes[t][l][j].begin(), bes[t][l][j].end(), 0);
+      }
+      if (targets.x)
+      {
+        gather_element_vectors(
+            std::span(xes[t][l].data(), (num_linked_cells + 1) * num_dofs),
+            *targets.x, *dofmap, cell, linked_cells.links(f));
+      }
     }
 
-    // Compute what quadrature points to integrate over (which ones has
-    // corresponding facets on other surface)
-    std::vector<std::int32_t> q_indices;
+    FacetBatch facet_batch{
+        t,
+        batch,
+        std::span(batch_coeffs[t].data(), n),
+        std::span(coordinate_dofs[t].data(), n * num_dofs_g * 3),
+        std::span(facet_indices[t].data(), n),
+        std::span(num_links[t].data(), n),
+        std::span(q_indices[t].data(), n),
+        std::span(Aes[t].data(), targets.mat_set ? n : 0),
+        std::span(bes[t].data(), targets.b ? n : 0),
+        std::span(xes[t].data(), targets.x ? n : 0),
+        workspaces[t]};
+    compute(facet_batch);
+
+    // Add the element tensors to the matrix and the vector
+    // FIXME: We would have to handle possible Dirichlet conditions here, if
+    // we think that we can have a case with contact and Dirichlet
+    for (std::size_t l = 0; l < n; ++l)
+    {
+      const std::int32_t f = batch[l];
+      const std::int32_t cell = active_facets[2 * f];
+      if (targets.mat_set)
+      {
+        add_element_matrices(*targets.mat_set, *dofmap, f, cell,
+                             linked_cells.links(f), Aes[t][l],
+                             targets.insertion_map, targets.values);
+      }
+      if (targets.b)
+      {
+        add_element_vectors(*targets.b, *dofmap, cell, linked_cells.links(f),
+                            bes[t][l]);
+      }
+    }
+  };
 
-    // Compute the unique set of cells linked to the current facet
-    if (max_links > 0)
+  // Assemble the facets in batches of W consecutive facets of the list
+  auto assemble_batches
+      = [&](std::size_t t, std::span<const std::int32_t> facets)
+  {
+    for (std::size_t i = 0; i < facets.size(); i += W)
+      assemble_batch(t, facets.subspan(i, std::min(W, facets.size() - i)));
+  };
+
+  if (num_threads == 1)
+  {
+    std::vector<std::int32_t> facets(num_facets);
+    std::iota(facets.begin(), facets.end(), 0);
+    assemble_batches(0, facets);
+  }
+  else
+  {
+    // Facets of the same colour do not share any degrees of freedom and are
+    // assembled concurrently, with batches formed within each chunk
+    const std::vector<std::vector<std::int32_t>> colours = colour_facets(
+        active_facets.subspan(0, 2 * num_facets), linked_cells, *dofmap);
+    for (const std::vector<std::int32_t>& colour : colours)
     {
-      assert(map);
-      auto connected_facets = map->links((int)i / 2);
-      q_indices.reserve(connected_facets.size());
+      parallel_for(colour.size(), (int)num_threads,
+                   [&](std::size_t t, std::size_t c0, std::size_t c1)
+                   {
+                     assemble_batches(t, std::span(colour.data() + c0,
+                                                   c1 - c0));
+                   });
+    }
+  }
+}
+//------------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::assemble_pair_matrix(
+    mat_set_fn& mat_set, int pair,
+    const dolfinx_contact::kernel_fn<PetscScalar>& kernel,
+    const std::span<const PetscScalar> coeffs,
+    std::span<const std::int32_t> coeff_offsets,
+    const std::span<const PetscScalar>& constants,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    int num_threads_pair, const CSRInsertionMap* insertion_map,
+    std::array<std::span<PetscScalar>, 2> values)
+{
+  assemble_pair(pair, V, coeffs, coeff_offsets, 1, num_threads_pair,
+                {&mat_set, insertion_map, values, std::nullopt},
+                [&](FacetBatch& batch)
+                {
+                  kernel(batch.Ae[0], batch.coeffs[0], constants.data(),
+                         batch.coordinate_dofs.data(), batch.facet_indices[0],
+                         batch.num_links[0], batch.q_indices[0],
+                         batch.workspace);
+                });
+}
+//------------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::assemble_pair_matrix_batched(
+    mat_set_fn& mat_set, int pair,
+    const dolfinx_contact::batched_kernel_fn<PetscScalar>& kernel,
+    const std::span<const PetscScalar> coeffs,
+    std::span<const std::int32_t> coeff_offsets,
+    const std::span<const PetscScalar>& constants,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    int num_threads_pair, const CSRInsertionMap* insertion_map,
+    std::array<std::span<PetscScalar>, 2> values)
+{
+  const std::size_t num_q_points = _quadrature_rule->num_points(0);
+  std::vector<std::vector<PetscScalar>> q_factors(
+      std::max(num_threads_pair, 1));
+  std::vector<std::vector<PetscScalar>> scratch(q_factors.size());
+  assemble_pair(pair, V, coeffs, coeff_offsets, kernel_batch_size,
+                num_threads_pair,
+                {&mat_set, insertion_map, values, std::nullopt},
+                [&](FacetBatch& batch)
+                {
+                  std::vector<PetscScalar>& factors = q_factors[batch.thread];
+                  quadrature_factors(factors, batch.q_indices, num_q_points);
+                  kernel(batch.Ae, batch.coeffs, constants.data(),
+                         batch.coordinate_dofs, batch.facet_indices,
+                         batch.num_links, factors, scratch[batch.thread]);
+                });
+}
+//------------------------------------------------------------------------------------------------
+dolfinx_contact::CSRInsertionMap dolfinx_contact::Contact::create_insertion_map(
+    int pair, std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    const std::function<std::int64_t(std::int32_t, std::int32_t)>& offset,
+    std::array<std::int64_t, 2> num_values,
+    std::array<std::int64_t, 2> pattern_state, std::uint64_t pattern) const
+{
+  std::shared_ptr<const dolfinx::fem::DofMap> dofmap = V->dofmap();
+  const std::size_t bs = dofmap->bs();
+  const std::size_t num_dofs = dofmap->cell_dofs(0).size() * bs;
+  const std::size_t block_size = num_dofs * num_dofs;
+  const std::size_t max_links
+      = *std::max_element(_max_links.begin(), _max_links.end());
 
-      // NOTE: Should probably be pre-computed
-      for (std::size_t j = 0; j < connected_facets.size(); ++j)
-        if (connected_facets[j] >= 0)
-          q_indices.push_back(j);
+  const std::array<int, 2>& contact_pair = _contact_pairs[pair];
+  std::span<const std::int32_t> active_facets
+      = _cell_facet_pairs->links(contact_pair.front());
+  const std::size_t num_facets = _local_facets[contact_pair.front()];
+  std::shared_ptr<const dolfinx::graph::AdjacencyList<int>> map
+      = _facet_maps[pair];
 
-      compute_linked_cells(linked_cells, connected_facets, facet_map,
-                           parent_cells);
+  // The linked cells are computed as in assemble_matrix, such that the
+  // blocks are in the same order
+  const dolfinx::graph::AdjacencyList<std::int32_t> linked_cells
+      = compute_linked_cells(max_links > 0 ? map : nullptr, num_facets,
+                             _submesh.facet_map(), _submesh.parent_cells());
+
+  std::vector<std::int32_t> facet_blocks(num_facets + 1, 0);
+  std::vector<std::int64_t> blocks;
+  std::vector<std::int64_t> offsets;
+  std::vector<std::int64_t> block_offsets(block_size);
+
+  // Append the block coupling the rows of cell0 to the columns of cell1
+  auto append_block = [&](std::int32_t cell0, std::int32_t cell1)
+  {
+    std::span<const std::int32_t> dofs0 = dofmap->cell_dofs(cell0);
+    std::span<const std::int32_t> dofs1 = dofmap->cell_dofs(cell1);
+    for (std::size_t i = 0; i < num_dofs; ++i)
+    {
+      const auto row = (std::int32_t)(dofs0[i / bs] * bs + i % bs);
+      for (std::size_t j = 0; j < num_dofs; ++j)
+      {
+        const std::int64_t pos
+            = offset(row, (std::int32_t)(dofs1[j / bs] * bs + j % bs));
+        if (pos < 0)
+        {
+          blocks.push_back(-1);
+          return;
+        }
+        block_offsets[i * num_dofs + j] = pos;
+      }
     }
+    blocks.push_back(offsets.size() / block_size);
+    offsets.insert(offsets.end(), block_offsets.begin(), block_offsets.end());
+  };
 
-    // Using integer loop here to reduce number of zeroed vectors
-    const std::size_t num_linked_cells = linked_cells.size();
-    std::fill(bes[0].begin(), bes[0].end(), 0);
-    for (std::size_t j = 0; j < num_linked_cells; j++)
-      std::fill(bes[j + 1].begin(), bes[j + 1].end(), 0);
+  for (std::size_t f = 0; f < num_facets; ++f)
+  {
+    const std::int32_t cell = active_facets[2 * f];
+    append_block(cell, cell);
+    for (std::int32_t linked_cell : linked_cells.links((int)f))
+    {
+      if (linked_cell < 0)
+      {
+        blocks.insert(blocks.end(), 3, -1);
+        continue;
+      }
+      append_block(cell, linked_cell);
+      append_block(linked_cell, cell);
+      append_block(linked_cell, linked_cell);
+    }
+    facet_blocks[f + 1] = (std::int32_t)blocks.size();
+  }
+
+  return CSRInsertionMap(map, std::move(facet_blocks), std::move(blocks),
+                         std::move(offsets), block_size, num_values,
+                         pattern_state, pattern);
+}
+//------------------------------------------------------------------------------------------------
+dolfinx_contact::CSRInsertionMap dolfinx_contact::Contact::create_insertion_map(
+    int pair, Mat A,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V) const
+{
+  MatInfo info;
+  MatGetInfo(A, MAT_LOCAL, &info);
+  if (info.assemblies == 0)
+  {
+    throw std::invalid_argument(
+        "Matrix has to be assembled before creating an insertion map.");
+  }
+  Mat Ad, Ao;
+  const PetscInt* colmap;
+  std::tie(Ad, Ao, colmap) = aij_blocks(A);
+
+  // Rows and columns of the entries in the owned rows
+  PetscInt num_rows;
+  const PetscInt *rows_d, *cols_d;
+  const PetscInt *rows_o = nullptr, *cols_o = nullptr;
+  PetscBool done;
+  MatGetRowIJ(Ad, 0, PETSC_FALSE, PETSC_FALSE, &num_rows, &rows_d, &cols_d,
+              &done);
+  if (Ao)
+  {
+    MatGetRowIJ(Ao, 0, PETSC_FALSE, PETSC_FALSE, &num_rows, &rows_o, &cols_o,
+                &done);
+  }
+  const std::array<std::int64_t, 2> num_values
+      = {aij_num_values(Ad), aij_num_values(Ao)};
 
-    kernel(bes, std::span(coeffs.data() + i / 2 * cstride, cstride),
-           constants.data(), coordinate_dofs.data(), active_facets[i + 1],
-           num_linked_cells, q_indices);
+  std::shared_ptr<const dolfinx::common::IndexMap> index_map
+      = V->dofmap()->index_map;
+  const int bs = V->dofmap()->index_map_bs();
+  const std::int32_t num_owned = bs * index_map->size_local();
+  std::span<const std::int64_t> ghosts = index_map->ghosts();
 
-    // Add element vector to global vector
-    const std::span<const int> dofs_cell = dofmap->cell_dofs(active_facets[i]);
-    for (std::size_t j = 0; j < ndofs_cell; ++j)
-      for (int k = 0; k < bs; ++k)
-        b[bs * dofs_cell[j] + k] += bes[0][bs * j + k];
-    for (std::size_t l = 0; l < num_linked_cells; ++l)
+  auto offset = [&](std::int32_t row, std::int32_t col) -> std::int64_t
+  {
+    // Rows owned by other processes are communicated by PETSc
+    if (row >= num_owned)
+      return -1;
+
+    if (col < num_owned)
+    {
+      const PetscInt* first = cols_d + rows_d[row];
+      const PetscInt* last = cols_d + rows_d[row + 1];
+      if (const PetscInt* it = std::find(first, last, col); it != last)
+        return std::distance(cols_d, it);
+    }
+    else if (Ao)
     {
-      const std::span<const int> dofs_linked
-          = dofmap->cell_dofs(linked_cells[l]);
-      for (std::size_t j = 0; j < ndofs_cell; ++j)
-        for (int k = 0; k < bs; ++k)
-          b[bs * dofs_linked[j] + k] += bes[l + 1][bs * j + k];
+      const PetscInt global_col
+          = ghosts[(col - num_owned) / bs] * bs + (col - num_owned) % bs;
+      for (PetscInt k = rows_o[row]; k < rows_o[row + 1]; ++k)
+      {
+        if (colmap[cols_o[k]] == global_col)
+          return num_values[0] + k;
+      }
     }
+    throw std::runtime_error(
+        "Contact coupling is not in the sparsity pattern of the matrix.");
+  };
+#ifndef NDEBUG
+  const std::uint64_t pattern = aij_pattern(A);
+#else
+  const std::uint64_t pattern = 0;
+#endif
+  CSRInsertionMap insertion_map = create_insertion_map(
+      pair, V, offset, num_values, aij_pattern_state(A), pattern);
+
+  MatRestoreRowIJ(Ad, 0, PETSC_FALSE, PETSC_FALSE, &num_rows, &rows_d,
+                  &cols_d, &done);
+  if (Ao)
+  {
+    MatRestoreRowIJ(Ao, 0, PETSC_FALSE, PETSC_FALSE, &num_rows, &rows_o,
+                    &cols_o, &done);
   }
+  return insertion_map;
+}
+//------------------------------------------------------------------------------------------------
+dolfinx_contact::CSRInsertionMap dolfinx_contact::Contact::create_insertion_map(
+    int pair, const dolfinx::la::MatrixCSR<PetscScalar>& A,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V) const
+{
+  // In the compact block mode, each column index refers to a dense
+  // (bs, bs) block of values
+  const int bs = V->dofmap()->index_map_bs();
+  const std::array<int, 2> mat_bs = A.block_size();
+  if (mat_bs[0] != mat_bs[1] or (mat_bs[0] != 1 and mat_bs[0] != bs))
+  {
+    throw std::invalid_argument(
+        "Block size of matrix does not match the function space.");
+  }
+  const std::int32_t mbs = mat_bs[0];
+
+  // All rows, including the ghost rows, are stored on the process
+  const auto& row_ptr = A.row_ptr();
+  const auto& cols = A.cols();
+  auto offset = [&](std::int32_t row, std::int32_t col) -> std::int64_t
+  {
+    auto first = std::next(cols.begin(), row_ptr[row / mbs]);
+    auto last = std::next(cols.begin(), row_ptr[row / mbs + 1]);
+    auto it = std::find(first, last, col / mbs);
+    if (it == last)
+    {
+      throw std::runtime_error(
+          "Contact coupling is not in the sparsity pattern of the matrix.");
+    }
+    return std::distance(cols.begin(), it) * mbs * mbs + (row % mbs) * mbs
+           + col % mbs;
+  };
+#ifndef NDEBUG
+  const std::uint64_t pattern = csr_pattern(A);
+#else
+  const std::uint64_t pattern = 0;
+#endif
+  return create_insertion_map(pair, V, offset,
+                              {(std::int64_t)A.values().size(), 0},
+                              csr_pattern_state(A), pattern);
+}
+//------------------------------------------------------------------------------------------------
+bool dolfinx_contact::Contact::insertion_map_valid(
+    int pair, const CSRInsertionMap& insertion_map, Mat A) const
+{
+  auto [Ad, Ao, colmap] = aij_blocks(A);
+  const bool valid
+      = insertion_map.facet_map() == _facet_maps[pair]
+        and insertion_map.pattern_state() == aij_pattern_state(A)
+        and insertion_map.num_values()
+                == std::array{aij_num_values(Ad), aij_num_values(Ao)};
+  assert(!valid or insertion_map.pattern() == aij_pattern(A));
+  return valid;
+}
+//------------------------------------------------------------------------------------------------
+bool dolfinx_contact::Contact::insertion_map_valid(
+    int pair, const CSRInsertionMap& insertion_map,
+    const dolfinx::la::MatrixCSR<PetscScalar>& A) const
+{
+  const bool valid
+      = insertion_map.facet_map() == _facet_maps[pair]
+        and insertion_map.pattern_state() == csr_pattern_state(A)
+        and insertion_map.num_values()
+                == std::array<std::int64_t, 2>{(std::int64_t)A.values().size(),
+                                               0};
+  assert(!valid or insertion_map.pattern() == csr_pattern(A));
+  return valid;
+}
+//------------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::assemble_matrix(
+    Mat A, const CSRInsertionMap& insertion_map, mat_set_fn& mat_set, int pair,
+    const dolfinx_contact::kernel_fn<PetscScalar>& kernel,
+    const std::span<const PetscScalar> coeffs, int cstride,
+    const std::span<const PetscScalar>& constants,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+{
+  if (!insertion_map_valid(pair, insertion_map, A))
+  {
+    throw std::invalid_argument(
+        "Insertion map does not match the contact pair or the matrix.");
+  }
+
+  const std::vector<std::int32_t> coeff_offsets
+      = uniform_offsets(_local_facets[_contact_pairs[pair].front()], cstride);
+  with_aij_values(A, insertion_map.num_values(),
+                  [&](std::array<std::span<PetscScalar>, 2> values)
+                  {
+                    assemble_pair_matrix(mat_set, pair, kernel, coeffs,
+                                         coeff_offsets, constants, V,
+                                         _num_threads, &insertion_map, values);
+                  });
+}
+//------------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::assemble_matrix(
+    Mat A, const CSRInsertionMap& insertion_map, mat_set_fn& mat_set, int pair,
+    const dolfinx_contact::batched_kernel_fn<PetscScalar>& kernel,
+    const std::span<const PetscScalar> coeffs, int cstride,
+    const std::span<const PetscScalar>& constants,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+{
+  if (!insertion_map_valid(pair, insertion_map, A))
+  {
+    throw std::invalid_argument(
+        "Insertion map does not match the contact pair or the matrix.");
+  }
+
+  const std::vector<std::int32_t> coeff_offsets
+      = uniform_offsets(_local_facets[_contact_pairs[pair].front()], cstride);
+  with_aij_values(A, insertion_map.num_values(),
+                  [&](std::array<std::span<PetscScalar>, 2> values)
+                  {
+                    assemble_pair_matrix_batched(
+                        mat_set, pair, kernel, coeffs, coeff_offsets,
+                        constants, V, _num_threads, &insertion_map, values);
+                  });
+}
+//------------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::assemble_matrix(
+    dolfinx::la::MatrixCSR<PetscScalar>& A,
+    const CSRInsertionMap& insertion_map, int pair,
+    const dolfinx_contact::kernel_fn<PetscScalar>& kernel,
+    const std::span<const PetscScalar> coeffs, int cstride,
+    const std::span<const PetscScalar>& constants,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+{
+  if (!insertion_map_valid(pair, insertion_map, A))
+  {
+    throw std::invalid_argument(
+        "Insertion map does not match the contact pair or the matrix.");
+  }
+
+  // All rows of the matrix are stored on the process, so every block is
+  // added directly
+  mat_set_fn mat_set
+      = [](const std::span<const std::int32_t>&,
+           const std::span<const std::int32_t>&,
+           const std::span<const PetscScalar>&) -> int
+  {
+    throw std::runtime_error("Block missing from insertion map.");
+  };
+
+  const std::vector<std::int32_t> coeff_offsets
+      = uniform_offsets(_local_facets[_contact_pairs[pair].front()], cstride);
+  assemble_pair_matrix(mat_set, pair, kernel, coeffs, coeff_offsets, constants,
+                       V, _num_threads, &insertion_map,
+                       {std::span<PetscScalar>(A.values()),
+                        std::span<PetscScalar>()});
+}
+//------------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::apply_matrix(
+    std::span<const PetscScalar> x, std::span<PetscScalar> y, int pair,
+    const dolfinx_contact::action_kernel_fn<PetscScalar>& kernel,
+    const std::span<const PetscScalar> coeffs, int cstride,
+    const std::span<const PetscScalar>& constants,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+{
+  const std::vector<std::int32_t> coeff_offsets
+      = uniform_offsets(_local_facets[_contact_pairs[pair].front()], cstride);
+  assemble_pair(pair, V, coeffs, coeff_offsets, 1, _num_threads,
+                {nullptr, nullptr, {}, y, x},
+                [&](FacetBatch& batch)
+                {
+                  kernel(batch.be[0], batch.xe[0], batch.coeffs[0],
+                         constants.data(), batch.coordinate_dofs.data(),
+                         batch.facet_indices[0], batch.num_links[0],
+                         batch.q_indices[0], batch.workspace);
+                });
+}
+//------------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::assemble_vector(
+    std::span<PetscScalar> b, int pair,
+    const dolfinx_contact::kernel_fn<PetscScalar>& kernel,
+    const std::span<const PetscScalar>& coeffs, int cstride,
+    const std::span<const PetscScalar>& constants,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+{
+  const std::vector<std::int32_t> coeff_offsets
+      = uniform_offsets(_local_facets[_contact_pairs[pair].front()], cstride);
+  assemble_vector(b, pair, kernel, coeffs, coeff_offsets, constants, V);
+}
+//------------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::assemble_vector(
+    std::span<PetscScalar> b, int pair,
+    const dolfinx_contact::kernel_fn<PetscScalar>& kernel,
+    const std::span<const PetscScalar>& coeffs,
+    std::span<const std::int32_t> coeff_offsets,
+    const std::span<const PetscScalar>& constants,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+{
+  assemble_pair_vector(b, pair, kernel, coeffs, coeff_offsets, constants, V,
+                       _num_threads);
+}
+//------------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::assemble_vector(
+    std::span<PetscScalar> b, int pair,
+    const dolfinx_contact::batched_kernel_fn<PetscScalar>& kernel,
+    const std::span<const PetscScalar>& coeffs, int cstride,
+    const std::span<const PetscScalar>& constants,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+{
+  const std::vector<std::int32_t> coeff_offsets
+      = uniform_offsets(_local_facets[_contact_pairs[pair].front()], cstride);
+  assemble_pair_vector_batched(b, pair, kernel, coeffs, coeff_offsets,
+                               constants, V, _num_threads);
+}
+//------------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::assemble_pair_vector(
+    std::span<PetscScalar> b, int pair,
+    const dolfinx_contact::kernel_fn<PetscScalar>& kernel,
+    const std::span<const PetscScalar>& coeffs,
+    std::span<const std::int32_t> coeff_offsets,
+    const std::span<const PetscScalar>& constants,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    int num_threads_pair)
+{
+  assemble_pair(pair, V, coeffs, coeff_offsets, 1, num_threads_pair,
+                {nullptr, nullptr, {}, b},
+                [&](FacetBatch& batch)
+                {
+                  kernel(batch.be[0], batch.coeffs[0], constants.data(),
+                         batch.coordinate_dofs.data(), batch.facet_indices[0],
+                         batch.num_links[0], batch.q_indices[0],
+                         batch.workspace);
+                });
+}
+//------------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::assemble_pair_vector_batched(
+    std::span<PetscScalar> b, int pair,
+    const dolfinx_contact::batched_kernel_fn<PetscScalar>& kernel,
+    const std::span<const PetscScalar>& coeffs,
+    std::span<const std::int32_t> coeff_offsets,
+    const std::span<const PetscScalar>& constants,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    int num_threads_pair)
+{
+  const std::size_t num_q_points = _quadrature_rule->num_points(0);
+  std::vector<std::vector<PetscScalar>> q_factors(
+      std::max(num_threads_pair, 1));
+  std::vector<std::vector<PetscScalar>> scratch(q_factors.size());
+  assemble_pair(pair, V, coeffs, coeff_offsets, kernel_batch_size,
+                num_threads_pair, {nullptr, nullptr, {}, b},
+                [&](FacetBatch& batch)
+                {
+                  std::vector<PetscScalar>& factors = q_factors[batch.thread];
+                  quadrature_factors(factors, batch.q_indices, num_q_points);
+                  kernel(batch.be, batch.coeffs, constants.data(),
+                         batch.coordinate_dofs, batch.facet_indices,
+                         batch.num_links, factors, scratch[batch.thread]);
+                });
 }
 //-----------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::assemble_system(
+    const mat_set_fn& mat_set, std::span<PetscScalar> b, int pair,
+    const dolfinx_contact::system_kernel_fn<PetscScalar>& kernel,
+    const std::span<const PetscScalar>& coeffs, int cstride,
+    const std::span<const PetscScalar>& constants,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+{
+  const std::vector<std::int32_t> coeff_offsets
+      = uniform_offsets(_local_facets[_contact_pairs[pair].front()], cstride);
+  assemble_pair_system(mat_set, b, pair, kernel, coeffs, coeff_offsets,
+                       constants, V, _num_threads);
+}
+//------------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::assemble_system(
+    const mat_set_fn& mat_set, std::span<PetscScalar> b, int pair,
+    const dolfinx_contact::system_kernel_fn<PetscScalar>& kernel,
+    const std::span<const PetscScalar>& coeffs,
+    std::span<const std::int32_t> coeff_offsets,
+    const std::span<const PetscScalar>& constants,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+{
+  assemble_pair_system(mat_set, b, pair, kernel, coeffs, coeff_offsets,
+                       constants, V, _num_threads);
+}
+//------------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::assemble_system(
+    Mat A, const CSRInsertionMap& insertion_map, const mat_set_fn& mat_set,
+    std::span<PetscScalar> b, int pair,
+    const dolfinx_contact::system_kernel_fn<PetscScalar>& kernel,
+    const std::span<const PetscScalar>& coeffs, int cstride,
+    const std::span<const PetscScalar>& constants,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+{
+  if (!insertion_map_valid(pair, insertion_map, A))
+  {
+    throw std::invalid_argument(
+        "Insertion map does not match the contact pair or the matrix.");
+  }
+
+  const std::vector<std::int32_t> coeff_offsets
+      = uniform_offsets(_local_facets[_contact_pairs[pair].front()], cstride);
+  with_aij_values(A, insertion_map.num_values(),
+                  [&](std::array<std::span<PetscScalar>, 2> values)
+                  {
+                    assemble_pair_system(mat_set, b, pair, kernel, coeffs,
+                                         coeff_offsets, constants, V,
+                                         _num_threads, &insertion_map, values);
+                  });
+}
+//------------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::assemble_pair_system(
+    const mat_set_fn& mat_set, std::span<PetscScalar> b, int pair,
+    const dolfinx_contact::system_kernel_fn<PetscScalar>& kernel,
+    const std::span<const PetscScalar>& coeffs,
+    std::span<const std::int32_t> coeff_offsets,
+    const std::span<const PetscScalar>& constants,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    int num_threads_pair, const CSRInsertionMap* insertion_map,
+    std::array<std::span<PetscScalar>, 2> values)
+{
+  assemble_pair(pair, V, coeffs, coeff_offsets, 1, num_threads_pair,
+                {&mat_set, insertion_map, values, b},
+                [&](FacetBatch& batch)
+                {
+                  kernel(batch.be[0], batch.Ae[0], batch.coeffs[0],
+                         constants.data(), batch.coordinate_dofs.data(),
+                         batch.facet_indices[0], batch.num_links[0],
+                         batch.q_indices[0], batch.workspace);
+                });
+}
+//------------------------------------------------------------------------------------------------
 std::pair<std::vector<PetscScalar>, int>
 dolfinx_contact::Contact::pack_grad_test_functions(
     int pair, std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+{
+  auto [c, offsets, block_size] = pack_grad_test_functions(pair, V, false);
+  const std::size_t max_links
+      = *std::max_element(_max_links.begin(), _max_links.end());
+  return {std::move(c), int(max_links * block_size)};
+}
+//-----------------------------------------------------------------------------------------------
+std::pair<std::vector<PetscScalar>, std::vector<std::int32_t>>
+dolfinx_contact::Contact::pack_grad_test_functions_ragged(
+    int pair, std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+{
+  auto [c, offsets, block_size] = pack_grad_test_functions(pair, V, true);
+  return {std::move(c), std::move(offsets)};
+}
+//-----------------------------------------------------------------------------------------------
+std::tuple<std::vector<PetscScalar>, std::vector<std::int32_t>, std::size_t>
+dolfinx_contact::Contact::pack_grad_test_functions(
+    int pair, std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    bool ragged)
 {
   auto [quadrature_mt, candidate_mt] = _contact_pairs[pair];
   // Mesh info
@@ -1344,13 +2882,15 @@ dolfinx_contact::Contact::pack_grad_test_functions(
   std::vector<std::int32_t> linked_cells(num_q_points);
 
   // Create output vector
-  std::vector<PetscScalar> c(
-      num_facets * num_q_points * max_links * ndofs * gdim, 0.0);
-  const auto cstride = int(num_q_points * max_links * ndofs * gdim);
+  const std::size_t block_size = num_q_points * ndofs * gdim;
+  std::vector<std::int32_t> link_offsets = link_block_offsets(
+      compute_linked_cells(map, num_facets, facet_map, parent_cells),
+      block_size, max_links, ragged);
+  std::vector<PetscScalar> c(link_offsets.back(), 0.0);
 
   // return if no facets on process
   if (num_facets == 0)
-    return {std::move(c), cstride};
+    return {std::move(c), std::move(link_offsets), block_size};
 
   // temporary data structure used inside loop
   std::vector<std::int32_t> cells(max_links, -1);
@@ -1415,7 +2955,7 @@ dolfinx_contact::Contact::pack_grad_test_functions(
         for (std::size_t q = 0; q < indices.size(); ++q)
           for (std::size_t l = 0; l < gdim; l++)
           {
-            c[i * cstride + link * ndofs * gdim * num_q_points
+            c[link_offsets[i] + link * block_size
               + k * gdim * num_q_points + indices[q] * gdim + l]
                 = basis_values(l + 1, q, k, 0);
           }
@@ -1423,12 +2963,26 @@ dolfinx_contact::Contact::pack_grad_test_functions(
     }
   }
 
-  return {std::move(c), cstride};
+  return {std::move(c), std::move(link_offsets), block_size};
 }
 //-----------------------------------------------------------------------------------------------
 std::pair<std::vector<PetscScalar>, int>
 dolfinx_contact::Contact::pack_grad_u_contact(
     int pair, std::shared_ptr<dolfinx::fem::Function<PetscScalar>> u)
+{
+  const std::size_t num_facets = _local_facets[_contact_pairs[pair].front()];
+  std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V
+      = u->function_space();
+  const auto cstride = int(num_q_points() * V->element()->block_size()
+                           * V->mesh()->geometry().dim());
+  std::vector<PetscScalar> c(num_facets * cstride);
+  pack_grad_u_contact(pair, u, c, strided_positions(num_facets, cstride));
+  return {std::move(c), cstride};
+}
+//-----------------------------------------------------------------------------------------------
+void dolfinx_contact::Contact::pack_grad_u_contact(
+    int pair, std::shared_ptr<dolfinx::fem::Function<PetscScalar>> u,
+    std::span<PetscScalar> c, std::span<const std::int32_t> positions)
 {
   auto [quadrature_mt, candidate_mt] = _contact_pairs[pair];
 
@@ -1449,13 +3003,16 @@ dolfinx_contact::Contact::pack_grad_u_contact(
   const std::size_t num_facets = _local_facets[quadrature_mt];
   const std::size_t num_q_points
       = _quadrature_rule->offset()[1] - _quadrature_rule->offset()[0];
-  // Output vector
-  const auto cstride = int(num_q_points * bs_element * gdim);
-  std::vector<PetscScalar> c(num_facets * cstride, 0.0);
+  // Clear output
+  const std::size_t cstride = num_q_points * bs_element * gdim;
+  if (positions.size() < num_facets)
+    throw std::invalid_argument("Missing positions of facet data.");
+  for (std::size_t i = 0; i < num_facets; ++i)
+    std::fill_n(std::next(c.begin(), positions[i]), cstride, 0.0);
 
   // return if no facets on process
   if (num_facets == 0)
-    return {std::move(c), cstride};
+    return;
 
   std::shared_ptr<const dolfinx::graph::AdjacencyList<int>> facet_map
       = _submesh.facet_map();
@@ -1519,7 +3076,7 @@ dolfinx_contact::Contact::pack_grad_u_contact(
           {
             for (std::size_t m = 0; m < value_size; ++m)
             {
-              c[cstride * i + q * bs_element * gdim + k * gdim + j]
+              c[positions[i] + q * bs_element * gdim + k * gdim + j]
                   += coefficients[bs_element * l + k]
                      * bvals(j + 1, num_q_points * i + q, l, m);
             }
@@ -1528,13 +3085,44 @@ dolfinx_contact::Contact::pack_grad_u_contact(
       }
     }
   }
-  return {std::move(c), cstride};
 }
 //-----------------------------------------------------------------------------------------------
 void dolfinx_contact::Contact::update_submesh_geometry(
     dolfinx::fem::Function<PetscScalar>& u)
 {
+  // Largest displacement of the submesh geometry, used to estimate the
+  // search radius
+  std::vector<double> x_old;
+  if (_automatic_radius)
+  {
+    std::span<const double> x = _submesh.mesh()->geometry().x();
+    x_old.assign(x.begin(), x.end());
+  }
+
   _submesh.update_geometry(u);
+
+  if (_automatic_radius)
+  {
+    std::span<const double> x = _submesh.mesh()->geometry().x();
+    double increment = 0;
+    for (std::size_t i = 0; i < x.size(); i += 3)
+    {
+      double norm = 0;
+      for (std::size_t k = 0; k < 3; ++k)
+        norm += (x[i + k] - x_old[i + k]) * (x[i + k] - x_old[i + k]);
+      increment = std::max(increment, norm);
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &increment, 1, MPI_DOUBLE, MPI_MAX,
+                  _mesh->comm());
+    for (auto& inc : _increments)
+      inc += std::sqrt(increment);
+  }
+
+  for (auto& tree : _search_trees)
+  {
+    if (tree)
+      tree->update(*_submesh.mesh());
+  }
 }
 
 //-----------------------------------------------------------------------------------------------
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include "CSRInsertionMap.h"
 #include "KernelData.h"
 #include "QuadratureRule.h"
 #include "SubMesh.h"
@@ -14,6 +15,7 @@
 #include "geometric_quantities.h"
 #include "meshtie_kernels.h"
 #include "utils.h"
+#include <atomic>
 #include <basix/cell.h>
 #include <basix/finite-element.h>
 #include <basix/quadrature.h>
@@ -21,9 +23,13 @@
 #include <dolfinx/geometry/BoundingBoxTree.h>
 #include <dolfinx/geometry/utils.h>
 #include <dolfinx/graph/AdjacencyList.h>
+#include <dolfinx/la/MatrixCSR.h>
+#include <dolfinx/la/SparsityPattern.h>
 #include <dolfinx/mesh/Mesh.h>
 #include <dolfinx/mesh/MeshTags.h>
 #include <dolfinx/mesh/cell_types.h>
+#include <optional>
+#include <tuple>
 
 using mat_set_fn = const std::function<int(
     const std::span<const std::int32_t>&, const std::span<const std::int32_t>&,
@@ -91,8 +97,41 @@ public:
   {
     return *std::max_element(_max_links.begin(), _max_links.end());
   }
-  // set search radius for ray-tracing
-  void set_search_radius(double r) { _radius = r; }
+  // set search radius for ray-tracing. Disables the automatic search radius
+  void set_search_radius(double r)
+  {
+    _radius = r;
+    _automatic_radius = false;
+  }
+
+  /// Set whether the search radius for ray-tracing is estimated for each
+  /// contact pair on every call to `create_distance_map`, see
+  /// `estimate_search_radius`
+  void set_automatic_search_radius(bool automatic)
+  {
+    _automatic_radius = automatic;
+  }
+
+  // return whether the search radius for ray-tracing is estimated
+  bool automatic_search_radius() const { return _automatic_radius; }
+
+  // return the search radius used in the last contact detection of a pair
+  double search_radius(int pair) const { return _pair_radius[pair]; }
+
+  // set number of threads used for contact detection and assembly
+  void set_num_threads(int num_threads) { _num_threads = num_threads; }
+
+  // return number of threads used for contact detection and assembly
+  int num_threads() const { return _num_threads; }
+
+  // set whether contact detection is seeded with the previous facet maps
+  void set_incremental_search(bool incremental)
+  {
+    _incremental_search = incremental;
+  }
+
+  // return whether contact detection is seeded with the previous facet maps
+  bool incremental_search() const { return _incremental_search; }
 
   /// return size of coefficients vector per facet on s
   /// @param[in] meshtie - Type of constraint,meshtie if true, unbiased contact
@@ -126,18 +165,47 @@ public:
     return _mesh;
   }
 
+  /// @brief Create the sparsity pattern of the input form and the coupling
+  /// of the contact interfaces
+  ///
+  /// @param[in] The bilinear form
+  /// @param[in] halo See `create_petsc_matrix`
+  /// @returns The finalized sparsity pattern
+  dolfinx::la::SparsityPattern
+  create_sparsity_pattern(const dolfinx::fem::Form<PetscScalar>& a,
+                          double halo = -1);
+
   /// @brief Create a PETSc matrix with contact sparsity pattern
   ///
   /// Create a PETSc matrix with the sparsity pattern of the input form and the
-  /// coupling contact interfaces
+  /// coupling contact interfaces, see `create_sparsity_pattern`
   ///
   /// @param[in] The bilinear form
   /// @param[in] The matrix type, see:
   /// https://petsc.org/main/docs/manualpages/Mat/MatType.html#MatType for
   /// available types
+  /// @param[in] halo If non-negative, each facet is also coupled to all
+  /// facets of the opposite surface within this distance of its quadrature
+  /// points, such that the matrix can be reused while the contact partners
+  /// stay within the halo, see `sparsity_pattern_fits`
   /// @returns Mat The PETSc matrix
+  /// @note The halo, like the contact detection, only contains the facets
+  /// of the opposite surface that are on the process (owned or ghosted).
+  /// Facets on other processes can not become contact partners without
+  /// redistributing the mesh, which requires a new matrix anyway
   Mat create_petsc_matrix(const dolfinx::fem::Form<PetscScalar>& a,
-                          const std::string& type);
+                          const std::string& type, double halo = -1);
+
+  /// @brief Check if the contact coupling of the current facet maps is
+  /// contained in the sparsity pattern last created by
+  /// `create_sparsity_pattern` or `create_petsc_matrix`
+  ///
+  /// The check compares the cells linked to each facet, and is collective.
+  /// As both the pattern and the facet maps are computed from the facets on
+  /// the process, each process only checks the coupling of its own facets.
+  /// @returns True if the matrix can be reused, false if it has to be
+  /// recreated
+  bool sparsity_pattern_fits() const;
 
   /// Assemble matrix over exterior facets (for contact facets)
   ///
@@ -149,9 +217,187 @@ public:
   /// facets
   /// @param[in] cstride Number of coefficients per facet
   /// @param[in] constants used in the variational form
+  /// @note If more than one thread is used (see `set_num_threads`), the
+  /// facets are coloured such that facets of the same colour (including their
+  /// linked cells) share no degrees of freedom, and each colour is assembled
+  /// concurrently. `mat_set` is then called from several threads and must
+  /// be thread-safe.
+  void
+  assemble_matrix(const mat_set_fn& mat_set, int pair,
+                  const kernel_fn<PetscScalar>& kernel,
+                  const std::span<const PetscScalar> coeffs, int cstride,
+                  const std::span<const PetscScalar>& constants,
+                  std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V);
+
+  /// Assemble matrix over exterior facets (for contact facets) with
+  /// coefficients in the ragged layout
+  ///
+  /// @param[in] mat_set the function for setting the values in the matrix
+  /// @param[in] pair index of contact pair
+  /// @param[in] kernel The integration kernel
+  /// @param[in] coeffs coefficients used in the variational form packed on
+  /// facets
+  /// @param[in] coeff_offsets The coefficients of the ith facet are
+  /// `coeffs[coeff_offsets[i]:coeff_offsets[i+1]]`
+  /// @param[in] constants used in the variational form
+  /// @note See `assemble_matrix` for multi-threaded assembly
   void
   assemble_matrix(const mat_set_fn& mat_set, int pair,
                   const kernel_fn<PetscScalar>& kernel,
+                  const std::span<const PetscScalar> coeffs,
+                  std::span<const std::int32_t> coeff_offsets,
+                  const std::span<const PetscScalar>& constants,
+                  std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V);
+
+  /// Assemble matrix over exterior facets (for contact facets) with a
+  /// batched kernel, see `generate_batched_kernel`
+  ///
+  /// @param[in] mat_set the function for setting the values in the matrix
+  /// @param[in] pair index of contact pair
+  /// @param[in] kernel The batched integration kernel
+  /// @param[in] coeffs coefficients used in the variational form packed on
+  /// facets
+  /// @param[in] cstride Number of coefficients per facet
+  /// @param[in] constants used in the variational form
+  /// @note See `assemble_matrix` for multi-threaded assembly. The facets of
+  /// a colour are passed to the kernel in batches within the chunk of each
+  /// thread
+  void
+  assemble_matrix(const mat_set_fn& mat_set, int pair,
+                  const batched_kernel_fn<PetscScalar>& kernel,
+                  const std::span<const PetscScalar> coeffs, int cstride,
+                  const std::span<const PetscScalar>& constants,
+                  std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V);
+
+  /// Apply the contact Jacobian to a vector, y += A x, without forming the
+  /// matrix
+  ///
+  /// The entries of `x` on the cell of each facet and its linked cells are
+  /// gathered and passed to the action kernel, and the element vectors it
+  /// computes are added to `y` as in `assemble_vector`.
+  /// @param[in] x The vector to apply the matrix to, including ghost entries
+  /// @param[in,out] y The vector to add the result to, including ghost
+  /// entries. The contributions to the ghost entries have to be added to
+  /// the owning processes afterwards
+  /// @param[in] pair index of contact pair
+  /// @param[in] kernel The action kernel, see `generate_action_kernel`
+  /// @param[in] coeffs coefficients used in the variational form packed on
+  /// facets
+  /// @param[in] cstride Number of coefficients per facet
+  /// @param[in] constants used in the variational form
+  /// @note See `assemble_matrix` for multi-threaded assembly
+  void
+  apply_matrix(std::span<const PetscScalar> x, std::span<PetscScalar> y,
+               int pair, const action_kernel_fn<PetscScalar>& kernel,
+               const std::span<const PetscScalar> coeffs, int cstride,
+               const std::span<const PetscScalar>& constants,
+               std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V);
+
+  /// @brief Compute the positions of the contact element matrices of a
+  /// contact pair in the values of a PETSc AIJ matrix
+  ///
+  /// @param[in] pair index of contact pair
+  /// @param[in] A The matrix. It has to be assembled at least once after the
+  /// contact coupling of the current facet map has been inserted, see
+  /// `create_petsc_matrix`
+  /// @param[in] V The function space
+  /// @returns The insertion map. It is valid until the facet map of the pair
+  /// or the sparsity pattern of the matrix changes, see
+  /// `insertion_map_valid`
+  CSRInsertionMap create_insertion_map(
+      int pair, Mat A,
+      std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V) const;
+
+  /// @brief Compute the positions of the contact element matrices of a
+  /// contact pair in the values of a CSR matrix
+  ///
+  /// @param[in] pair index of contact pair
+  /// @param[in] A The matrix, with a sparsity pattern containing the contact
+  /// coupling of the current facet map, see `create_sparsity_pattern`
+  /// @param[in] V The function space
+  /// @returns The insertion map. It is valid for `A` until the facet map of
+  /// the pair changes
+  CSRInsertionMap create_insertion_map(
+      int pair, const dolfinx::la::MatrixCSR<PetscScalar>& A,
+      std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V) const;
+
+  /// Check if an insertion map can be used to assemble a contact pair into a
+  /// PETSc matrix, i.e. if it was created for the matrix and neither the
+  /// facet map of the pair nor the sparsity pattern of the matrix has
+  /// changed since. The latter is checked with the nonzero state of the
+  /// matrix (`MatGetNonzeroState`), so the check does not depend on the size
+  /// of the matrix
+  /// @param[in] pair index of contact pair
+  /// @param[in] insertion_map The insertion map
+  /// @param[in] A The matrix
+  bool insertion_map_valid(int pair, const CSRInsertionMap& insertion_map,
+                           Mat A) const;
+
+  /// Check if an insertion map can be used to assemble a contact pair into a
+  /// CSR matrix, i.e. if it was created for the matrix and the facet map of
+  /// the pair has not changed since. The sparsity pattern of a CSR matrix is
+  /// fixed, so the matrix is identified by the storage of its pattern
+  /// @param[in] pair index of contact pair
+  /// @param[in] insertion_map The insertion map
+  /// @param[in] A The matrix
+  bool
+  insertion_map_valid(int pair, const CSRInsertionMap& insertion_map,
+                      const dolfinx::la::MatrixCSR<PetscScalar>& A) const;
+
+  /// Assemble matrix over exterior facets (for contact facets), adding the
+  /// element matrices directly to the values of a PETSc AIJ matrix
+  ///
+  /// @param[in] A The matrix
+  /// @param[in] insertion_map The positions of the element matrices in the
+  /// values of `A`, see `create_insertion_map`
+  /// @param[in] mat_set the function for setting the values in the matrix,
+  /// used for blocks with rows owned by other processes
+  /// @param[in] pair index of contact pair
+  /// @param[in] kernel The integration kernel
+  /// @param[in] coeffs coefficients used in the variational form packed on
+  /// facets
+  /// @param[in] cstride Number of coefficients per facet
+  /// @param[in] constants used in the variational form
+  /// @note The matrix has to be assembled (`MatAssemblyBegin/End`)
+  /// afterwards, as for `assemble_matrix` with `mat_set` only
+  void
+  assemble_matrix(Mat A, const CSRInsertionMap& insertion_map,
+                  const mat_set_fn& mat_set, int pair,
+                  const kernel_fn<PetscScalar>& kernel,
+                  const std::span<const PetscScalar> coeffs, int cstride,
+                  const std::span<const PetscScalar>& constants,
+                  std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V);
+
+  /// Assemble matrix over exterior facets (for contact facets), adding the
+  /// element matrices directly to the values of a CSR matrix
+  ///
+  /// @param[in] A The matrix
+  /// @param[in] insertion_map The positions of the element matrices in the
+  /// values of `A`, see `create_insertion_map`
+  /// @param[in] pair index of contact pair
+  /// @param[in] kernel The integration kernel
+  /// @param[in] coeffs coefficients used in the variational form packed on
+  /// facets
+  /// @param[in] cstride Number of coefficients per facet
+  /// @param[in] constants used in the variational form
+  /// @note All rows of the matrix, including the ghost rows, are stored on
+  /// the process. The ghost rows have to be scattered to their owners
+  /// afterwards (`MatrixCSR::scatter_rev`)
+  void
+  assemble_matrix(dolfinx::la::MatrixCSR<PetscScalar>& A,
+                  const CSRInsertionMap& insertion_map, int pair,
+                  const kernel_fn<PetscScalar>& kernel,
+                  const std::span<const PetscScalar> coeffs, int cstride,
+                  const std::span<const PetscScalar>& constants,
+                  std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V);
+
+  /// Assemble matrix over exterior facets (for contact facets) with a
+  /// batched kernel, adding the element matrices directly to the values of
+  /// a PETSc AIJ matrix, see the overload with a per-facet kernel
+  void
+  assemble_matrix(Mat A, const CSRInsertionMap& insertion_map,
+                  const mat_set_fn& mat_set, int pair,
+                  const batched_kernel_fn<PetscScalar>& kernel,
                   const std::span<const PetscScalar> coeffs, int cstride,
                   const std::span<const PetscScalar>& constants,
                   std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V);
@@ -164,6 +410,8 @@ public:
   /// facets
   /// @param[in] cstride Number of coefficients per facet
   /// @param[in] constants used in the variational form
+  /// @note If more than one thread is used (see `set_num_threads`), facets
+  /// sharing no degrees of freedom are assembled concurrently
   void
   assemble_vector(std::span<PetscScalar> b, int pair,
                   const kernel_fn<PetscScalar>& kernel,
@@ -171,6 +419,96 @@ public:
                   const std::span<const PetscScalar>& constants,
                   std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V);
 
+  /// Assemble vector over exterior facet (for contact facets) with
+  /// coefficients in the ragged layout
+  /// @param[in] b The vector
+  /// @param[in] pair index of contact pair
+  /// @param[in] kernel The integration kernel
+  /// @param[in] coeffs coefficients used in the variational form packed on
+  /// facets
+  /// @param[in] coeff_offsets The coefficients of the ith facet are
+  /// `coeffs[coeff_offsets[i]:coeff_offsets[i+1]]`
+  /// @param[in] constants used in the variational form
+  void
+  assemble_vector(std::span<PetscScalar> b, int pair,
+                  const kernel_fn<PetscScalar>& kernel,
+                  const std::span<const PetscScalar>& coeffs,
+                  std::span<const std::int32_t> coeff_offsets,
+                  const std::span<const PetscScalar>& constants,
+                  std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V);
+
+  /// Assemble vector over exterior facet (for contact facets) with a
+  /// batched kernel, see `generate_batched_kernel`
+  /// @param[in] b The vector
+  /// @param[in] pair index of contact pair
+  /// @param[in] kernel The batched integration kernel
+  /// @param[in] coeffs coefficients used in the variational form packed on
+  /// facets
+  /// @param[in] cstride Number of coefficients per facet
+  /// @param[in] constants used in the variational form
+  void
+  assemble_vector(std::span<PetscScalar> b, int pair,
+                  const batched_kernel_fn<PetscScalar>& kernel,
+                  const std::span<const PetscScalar>& coeffs, int cstride,
+                  const std::span<const PetscScalar>& constants,
+                  std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V);
+
+  /// Assemble vector and matrix over exterior facets (for contact facets)
+  /// in one pass
+  ///
+  /// Each facet, its geometry and its linked cells are visited once, and the
+  /// element vectors and matrices computed by the kernel are added to `b`
+  /// and through `mat_set`, as in `assemble_vector` and `assemble_matrix`.
+  /// @param[in] mat_set the function for setting the values in the matrix
+  /// @param[in,out] b The vector
+  /// @param[in] pair index of contact pair
+  /// @param[in] kernel The integration kernel, see
+  /// `generate_system_kernel`
+  /// @param[in] coeffs coefficients used in the variational form packed on
+  /// facets
+  /// @param[in] cstride Number of coefficients per facet
+  /// @param[in] constants used in the variational form
+  /// @note See `assemble_matrix` for multi-threaded assembly
+  void
+  assemble_system(const mat_set_fn& mat_set, std::span<PetscScalar> b,
+                  int pair, const system_kernel_fn<PetscScalar>& kernel,
+                  const std::span<const PetscScalar>& coeffs, int cstride,
+                  const std::span<const PetscScalar>& constants,
+                  std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V);
+
+  /// Assemble vector and matrix over exterior facets (for contact facets)
+  /// in one pass with coefficients in the ragged layout, see
+  /// `assemble_system`
+  ///
+  /// @param[in] mat_set the function for setting the values in the matrix
+  /// @param[in,out] b The vector
+  /// @param[in] pair index of contact pair
+  /// @param[in] kernel The integration kernel
+  /// @param[in] coeffs coefficients used in the variational form packed on
+  /// facets
+  /// @param[in] coeff_offsets The coefficients of the ith facet are
+  /// `coeffs[coeff_offsets[i]:coeff_offsets[i+1]]`
+  /// @param[in] constants used in the variational form
+  void
+  assemble_system(const mat_set_fn& mat_set, std::span<PetscScalar> b,
+                  int pair, const system_kernel_fn<PetscScalar>& kernel,
+                  const std::span<const PetscScalar>& coeffs,
+                  std::span<const std::int32_t> coeff_offsets,
+                  const std::span<const PetscScalar>& constants,
+                  std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V);
+
+  /// Assemble vector and matrix over exterior facets (for contact facets)
+  /// in one pass, adding the element matrices directly to the values of a
+  /// PETSc AIJ matrix, see `assemble_system` and the `assemble_matrix`
+  /// overload with an insertion map
+  void
+  assemble_system(Mat A, const CSRInsertionMap& insertion_map,
+                  const mat_set_fn& mat_set, std::span<PetscScalar> b,
+                  int pair, const system_kernel_fn<PetscScalar>& kernel,
+                  const std::span<const PetscScalar>& coeffs, int cstride,
+                  const std::span<const PetscScalar>& constants,
+                  std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V);
+
   /// @brief Generate contact kernel
   ///
   /// The kernel will expect input on the form
@@ -191,6 +529,39 @@ public:
   generate_kernel(Kernel type,
                   std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V);
 
+  /// @brief Generate contact kernel computing the residual and the Jacobian
+  /// in one pass, see `assemble_system`
+  ///
+  /// @param[in] type The kernel type (`System`, `TrescaSystem` or
+  /// `CoulombSystem`). The friction kernels include the frictionless terms,
+  /// see `generate_contact_system_kernel`
+  /// @param[in] V The function space
+  system_kernel_fn<PetscScalar> generate_system_kernel(
+      Kernel type,
+      std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V);
+
+  /// @brief Generate contact kernel applying the Jacobian to a vector, see
+  /// `apply_matrix`
+  ///
+  /// @param[in] type The kernel type (`System`, `TrescaSystem` or
+  /// `CoulombSystem`). The kernel applies the Jacobian computed by the
+  /// system kernel of the same type, see `generate_contact_action_kernel`
+  /// @param[in] V The function space
+  action_kernel_fn<PetscScalar> generate_action_kernel(
+      Kernel type,
+      std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V);
+
+  /// @brief Generate contact kernel evaluating several facets at once
+  ///
+  /// @param[in] type The kernel type (`Rhs` or `Jac`)
+  /// @param[in] V The function space
+  /// @returns The kernel, or an empty function if there is no batched kernel
+  /// for the element, see `generate_batched_contact_kernel`. The kernel
+  /// expects the coefficients of `generate_kernel`
+  batched_kernel_fn<PetscScalar> generate_batched_kernel(
+      Kernel type,
+      std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V);
+
   /// Compute push forward of quadrature points _qp_ref_facet to the
   /// physical facet for each facet in _facet_"origin_meshtag" Creates and
   /// fills _qp_phys_"origin_meshtag"
@@ -210,6 +581,12 @@ public:
   /// _qp_phys, _phi_ref_facets
   void create_distance_map(int pair);
 
+  /// Compute the distance maps of all contact pairs, see
+  /// `create_distance_map`
+  /// @note If more than one thread is used (see `set_num_threads`), the
+  /// contact pairs are processed concurrently, see `for_each_pair`
+  void create_distance_maps();
+
   /// Compute and pack the gap function for each quadrature point the set of
   /// facets. For a set of facets; go through the quadrature points on each
   /// facet find the closest facet on the other surface and compute the
@@ -228,6 +605,17 @@ public:
   std::pair<std::vector<PetscScalar>, int> pack_test_functions(
       int pair, std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V);
 
+  /// Compute test functions on opposite surface at quadrature points of
+  /// facets, only storing the test functions of the cells linked to each
+  /// facet (ragged layout)
+  /// @param[in] pair - index of contact pair
+  /// @param[in] V - the function space
+  /// @returns (c, offsets) - test functions packed on facets. The test
+  /// functions of the ith facet are stored in `c[offsets[i]:offsets[i+1]]`
+  std::pair<std::vector<PetscScalar>, std::vector<std::int32_t>>
+  pack_test_functions_ragged(
+      int pair, std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V);
+
   /// Compute gradient of test functions on opposite surface (initial
   /// configuration) at quadrature points of facets
   /// @param[in] pair - index of contact pair
@@ -235,6 +623,16 @@ public:
   std::pair<std::vector<PetscScalar>, int> pack_grad_test_functions(
       int pair, std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V);
 
+  /// Compute gradient of test functions on opposite surface (initial
+  /// configuration) at quadrature points of facets in the ragged layout, see
+  /// `pack_test_functions_ragged`
+  /// @param[in] pair - index of contact pair
+  /// @param[in] V - the function space
+  /// @returns (c, offsets) - gradients packed on facets
+  std::pair<std::vector<PetscScalar>, std::vector<std::int32_t>>
+  pack_grad_test_functions_ragged(
+      int pair, std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V);
+
   /// Remove points from facet map with a distance larger than tol
   /// in the surface or if the angle of distance vector and opposite surface is
   /// too large
@@ -254,6 +652,18 @@ public:
   pack_u_contact(int pair,
                  std::shared_ptr<dolfinx::fem::Function<PetscScalar>> u);
 
+  /// Compute function on opposite surface at quadrature points of facets
+  /// and write it directly into a coefficient array
+  /// @param[in] pair - index of contact pair
+  /// @param[in] u - the function
+  /// @param[in,out] c - the coefficient array. The values on the ith facet
+  /// are written to `c[positions[i]:positions[i] + num_q_points * bs]`
+  /// @param[in] positions - the position of the data of each facet
+  void pack_u_contact(int pair,
+                      std::shared_ptr<dolfinx::fem::Function<PetscScalar>> u,
+                      std::span<PetscScalar> c,
+                      std::span<const std::int32_t> positions);
+
   /// Compute gradient of function on opposite surface at quadrature points of
   /// facets
   /// @param[in] pair - index of contact pair
@@ -262,6 +672,20 @@ public:
   pack_grad_u_contact(int pair,
                       std::shared_ptr<dolfinx::fem::Function<PetscScalar>> u);
 
+  /// Compute gradient of function on opposite surface at quadrature points
+  /// of facets and write it directly into a coefficient array
+  /// @param[in] pair - index of contact pair
+  /// @param[in] u - the function
+  /// @param[in,out] c - the coefficient array. The values on the ith facet
+  /// are written to `c[positions[i]:positions[i] + num_q_points * bs *
+  /// gdim]`
+  /// @param[in] positions - the position of the data of each facet
+  void
+  pack_grad_u_contact(int pair,
+                      std::shared_ptr<dolfinx::fem::Function<PetscScalar>> u,
+                      std::span<PetscScalar> c,
+                      std::span<const std::int32_t> positions);
+
   /// Compute outward surface normal at x
   /// @param[in] pair - index of contact pair
   /// @returns c - (normals, cstride) ny packed on facets.
@@ -281,8 +705,30 @@ public:
   /// jth component of the Gap on the ith facet at kth quadrature point
   std::pair<std::vector<PetscScalar>, int> pack_gap_plane(int pair, double g);
 
+  /// Pack the gap, the contact normals and the test functions on the
+  /// opposite surface in a single pass over the facets and quadrature
+  /// points, directly into the coefficient layout of the contact kernels.
+  /// The normal is -n_x for pairs using ray-tracing and n_y otherwise.
+  /// @param[in] pair - index of contact pair
+  /// @param[in] V - the function space of the test functions
+  /// @param[in,out] c - the coefficients of the ith facet are
+  /// `c[i*cstride:(i+1)*cstride]`
+  /// @param[in] cstride - number of coefficients per facet
+  /// @param[in] offset - position of the gap within the coefficients of a
+  /// facet. The gap is followed by the normals and the test functions
+  /// (padded to `max_links` linked cells) in the same layout as returned
+  /// by `pack_gap`, `pack_nx`/`pack_ny` and `pack_test_functions`
+  /// @note The coefficients stay padded to `max_links`, as the Python
+  /// `ContactProblem` updates them column-wise in place. Use
+  /// `pack_test_functions_ragged` with the `assemble_*` overloads taking
+  /// coefficient offsets for the ragged layout
+  void pack_contact_data(
+      int pair, std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+      std::span<PetscScalar> c, std::size_t cstride, std::size_t offset);
+
   /// This function updates the submesh geometry for all submeshes using
-  /// a function given on the parent mesh
+  /// a function given on the parent mesh. The search trees of the surfaces
+  /// are refitted to the new geometry
   /// @param[in] u - displacement
   void update_submesh_geometry(dolfinx::fem::Function<PetscScalar>& u);
 
@@ -290,7 +736,256 @@ public:
   /// Assumes all facets are identical
   std::size_t num_q_points() const;
 
+protected:
+  /// @brief Process contact pairs concurrently
+  ///
+  /// The threads set by `set_num_threads` are shared by the pairs. Each
+  /// thread processes the next unprocessed pair until all pairs are done.
+  /// Threads left over when there are fewer pairs than threads are
+  /// distributed over the pairs and used within them.
+  /// @param[in] num_pairs The number of pairs
+  /// @param[in] f Function called as `f(thread, pair, num_threads)` for
+  /// each pair, where `thread < min(num_pairs, num_threads())` is the index
+  /// of the calling thread and `num_threads` the number of threads to use
+  /// for the pair
+  template <typename F>
+  void for_each_pair(std::size_t num_pairs, F&& f) const
+  {
+    const std::size_t num_threads = std::max(_num_threads, 1);
+    const std::size_t nt = std::min(num_pairs, num_threads);
+
+    // The first num_threads % num_pairs pairs get one of the remaining
+    // threads each
+    auto pair_threads = [num_pairs, num_threads](std::size_t p)
+    {
+      if (num_pairs >= num_threads)
+        return 1;
+      return (int)(num_threads / num_pairs
+                   + (p < num_threads % num_pairs ? 1 : 0));
+    };
+
+    // Pairs differ in size, so they are handed out one at a time
+    std::atomic<std::size_t> next = 0;
+    parallel_for(nt, (int)nt,
+                 [&](std::size_t t, std::size_t, std::size_t)
+                 {
+                   for (std::size_t p = next++; p < num_pairs; p = next++)
+                     f(t, (int)p, pair_threads(p));
+                 });
+  }
+
+  /// Geometry, coefficients and element tensors of a batch of facets of a
+  /// contact pair, see `assemble_pair`
+  struct FacetBatch
+  {
+    /// Index of the thread assembling the batch
+    std::size_t thread;
+    /// The facets (position in the active facets of the pair)
+    std::span<const std::int32_t> facets;
+    /// Coefficients of each facet
+    std::span<const std::span<const PetscScalar>> coeffs;
+    /// Coordinate dofs of the cell of each facet, shape (num_facets,
+    /// num_dofs_g, 3)
+    std::span<const double> coordinate_dofs;
+    /// Local index of each facet in its cell
+    std::span<const std::size_t> facet_indices;
+    /// Number of cells linked to each facet
+    std::span<const std::size_t> num_links;
+    /// Quadrature points of each facet with a linked facet on the other
+    /// surface
+    std::span<const std::vector<std::int32_t>> q_indices;
+    /// Element matrices of each facet, see `kernel_fn`. The blocks of the
+    /// linked cells are zero
+    std::span<std::vector<std::vector<PetscScalar>>> Ae;
+    /// Element vectors of each facet, zeroed as `Ae`
+    std::span<std::vector<std::vector<PetscScalar>>> be;
+    /// Entries of the input vector on the cell of each facet followed by
+    /// the entries on each linked cell, see `PairTargets::x`
+    std::span<const std::vector<PetscScalar>> xe;
+    /// Scratch memory of the thread for per-facet kernels
+    KernelWorkspace& workspace;
+  };
+
+  /// The matrix and vector `assemble_pair` adds the element tensors to
+  struct PairTargets
+  {
+    /// Function for setting the values in the matrix, null if no element
+    /// matrices are computed
+    const mat_set_fn* mat_set = nullptr;
+    /// If not null, the blocks the insertion map has positions for are
+    /// added directly to the value arrays `values` of the matrix, and only
+    /// the remaining blocks are passed to `mat_set`
+    const CSRInsertionMap* insertion_map = nullptr;
+    std::array<std::span<PetscScalar>, 2> values = {};
+    /// The vector, if element vectors are computed
+    std::optional<std::span<PetscScalar>> b;
+    /// A vector (including ghost entries) to gather on the cells of each
+    /// facet, if the element tensors depend on it
+    std::optional<std::span<const PetscScalar>> x;
+  };
+
+  /// @brief Assemble the contributions of a contact pair
+  ///
+  /// Visits the facets of the pair in batches of up to `batch_size` facets.
+  /// For each batch the geometry, coefficients and quadrature points are
+  /// gathered and the element tensors zeroed, `compute` is called and the
+  /// element tensors are added to `targets`. With more than one thread, the
+  /// facets are coloured (see `assemble_matrix`) and the batches are formed
+  /// within the facets of a colour handled by each thread.
+  /// @param[in] pair index of contact pair
+  /// @param[in] V The function space
+  /// @param[in] coeffs coefficients used in the variational form packed on
+  /// facets
+  /// @param[in] coeff_offsets The coefficients of the ith facet are
+  /// `coeffs[coeff_offsets[i]:coeff_offsets[i+1]]`
+  /// @param[in] batch_size The maximum number of facets in a batch
+  /// @param[in] num_threads The number of threads
+  /// @param[in] targets Where the element tensors are added
+  /// @param[in] compute Function computing the element tensors of a batch
+  void
+  assemble_pair(int pair,
+                std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+                std::span<const PetscScalar> coeffs,
+                std::span<const std::int32_t> coeff_offsets,
+                std::size_t batch_size, int num_threads,
+                const PairTargets& targets,
+                const std::function<void(FacetBatch&)>& compute);
+
+  /// Assemble matrix contributions of a contact pair with a given number of
+  /// threads, see `assemble_matrix`. If an insertion map is given, the blocks
+  /// it has positions for are added directly to the value arrays `values`
+  /// of the matrix, and only the remaining blocks are passed to `mat_set`
+  void assemble_pair_matrix(
+      const mat_set_fn& mat_set, int pair,
+      const kernel_fn<PetscScalar>& kernel,
+      const std::span<const PetscScalar> coeffs,
+      std::span<const std::int32_t> coeff_offsets,
+      const std::span<const PetscScalar>& constants,
+      std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+      int num_threads, const CSRInsertionMap* insertion_map = nullptr,
+      std::array<std::span<PetscScalar>, 2> values = {});
+
+  /// Assemble matrix contributions of a contact pair with a batched kernel,
+  /// see `assemble_pair_matrix` and `batched_kernel_fn`. The facets are
+  /// passed to the kernel in batches of `kernel_batch_size`.
+  void assemble_pair_matrix_batched(
+      const mat_set_fn& mat_set, int pair,
+      const batched_kernel_fn<PetscScalar>& kernel,
+      const std::span<const PetscScalar> coeffs,
+      std::span<const std::int32_t> coeff_offsets,
+      const std::span<const PetscScalar>& constants,
+      std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+      int num_threads, const CSRInsertionMap* insertion_map = nullptr,
+      std::array<std::span<PetscScalar>, 2> values = {});
+
+  /// Assemble vector contributions of a contact pair with a given number of
+  /// threads, see `assemble_vector`
+  void assemble_pair_vector(
+      std::span<PetscScalar> b, int pair, const kernel_fn<PetscScalar>& kernel,
+      const std::span<const PetscScalar>& coeffs,
+      std::span<const std::int32_t> coeff_offsets,
+      const std::span<const PetscScalar>& constants,
+      std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+      int num_threads);
+
+  /// Assemble vector and matrix contributions of a contact pair in one pass
+  /// with a given number of threads, see `assemble_system` and
+  /// `assemble_pair_matrix`
+  void assemble_pair_system(
+      const mat_set_fn& mat_set, std::span<PetscScalar> b, int pair,
+      const system_kernel_fn<PetscScalar>& kernel,
+      const std::span<const PetscScalar>& coeffs,
+      std::span<const std::int32_t> coeff_offsets,
+      const std::span<const PetscScalar>& constants,
+      std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+      int num_threads, const CSRInsertionMap* insertion_map = nullptr,
+      std::array<std::span<PetscScalar>, 2> values = {});
+
+  /// Assemble vector contributions of a contact pair with a batched kernel,
+  /// see `assemble_pair_vector` and `assemble_pair_matrix_batched`
+  void assemble_pair_vector_batched(
+      std::span<PetscScalar> b, int pair,
+      const batched_kernel_fn<PetscScalar>& kernel,
+      const std::span<const PetscScalar>& coeffs,
+      std::span<const std::int32_t> coeff_offsets,
+      const std::span<const PetscScalar>& constants,
+      std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+      int num_threads);
+
 private:
+  /// Create the data of a contact pair that is shared with other pairs:
+  /// the search tree of the candidate surface, the tabulated coordinate
+  /// element and the physical quadrature points of the quadrature surface.
+  /// Also sets the search radius of the pair
+  /// @param[in] pair - index of contact pair
+  /// @note Collective if the search radius is estimated
+  void prepare_distance_map(int pair);
+
+  /// Compute the distance map of a contact pair. Only data of the pair is
+  /// modified, such that different pairs can be processed concurrently
+  /// after `prepare_distance_map`. The largest gap of the pair is the
+  /// largest gap on this process, see `reduce_max_gaps`
+  /// @param[in] pair - index of contact pair
+  /// @param[in] num_threads - number of threads used for the search
+  /// @note Not collective
+  void compute_pair_distance_map(int pair, int num_threads);
+
+  /// Take the maximum of the largest gaps of contact pairs over all
+  /// processes, if the search radius is estimated
+  /// @param[in,out] max_gaps - the largest gaps, entries of `_max_gap`
+  /// @note Collective
+  void reduce_max_gaps(std::span<double> max_gaps);
+
+  /// Compute the insertion map of a contact pair, see
+  /// `create_insertion_map`
+  /// @param[in] pair - index of contact pair
+  /// @param[in] V - the function space
+  /// @param[in] offset - function returning the position of the entry
+  /// (row, col) in the values of the matrix, where the rows and columns are
+  /// unrolled local degrees of freedom. Returns -1 if the row is not stored
+  /// on the process, and throws if the entry is not in the sparsity pattern
+  /// @param[in] num_values - number of values in each value array of the
+  /// matrix
+  /// @param[in] pattern_state - identifier and sparsity pattern state of
+  /// the matrix
+  /// @param[in] pattern - hash of the sparsity pattern of the matrix
+  CSRInsertionMap create_insertion_map(
+      int pair, std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+      const std::function<std::int64_t(std::int32_t, std::int32_t)>& offset,
+      std::array<std::int64_t, 2> num_values,
+      std::array<std::int64_t, 2> pattern_state, std::uint64_t pattern) const;
+
+  /// Pack (gradients of) test functions on opposite surface
+  /// @param[in] pair - index of contact pair
+  /// @param[in] V - the function space
+  /// @param[in] ragged - if false the values of each facet are padded to
+  /// `max_links` linked cells
+  /// @returns (c, offsets, block_size) where the values of the ith facet are
+  /// stored in `c[offsets[i]:offsets[i+1]]`, and block_size is the number of
+  /// values per linked cell
+  std::tuple<std::vector<PetscScalar>, std::vector<std::int32_t>, std::size_t>
+  pack_test_functions(
+      int pair, std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+      bool ragged);
+  std::tuple<std::vector<PetscScalar>, std::vector<std::int32_t>, std::size_t>
+  pack_grad_test_functions(
+      int pair, std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+      bool ragged);
+
+  /// Estimate the search radius for ray-tracing of a contact pair from the
+  /// largest gap found by the previous search, the displacement of the
+  /// submesh since then and the size of the facets on both surfaces
+  /// @param[in] pair - index of contact pair
+  /// @param[in] quadrature_facets - (cell, local_facet) pairs of the
+  /// quadrature facets on the submesh. Flattened row-major
+  /// @param[in] candidate_facets - (cell, local_facet) pairs of the
+  /// candidate facets on the submesh. Flattened row-major
+  /// @returns The search radius, or -1 if there is no previous search
+  /// @note Collective. The radius is the same on all processes
+  double estimate_search_radius(int pair,
+                                std::span<const std::int32_t> quadrature_facets,
+                                std::span<const std::int32_t> candidate_facets);
+
   std::shared_ptr<QuadratureRule> _quadrature_rule; // quadrature rule
   std::vector<int> _surfaces; // meshtag values for surfaces
   // store index of candidate_surface for each quadrature_surface
@@ -329,5 +1024,24 @@ private:
   std::vector<ContactMode> _mode;
   // Search radius for ray-tracing
   double _radius = -1;
+  // Estimate the search radius for each pair on every contact detection
+  bool _automatic_radius = false;
+  // Search radius used in the last contact detection of each pair
+  std::vector<double> _pair_radius;
+  // Largest gap found by the last contact detection of each pair (-1 if
+  // unknown), and the largest displacement of the submesh since then
+  std::vector<double> _max_gap;
+  std::vector<double> _increments;
+  // Number of threads used for contact detection
+  int _num_threads = 1;
+  // Seed contact detection with the previous facet maps
+  bool _incremental_search = false;
+  // Closest point search tree over the facets of each surface
+  std::vector<std::shared_ptr<FacetTree>> _search_trees;
+  // Cells on the parent mesh coupled to each facet of each pair in the
+  // sparsity pattern of the last matrix created
+  std::vector<
+      std::shared_ptr<const dolfinx::graph::AdjacencyList<std::int32_t>>>
+      _pattern_cells;
 };
 } // namespace dolfinx_contact
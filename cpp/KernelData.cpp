@@ -65,10 +65,16 @@ dolfinx_contact::KernelData::KernelData(
   cmap.tabulate(1, q_points, {num_quadrature_pts, _tdim}, _c_basis_values);
 
   // Create offsets from cstrides
+  if (cstrides.size() + 1 > max_offsets)
+  {
+    throw std::invalid_argument(
+        "Number of coefficients exceeds KernelData::max_offsets.");
+  }
   _offsets.resize(cstrides.size() + 1);
   _offsets[0] = 0;
   std::partial_sum(cstrides.cbegin(), cstrides.cend(),
                    std::next(_offsets.begin()));
+  _link_block_sizes.assign(cstrides.size(), 0);
 
   // As reference facet and reference cell are affine, we do not need to
   // compute this per quadrature point
@@ -122,7 +128,63 @@ dolfinx_contact::KernelData::weights(std::size_t i) const
                    _qp_offsets[i + 1] - _qp_offsets[i]);
 }
 //-----------------------------------------------------------------------------
+void dolfinx_contact::KernelData::set_link_coefficients(
+    std::size_t first, std::size_t last, std::size_t max_links)
+{
+  assert(first <= last and last < _offsets.size());
+  _link_coefficients = {first, last};
+  std::fill(_link_block_sizes.begin(), _link_block_sizes.end(), 0);
+  for (std::size_t i = first; i < last; ++i)
+  {
+    const std::size_t stride = _offsets[i + 1] - _offsets[i];
+    if (max_links == 0 ? stride != 0 : stride % max_links != 0)
+    {
+      throw std::invalid_argument(
+          "Coefficient stride is not a multiple of the number of links.");
+    }
+    _link_block_sizes[i] = max_links == 0 ? 0 : stride / max_links;
+  }
+}
+//-----------------------------------------------------------------------------
+void dolfinx_contact::KernelData::facet_offsets(
+    std::size_t num_links, std::size_t num_coeffs,
+    std::span<std::size_t> offsets) const
+{
+  assert(offsets.size() >= _offsets.size());
+  std::copy(_offsets.cbegin(), _offsets.cend(), offsets.begin());
+  if (num_coeffs == _offsets.back())
+    return;
+
+  // The linked cell blocks of the facet are stored ragged, with num_links
+  // blocks per link coefficient
+  for (std::size_t i = 0; i < _link_block_sizes.size(); ++i)
+  {
+    const bool linked
+        = i >= _link_coefficients[0] and i < _link_coefficients[1];
+    offsets[i + 1] = offsets[i]
+                     + (linked ? _link_block_sizes[i] * num_links
+                               : _offsets[i + 1] - _offsets[i]);
+  }
+  if (offsets[_offsets.size() - 1] != num_coeffs)
+  {
+    throw std::invalid_argument(
+        "Number of coefficients does not match the kernel data.");
+  }
+}
+//-----------------------------------------------------------------------------
 dolfinx_contact::cmdspan3_t dolfinx_contact::KernelData::ref_jacobians() const
 {
   return dolfinx_contact::cmdspan3_t(_ref_jacobians.data(), _jac_shape);
 }
+//-----------------------------------------------------------------------------
+dolfinx_contact::KernelWorkspace::KernelWorkspace(std::size_t ndofs_cell,
+                                                  std::size_t gdim,
+                                                  std::size_t max_links)
+    : _ndofs_cell(ndofs_cell), _gdim(gdim), _max_links(max_links),
+      _epsn(ndofs_cell * gdim), _tr(ndofs_cell * gdim), _sig_n_u(gdim),
+      _jump_u(gdim), _sig_n(ndofs_cell * gdim * gdim),
+      _sig_n_opp(max_links * ndofs_cell * gdim * gdim),
+      _test_fn_n((max_links + 2) * ndofs_cell * gdim),
+      _x_opp(max_links * (gdim + 1))
+{
+}
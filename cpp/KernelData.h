@@ -17,6 +17,7 @@
 #include <dolfinx/fem/utils.h>
 #include <dolfinx/mesh/Mesh.h>
 #include <dolfinx/mesh/MeshTags.h>
+#include <type_traits>
 
 namespace dolfinx_contact
 {
@@ -94,6 +95,33 @@ public:
 
   const std::vector<std::size_t>& offsets_array() const { return _offsets; }
 
+  /// @brief Mark the coefficients holding one block per linked cell
+  ///
+  /// The strides of the coefficients `first, ..., last - 1` are assumed to
+  /// be `max_links` times the size of a single block.
+  /// @param[in] first The first coefficient with linked cell blocks
+  /// @param[in] last One past the last coefficient with linked cell blocks
+  /// @param[in] max_links The maximum number of cells linked to a facet
+  void set_link_coefficients(std::size_t first, std::size_t last,
+                             std::size_t max_links);
+
+  /// @brief Compute the coefficient offsets of a single facet
+  ///
+  /// The linked cell blocks (see `set_link_coefficients`) of a facet are
+  /// either padded to `max_links` blocks, in which case the offsets are
+  /// `offsets_array()`, or stored ragged with only the blocks of the
+  /// `num_links` cells linked to the facet.
+  /// @param[in] num_links The number of cells linked to the facet
+  /// @param[in] num_coeffs The number of coefficients of the facet
+  /// @param[in,out] offsets The offsets of the coefficients of the facet.
+  /// Size at least `offsets_array().size()`, see `max_offsets`.
+  void facet_offsets(std::size_t num_links, std::size_t num_coeffs,
+                     std::span<std::size_t> offsets) const;
+
+  /// Upper bound of `offsets_array().size()`, such that kernels can hold the
+  /// offsets of a facet in a `std::array<std::size_t, max_offsets>`
+  static constexpr std::size_t max_offsets = 10;
+
   // Return reference facet normals
   cmdspan2_t facet_normals() const
   {
@@ -172,6 +200,11 @@ private:
                        // derivatives) at quadrature points
   std::array<std::size_t, 4> _c_basis_shape; // Shape of coordinate basis values
   std::vector<std::size_t> _offsets;         // the coefficient offsets
+  // Range of coefficients with one block per linked cell
+  std::array<std::size_t, 2> _link_coefficients = {0, 0};
+  // Size of a single linked cell block of each coefficient (zero for the
+  // coefficients without linked cell blocks)
+  std::vector<std::size_t> _link_block_sizes;
   std::vector<double> _ref_jacobians;
   std::array<std::size_t, 3> _jac_shape;
   std::vector<double> _facet_normals;
@@ -180,4 +213,152 @@ private:
   normal_fn _update_normal;
   std::vector<double> _q_weights;
 };
+
+/// Scratch memory used by the contact and meshtie kernels, such that calling
+/// a kernel does not allocate. The workspace is owned by the assembler and
+/// reused for all facets. Each thread calling a kernel needs its own
+/// workspace.
+class KernelWorkspace
+{
+public:
+  /// Create a workspace
+  ///@param[in] ndofs_cell The number of dofs (blocks) per cell
+  ///@param[in] gdim The geometrical dimension
+  ///@param[in] max_links The maximum number of cells linked to a facet
+  KernelWorkspace(std::size_t ndofs_cell, std::size_t gdim,
+                  std::size_t max_links);
+
+  /// Create a workspace for the kernels generated with the kernel data `kd`
+  ///@param[in] kd The kernel data
+  ///@param[in] max_links The maximum number of cells linked to a facet
+  KernelWorkspace(const KernelData& kd, std::size_t max_links)
+      : KernelWorkspace(kd.ndofs_cell(), kd.gdim(), max_links)
+  {
+  }
+
+  // Return number of dofs per cell the workspace is sized for
+  std::size_t ndofs_cell() const { return _ndofs_cell; }
+
+  // Return geometrical dimension the workspace is sized for
+  std::size_t gdim() const { return _gdim; }
+
+  // Return maximum number of linked cells the workspace is sized for
+  std::size_t max_links() const { return _max_links; }
+
+  // Storage for dot(eps(v)n_1, n_2) of each basis function, shape
+  // (ndofs_cell, gdim)
+  mdspan2_t epsn() { return mdspan2_t(_epsn.data(), _ndofs_cell, _gdim); }
+
+  // Storage for tr(eps(v)) of each basis function, shape (ndofs_cell, gdim)
+  mdspan2_t tr() { return mdspan2_t(_tr.data(), _ndofs_cell, _gdim); }
+
+  // Storage for sigma(u)n, size gdim
+  std::span<double> sig_n_u() { return _sig_n_u; }
+
+  // Storage for the jump of u, size gdim
+  std::span<double> jump_u() { return _jump_u; }
+
+  // Storage for sigma(v)n of each basis function, shape (ndofs_cell, gdim,
+  // gdim)
+  mdspan3_t sig_n()
+  {
+    return mdspan3_t(_sig_n.data(), _ndofs_cell, _gdim, _gdim);
+  }
+
+  // Storage for sigma(v)n of each basis function on the linked cells, shape
+  // (num_links, ndofs_cell, gdim, gdim)
+  mdspan4_t sig_n_opp(std::size_t num_links)
+  {
+    assert(num_links <= _max_links);
+    return mdspan4_t(_sig_n_opp.data(), num_links, _ndofs_cell, _gdim, _gdim);
+  }
+
+  // Storage for the normal terms of each test function that are reused
+  // between the residual and the Jacobian of a system kernel, shape
+  // (num_links + 2, ndofs_cell, gdim): sigma(v)n in the normal direction,
+  // the Nitsche term P_n(v), and the normal component of v on each linked
+  // cell
+  mdspan3_t test_fn_n(std::size_t num_links)
+  {
+    assert(num_links <= _max_links);
+    return mdspan3_t(_test_fn_n.data(), num_links + 2, _ndofs_cell, _gdim);
+  }
+
+  // Storage for the value and the normal component of a vector on each
+  // linked cell at a quadrature point, shape (num_links, gdim + 1)
+  mdspan2_t x_opp(std::size_t num_links)
+  {
+    assert(num_links <= _max_links);
+    return mdspan2_t(_x_opp.data(), num_links, _gdim + 1);
+  }
+
+private:
+  std::size_t _ndofs_cell;
+  std::size_t _gdim;
+  std::size_t _max_links;
+  std::vector<double> _epsn;
+  std::vector<double> _tr;
+  std::vector<double> _sig_n_u;
+  std::vector<double> _jump_u;
+  std::vector<double> _sig_n;
+  std::vector<double> _sig_n_opp;
+  std::vector<double> _test_fn_n;
+  std::vector<double> _x_opp;
+};
+
+/// @brief Call `f(gdim, ndofs)` with the dimensions of the function space as
+/// `std::integral_constant`s
+///
+/// For P1/P2 on triangles and tetrahedra and Q1 on hexahedra the dimensions
+/// are passed as compile time constants, otherwise both are zero. The number
+/// of quadrature points is left as a runtime quantity, as only the active
+/// points (`q_indices`) are visited by the kernels.
+template <typename F>
+auto dispatch_dimensions(const dolfinx::fem::FunctionSpace<double>& V, F&& f)
+{
+  std::shared_ptr<const dolfinx::mesh::Mesh<double>> mesh = V.mesh();
+  assert(mesh);
+  const std::size_t gdim = mesh->geometry().dim();
+  const std::size_t tdim = mesh->topology()->dim();
+  const std::size_t bs = V.dofmap()->bs();
+  const std::size_t ndofs_cell = V.dofmap()->element_dof_layout().num_dofs();
+  using std::integral_constant;
+  if (bs == gdim && tdim == gdim)
+  {
+    if (gdim == 2)
+    {
+      switch (ndofs_cell)
+      {
+      case 3:
+        return f(integral_constant<std::size_t, 2>(),
+                 integral_constant<std::size_t, 3>());
+      case 6:
+        return f(integral_constant<std::size_t, 2>(),
+                 integral_constant<std::size_t, 6>());
+      default:
+        break;
+      }
+    }
+    else if (gdim == 3)
+    {
+      switch (ndofs_cell)
+      {
+      case 4:
+        return f(integral_constant<std::size_t, 3>(),
+                 integral_constant<std::size_t, 4>());
+      case 8:
+        return f(integral_constant<std::size_t, 3>(),
+                 integral_constant<std::size_t, 8>());
+      case 10:
+        return f(integral_constant<std::size_t, 3>(),
+                 integral_constant<std::size_t, 10>());
+      default:
+        break;
+      }
+    }
+  }
+
+  return f(integral_constant<std::size_t, 0>(),
+           integral_constant<std::size_t, 0>());
+}
 } // namespace dolfinx_contact
@@ -5,6 +5,35 @@
 // SPDX-License-Identifier:    MIT
 
 #include "MeshTie.h"
+#include <mutex>
+
+namespace
+{
+/// Compute the offsets of the coefficients of each facet, when the test
+/// functions and their gradients on the linked cells are stored ragged
+/// @param[in] num_facets The number of facets
+/// @param[in] head Number of coefficients preceding the test functions
+/// @param[in] test_offsets Offsets of the test functions of each facet
+/// @param[in] grad_offsets Offsets of the gradients of the test functions
+/// @param[in] tail Number of coefficients following the gradients
+/// @returns The coefficients of the ith facet are stored in
+/// `[offsets[i], offsets[i+1])`
+std::vector<std::int32_t>
+ragged_coefficient_offsets(std::size_t num_facets, std::size_t head,
+                           std::span<const std::int32_t> test_offsets,
+                           std::span<const std::int32_t> grad_offsets,
+                           std::size_t tail)
+{
+  std::vector<std::int32_t> offsets(num_facets + 1, 0);
+  for (std::size_t e = 0; e < num_facets; ++e)
+  {
+    offsets[e + 1] = offsets[e] + (std::int32_t)(head + tail)
+                     + test_offsets[e + 1] - test_offsets[e]
+                     + grad_offsets[e + 1] - grad_offsets[e];
+  }
+  return offsets;
+}
+} // namespace
 
 void dolfinx_contact::MeshTie::generate_kernel_data(
     dolfinx_contact::Problem problem_type,
@@ -122,14 +151,20 @@ void dolfinx_contact::MeshTie::generate_meshtie_data_matrix_only(
     cstrides.push_back(num_q_points);
     cstrides.push_back(num_q_points);
     _kernel_thermo_el = dolfinx_contact::generate_meshtie_kernel(
-        Kernel::ThermoElasticRhs, V, Contact::quadrature_rule(), cstrides);
+        Kernel::ThermoElasticRhs, V, Contact::quadrature_rule(), cstrides,
+        max_links);
   }
 
   // Generate integration kernels
   _kernel_rhs = dolfinx_contact::generate_meshtie_kernel(
-      Kernel::MeshTieRhs, V, Contact::quadrature_rule(), cstrides);
+      Kernel::MeshTieRhs, V, Contact::quadrature_rule(), cstrides,
+      max_links);
   _kernel_jac = dolfinx_contact::generate_meshtie_kernel(
-      Kernel::MeshTieJac, V, Contact::quadrature_rule(), cstrides);
+      Kernel::MeshTieJac, V, Contact::quadrature_rule(), cstrides,
+      max_links);
+  _kernel_jac_batched = dolfinx_contact::generate_batched_meshtie_kernel(
+      Kernel::MeshTieJac, V, Contact::quadrature_rule(), cstrides,
+      max_links);
 
   // save nitsche parameters as constants
   _consts = {gamma, theta};
@@ -158,30 +193,40 @@ void dolfinx_contact::MeshTie::generate_meshtie_data_matrix_only(
     auto [mu_p, c_mu]
         = pack_coefficient_quadrature(coeffs[0], 0, entities, it); // mu
     auto [gap, cgap] = Contact::pack_gap(i);                   // gap function
-    auto [testfn, ctest] = Contact::pack_test_functions(i, V); // test functions
-    auto [gradtst, cgt] = Contact::pack_grad_test_functions(
-        i, V); // test fns on connected surface
+    // test functions and their gradients on connected surface, only
+    // storing the blocks of the linked cells of each facet
+    auto [testfn, ctest] = Contact::pack_test_functions_ragged(i, V);
+    auto [gradtst, cgt] = Contact::pack_grad_test_functions_ragged(i, V);
+
+    // Compute the coefficient offsets of each facet. The coefficients
+    // following the test functions have a fixed size per facet
+    const std::size_t tail = _cstride - cstrides[0] - cstrides[1] - cstrides[2];
+    _coeff_offsets[i] = ragged_coefficient_offsets(num_facets, cstrides[0],
+                                                   ctest, cgt, tail);
 
     // copy data into one common data vector in the order expected by the
     // integration kernel
-    _coeffs[i].resize(_cstride * num_facets);
+    _coeffs[i].assign(_coeff_offsets[i].back(), 0.0);
     for (std::size_t e = 0; e < num_facets; ++e)
     {
+      const std::size_t c0 = _coeff_offsets[i][e];
       std::copy_n(std::next(mu_p.begin(), e * c_mu), c_mu,
-                  std::next(_coeffs[i].begin(), e * _cstride));
+                  std::next(_coeffs[i].begin(), c0));
       std::size_t offset = c_mu;
       std::copy_n(std::next(lm_p.begin(), e * c_lm), c_lm,
-                  std::next(_coeffs[i].begin(), e * _cstride + offset));
+                  std::next(_coeffs[i].begin(), c0 + offset));
       offset += c_lm;
       std::copy_n(std::next(h_p.begin(), e * c_h), c_h,
-                  std::next(_coeffs[i].begin(), e * _cstride + offset));
+                  std::next(_coeffs[i].begin(), c0 + offset));
 
       offset = cstrides[0];
-      std::copy_n(std::next(testfn.begin(), e * ctest), ctest,
-                  std::next(_coeffs[i].begin(), e * _cstride + offset));
-      offset += ctest;
-      std::copy_n(std::next(gradtst.begin(), e * cgt), cgt,
-                  std::next(_coeffs[i].begin(), e * _cstride + offset));
+      std::copy(std::next(testfn.begin(), ctest[e]),
+                std::next(testfn.begin(), ctest[e + 1]),
+                std::next(_coeffs[i].begin(), c0 + offset));
+      offset += ctest[e + 1] - ctest[e];
+      std::copy(std::next(gradtst.begin(), cgt[e]),
+                std::next(gradtst.begin(), cgt[e + 1]),
+                std::next(_coeffs[i].begin(), c0 + offset));
     }
     if (problem_type == dolfinx_contact::Problem::ThermoElasticity)
     {
@@ -189,7 +234,7 @@ void dolfinx_contact::MeshTie::generate_meshtie_data_matrix_only(
           = pack_coefficient_quadrature(coeffs[2], 0, entities, it); // alpha
       for (std::size_t e = 0; e < num_facets; ++e)
         std::copy_n(std::next(alpha.begin(), e * c_alpha), c_alpha,
-                    std::next(_coeffs[i].begin(), e * _cstride + 3));
+                    std::next(_coeffs[i].begin(), _coeff_offsets[i][e] + 3));
     }
   }
 }
@@ -225,10 +270,12 @@ void dolfinx_contact::MeshTie::update_kernel_data(
     bs = coeff_list[0]->function_space()->dofmap()->bs();
     offset0 = 3 + 2 * (num_pts * max_links * bs * ndofs_cell);
     offset1 = offset0 + (1 + gdim) * num_pts * bs;
-    update_function_data(coeff_list[0], _coeffs, offset0, offset1, _cstride);
+    update_function_data(coeff_list[0], _coeffs, _coeff_offsets, offset0,
+                         offset1, _cstride);
     offset0 += num_pts * bs;
     offset1 += num_pts * bs;
-    update_gradient_data(coeff_list[0], _coeffs, offset0, offset1, _cstride);
+    update_gradient_data(coeff_list[0], _coeffs, _coeff_offsets, offset0,
+                         offset1, _cstride);
     break;
   case Poisson:
     if (auto it = coefficients.find("T"); it != coefficients.end())
@@ -241,11 +288,13 @@ void dolfinx_contact::MeshTie::update_kernel_data(
     ndofs_cell = coeff_list[0]->function_space()->dofmap()->cell_dofs(0).size();
     offset0 = 2 + (1 + gdim) * (num_pts * max_links * ndofs_cell);
     offset1 = offset0 + (1 + gdim) * num_pts;
-    update_function_data(coeff_list[0], _coeffs_poisson, offset0, offset1,
+    update_function_data(coeff_list[0], _coeffs_poisson,
+                         _coeff_offsets_poisson, offset0, offset1,
                          _cstride_poisson);
     offset0 += num_pts;
     offset1 += num_pts;
-    update_gradient_data(coeff_list[0], _coeffs_poisson, offset0, offset1,
+    update_gradient_data(coeff_list[0], _coeffs_poisson,
+                         _coeff_offsets_poisson, offset0, offset1,
                          _cstride_poisson);
     break;
   case ThermoElasticity:
@@ -268,13 +317,16 @@ void dolfinx_contact::MeshTie::update_kernel_data(
     bs = coeff_list[0]->function_space()->dofmap()->bs();
     offset0 = 4 + 2 * (num_pts * max_links * bs * ndofs_cell);
     offset1 = offset0 + (1 + gdim) * num_pts * bs;
-    update_function_data(coeff_list[0], _coeffs, offset0, offset1, _cstride);
+    update_function_data(coeff_list[0], _coeffs, _coeff_offsets, offset0,
+                         offset1, _cstride);
     offset0 += num_pts * bs;
     offset1 += num_pts * bs;
-    update_gradient_data(coeff_list[0], _coeffs, offset0, offset1, _cstride);
+    update_gradient_data(coeff_list[0], _coeffs, _coeff_offsets, offset0,
+                         offset1, _cstride);
     offset0 = offset1 + num_pts * bs * gdim;
     offset1 = offset0 + num_pts;
-    update_function_data(coeff_list[1], _coeffs, offset0, offset1, _cstride);
+    update_function_data(coeff_list[1], _coeffs, _coeff_offsets, offset0,
+                         offset1, _cstride);
     break;
   default:
     throw std::invalid_argument("Problem type not implemented");
@@ -283,71 +335,66 @@ void dolfinx_contact::MeshTie::update_kernel_data(
 
 void dolfinx_contact::MeshTie::update_function_data(
     std::shared_ptr<dolfinx::fem::Function<double>> u,
-    std::vector<std::vector<double>>& coeffs, std::size_t offset0,
-    std::size_t offset1, std::size_t coeff_size)
+    std::vector<std::vector<double>>& coeffs,
+    const std::vector<std::vector<std::int32_t>>& coeff_offsets,
+    std::size_t offset0, std::size_t offset1, std::size_t coeff_size)
 {
   std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V
-      = u->function_space();                                           // mesh
-  std::shared_ptr<const dolfinx::mesh::Mesh<double>> mesh = V->mesh(); // mesh
-  auto it = dolfinx::fem::IntegralType::exterior_facet;
+      = u->function_space();
 
   // loop over connected pairs
   for (int i = 0; i < _num_pairs; ++i)
   {
     // retrieve indices of connected surfaces
     const std::array<int, 2>& pair = Contact::contact_pair(i);
-    // retrieve integration facets
-    std::span<const std::int32_t> entities = Contact::active_entities(pair[0]);
     // number of facets own by process
     std::size_t num_facets = Contact::local_facets(pair[0]);
-    auto [u_p, c_u] = pack_coefficient_quadrature(u, _q_deg, entities, it); // u
-    auto [u_cd, c_uc] = Contact::pack_u_contact(i, u); // u on connected surface
-
-    // copy data into _coeffs in the order expected by the
-    // integration kernel
+    // The data is stored after the (ragged) test functions, so the
+    // position is computed relative to the end of the facet data
+    std::vector<std::int32_t> positions(num_facets);
     for (std::size_t e = 0; e < num_facets; ++e)
     {
-      std::copy_n(std::next(u_p.begin(), e * c_u), c_u,
-                  std::next(coeffs[i].begin(), e * coeff_size + offset0));
-      std::copy_n(std::next(u_cd.begin(), e * c_uc), c_uc,
-                  std::next(coeffs[i].begin(), e * coeff_size + offset1));
+      positions[e]
+          = coeff_offsets[i][e + 1] - (std::int32_t)(coeff_size - offset0);
     }
+    quadrature_packer(V, i).pack(*u, coeffs[i], positions); // u
+
+    // u on connected surface
+    for (auto& p : positions)
+      p += (std::int32_t)offset1 - (std::int32_t)offset0;
+    Contact::pack_u_contact(i, u, coeffs[i], positions);
   }
 }
 void dolfinx_contact::MeshTie::update_gradient_data(
     std::shared_ptr<dolfinx::fem::Function<double>> u,
-    std::vector<std::vector<double>>& coeffs, std::size_t offset0,
-    std::size_t offset1, std::size_t coeff_size)
+    std::vector<std::vector<double>>& coeffs,
+    const std::vector<std::vector<std::int32_t>>& coeff_offsets,
+    std::size_t offset0, std::size_t offset1, std::size_t coeff_size)
 {
   std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V
-      = u->function_space();                                           // mesh
-  std::shared_ptr<const dolfinx::mesh::Mesh<double>> mesh = V->mesh(); // mesh
-  auto it = dolfinx::fem::IntegralType::exterior_facet;
+      = u->function_space();
 
   // loop over connected pairs
   for (int i = 0; i < _num_pairs; ++i)
   {
     // retrieve indices of connected surfaces
     const std::array<int, 2>& pair = Contact::contact_pair(i);
-    // retrieve integration facets
-    std::span<const std::int32_t> entities = Contact::active_entities(pair[0]);
     // number of facets own by process
     std::size_t num_facets = Contact::local_facets(pair[0]);
-    auto [gradu, c_gu]
-        = pack_gradient_quadrature(u, _q_deg, entities, it); // grad(u)
-    auto [u_gc, c_ugc]
-        = Contact::pack_grad_u_contact(i, u); // grad(u) on connected surface
-
-    // copy data into _coeffs in the order expected by the
-    // integration kernel
+    // The data is stored after the (ragged) test functions, so the
+    // position is computed relative to the end of the facet data
+    std::vector<std::int32_t> positions(num_facets);
     for (std::size_t e = 0; e < num_facets; ++e)
     {
-      std::copy_n(std::next(gradu.begin(), e * c_gu), c_gu,
-                  std::next(coeffs[i].begin(), e * coeff_size + offset0));
-
-      std::copy_n(std::next(u_gc.begin(), e * c_ugc), c_ugc,
-                  std::next(coeffs[i].begin(), e * coeff_size + offset1));
+      positions[e]
+          = coeff_offsets[i][e + 1] - (std::int32_t)(coeff_size - offset0);
     }
+    quadrature_packer(V, i).pack_gradient(*u, coeffs[i], positions); // grad(u)
+
+    // grad(u) on connected surface
+    for (auto& p : positions)
+      p += (std::int32_t)offset1 - (std::int32_t)offset0;
+    Contact::pack_grad_u_contact(i, u, coeffs[i], positions);
   }
 }
 
@@ -384,9 +431,11 @@ void dolfinx_contact::MeshTie::generate_poisson_data_matrix_only(
 
   _cstride_poisson = std::accumulate(cstrides.cbegin(), cstrides.cend(), 0);
   _kernel_rhs_poisson = dolfinx_contact::generate_poisson_kernel(
-      Kernel::MeshTieRhs, V, Contact::quadrature_rule(), cstrides);
+      Kernel::MeshTieRhs, V, Contact::quadrature_rule(), cstrides,
+      max_links);
   _kernel_jac_poisson = dolfinx_contact::generate_poisson_kernel(
-      Kernel::MeshTieJac, V, Contact::quadrature_rule(), cstrides);
+      Kernel::MeshTieJac, V, Contact::quadrature_rule(), cstrides,
+      max_links);
 
   // save nitsche parameters as constants
   _consts_poisson = {gamma, theta};
@@ -411,29 +460,36 @@ void dolfinx_contact::MeshTie::generate_poisson_data_matrix_only(
     auto it = dolfinx::fem::IntegralType::exterior_facet;
     auto [kdt_p, c_kdt]
         = pack_coefficient_quadrature(kdt, 0, entities, it);   // lambda
-    auto [testfn, ctest] = Contact::pack_test_functions(i, V); // test functions
-    auto [gradtst, cgt] = Contact::pack_grad_test_functions(
-        i, V); // test fns on connected surface
+    // test functions and their gradients on connected surface, only
+    // storing the blocks of the linked cells of each facet
+    auto [testfn, ctest] = Contact::pack_test_functions_ragged(i, V);
+    auto [gradtst, cgt] = Contact::pack_grad_test_functions_ragged(i, V);
+
+    // Compute the coefficient offsets of each facet
+    const std::size_t tail
+        = _cstride_poisson - cstrides[0] - cstrides[1] - cstrides[2];
+    _coeff_offsets_poisson[i] = ragged_coefficient_offsets(
+        num_facets, cstrides[0], ctest, cgt, tail);
 
     // copy data into one common data vector in the order expected by the
     // integration kernel
-    _coeffs_poisson[i].resize(_cstride_poisson * num_facets);
+    _coeffs_poisson[i].assign(_coeff_offsets_poisson[i].back(), 0.0);
     for (std::size_t e = 0; e < num_facets; ++e)
     {
+      const std::size_t c0 = _coeff_offsets_poisson[i][e];
       std::copy_n(std::next(h_p.begin(), e * c_h), c_h,
-                  std::next(_coeffs_poisson[i].begin(), e * _cstride_poisson));
+                  std::next(_coeffs_poisson[i].begin(), c0));
       std::size_t offset = c_h;
-      std::copy_n(
-          std::next(kdt_p.begin(), e * c_kdt), c_kdt,
-          std::next(_coeffs_poisson[i].begin(), e * _cstride_poisson + offset));
+      std::copy_n(std::next(kdt_p.begin(), e * c_kdt), c_kdt,
+                  std::next(_coeffs_poisson[i].begin(), c0 + offset));
       offset += c_kdt;
-      std::copy_n(
-          std::next(testfn.begin(), e * ctest), ctest,
-          std::next(_coeffs_poisson[i].begin(), e * _cstride_poisson + offset));
-      offset += ctest;
-      std::copy_n(
-          std::next(gradtst.begin(), e * cgt), cgt,
-          std::next(_coeffs_poisson[i].begin(), e * _cstride_poisson + offset));
+      std::copy(std::next(testfn.begin(), ctest[e]),
+                std::next(testfn.begin(), ctest[e + 1]),
+                std::next(_coeffs_poisson[i].begin(), c0 + offset));
+      offset += ctest[e + 1] - ctest[e];
+      std::copy(std::next(gradtst.begin(), cgt[e]),
+                std::next(gradtst.begin(), cgt[e + 1]),
+                std::next(_coeffs_poisson[i].begin(), c0 + offset));
     }
   }
 }
@@ -443,29 +499,57 @@ void dolfinx_contact::MeshTie::assemble_vector(
     std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
     dolfinx_contact::Problem problem_type)
 {
+  std::vector<const kernel_fn<PetscScalar>*> kernels;
+  const std::vector<std::vector<double>>* coeffs = &_coeffs;
+  const std::vector<std::vector<std::int32_t>>* offsets = &_coeff_offsets;
+  std::span<const double> consts = _consts;
   switch (problem_type)
   {
     using enum dolfinx_contact::Problem;
   case Elasticity:
-    for (int i = 0; i < _num_pairs; ++i)
-      assemble_vector(b, i, _kernel_rhs, _coeffs[i], (int)_cstride, _consts, V);
+    kernels = {&_kernel_rhs};
     break;
   case Poisson:
-    for (int i = 0; i < _num_pairs; ++i)
-      assemble_vector(b, i, _kernel_rhs_poisson, _coeffs_poisson[i],
-                      (int)_cstride_poisson, _consts_poisson, V);
+    kernels = {&_kernel_rhs_poisson};
+    coeffs = &_coeffs_poisson;
+    offsets = &_coeff_offsets_poisson;
+    consts = _consts_poisson;
     break;
   case ThermoElasticity:
-    for (int i = 0; i < _num_pairs; ++i)
-    {
-      assemble_vector(b, i, _kernel_rhs, _coeffs[i], (int)_cstride, _consts, V);
-      assemble_vector(b, i, _kernel_thermo_el, _coeffs[i], (int)_cstride,
-                      _consts, V);
-    }
+    kernels = {&_kernel_rhs, &_kernel_thermo_el};
     break;
   default:
     throw std::invalid_argument("Problem type not implemented");
   }
+
+  const std::size_t num_workers = std::min(
+      (std::size_t)_num_pairs, (std::size_t)std::max(num_threads(), 1));
+  if (num_workers < 2)
+  {
+    for (int i = 0; i < _num_pairs; ++i)
+      for (const kernel_fn<PetscScalar>* kernel : kernels)
+        assemble_vector(b, i, *kernel, (*coeffs)[i], (*offsets)[i], consts, V);
+    return;
+  }
+
+  // Pairs can share degrees of freedom, so each thread assembles into its
+  // own vector. The calling thread assembles directly into b.
+  std::vector<std::vector<PetscScalar>> b_threads(
+      num_workers - 1, std::vector<PetscScalar>(b.size(), 0));
+  Contact::for_each_pair(
+      _num_pairs,
+      [&](std::size_t t, int i, int pair_threads)
+      {
+        std::span<PetscScalar> b_t
+            = t == 0 ? b : std::span<PetscScalar>(b_threads[t - 1]);
+        for (const kernel_fn<PetscScalar>* kernel : kernels)
+        {
+          assemble_pair_vector(b_t, i, *kernel, (*coeffs)[i], (*offsets)[i],
+                               consts, V, pair_threads);
+        }
+      });
+  for (const std::vector<PetscScalar>& b_t : b_threads)
+    std::transform(b_t.begin(), b_t.end(), b.begin(), b.begin(), std::plus{});
 }
 
 void dolfinx_contact::MeshTie::assemble_matrix(
@@ -473,32 +557,94 @@ void dolfinx_contact::MeshTie::assemble_matrix(
     std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
     dolfinx_contact::Problem problem_type)
 {
+  const kernel_fn<PetscScalar>* kernel = &_kernel_jac;
+  const std::vector<std::vector<double>>* coeffs = &_coeffs;
+  const std::vector<std::vector<std::int32_t>>* offsets = &_coeff_offsets;
+  std::span<const double> consts = _consts;
+  // The batched kernel is used if there is one for the element
+  bool batched = _batched_kernels and bool(_kernel_jac_batched);
   switch (problem_type)
   {
     using enum dolfinx_contact::Problem;
   case Elasticity:
-    for (int i = 0; i < _num_pairs; ++i)
-      assemble_matrix(mat_set, i, _kernel_jac, _coeffs[i], (int)_cstride,
-                      _consts, V);
+  case ThermoElasticity:
     break;
   case Poisson:
-    for (int i = 0; i < _num_pairs; ++i)
-      assemble_matrix(mat_set, i, _kernel_jac_poisson, _coeffs_poisson[i],
-                      (int)_cstride_poisson, _consts_poisson, V);
-    break;
-  case ThermoElasticity:
-    for (int i = 0; i < _num_pairs; ++i)
-      assemble_matrix(mat_set, i, _kernel_jac, _coeffs[i], (int)_cstride,
-                      _consts, V);
+    kernel = &_kernel_jac_poisson;
+    coeffs = &_coeffs_poisson;
+    offsets = &_coeff_offsets_poisson;
+    consts = _consts_poisson;
+    batched = false;
     break;
   default:
     throw std::invalid_argument("Problem type not implemented");
   }
+
+  // Assemble a single pair with the given number of threads
+  auto assemble_single_pair
+      = [&](const mat_set_fn& set, int i, int pair_threads)
+  {
+    if (batched)
+    {
+      assemble_pair_matrix_batched(set, i, _kernel_jac_batched, (*coeffs)[i],
+                                   (*offsets)[i], consts, V, pair_threads);
+    }
+    else
+    {
+      assemble_pair_matrix(set, i, *kernel, (*coeffs)[i], (*offsets)[i],
+                           consts, V, pair_threads);
+    }
+  };
+
+  if (std::min(_num_pairs, num_threads()) < 2)
+  {
+    for (int i = 0; i < _num_pairs; ++i)
+      assemble_single_pair(mat_set, i, num_threads());
+    return;
+  }
+
+  // Pairs can share degrees of freedom, so the insertion into the matrix is
+  // serialised
+  std::mutex mutex;
+  mat_set_fn mat_set_locked
+      = [&mat_set, &mutex](const std::span<const std::int32_t>& rows,
+                           const std::span<const std::int32_t>& cols,
+                           const std::span<const PetscScalar>& vals)
+  {
+    std::scoped_lock lock(mutex);
+    return mat_set(rows, cols, vals);
+  };
+  Contact::for_each_pair(
+      _num_pairs, [&](std::size_t, int i, int pair_threads)
+      { assemble_single_pair(mat_set_locked, i, pair_threads); });
 }
 
-std::pair<std::vector<double>, std::size_t>
+std::pair<std::vector<double>, std::vector<std::int32_t>>
 dolfinx_contact::MeshTie::coeffs(int pair)
 {
-  std::vector<double>& coeffs = _coeffs[pair];
-  return {coeffs, _cstride};
+  return {_coeffs[pair], _coeff_offsets[pair]};
+}
+//-----------------------------------------------------------------------------
+const dolfinx_contact::QuadraturePacker&
+dolfinx_contact::MeshTie::quadrature_packer(
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V, int pair)
+{
+  auto it = _packers.find(V);
+  if (it == _packers.end())
+  {
+    // The integration facets of the pairs do not change, so the packers
+    // are reused for all subsequent updates
+    const bool gradient = !V->element()->needs_dof_transformations();
+    std::vector<QuadraturePacker> packers;
+    packers.reserve(_num_pairs);
+    for (int i = 0; i < _num_pairs; ++i)
+    {
+      const std::array<int, 2>& contact_pair = Contact::contact_pair(i);
+      packers.emplace_back(V, _q_deg, Contact::active_entities(contact_pair[0]),
+                           dolfinx::fem::IntegralType::exterior_facet,
+                           gradient);
+    }
+    it = _packers.emplace(V, std::move(packers)).first;
+  }
+  return it->second[pair];
 }
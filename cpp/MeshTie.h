@@ -37,9 +37,9 @@ public:
                         ContactMode::ClosestPoint), q_deg)
   {
     // Find closest points
+    Contact::create_distance_maps();
     for (int i = 0; i < (int)connected_pairs.size(); ++i)
     {
-      Contact::create_distance_map(i);
       const std::array<int, 2>& pair = Contact::contact_pair(i);
       std::size_t num_facets = Contact::local_facets(pair[0]);
       if (num_facets > 0)
@@ -65,9 +65,18 @@ public:
     _num_pairs = (int)connected_pairs.size();
     _coeffs.resize(_num_pairs);
     _coeffs_poisson.resize(_num_pairs);
+    _coeff_offsets.resize(_num_pairs);
+    _coeff_offsets_poisson.resize(_num_pairs);
     _q_deg = q_deg;
   };
 
+  /// Use the batched kernels where there is one for the element (default),
+  /// see `generate_batched_meshtie_kernel`
+  void set_batched_kernels(bool batched) { _batched_kernels = batched; }
+
+  /// Return true if the batched kernels are used where possible
+  bool batched_kernels() const { return _batched_kernels; }
+
   std::size_t offset_elasticity(
       std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V);
   std::size_t
@@ -113,28 +122,34 @@ public:
   /// Update funciton value data for vector assembly based on state
   /// @param[in] u - the function
   /// @param[in] coeffs - the coefficient vector to be updated
+  /// @param[in] coeff_offsets - the offsets of the coefficients of each facet
   /// @param[in] offset0 - position within coeffs where data on integration
-  /// surface should be added
+  /// surface should be added (in the padded layout)
   /// @param[in] offset1 - position within coeffs where data on contacting
-  /// surface should be added
+  /// surface should be added (in the padded layout)
   /// @param[in] coeff_size - total size of the coefficient array per facet
-  void update_function_data(std::shared_ptr<dolfinx::fem::Function<double>> u,
-                            std::vector<std::vector<double>>& coeffs,
-                            std::size_t offset0, std::size_t offset1,
-                            std::size_t coeff_size);
+  /// in the padded layout
+  void update_function_data(
+      std::shared_ptr<dolfinx::fem::Function<double>> u,
+      std::vector<std::vector<double>>& coeffs,
+      const std::vector<std::vector<std::int32_t>>& coeff_offsets,
+      std::size_t offset0, std::size_t offset1, std::size_t coeff_size);
 
   /// Update gradient value data for vector assembly based on state
   /// @param[in] u - the function
   /// @param[in] coeffs - the coefficient vector to be updated
+  /// @param[in] coeff_offsets - the offsets of the coefficients of each facet
   /// @param[in] offset0 - position within coeffs where data on integration
-  /// surface should be added
+  /// surface should be added (in the padded layout)
   /// @param[in] offset1 - position within coeffs where data on contacting
-  /// surface should be added
+  /// surface should be added (in the padded layout)
   /// @param[in] coeff_size - total size of the coefficient array per facet
-  void update_gradient_data(std::shared_ptr<dolfinx::fem::Function<double>> u,
-                            std::vector<std::vector<double>>& coeffs,
-                            std::size_t offset0, std::size_t offset1,
-                            std::size_t coeff_size);
+  /// in the padded layout
+  void update_gradient_data(
+      std::shared_ptr<dolfinx::fem::Function<double>> u,
+      std::vector<std::vector<double>>& coeffs,
+      const std::vector<std::vector<std::int32_t>>& coeff_offsets,
+      std::size_t offset0, std::size_t offset1, std::size_t coeff_size);
 
   /// Generate data for matrix assembly for Poisson
   /// @param[in] V - The FunctionSpace
@@ -148,6 +163,10 @@ public:
 
   using Contact::assemble_vector;
   /// Assemble right hand side
+  ///
+  /// If more than one thread is used (see `set_num_threads`), the pairs are
+  /// assembled concurrently into thread-local copies of b, which are added
+  /// to b afterwards
   /// @param[in] b - the vector to assemble into
   /// @param[in] V - the associated FunctionSpace
   /// @param[in] problem_type - the type of equation, e.g. elasticity
@@ -158,6 +177,10 @@ public:
 
   using Contact::assemble_matrix;
   /// Assemble matrix
+  ///
+  /// If more than one thread is used (see `set_num_threads`), the pairs are
+  /// assembled concurrently. The calls to mat_set are serialised, so it does
+  /// not need to be thread-safe
   /// @param[in] mat_set function for setting matrix entries
   /// @param[in] V function space for Trial/Test functions
   /// @param[in] problem_type - the type of equation, e.g. elasticity
@@ -168,9 +191,19 @@ public:
 
   /// Return data generated with generate_meshtie_data
   /// @param[in] pair - the index of the pair of connected surfaces
-  std::pair<std::vector<double>, std::size_t> coeffs(int pair);
+  /// @returns (coeffs, offsets) - The coefficients of the ith facet are
+  /// `coeffs[offsets[i]:offsets[i+1]]`. Only the test functions of the cells
+  /// linked to a facet are stored.
+  std::pair<std::vector<double>, std::vector<std::int32_t>> coeffs(int pair);
 
 private:
+  /// Return the packer for coefficients in a function space on the
+  /// integration surface of a pair. The packers are created on first use.
+  /// @param[in] V - the function space
+  /// @param[in] pair - the index of the pair of connected surfaces
+  const QuadraturePacker& quadrature_packer(
+      std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V, int pair);
+
   // kernel function for rhs
   kernel_fn<PetscScalar> _kernel_rhs;
   // kernel function addding temperature dependent thermo-elasticity terms to
@@ -178,6 +211,11 @@ private:
   kernel_fn<PetscScalar> _kernel_thermo_el;
   // kernel function for matrix
   kernel_fn<PetscScalar> _kernel_jac;
+  // kernel function for matrix evaluating several facets at once, empty if
+  // there is none for the element
+  batched_kernel_fn<PetscScalar> _kernel_jac_batched;
+  // use the batched kernels where there is one
+  bool _batched_kernels = true;
   // kernel function for rhs
   kernel_fn<PetscScalar> _kernel_rhs_poisson;
   // kernel function for matrix
@@ -187,12 +225,21 @@ private:
   // storage for generated data
   std::vector<std::vector<double>> _coeffs;
   std::vector<std::vector<double>> _coeffs_poisson;
+  // offsets of the (ragged) data of each facet
+  std::vector<std::vector<std::int32_t>> _coeff_offsets;
+  std::vector<std::vector<std::int32_t>> _coeff_offsets_poisson;
   // constant input parameters for kernels
   std::vector<double> _consts;
   std::vector<double> _consts_poisson;
   // quadrature degree
   std::int32_t _q_deg;
+  // number of coefficients per facet in the padded layout
   std::size_t _cstride = 0;
   std::size_t _cstride_poisson = 0;
+  // packers for coefficients on the integration surface of each pair,
+  // for each function space
+  std::map<std::shared_ptr<const dolfinx::fem::FunctionSpace<double>>,
+           std::vector<QuadraturePacker>>
+      _packers;
 };
 } // namespace dolfinx_contact
\ No newline at end of file
@@ -76,6 +76,32 @@ void compute_tangents(std::span<const double, gdim> n,
   normalize<gdim - 1, gdim>(tangents);
 };
 
+/// Check if a set of reference facet parameters is inside the reference facet
+///
+/// @param[in] xi The reference parameters
+/// @param[in] cell_type The cell type of the mesh
+/// @param[in] tol The tolerance for the inside test
+/// @tparam tdim The topological dimension of the cell
+template <std::size_t tdim>
+bool inside_reference_facet(std::span<const double, tdim - 1> xi,
+                            dolfinx::mesh::CellType cell_type, double tol)
+{
+  switch (cell_type)
+  {
+  case dolfinx::mesh::CellType::tetrahedron:
+    return (xi[0] >= -tol) and (xi[0] <= 1 + tol) and (xi[1] >= -tol)
+           and (xi[1] <= 1 - xi[0] + tol);
+  case dolfinx::mesh::CellType::hexahedron:
+    return (xi[0] >= -tol) and (xi[0] <= 1 + tol) and (xi[1] >= -tol)
+           and (xi[1] <= 1 + tol);
+  case dolfinx::mesh::CellType::triangle:
+  case dolfinx::mesh::CellType::quadrilateral:
+    return (xi[0] >= -tol) and (xi[0] <= 1 + tol);
+  default:
+    throw std::invalid_argument("Unsupported cell type");
+  }
+}
+
 } // namespace impl
 
 template <std::size_t tdim, std::size_t gdim>
@@ -199,6 +225,129 @@ private:
   std::array<std::size_t, 13> _offsets;
 };
 
+/// @brief Compute the solution to the ray tracing problem for a single
+/// affine cell
+///
+/// For an affine cell the parameterization of the facet \Phi(\xi) = x_0 +
+/// J dxi \xi is linear, and dot(\Phi(\xi)-p, t_i)=0 is solved directly as a
+/// single linear system in the reference parameters. The intersection is
+/// accepted if the parameters (barycentric coordinates on simplex facets)
+/// are inside the reference facet.
+///
+/// @param[in,out] storage Structure holding all memory required for
+/// the intersection. See `raytracing_cell` for the expected input.
+/// @param[in, out] basis_values Work_array for basis evaluation. Should have
+/// the length given by `cmap.tabulate_shape(1,1)`
+/// @param[in] tol The tolerance for singular systems and the inside test
+/// @param[in] cmap The coordinate element
+/// @param[in] cell_type The cell type of the mesh
+/// @param[in] coordinate_dofs The cell geometry, shape (num_dofs_g, gdim).
+/// Flattened row-major
+/// @param[in] reference_map Function mapping from reference parameters (xi,
+/// eta) to the physical element
+/// @returns The status, 1 if the ray intersects the facet, -2 if the facet
+/// is parallel with the tangent, -3 if the intersection is outside the
+/// facet.
+/// @tparam tdim The topological dimension of the cell
+/// @tparam gdim The geometrical dimension of the cell
+template <std::size_t tdim, std::size_t gdim>
+int raytracing_affine_cell(
+    NewtonStorage<tdim, gdim>& storage, std::span<double> basis_values,
+    const std::array<std::size_t, 4>& basis_shape, double tol,
+    const dolfinx::fem::CoordinateElement<double>& cmap,
+    dolfinx::mesh::CellType cell_type, std::span<const double> coordinate_dofs,
+    const std::function<void(std::span<const double, tdim - 1>,
+                             std::span<double, tdim>)>& reference_map)
+{
+  assert(cmap.is_affine());
+  auto x_k = storage.x_k();
+  auto xi_k = storage.xi_k();
+  auto X_k = storage.X_k();
+  auto dGk = storage.dGk();
+  auto dGk_inv = storage.dGk_inv();
+  auto Gk = storage.Gk();
+  auto point = storage.point();
+  auto tangents = storage.tangents();
+  auto J = storage.J();
+  auto dGk_tmp = storage.dGk_tmp();
+  auto dxi = storage.dxi();
+  assert(std::size_t(std::reduce(basis_shape.cbegin(), basis_shape.cend(), 1,
+                                 std::multiplies{}))
+         == basis_values.size());
+
+  // Evaluate the geometry and (constant) Jacobian at the origin of the
+  // facet parameterization
+  std::fill(xi_k.begin(), xi_k.end(), 0);
+  reference_map(xi_k, X_k);
+  cmap.tabulate(1, X_k, {1, tdim}, basis_values);
+  cmdspan4_t basis(basis_values.data(), basis_shape);
+  cmdspan2_t coords(coordinate_dofs.data(), cmap.dim(), gdim);
+  std::array<double, gdim> x0b;
+  mdspan2_t x0(x0b.data(), 1, gdim);
+  dolfinx::fem::CoordinateElement<double>::push_forward(
+      x0, coords,
+      stdex::submdspan(basis, 0, MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent,
+                       MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent, 0));
+  for (std::size_t i = 0; i < gdim; ++i)
+    for (std::size_t j = 0; j < tdim; ++j)
+      J(i, j) = 0;
+  dolfinx::fem::CoordinateElement<double>::compute_jacobian(
+      stdex::submdspan(basis, std::pair{1, tdim + 1}, 0,
+                       MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent, 0),
+      coords, J);
+
+  // Tangent vectors of the physical facet, J dxi
+  for (std::size_t i = 0; i < gdim; ++i)
+    for (std::size_t j = 0; j < tdim - 1; ++j)
+      dGk_tmp(i, j) = 0;
+  dolfinx::math::dot(J, dxi, dGk_tmp);
+
+  // Assemble linear system t_i . (J dxi) \xi = t_i . (p - x_0)
+  for (std::size_t i = 0; i < gdim - 1; ++i)
+  {
+    Gk[i] = 0;
+    for (std::size_t l = 0; l < gdim; ++l)
+      Gk[i] += (point[l] - x0b[l]) * tangents(i, l);
+    for (std::size_t j = 0; j < tdim - 1; ++j)
+    {
+      dGk(i, j) = 0;
+      for (std::size_t l = 0; l < gdim; ++l)
+        dGk(i, j) += dGk_tmp(l, j) * tangents(i, l);
+    }
+  }
+
+  // Terminate if the facet is parallel to the ray
+  double det_dGk;
+  if constexpr ((gdim != tdim) and (gdim == 3) and (tdim == 2))
+    det_dGk = std::sqrt(dGk(0, 0) * dGk(0, 0) + dGk(1, 0) * dGk(1, 0));
+  else
+    det_dGk = dolfinx::math::det(dGk);
+  if (std::abs(det_dGk) < tol)
+    return -2;
+
+  if constexpr (gdim == tdim)
+    dolfinx::math::inv(dGk, dGk_inv);
+  else
+    dolfinx::math::pinv(dGk, dGk_inv);
+
+  // Solve for the reference parameters and map them to the cell
+  for (std::size_t i = 0; i < tdim - 1; ++i)
+  {
+    xi_k[i] = 0;
+    for (std::size_t j = 0; j < gdim - 1; ++j)
+      xi_k[i] += dGk_inv(i, j) * Gk[j];
+  }
+  reference_map(xi_k, X_k);
+  for (std::size_t i = 0; i < gdim; ++i)
+  {
+    x_k[i] = x0b[i];
+    for (std::size_t j = 0; j < tdim - 1; ++j)
+      x_k[i] += dGk_tmp(i, j) * xi_k[j];
+  }
+
+  return impl::inside_reference_facet<tdim>(xi_k, cell_type, tol) ? 1 : -3;
+}
+
 /// @brief Compute the solution to the ray tracing problem for a single cell
 ///
 /// The implementation solves dot(\Phi(\xi, \eta)-p, t_i)=0, i=1,..,, tdim-1
@@ -207,7 +356,8 @@ private:
 /// is the ith tangents defining the ray. For more details, see
 /// DOI: 10.1016/j.compstruc.2015.02.027 (eq 14).
 ///
-/// @note The problem is solved using Newton's method
+/// @note The problem is solved using Newton's method. For affine cells the
+/// closed form solution of `raytracing_affine_cell` is used instead.
 ///
 /// @param[in,out] storage Structure holding all memory required for
 /// the newton iteration.
@@ -238,6 +388,15 @@ int raytracing_cell(
   if constexpr ((gdim != 2) and (gdim != 3))
     throw std::invalid_argument("The geometrical dimension has to be 2 or 3");
 
+  // Flat facets of affine cells have a closed form intersection
+  if (cmap.is_affine())
+  {
+    return raytracing_affine_cell<tdim, gdim>(storage, basis_values,
+                                              basis_shape, tol, cmap,
+                                              cell_type, coordinate_dofs,
+                                              reference_map);
+  }
+
   int status = -1;
   auto x_k = storage.x_k();
   std::fill(x_k.begin(), x_k.end(), 0);
@@ -360,37 +519,8 @@ int raytracing_cell(
                    [](auto x, auto y) { return x - y; });
   }
   // Check if converged  parameters are valid
-  switch (cell_type)
-  {
-  case dolfinx::mesh::CellType::tetrahedron:
-    if ((xi_k[0] < -tol) or (xi_k[0] > 1 + tol) or (xi_k[1] < -tol)
-        or (xi_k[1] > 1 - xi_k[0] + tol))
-    {
-      status = -3;
-    }
-    break;
-  case dolfinx::mesh::CellType::hexahedron:
-    if ((xi_k[0] < -tol) or (xi_k[0] > 1 + tol) or (xi_k[1] < -tol)
-        or (xi_k[1] > 1 + tol))
-    {
-      status = -3;
-    }
-    break;
-  case dolfinx::mesh::CellType::triangle:
-    if ((xi_k[0] < -tol) or (xi_k[0] > 1 + tol))
-    {
-      status = -3;
-    }
-    break;
-  case dolfinx::mesh::CellType::quadrilateral:
-    if ((xi_k[0] < -tol) or (xi_k[0] > 1 + tol))
-    {
-      status = -3;
-    }
-    break;
-  default:
-    throw std::invalid_argument("Unsupported cell type");
-  }
+  if (!impl::inside_reference_facet<tdim>(xi_k, cell_type, tol))
+    status = -3;
   return status;
 }
 
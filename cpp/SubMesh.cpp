@@ -149,6 +149,35 @@ dolfinx_contact::SubMesh::create_functionspace(
   return dolfinx::fem::FunctionSpace(_mesh, element, dofmap);
 }
 
+//-----------------------------------------------------------------------------------------------
+dolfinx_contact::SubMesh::SubFunctionSpace&
+dolfinx_contact::SubMesh::cached_space(
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V_parent)
+{
+  // Drop spaces whose parent space no longer exists
+  std::erase_if(_function_spaces,
+                [](const SubFunctionSpace& s) { return s.parent.expired(); });
+
+  auto it = std::find_if(_function_spaces.begin(), _function_spaces.end(),
+                         [&V_parent](const SubFunctionSpace& s)
+                         { return s.parent.lock() == V_parent; });
+  if (it != _function_spaces.end())
+    return *it;
+
+  _function_spaces.push_back(
+      {V_parent,
+       std::make_shared<const dolfinx::fem::FunctionSpace<double>>(
+           create_functionspace(V_parent)),
+       {}});
+  return _function_spaces.back();
+}
+//-----------------------------------------------------------------------------------------------
+std::shared_ptr<const dolfinx::fem::FunctionSpace<double>>
+dolfinx_contact::SubMesh::function_space(
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V_parent)
+{
+  return cached_space(V_parent).V;
+}
 //-----------------------------------------------------------------------------------------------
 void dolfinx_contact::SubMesh::copy_function(
     dolfinx::fem::Function<PetscScalar>& u_parent,
@@ -196,26 +225,60 @@ void dolfinx_contact::SubMesh::copy_function(
 void dolfinx_contact::SubMesh::update_geometry(
     dolfinx::fem::Function<PetscScalar>& u)
 {
-  // Recover original geometry from parent mesh
-  std::shared_ptr<const dolfinx::mesh::Mesh<double>> parent_mesh
-      = u.function_space()->mesh();
+  std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V_parent
+      = u.function_space();
+  std::shared_ptr<const dolfinx::fem::DofMap> dofmap_parent
+      = V_parent->dofmap();
+  assert(dofmap_parent);
+
+  // Compute map from submesh geometry nodes to dofs of the parent space
+  std::vector<std::int32_t>& geometry_dofs
+      = cached_space(V_parent).geometry_dofs;
+  if (geometry_dofs.empty())
+  {
+    // The Function and the mesh must have identical element_dof_layouts
+    // (up to the block size)
+    assert(dofmap_parent->element_dof_layout()
+           == _mesh->geometry().cmaps()[0].create_dof_layout());
+
+    const int tdim = _mesh->topology()->dim();
+    std::shared_ptr<const dolfinx::common::IndexMap> cell_map
+        = _mesh->topology()->index_map(tdim);
+    assert(cell_map);
+    const std::int32_t num_cells
+        = cell_map->size_local() + cell_map->num_ghosts();
+    stdex::mdspan<const std::int32_t,
+                  MDSPAN_IMPL_STANDARD_NAMESPACE::dextents<std::size_t, 2>>
+        dofmap_x = _mesh->geometry().dofmap();
+    geometry_dofs.resize(_mesh->geometry().x().size() / 3);
+    for (std::int32_t c = 0; c < num_cells; ++c)
+    {
+      const std::span<const int> dofs_parent
+          = dofmap_parent->cell_dofs(_parent_cells[c]);
+      auto dofs_x = stdex::submdspan(
+          dofmap_x, c, MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent);
+      assert(dofs_x.size() == dofs_parent.size());
+      for (std::size_t i = 0; i < dofs_parent.size(); ++i)
+        geometry_dofs[dofs_x[i]] = dofs_parent[i];
+    }
+  }
+
+  // Recover original geometry from parent mesh and add u
   std::span<double> sub_geometry = _mesh->geometry().x();
-  std::span<const double> parent_geometry = parent_mesh->geometry().x();
-  std::size_t num_x_dofs = sub_geometry.size() / 3;
+  std::span<const double> parent_geometry = V_parent->mesh()->geometry().x();
+  std::span<const PetscScalar> u_data = u.x()->array();
+  const int bs = dofmap_parent->bs();
+  assert(bs <= 3);
+  const std::size_t num_x_dofs = sub_geometry.size() / 3;
+  assert(geometry_dofs.size() == num_x_dofs);
   for (std::size_t i = 0; i < num_x_dofs; ++i)
   {
     std::copy_n(
         std::next(parent_geometry.begin(), 3 * _submesh_to_mesh_x_dof_map[i]),
         3, std::next(sub_geometry.begin(), 3 * i));
+    for (int j = 0; j < bs; ++j)
+      sub_geometry[3 * i + j] += u_data[bs * geometry_dofs[i] + j];
   }
-  // use u to update geometry
-  std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V_parent
-      = u.function_space();
-  auto V_sub = std::make_shared<dolfinx::fem::FunctionSpace<double>>(
-      create_functionspace(V_parent));
-  auto u_sub = dolfinx::fem::Function<PetscScalar>(V_sub);
-  copy_function(u, u_sub);
-  dolfinx_contact::update_geometry(u_sub, _mesh);
 }
 //-----------------------------------------------------------------------------------------------
 
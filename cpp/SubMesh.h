@@ -69,6 +69,14 @@ public:
       std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V_parent)
       const;
 
+  /// Return the FunctionSpace on the submesh corresponding to a FunctionSpace
+  /// on the parent mesh. The function space is created on the first call for
+  /// a given parent space and cached for subsequent calls.
+  /// @param[in] V_parent - the function space on the the parent mesh
+  /// @return the function space on the submesh
+  std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> function_space(
+      std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V_parent);
+
   // Copy of a function on the parent mesh/ in the parent function space
   // to submesh/ function space on submesh
   ///@param[in] u_parent - function to be copied
@@ -80,6 +88,8 @@ public:
   /// @brief Adds perturbation u to mesh
   /// @param[in] u: The function to perturb the mesh with. The function must be
   /// based on the same finite element as the mesh coordinate element.
+  /// @note The map from dofs of the function space of u to submesh geometry
+  /// nodes is computed on the first call and cached.
   void update_geometry(dolfinx::fem::Function<PetscScalar>& u);
 
   /// Map parent facets (parent_cell, local_facet_index) to submesh (cell,
@@ -111,5 +121,28 @@ private:
   // adjacency list mapping from submesh facet corresponding to facets
   // from the original input list to pair (cell, facet)
   std::shared_ptr<dolfinx::graph::AdjacencyList<std::int32_t>> _facets_to_cells;
+
+  // Function space on the submesh created from a parent function space
+  struct SubFunctionSpace
+  {
+    // the function space on the parent mesh
+    std::weak_ptr<const dolfinx::fem::FunctionSpace<double>> parent;
+
+    // the corresponding function space on the submesh
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V;
+
+    // geometry_dofs[i] is the (unblocked) dof in the parent space at the ith
+    // geometry node of the submesh. Only computed when needed by
+    // update_geometry
+    std::vector<std::int32_t> geometry_dofs;
+  };
+
+  // Return the cached data for a parent function space, creating it if
+  // necessary
+  SubFunctionSpace& cached_space(
+      std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V_parent);
+
+  // cached function spaces on the submesh
+  std::vector<SubFunctionSpace> _function_spaces;
 };
 } // namespace dolfinx_contact
@@ -7,6 +7,7 @@
 #include "coefficients.h"
 #include "error_handling.h"
 #include "geometric_quantities.h"
+#include "utils.h"
 #include <basix/quadrature.h>
 #include <dolfinx/mesh/cell_types.h>
 using namespace dolfinx_contact;
@@ -43,22 +44,22 @@ void dolfinx_contact::transformed_push_forward(
                              MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent);
   push_forward_fn(_u, element_basis, J, detJ, K);
 }
-std::pair<std::vector<PetscScalar>, int>
-dolfinx_contact::pack_coefficient_quadrature(
-    std::shared_ptr<const dolfinx::fem::Function<PetscScalar>> coeff,
-    const int q_degree, std::span<const std::int32_t> active_entities,
-    dolfinx::fem::IntegralType integral)
+//-----------------------------------------------------------------------------
+dolfinx_contact::QuadraturePacker::QuadraturePacker(
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    int q_degree, std::span<const std::int32_t> active_entities,
+    dolfinx::fem::IntegralType integral, bool gradient)
+    : _V(V), _gradient(gradient)
 {
-
   // Get mesh
-  std::shared_ptr<const dolfinx::mesh::Mesh<double>> mesh
-      = coeff->function_space()->mesh();
+  std::shared_ptr<const dolfinx::mesh::Mesh<double>> mesh = V->mesh();
   assert(mesh);
 
   // Get topology data
   auto topology = mesh->topology();
   const std::size_t tdim = topology->dim();
   const dolfinx::mesh::CellType cell_type = topology->cell_types()[0];
+  dolfinx_contact::error::check_cell_type(cell_type);
 
   // Get what entity type we are integrating over
   std::size_t entity_dim;
@@ -66,69 +67,126 @@ dolfinx_contact::pack_coefficient_quadrature(
   {
   case dolfinx::fem::IntegralType::cell:
     entity_dim = tdim;
+    _num_entities = active_entities.size();
     break;
   case dolfinx::fem::IntegralType::exterior_facet:
     entity_dim = tdim - 1;
+    _num_entities = active_entities.size() / 2;
     break;
   default:
     throw std::invalid_argument("Unsupported integral type.");
   }
-  // Create quadrature rule
-  QuadratureRule q_rule(cell_type, q_degree, (int)entity_dim, basix::quadrature::type::Default);
-
-  // Get element information
-  const dolfinx::fem::FiniteElement<double>* element
-      = coeff->function_space()->element().get();
-  const std::size_t bs = element->block_size();
-  const std::size_t value_size = element->value_size();
 
-  // Tabulate function at quadrature points (assuming no derivatives)
-  dolfinx_contact::error::check_cell_type(cell_type);
+  // Create quadrature rule
+  QuadratureRule q_rule(cell_type, q_degree, (int)entity_dim,
+                        basix::quadrature::type::Default);
   const std::vector<double>& q_points = q_rule.points();
-  const std::vector<std::size_t>& q_offset = q_rule.offset();
-  const std::size_t sum_q_points = q_offset.back();
-  const std::size_t num_points_per_entity = q_offset[1] - q_offset[0];
+  const std::vector<std::size_t>& q_offsets = q_rule.offset();
+  const std::size_t sum_q_points = q_offsets.back();
+  _num_points = q_offsets[1] - q_offsets[0];
   std::array<std::size_t, 2> p_shape = {sum_q_points, tdim};
   assert(q_rule.tdim() == tdim);
 
+  // Get element information
+  const dolfinx::fem::FiniteElement<double>* element = V->element().get();
+  _bs = element->block_size();
+  const bool needs_dof_transformations = element->needs_dof_transformations();
+  if (gradient and needs_dof_transformations)
+  {
+    throw std::invalid_argument(
+        "Packing of gradients at quadrature points not implemented for "
+        "Function spaces requiring dof transformations.");
+  }
+
+  // Tabulate basis functions (and their first derivatives) at all
+  // quadrature points of the reference cell
+  const int num_derivatives = gradient ? 1 : 0;
   const basix::FiniteElement<double>& basix_element = element->basix_element();
   std::array<std::size_t, 4> tab_shape
-      = basix_element.tabulate_shape(0, sum_q_points);
+      = basix_element.tabulate_shape(num_derivatives, sum_q_points);
   std::vector<double> reference_basisb(
       std::reduce(tab_shape.cbegin(), tab_shape.cend(), 1, std::multiplies{}));
-  element->tabulate(reference_basisb, q_points, p_shape, 0);
+  element->tabulate(reference_basisb, q_points, p_shape, num_derivatives);
   cmdspan4_t reference_basis(reference_basisb.data(), tab_shape);
+  _num_basis = tab_shape[2];
+  _value_size = tab_shape[3];
+  assert(element->value_size() / _bs == _value_size);
+
+  // Gather the cell dofs of each entity
+  const dolfinx::fem::DofMap* dofmap = V->dofmap().get();
+  _dofmap_bs = dofmap->bs();
+  _num_cell_dofs
+      = _num_entities > 0 ? dofmap->cell_dofs(active_entities[0]).size() : 0;
+  _dofs.resize(_num_entities * _num_cell_dofs);
+  std::vector<std::int32_t> cells(_num_entities);
+  std::vector<std::int32_t> local_indices(_num_entities, 0);
+  for (std::size_t i = 0; i < _num_entities; ++i)
+  {
+    if (integral == dolfinx::fem::IntegralType::cell)
+      cells[i] = active_entities[i];
+    else
+    {
+      cells[i] = active_entities[2 * i];
+      local_indices[i] = active_entities[2 * i + 1];
+    }
+    auto dofs = dofmap->cell_dofs(cells[i]);
+    std::copy(dofs.begin(), dofs.end(),
+              std::next(_dofs.begin(), i * _num_cell_dofs));
+  }
 
-  assert(value_size / bs == tab_shape[3]);
-
-  std::function<std::array<std::int32_t, 2>(std::size_t)> get_cell_info;
-  std::size_t num_active_entities;
-  switch (integral)
+  // Without dof transformations, the basis functions are the basis
+  // functions on the reference cell, and each entity accesses the points
+  // of its local index
+  const std::size_t basis_size = _num_basis * _value_size;
+  _point_offsets.resize(_num_entities);
+  if (!needs_dof_transformations)
   {
-  case dolfinx::fem::IntegralType::cell:
-    num_active_entities = active_entities.size();
-    break;
-  case dolfinx::fem::IntegralType::exterior_facet:
-    num_active_entities = active_entities.size() / 2;
-    break;
-  default:
-    throw std::invalid_argument("Unsupported integral type.");
+    _basis.resize(sum_q_points * basis_size);
+    for (std::size_t q = 0; q < sum_q_points; ++q)
+      for (std::size_t d = 0; d < _num_basis; ++d)
+        for (std::size_t l = 0; l < _value_size; ++l)
+          _basis[(q * _num_basis + d) * _value_size + l]
+              = reference_basis(0, q, d, l);
+    for (std::size_t i = 0; i < _num_entities; ++i)
+      _point_offsets[i] = q_offsets[local_indices[i]];
+  }
+  else
+  {
+    _basis.resize(_num_entities * _num_points * basis_size);
+    for (std::size_t i = 0; i < _num_entities; ++i)
+      _point_offsets[i] = i * _num_points;
   }
 
-  // Create output array
-  const std::vector<std::size_t>& q_offsets = q_rule.offset();
-  const auto cstride = int(value_size * num_points_per_entity);
-  std::vector<PetscScalar> coefficients(num_active_entities * cstride, 0.0);
+  // Nothing depends on the geometry
+  if (!gradient and !needs_dof_transformations)
+    return;
 
-  // Get the coeffs to pack
-  const std::span<const double> data = coeff->x()->array();
+  // Get geometry data
+  const dolfinx::mesh::Geometry<double>& geometry = mesh->geometry();
+  _gdim = geometry.dim();
+  stdex::mdspan<const std::int32_t,
+                MDSPAN_IMPL_STANDARD_NAMESPACE::dextents<std::size_t, 2>>
+      x_dofmap = geometry.dofmap();
+  const dolfinx::fem::CoordinateElement<double>& cmap = geometry.cmaps()[0];
+  const std::size_t num_dofs_g = cmap.dim();
+  std::span<const double> x_g = geometry.x();
 
-  // Get dofmap info
-  const dolfinx::fem::DofMap* dofmap = coeff->function_space()->dofmap().get();
-  const std::size_t dofmap_bs = dofmap->bs();
+  // Tabulate coordinate basis to compute Jacobian
+  std::array<std::size_t, 4> c_shape = cmap.tabulate_shape(1, sum_q_points);
+  std::vector<double> c_basisb(
+      std::reduce(c_shape.cbegin(), c_shape.cend(), 1, std::multiplies{}));
+  cmap.tabulate(1, q_points, p_shape, c_basisb);
+  cmdspan4_t c_basis(c_basisb.data(), c_shape);
 
-  // Get dof transformations
-  const bool needs_dof_transformations = element->needs_dof_transformations();
+  // Prepare geometry data structures
+  std::array<double, 9> Jb;
+  std::array<double, 9> Kb;
+  mdspan2_t J(Jb.data(), _gdim, tdim);
+  mdspan2_t K(Kb.data(), tdim, _gdim);
+  std::vector<double> detJ_scratch(2 * _gdim * tdim);
+  std::vector<double> coordinate_dofsb(num_dofs_g * _gdim);
+  mdspan2_t coordinate_dofs(coordinate_dofsb.data(), num_dofs_g, _gdim);
+  std::vector<double> element_basisb(basis_size);
   std::span<const std::uint32_t> cell_info;
   if (needs_dof_transformations)
   {
@@ -136,400 +194,221 @@ dolfinx_contact::pack_coefficient_quadrature(
     cell_info = topology->get_cell_permutation_info();
   }
 
-  if (needs_dof_transformations)
+  if (gradient)
+    _grad_basis.resize(_num_entities * _num_points * basis_size * _gdim);
+  for (std::size_t i = 0; i < _num_entities; ++i)
   {
-    const auto num_points = q_offsets.back();
-
-    // Get geometry data
-    const dolfinx::mesh::Geometry<double>& geometry = mesh->geometry();
-    const int gdim = geometry.dim();
-    stdex::mdspan<const std::int32_t, MDSPAN_IMPL_STANDARD_NAMESPACE::dextents<std::size_t, 2>> x_dofmap
-        = mesh->geometry().dofmap();
-    const dolfinx::fem::CoordinateElement<double>& cmap = geometry.cmaps()[0];
-    const std::size_t num_dofs_g = cmap.dim();
-    std::span<const double> x_g = geometry.x();
-
-    // Tabulate coordinate basis to compute Jacobian
-    std::array<std::size_t, 4> c_shape = cmap.tabulate_shape(1, num_points);
-    std::vector<double> c_basisb(
-        std::reduce(c_shape.cbegin(), c_shape.cend(), 1, std::multiplies{}));
-    cmap.tabulate(1, q_points, p_shape, c_basisb);
-    cmdspan4_t c_basis(c_basisb.data(), c_shape);
-
-    // Prepare geometry data structures
-    std::array<double, 9> Jb;
-    std::array<double, 9> Kb;
-    mdspan2_t J(Jb.data(), gdim, tdim);
-    mdspan2_t K(Kb.data(), tdim, gdim);
-    std::vector<double> detJ_scratch(2 * gdim * tdim);
-    std::vector<double> coordinate_dofsb(num_dofs_g * gdim);
-    mdspan2_t coordinate_dofs(coordinate_dofsb.data(), num_dofs_g, gdim);
-
-    // Prepare transformation function
-    std::vector<double> element_basisb(tab_shape[2] * tab_shape[3]);
-    std::vector<double> basis_valuesb(num_points_per_entity * tab_shape[2]
-                                      * tab_shape[3]);
-    mdspan3_t basis_values(basis_valuesb.data(), num_points_per_entity,
-                           tab_shape[2], tab_shape[3]);
-
-    for (std::size_t i = 0; i < num_active_entities; i++)
+    // Get cell geometry (coordinate dofs)
+    auto x_dofs = stdex::submdspan(x_dofmap, cells[i],
+                                   MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent);
+    assert(x_dofs.size() == num_dofs_g);
+    for (std::size_t j = 0; j < num_dofs_g; ++j)
     {
-      // Get local cell info
-      std::int32_t cell;
-      std::int32_t entity_index;
-      switch (integral)
-      {
-      case dolfinx::fem::IntegralType::cell:
-        cell = active_entities[i];
-        entity_index = 0;
-        break;
-      case dolfinx::fem::IntegralType::exterior_facet:
-        cell = active_entities[2 * i];
-        entity_index = active_entities[2 * i + 1];
-        break;
-      default:
-        throw std::invalid_argument("Unsupported integral type.");
-      }
-
-      // Get cell geometry (coordinate dofs)
-      auto x_dofs = stdex::submdspan(x_dofmap, cell, MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent);
-      assert(x_dofs.size() == num_dofs_g);
-      for (std::size_t j = 0; j < num_dofs_g; ++j)
-      {
-        auto pos = 3 * x_dofs[j];
-        for (std::size_t k = 0; k < coordinate_dofs.extent(1); ++k)
-          coordinate_dofs(j, k) = x_g[pos + k];
-      }
+      auto pos = 3 * x_dofs[j];
+      for (std::size_t k = 0; k < coordinate_dofs.extent(1); ++k)
+        coordinate_dofs(j, k) = x_g[pos + k];
+    }
 
-      if (cmap.is_affine())
+    const std::size_t q_offset = q_offsets[local_indices[i]];
+    mdspan3_t basis_values(_basis.data() + i * _num_points * basis_size,
+                           _num_points, _num_basis, _value_size);
+    double detJ = 0;
+    for (std::size_t q = 0; q < _num_points; ++q)
+    {
+      // The jacobian is only computed once for affine geometries
+      if (q == 0 or !cmap.is_affine())
       {
         std::fill(Jb.begin(), Jb.end(), 0);
-        auto dphi_q
-            = stdex::submdspan(c_basis, std::pair{1, std::size_t(tdim + 1)},
-                               q_offsets[entity_index], MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent, 0);
+        auto dphi_q = stdex::submdspan(
+            c_basis, std::pair{1, std::size_t(tdim + 1)}, q_offset + q,
+            MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent, 0);
         dolfinx::fem::CoordinateElement<double>::compute_jacobian(
             dphi_q, coordinate_dofs, J);
-        dolfinx::fem::CoordinateElement<double>::compute_jacobian_inverse(J, K);
-        double detJ = dolfinx::fem::CoordinateElement<
+        dolfinx::fem::CoordinateElement<double>::compute_jacobian_inverse(J,
+                                                                          K);
+        detJ = dolfinx::fem::CoordinateElement<
             double>::compute_jacobian_determinant(J, detJ_scratch);
-
-        for (std::size_t q = 0; q < num_points_per_entity; ++q)
-        {
-          transformed_push_forward(element, reference_basis, element_basisb,
-                                   basis_values, J, K, detJ,
-                                   q_offsets[entity_index], q, cell, cell_info);
-        }
       }
-      else
+
+      if (needs_dof_transformations)
       {
-        for (std::size_t q = 0; q < num_points_per_entity; ++q)
-        {
-          std::fill(Jb.begin(), Jb.end(), 0);
-          auto dphi_q = stdex::submdspan(
-              c_basis, std::pair{1, std::size_t(tdim + 1)},
-              q_offsets[entity_index] + q, MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent, 0);
-          dolfinx::fem::CoordinateElement<double>::compute_jacobian(
-              dphi_q, coordinate_dofs, J);
-          dolfinx::fem::CoordinateElement<double>::compute_jacobian_inverse(J,
-                                                                            K);
-          double detJ = dolfinx::fem::CoordinateElement<
-              double>::compute_jacobian_determinant(J, detJ_scratch);
-
-          transformed_push_forward(element, reference_basis, element_basisb,
-                                   basis_values, J, K, detJ,
-                                   q_offsets[entity_index], q, cell, cell_info);
-        }
+        transformed_push_forward(element, reference_basis, element_basisb,
+                                 basis_values, J, K, detJ, q_offset, q,
+                                 cells[i], cell_info);
       }
-      // Sum up quadrature contributions
-      auto dofs = dofmap->cell_dofs(cell);
-      for (std::size_t d = 0; d < dofs.size(); ++d)
-      {
-        const int pos_v = (int)dofmap_bs * dofs[d];
 
-        for (std::size_t q = 0; q < num_points_per_entity; ++q)
-          for (std::size_t k = 0; k < dofmap_bs; ++k)
-            for (std::size_t j = 0; j < tab_shape[3]; j++)
-              coefficients[cstride * i + q * value_size + k + j]
-                  += basis_values(q, d, j) * data[pos_v + k];
+      if (gradient)
+      {
+        // Multiply the reference derivatives by K (the inverse jacobian)
+        const std::size_t offset = (i * _num_points + q) * basis_size * _gdim;
+        for (std::size_t d = 0; d < _num_basis; ++d)
+          for (std::size_t l = 0; l < _value_size; ++l)
+            for (std::size_t j = 0; j < _gdim; ++j)
+            {
+              double dphi = 0;
+              for (std::size_t k = 0; k < tdim; ++k)
+                dphi += K(k, j) * reference_basis(k + 1, q_offset + q, d, l);
+              _grad_basis[offset + (d * _value_size + l) * _gdim + j] = dphi;
+            }
       }
     }
   }
-  else
+}
+//-----------------------------------------------------------------------------
+void dolfinx_contact::QuadraturePacker::check_space(
+    const dolfinx::fem::Function<PetscScalar>& coeff) const
+{
+  if (!(*coeff.function_space() == *_V))
   {
-    // Loop over all entities
-    for (std::size_t i = 0; i < num_active_entities; i++)
-    {
-      // Get local cell info
-      std::int32_t cell;
-      std::int32_t entity_index;
-      switch (integral)
-      {
-      case dolfinx::fem::IntegralType::cell:
-        cell = active_entities[i];
-        entity_index = 0;
-        break;
-      case dolfinx::fem::IntegralType::exterior_facet:
-        cell = active_entities[2 * i];
-        entity_index = active_entities[2 * i + 1];
-        break;
-      default:
-        throw std::invalid_argument("Unsupported integral type.");
-      }
+    throw std::invalid_argument(
+        "Function is not in the function space of the packer.");
+  }
+}
+//-----------------------------------------------------------------------------
+std::pair<std::vector<PetscScalar>, int>
+dolfinx_contact::QuadraturePacker::pack(
+    const dolfinx::fem::Function<PetscScalar>& coeff) const
+{
+  const std::size_t cstride = value_stride();
+  std::vector<PetscScalar> coefficients(_num_entities * cstride);
+  pack(coeff, coefficients, strided_positions(_num_entities, cstride));
+  return {std::move(coefficients), (int)cstride};
+}
+//-----------------------------------------------------------------------------
+void dolfinx_contact::QuadraturePacker::pack(
+    const dolfinx::fem::Function<PetscScalar>& coeff,
+    std::span<PetscScalar> c, std::span<const std::int32_t> positions) const
+{
+  check_space(coeff);
+  if (positions.size() > _num_entities)
+    throw std::invalid_argument("More positions than active entities.");
 
-      auto dofs = dofmap->cell_dofs(cell);
-      const std::size_t q_offset = q_offsets[entity_index];
+  // Get the coeffs to pack
+  const std::span<const PetscScalar> data = coeff.x()->array();
+  cmdspan3_t basis(_basis.data(), _basis.size() / (_num_basis * _value_size),
+                   _num_basis, _value_size);
 
-      // Loop over all dofs in cell
-      for (std::size_t d = 0; d < dofs.size(); ++d)
+  // Loop over all entities
+  const std::size_t cstride = value_stride();
+  for (std::size_t i = 0; i < positions.size(); i++)
+  {
+    std::span<PetscScalar> coefficients = c.subspan(positions[i], cstride);
+    std::fill(coefficients.begin(), coefficients.end(), 0.0);
+    std::span<const std::int32_t> dofs(_dofs.data() + i * _num_cell_dofs,
+                                       _num_cell_dofs);
+    const std::size_t q_offset = _point_offsets[i];
+
+    // Loop over all dofs in cell
+    for (std::size_t d = 0; d < dofs.size(); ++d)
+    {
+      const std::size_t pos_v = _dofmap_bs * dofs[d];
+      // Unroll dofmap
+      for (std::size_t b = 0; b < _dofmap_bs; ++b)
       {
-        const int pos_v = (int)dofmap_bs * dofs[d];
-        // Unroll dofmap
-        for (std::size_t b = 0; b < dofmap_bs; ++b)
-        {
-          auto coeff = data[pos_v + b];
-          std::div_t pos = std::div(int(d * dofmap_bs + b), (int)bs);
+        auto coeff_val = data[pos_v + b];
+        std::div_t pos = std::div(int(d * _dofmap_bs + b), (int)_bs);
 
-          // Pack coefficients for each quadrature point
-          for (std::size_t q = 0; q < num_points_per_entity; ++q)
+        // Pack coefficients for each quadrature point
+        for (std::size_t q = 0; q < _num_points; ++q)
+        {
+          // Access each component of the basis function (in the case of
+          // vector spaces)
+          for (std::size_t l = 0; l < _value_size; ++l)
           {
-            // Access each component of the reference basis function (in the
-            // case of vector spaces)
-            for (std::size_t l = 0; l < tab_shape[3]; ++l)
-            {
-              coefficients[cstride * i + q * bs * tab_shape[3] + l + pos.rem]
-                  += reference_basis(0, q_offset + q, pos.quot, l) * coeff;
-            }
+            coefficients[q * _bs * _value_size + l + pos.rem]
+                += basis(q_offset + q, pos.quot, l) * coeff_val;
           }
         }
       }
     }
   }
-  return {std::move(coefficients), cstride};
 }
-
+//-----------------------------------------------------------------------------
 std::pair<std::vector<PetscScalar>, int>
-dolfinx_contact::pack_gradient_quadrature(
-    std::shared_ptr<const dolfinx::fem::Function<PetscScalar>> coeff,
-    const int q_degree, std::span<const std::int32_t> active_entities,
-    dolfinx::fem::IntegralType integral)
+dolfinx_contact::QuadraturePacker::pack_gradient(
+    const dolfinx::fem::Function<PetscScalar>& coeff) const
 {
-
-  // Get mesh
-  std::shared_ptr<const dolfinx::mesh::Mesh<double>> mesh
-      = coeff->function_space()->mesh();
-  assert(mesh);
-
-  // Get topology data
-  auto topology = mesh->topology();
-  const std::size_t tdim = topology->dim();
-  const dolfinx::mesh::CellType cell_type = topology->cell_types()[0];
-
-  // Get what entity type we are integrating over
-  std::size_t entity_dim;
-  switch (integral)
-  {
-  case dolfinx::fem::IntegralType::cell:
-    entity_dim = tdim;
-    break;
-  case dolfinx::fem::IntegralType::exterior_facet:
-    entity_dim = tdim - 1;
-    break;
-  default:
-    throw std::invalid_argument("Unsupported integral type.");
-  }
-
-  // Create quadrature rule
-  QuadratureRule q_rule(cell_type, q_degree, (int)entity_dim, basix::quadrature::type::Default);
-
-  // Get element information
-  const dolfinx::fem::FiniteElement<double>* element
-      = coeff->function_space()->element().get();
-  const std::size_t bs = element->block_size();
-  const std::size_t value_size = element->value_size();
-
-  // Tabulate function at quadrature points (assuming one derivatives)
-  dolfinx_contact::error::check_cell_type(cell_type);
-  const std::vector<double>& q_points = q_rule.points();
-  const std::vector<std::size_t>& q_offsets = q_rule.offset();
-  const std::size_t sum_q_points = q_offsets.back();
-  const std::size_t num_points_per_entity = q_offsets[1] - q_offsets[0];
-  std::array<std::size_t, 2> p_shape = {sum_q_points, tdim};
-  assert(q_rule.tdim() == tdim);
-
-  const basix::FiniteElement<double>& basix_element = element->basix_element();
-  std::array<std::size_t, 4> tab_shape
-      = basix_element.tabulate_shape(1, sum_q_points);
-  std::vector<double> reference_basisb(
-      std::reduce(tab_shape.cbegin(), tab_shape.cend(), 1, std::multiplies{}));
-  element->tabulate(reference_basisb, q_points, p_shape, 1);
-  cmdspan4_t reference_basis(reference_basisb.data(), tab_shape);
-  assert(value_size / bs == tab_shape[3]);
-
-  // Get geometry data
-  const dolfinx::mesh::Geometry<double>& geometry = mesh->geometry();
-  const std::size_t gdim = geometry.dim();
-  stdex::mdspan<const std::int32_t, MDSPAN_IMPL_STANDARD_NAMESPACE::dextents<std::size_t, 2>> x_dofmap
-      = geometry.dofmap();
-  const dolfinx::fem::CoordinateElement<double>& cmap = geometry.cmaps()[0];
-
-  const std::size_t num_dofs_g = cmap.dim();
-  std::span<const double> x_g = geometry.x();
-
-  // Tabulate coordinate basis to compute Jacobian
-  std::array<std::size_t, 4> c_shape = cmap.tabulate_shape(1, sum_q_points);
-  std::vector<double> c_basisb(
-      std::reduce(c_shape.cbegin(), c_shape.cend(), 1, std::multiplies{}));
-  cmap.tabulate(1, q_points, p_shape, c_basisb);
-  cmdspan4_t c_basis(c_basisb.data(), c_shape);
-
-  // Prepare geometry data structures
-  std::array<double, 9> Jb;
-  std::array<double, 9> Kb;
-  mdspan2_t J(Jb.data(), gdim, tdim);
-  mdspan2_t K(Kb.data(), tdim, gdim);
-  std::vector<double> detJ_scratch(2 * gdim * tdim);
-  std::vector<double> coordinate_dofsb(num_dofs_g * gdim);
-  mdspan2_t coordinate_dofs(coordinate_dofsb.data(), num_dofs_g, gdim);
-
-  std::size_t num_active_entities;
-  switch (integral)
+  const std::size_t cstride = gradient_stride();
+  std::vector<PetscScalar> coefficients(_num_entities * cstride);
+  pack_gradient(coeff, coefficients, strided_positions(_num_entities, cstride));
+  return {std::move(coefficients), (int)cstride};
+}
+//-----------------------------------------------------------------------------
+void dolfinx_contact::QuadraturePacker::pack_gradient(
+    const dolfinx::fem::Function<PetscScalar>& coeff,
+    std::span<PetscScalar> c, std::span<const std::int32_t> positions) const
+{
+  check_space(coeff);
+  if (!_gradient)
   {
-  case dolfinx::fem::IntegralType::cell:
-    num_active_entities = active_entities.size();
-    break;
-  case dolfinx::fem::IntegralType::exterior_facet:
-    num_active_entities = active_entities.size() / 2;
-    break;
-  default:
-    throw std::invalid_argument("Unsupported integral type.");
+    throw std::runtime_error(
+        "Gradients of the basis functions have not been tabulated.");
   }
-
-  // Create output array
-  const auto cstride = int(value_size * num_points_per_entity * gdim);
-  std::vector<PetscScalar> coefficients(num_active_entities * cstride, 0.0);
+  if (positions.size() > _num_entities)
+    throw std::invalid_argument("More positions than active entities.");
 
   // Get the coeffs to pack
-  const std::span<const double> data = coeff->x()->array();
-
-  // Get dofmap info
-  const dolfinx::fem::DofMap* dofmap = coeff->function_space()->dofmap().get();
-  const std::size_t dofmap_bs = dofmap->bs();
-
-  // Get dof transformations
-  if (element->needs_dof_transformations())
-  {
-    throw std::invalid_argument(
-        "Packing of gradients at quadrature points not implemented for "
-        "Function spaces requiring dof transformations.");
-  }
+  const std::span<const PetscScalar> data = coeff.x()->array();
+  const std::size_t basis_size = _num_basis * _value_size * _gdim;
 
   // Loop over all entities
-  for (std::size_t i = 0; i < num_active_entities; i++)
+  const std::size_t cstride = gradient_stride();
+  for (std::size_t i = 0; i < positions.size(); i++)
   {
-    // Get local cell info
-    std::int32_t cell;
-    std::int32_t entity_index;
-    switch (integral)
-    {
-    case dolfinx::fem::IntegralType::cell:
-      cell = active_entities[i];
-      entity_index = 0;
-      break;
-    case dolfinx::fem::IntegralType::exterior_facet:
-      cell = active_entities[2 * i];
-      entity_index = active_entities[2 * i + 1];
-      break;
-    default:
-      throw std::invalid_argument("Unsupported integral type.");
-    }
-
-    // Get cell geometry (coordinate dofs)
-    auto x_dofs = stdex::submdspan(x_dofmap, cell, MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent);
-    assert(x_dofs.size() == num_dofs_g);
-    for (std::size_t j = 0; j < num_dofs_g; ++j)
-    {
-      auto pos = 3 * x_dofs[j];
-      for (std::size_t k = 0; k < coordinate_dofs.extent(1); ++k)
-        coordinate_dofs(j, k) = x_g[pos + k];
-    }
-    auto dofs = dofmap->cell_dofs(cell);
-    const std::size_t q_offset = q_offsets[entity_index];
+    std::span<PetscScalar> coefficients = c.subspan(positions[i], cstride);
+    std::fill(coefficients.begin(), coefficients.end(), 0.0);
+    std::span<const std::int32_t> dofs(_dofs.data() + i * _num_cell_dofs,
+                                       _num_cell_dofs);
 
     // Loop over all dofs in cell
     for (std::size_t d = 0; d < dofs.size(); ++d)
     {
-      const int pos_v = (int)dofmap_bs * dofs[d];
+      const std::size_t pos_v = _dofmap_bs * dofs[d];
       // Unroll dofmap
-      for (std::size_t b = 0; b < dofmap_bs; ++b)
+      for (std::size_t b = 0; b < _dofmap_bs; ++b)
       {
         auto coeff_val = data[pos_v + b];
-        std::div_t pos = std::div(int(d * dofmap_bs + b), (int)bs);
+        std::div_t pos = std::div(int(d * _dofmap_bs + b), (int)_bs);
 
         // Pack coefficients for each quadrature point
-        if (cmap.is_affine())
+        for (std::size_t q = 0; q < _num_points; ++q)
         {
-          // compute jacobian and its inverse once for affine geometries
-          std::fill(Jb.begin(), Jb.end(), 0);
-          auto dphi_q = stdex::submdspan(
-              c_basis, std::pair{1, std::size_t(tdim + 1)},
-              q_offsets[entity_index], MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent, 0);
-          dolfinx::fem::CoordinateElement<double>::compute_jacobian(
-              dphi_q, coordinate_dofs, J);
-          dolfinx::fem::CoordinateElement<double>::compute_jacobian_inverse(J,
-                                                                            K);
-          for (std::size_t q = 0; q < num_points_per_entity; ++q)
-          {
-
-            // Access each component of the reference basis function (in the
-            // case of vector spaces)
-            // multiply by K (the inverse jacobian)
-            for (std::size_t l = 0; l < tab_shape[3]; ++l)
+          const double* dphi
+              = _grad_basis.data() + (i * _num_points + q) * basis_size
+                + pos.quot * _value_size * _gdim;
+          for (std::size_t l = 0; l < _value_size; ++l)
+            for (std::size_t j = 0; j < _gdim; j++)
             {
-              for (std::size_t j = 0; j < gdim; j++)
-                for (std::size_t k = 0; k < tdim; k++)
-
-                  coefficients[cstride * i + q * bs * tab_shape[3] * gdim
-                               + (l + pos.rem) * gdim + j]
-                      += K(k, j)
-                         * reference_basis(k + 1, q_offset + q, pos.quot, l)
-                         * coeff_val;
+              coefficients[q * _bs * _value_size * _gdim
+                           + (l + pos.rem) * _gdim + j]
+                  += dphi[l * _gdim + j] * coeff_val;
             }
-          }
-        }
-        else
-        {
-          for (std::size_t q = 0; q < num_points_per_entity; ++q)
-          {
-            // compute jacobian for each quadrature point
-            std::fill(Jb.begin(), Jb.end(), 0);
-            auto dphi_q = stdex::submdspan(
-                c_basis, std::pair{1, std::size_t(tdim + 1)},
-                q_offsets[entity_index] + q, MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent, 0);
-            dolfinx::fem::CoordinateElement<double>::compute_jacobian(
-                dphi_q, coordinate_dofs, J);
-            dolfinx::fem::CoordinateElement<double>::compute_jacobian_inverse(
-                J, K);
-            // Access each component of the reference basis function (in the
-            // case of vector spaces)
-            // multiply by K (the inverse jacobian)
-            for (std::size_t l = 0; l < tab_shape[3]; ++l)
-            {
-              for (std::size_t j = 0; j < gdim; j++)
-                for (std::size_t k = 0; k < tdim; k++)
-
-                  coefficients[cstride * i + q * bs * tab_shape[3] * gdim
-                               + (l + pos.rem) * gdim + j]
-                      += K(k, j)
-                         * reference_basis(k + 1, q_offset + q, pos.quot, l)
-                         * coeff_val;
-            }
-          }
         }
       }
     }
   }
-
-  return {std::move(coefficients), cstride};
+}
+//-----------------------------------------------------------------------------
+std::pair<std::vector<PetscScalar>, int>
+dolfinx_contact::pack_coefficient_quadrature(
+    std::shared_ptr<const dolfinx::fem::Function<PetscScalar>> coeff,
+    const int q_degree, std::span<const std::int32_t> active_entities,
+    dolfinx::fem::IntegralType integral)
+{
+  QuadraturePacker packer(coeff->function_space(), q_degree, active_entities,
+                          integral, false);
+  return packer.pack(*coeff);
+}
+//-----------------------------------------------------------------------------
+std::pair<std::vector<PetscScalar>, int>
+dolfinx_contact::pack_gradient_quadrature(
+    std::shared_ptr<const dolfinx::fem::Function<PetscScalar>> coeff,
+    const int q_degree, std::span<const std::int32_t> active_entities,
+    dolfinx::fem::IntegralType integral)
+{
+  QuadraturePacker packer(coeff->function_space(), q_degree, active_entities,
+                          integral, true);
+  return packer.pack_gradient(*coeff);
 }
 
 //-----------------------------------------------------------------------------
@@ -8,7 +8,10 @@
 #include "QuadratureRule.h"
 #include <dolfinx/fem/Function.h>
 #include <dolfinx/fem/petsc.h>
+#include <memory>
+#include <span>
 #include <variant>
+#include <vector>
 namespace dolfinx_contact
 {
 
@@ -32,6 +35,128 @@ void transformed_push_forward(
     std::vector<double>& element_basisb, mdspan3_t basis_values, cmdspan2_t J,
     cmdspan2_t K, double detJ, std::size_t basis_offset, std::size_t q,
     std::int32_t cell, std::span<const std::uint32_t> cell_info);
+
+/// @brief Pack coefficients and their gradients at the quadrature points of
+/// a fixed set of entities.
+///
+/// The quadrature rule, the tabulated basis functions and the cell dofs of
+/// the active entities are computed once on construction. For spaces requiring
+/// dof transformations the transformed basis functions are pushed forward to
+/// each entity, and the physical gradients of the basis functions are stored
+/// when gradients are requested. Packing a function in the space only
+/// gathers its dofs and contracts them with the cached basis functions. The
+/// layout of the output is the same as for `pack_coefficient_quadrature` and
+/// `pack_gradient_quadrature`.
+///
+/// @note The cached data depends on the mesh geometry, so a new packer has to
+/// be created if the geometry of the mesh changes.
+class QuadraturePacker
+{
+public:
+  /// Constructor
+  /// @param[in] V The function space of the coefficients to pack
+  /// @param[in] q_degree The quadrature degree
+  /// @param[in] active_entities List of active entities
+  /// @param[in] integral The integral type (cells or exterior facet)
+  /// @param[in] gradient If true, the gradients of the basis functions are
+  /// cached such that `pack_gradient` can be used
+  QuadraturePacker(
+      std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+      int q_degree, std::span<const std::int32_t> active_entities,
+      dolfinx::fem::IntegralType integral, bool gradient = false);
+
+  /// Pack a coefficient at the quadrature points of the active entities
+  /// @param[in] coeff The coefficient. Has to be in the function space of the
+  /// packer
+  /// @returns c The packed coefficients and the number of coeffs per entity
+  std::pair<std::vector<PetscScalar>, int>
+  pack(const dolfinx::fem::Function<PetscScalar>& coeff) const;
+
+  /// Pack a coefficient at the quadrature points of the active entities
+  /// directly into a coefficient array
+  /// @param[in] coeff The coefficient. Has to be in the function space of the
+  /// packer
+  /// @param[in,out] c The coefficient array. The values of the ith entity are
+  /// written to `c[positions[i]:positions[i] + value_stride()]`
+  /// @param[in] positions The position of the data of each entity. Only the
+  /// first `positions.size()` entities are packed
+  void pack(const dolfinx::fem::Function<PetscScalar>& coeff,
+            std::span<PetscScalar> c,
+            std::span<const std::int32_t> positions) const;
+
+  /// Pack the gradient of a coefficient at the quadrature points of the
+  /// active entities
+  /// @param[in] coeff The coefficient. Has to be in the function space of the
+  /// packer
+  /// @returns c The packed coefficients and the number of coeffs per entity
+  std::pair<std::vector<PetscScalar>, int>
+  pack_gradient(const dolfinx::fem::Function<PetscScalar>& coeff) const;
+
+  /// Pack the gradient of a coefficient at the quadrature points of the
+  /// active entities directly into a coefficient array
+  /// @param[in] coeff The coefficient. Has to be in the function space of the
+  /// packer
+  /// @param[in,out] c The coefficient array. The values of the ith entity are
+  /// written to `c[positions[i]:positions[i] + gradient_stride()]`
+  /// @param[in] positions The position of the data of each entity. Only the
+  /// first `positions.size()` entities are packed
+  void pack_gradient(const dolfinx::fem::Function<PetscScalar>& coeff,
+                     std::span<PetscScalar> c,
+                     std::span<const std::int32_t> positions) const;
+
+  /// Return the number of packed values per entity
+  std::size_t value_stride() const { return _bs * _value_size * _num_points; }
+
+  /// Return the number of packed gradient values per entity
+  std::size_t gradient_stride() const { return value_stride() * _gdim; }
+
+  /// Return the function space
+  std::shared_ptr<const dolfinx::fem::FunctionSpace<double>>
+  function_space() const
+  {
+    return _V;
+  }
+
+  /// Return the number of active entities
+  std::size_t num_entities() const { return _num_entities; }
+
+private:
+  // Throw if coeff is not in the function space of the packer
+  void check_space(const dolfinx::fem::Function<PetscScalar>& coeff) const;
+
+  // The function space
+  std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> _V;
+
+  // True if the gradients of the basis functions are cached
+  bool _gradient;
+
+  // Number of entities and quadrature points per entity
+  std::size_t _num_entities = 0;
+  std::size_t _num_points = 0;
+
+  // Element data: block size, number of basis functions and value size of
+  // the (unblocked) element
+  std::size_t _bs = 1;
+  std::size_t _num_basis = 0;
+  std::size_t _value_size = 0;
+  std::size_t _gdim = 0;
+
+  // Cell dofs of each entity, flattened (num_entities, num_cell_dofs)
+  std::size_t _dofmap_bs = 1;
+  std::size_t _num_cell_dofs = 0;
+  std::vector<std::int32_t> _dofs;
+
+  // Basis functions (num_points, num_basis, value_size). The values at
+  // the quadrature points of the ith entity start at row
+  // _point_offsets[i]
+  std::vector<double> _basis;
+  std::vector<std::size_t> _point_offsets;
+
+  // Physical gradients of the basis functions (num_entities, num_points,
+  // num_basis, value_size, gdim)
+  std::vector<double> _grad_basis;
+};
+
 /// @brief Pack a coefficient at quadrature points.
 ///
 /// Prepare a coefficient (dolfinx::fem::Function) for assembly with custom
@@ -53,6 +178,8 @@ void transformed_push_forward(
 /// @param[in] active_entities List of active entities.
 /// @param[in] integral The integral type (cells or exterior facet)
 /// @returns c The packed coefficients and the number of coeffs per entity
+/// @note Use a QuadraturePacker to pack coefficients repeatedly on the same
+/// entities
 std::pair<std::vector<PetscScalar>, int> pack_coefficient_quadrature(
     std::shared_ptr<const dolfinx::fem::Function<PetscScalar>> coeff,
     const int q_degree, std::span<const std::int32_t> active_entities,
@@ -80,6 +207,8 @@ std::pair<std::vector<PetscScalar>, int> pack_coefficient_quadrature(
 /// @param[in] active_entities List of active entities.
 /// @param[in] integral The integral type (cells or exterior facet)
 /// @returns c The packed coefficients and the number of coeffs per entity
+/// @note Use a QuadraturePacker to pack gradients repeatedly on the same
+/// entities
 std::pair<std::vector<PetscScalar>, int> pack_gradient_quadrature(
     std::shared_ptr<const dolfinx::fem::Function<PetscScalar>> coeff,
     const int q_degree, std::span<const std::int32_t> active_entities,
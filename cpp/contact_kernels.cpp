@@ -5,11 +5,17 @@
 // SPDX-License-Identifier:    MIT
 
 #include "contact_kernels.h"
-dolfinx_contact::kernel_fn<PetscScalar>
-dolfinx_contact::generate_contact_kernel(
-    dolfinx_contact::Kernel type,
+
+using namespace dolfinx_contact;
+
+namespace
+{
+/// @brief Create the kernel data of the contact kernels
+///
+/// See `generate_contact_kernel` for a description of the input arguments
+KernelData contact_kernel_data(
     std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
-    std::shared_ptr<const dolfinx_contact::QuadratureRule> quadrature_rule,
+    std::shared_ptr<const QuadratureRule> quadrature_rule,
     const std::size_t max_links)
 {
   std::shared_ptr<const dolfinx::mesh::Mesh<double>> mesh = V->mesh();
@@ -44,6 +50,26 @@ dolfinx_contact::generate_contact_kernel(
          num_q_points * gdim};
 
   auto kd = dolfinx_contact::KernelData(V, quadrature_rule, cstrides);
+  kd.set_link_coefficients(3, 4, max_links);
+  return kd;
+}
+
+/// @brief Generate contact kernel for a fixed geometric dimension and number
+/// of dofs per cell
+///
+/// If `GDIM` and `NDOFS` are non-zero, the loop bounds over the spatial
+/// dimension, block size and cell dofs are known at compile time. Zero means
+/// that the value is read from the function space at runtime.
+/// @note For `GDIM > 0` it is assumed that `bs == tdim == gdim`.
+/// See `generate_contact_kernel` for a description of the input arguments
+template <std::size_t GDIM, std::size_t NDOFS>
+kernel_fn<PetscScalar>
+contact_kernel(Kernel type,
+               std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+               std::shared_ptr<const QuadratureRule> quadrature_rule,
+               const std::size_t max_links)
+{
+  KernelData kd = contact_kernel_data(V, quadrature_rule, max_links);
 
   /// @brief Assemble kernel for RHS of unbiased contact problem
   ///
@@ -60,17 +86,27 @@ dolfinx_contact::generate_contact_kernel(
   /// @param[in] num_links How many cells from opposite surface are connected
   /// with the cell.
   /// @param[in] q_indices The quadrature points to loop over
+  /// @param[in,out] workspace Scratch memory used by the kernel
   kernel_fn<PetscScalar> unbiased_rhs =
-      [kd, gdim, ndofs_cell,
-       bs](std::vector<std::vector<PetscScalar>>& b,
+      [kd](std::vector<std::vector<PetscScalar>>& b,
            std::span<const PetscScalar> c, const PetscScalar* w,
            const double* coordinate_dofs, const std::size_t facet_index,
-           const std::size_t num_links, std::span<const std::int32_t> q_indices)
+           const std::size_t num_links, std::span<const std::int32_t> q_indices,
+           KernelWorkspace& workspace)
 
   {
-    // Retrieve some data from kd
+    // Retrieve some data from kd. The dimensions are compile time constants
+    // for the specialised kernels (see generate_contact_kernel)
+    const std::size_t gdim = GDIM > 0 ? GDIM : kd.gdim();
+    const std::size_t ndofs_cell = NDOFS > 0 ? NDOFS : kd.ndofs_cell();
+    const std::size_t bs = GDIM > 0 ? GDIM : kd.bs();
     const std::uint32_t tdim = kd.tdim();
 
+    // Coefficient offsets of the facet, where the test functions of the
+    // linked cells may be stored ragged
+    std::array<std::size_t, KernelData::max_offsets> c_offsets;
+    kd.facet_offsets(num_links, c.size(), c_offsets);
+
     // NOTE: DOLFINx has 3D input coordinate dofs
     cmdspan2_t coord(coordinate_dofs, kd.num_coordinate_dofs(), 3);
 
@@ -115,11 +151,9 @@ dolfinx_contact::generate_contact_kernel(
 
     // Temporary data structures used inside quadrature loop
     std::array<double, 3> n_surf = {0, 0, 0};
-    std::vector<double> epsnb(ndofs_cell * gdim, 0);
-    mdspan2_t epsn(epsnb.data(), ndofs_cell, gdim);
-    std::vector<double> trb(ndofs_cell * gdim, 0);
-    mdspan2_t tr(trb.data(), ndofs_cell, gdim);
-    std::vector<double> sig_n_u(gdim);
+    mdspan2_t epsn = workspace.epsn();
+    mdspan2_t tr = workspace.tr();
+    std::span<double> sig_n_u = workspace.sig_n_u();
 
     // Loop over quadrature points
     const std::size_t q_start = kd.qp_offsets(facet_index);
@@ -140,9 +174,9 @@ dolfinx_contact::generate_contact_kernel(
       // For closest point n = -n_y
       for (std::size_t i = 0; i < gdim; i++)
       {
-        n_surf[i] = -c[kd.offsets(2) + q * gdim + i];
+        n_surf[i] = -c[c_offsets[2] + q * gdim + i];
         n_dot += n_phys[i] * n_surf[i];
-        gap += c[kd.offsets(1) + q * gdim + i] * n_surf[i];
+        gap += c[c_offsets[1] + q * gdim + i] * n_surf[i];
       }
 
       compute_normal_strain_basis(epsn, tr, K, dphi, n_surf,
@@ -151,7 +185,7 @@ dolfinx_contact::generate_contact_kernel(
       // compute sig(u)*n_phys
       std::fill(sig_n_u.begin(), sig_n_u.end(), 0.0);
       compute_sigma_n_u(sig_n_u,
-                        c.subspan(kd.offsets(5) + q * gdim * gdim, gdim * gdim),
+                        c.subspan(c_offsets[5] + q * gdim * gdim, gdim * gdim),
                         std::span(n_phys.data(), gdim), mu, lmbda);
 
       // compute inner(sig(u)*n_phys, n_surf) and inner(u, n_surf)
@@ -160,9 +194,9 @@ dolfinx_contact::generate_contact_kernel(
       for (std::size_t j = 0; j < gdim; ++j)
       {
         sign_u += sig_n_u[j] * n_surf[j];
-        jump_un += c[kd.offsets(4) + gdim * q + j] * n_surf[j];
+        jump_un += c[c_offsets[4] + gdim * q + j] * n_surf[j];
       }
-      std::size_t offset_u_opp = kd.offsets(6) + q * bs;
+      std::size_t offset_u_opp = c_offsets[6] + q * bs;
       for (std::size_t j = 0; j < bs; ++j)
         jump_un += -c[offset_u_opp + j] * n_surf[j];
 
@@ -183,7 +217,7 @@ dolfinx_contact::generate_contact_kernel(
           // entries corresponding to v on the other surface
           for (std::size_t k = 0; k < num_links; k++)
           {
-            std::size_t index = kd.offsets(3) + k * num_points * ndofs_cell * bs
+            std::size_t index = c_offsets[3] + k * num_points * ndofs_cell * bs
                                 + i * num_points * bs + q * bs + n;
             double v_n_opp = c[index] * n_surf[n];
 
@@ -210,16 +244,27 @@ dolfinx_contact::generate_contact_kernel(
   /// @param[in] num_links How many cells from opposite surface are connected
   /// with the cell.
   /// @param[in] q_indices The quadrature points to loop over
+  /// @param[in,out] workspace Scratch memory used by the kernel
   kernel_fn<PetscScalar> unbiased_jac
-      = [kd, gdim, ndofs_cell, bs](
+      = [kd](
             std::vector<std::vector<PetscScalar>>& A, std::span<const double> c,
             const double* w, const double* coordinate_dofs,
             const std::size_t facet_index, const std::size_t num_links,
-            std::span<const std::int32_t> q_indices)
+            std::span<const std::int32_t> q_indices,
+            KernelWorkspace& workspace)
   {
-    // Retrieve some data from kd
+    // Retrieve some data from kd. The dimensions are compile time constants
+    // for the specialised kernels (see generate_contact_kernel)
+    const std::size_t gdim = GDIM > 0 ? GDIM : kd.gdim();
+    const std::size_t ndofs_cell = NDOFS > 0 ? NDOFS : kd.ndofs_cell();
+    const std::size_t bs = GDIM > 0 ? GDIM : kd.bs();
     const std::uint32_t tdim = kd.tdim();
 
+    // Coefficient offsets of the facet, where the test functions of the
+    // linked cells may be stored ragged
+    std::array<std::size_t, KernelData::max_offsets> c_offsets;
+    kd.facet_offsets(num_links, c.size(), c_offsets);
+
     // NOTE: DOLFINx has 3D input coordinate dofs
     cmdspan2_t coord(coordinate_dofs, kd.num_coordinate_dofs(), 3);
 
@@ -263,11 +308,9 @@ dolfinx_contact::generate_contact_kernel(
     const std::size_t num_points = q_offset.back() - q_offset.front();
     std::span<const double> weights = kd.weights(facet_index);
     std::array<double, 3> n_surf = {0, 0, 0};
-    std::vector<double> epsnb(ndofs_cell * gdim);
-    mdspan2_t epsn(epsnb.data(), ndofs_cell, gdim);
-    std::vector<double> trb(ndofs_cell * gdim);
-    mdspan2_t tr(trb.data(), ndofs_cell, gdim);
-    std::vector<double> sig_n_u(gdim);
+    mdspan2_t epsn = workspace.epsn();
+    mdspan2_t tr = workspace.tr();
+    std::span<double> sig_n_u = workspace.sig_n_u();
 
     // Loop over quadrature points
     for (auto q : q_indices)
@@ -285,9 +328,9 @@ dolfinx_contact::generate_contact_kernel(
       // For closest point n = -n_y
       for (std::size_t i = 0; i < gdim; i++)
       {
-        n_surf[i] = -c[kd.offsets(2) + q * gdim + i];
+        n_surf[i] = -c[c_offsets[2] + q * gdim + i];
         n_dot += n_phys[i] * n_surf[i];
-        gap += c[kd.offsets(1) + q * gdim + i] * n_surf[i];
+        gap += c[c_offsets[1] + q * gdim + i] * n_surf[i];
       }
 
       compute_normal_strain_basis(epsn, tr, K, dphi, n_surf,
@@ -296,7 +339,7 @@ dolfinx_contact::generate_contact_kernel(
       // compute sig(u)*n_phys
       std::fill(sig_n_u.begin(), sig_n_u.end(), 0.0);
       compute_sigma_n_u(sig_n_u,
-                        c.subspan(kd.offsets(5) + q * gdim * gdim, gdim * gdim),
+                        c.subspan(c_offsets[5] + q * gdim * gdim, gdim * gdim),
                         std::span(n_phys.data(), gdim), mu, lmbda);
 
       // compute inner(sig(u)*n_phys, n_surf) and inner(u, n_surf)
@@ -305,9 +348,9 @@ dolfinx_contact::generate_contact_kernel(
       for (std::size_t j = 0; j < gdim; ++j)
       {
         sign_u += sig_n_u[j] * n_surf[j];
-        jump_un += c[kd.offsets(4) + gdim * q + j] * n_surf[j];
+        jump_un += c[c_offsets[4] + gdim * q + j] * n_surf[j];
       }
-      std::size_t offset_u_opp = kd.offsets(6) + q * bs;
+      std::size_t offset_u_opp = c_offsets[6] + q * bs;
       for (std::size_t j = 0; j < bs; ++j)
         jump_un += -c[offset_u_opp + j] * n_surf[j];
 
@@ -338,13 +381,13 @@ dolfinx_contact::generate_contact_kernel(
               // entries corresponding to u and v on the other surface
               for (std::size_t k = 0; k < num_links; k++)
               {
-                std::size_t index = kd.offsets(3)
+                std::size_t index = c_offsets[3]
                                     + k * num_points * ndofs_cell * bs
                                     + j * num_points * bs + q * bs + l;
                 double du_n_opp = c[index] * n_surf[l];
 
                 du_n_opp *= w0 * Pn_u;
-                index = kd.offsets(3) + k * num_points * ndofs_cell * bs
+                index = c_offsets[3] + k * num_points * ndofs_cell * bs
                         + i * num_points * bs + q * bs + b;
                 double v_n_opp = c[index] * n_surf[b];
                 A[3 * k + 1][(b + i * bs) * bs * ndofs_cell + l + j * bs]
@@ -375,17 +418,27 @@ dolfinx_contact::generate_contact_kernel(
   /// @param[in] num_links How many cells from opposite surface are connected
   /// with the cell.
   /// @param[in] q_indices The quadrature points to loop over
+  /// @param[in,out] workspace Scratch memory used by the kernel
   kernel_fn<PetscScalar> tresca_rhs =
-      [kd, gdim, ndofs_cell,
-       bs](std::vector<std::vector<PetscScalar>>& b,
+      [kd](std::vector<std::vector<PetscScalar>>& b,
            std::span<const PetscScalar> c, const PetscScalar* w,
            const double* coordinate_dofs, const std::size_t facet_index,
-           const std::size_t num_links, std::span<const std::int32_t> q_indices)
+           const std::size_t num_links, std::span<const std::int32_t> q_indices,
+           KernelWorkspace& workspace)
 
   {
-    // Retrieve some data from kd
+    // Retrieve some data from kd. The dimensions are compile time constants
+    // for the specialised kernels (see generate_contact_kernel)
+    const std::size_t gdim = GDIM > 0 ? GDIM : kd.gdim();
+    const std::size_t ndofs_cell = NDOFS > 0 ? NDOFS : kd.ndofs_cell();
+    const std::size_t bs = GDIM > 0 ? GDIM : kd.bs();
     const std::uint32_t tdim = kd.tdim();
 
+    // Coefficient offsets of the facet, where the test functions of the
+    // linked cells may be stored ragged
+    std::array<std::size_t, KernelData::max_offsets> c_offsets;
+    kd.facet_offsets(num_links, c.size(), c_offsets);
+
     // NOTE: DOLFINx has 3D input coordinate dofs
     cmdspan2_t coord(coordinate_dofs, kd.num_coordinate_dofs(), 3);
 
@@ -432,13 +485,10 @@ dolfinx_contact::generate_contact_kernel(
     // Temporary data structures used inside quadrature loop
     std::array<double, 3> n_surf = {0, 0, 0};
     std::array<double, 3> Pt_u = {0, 0, 0};
-    std::vector<double> epsnb(ndofs_cell * gdim, 0);
-    mdspan2_t epsn(epsnb.data(), ndofs_cell, gdim);
-    std::vector<double> trb(ndofs_cell * gdim, 0);
-    mdspan2_t tr(trb.data(), ndofs_cell, gdim);
-    std::vector<double> sig_n_u(gdim);
-    std::vector<double> sig_nb(ndofs_cell * gdim * gdim);
-    mdspan3_t sig_n(sig_nb.data(), ndofs_cell, gdim, gdim);
+    mdspan2_t epsn = workspace.epsn();
+    mdspan2_t tr = workspace.tr();
+    std::span<double> sig_n_u = workspace.sig_n_u();
+    mdspan3_t sig_n = workspace.sig_n();
 
     // Loop over quadrature points
     const std::size_t q_start = kd.qp_offsets(facet_index);
@@ -459,9 +509,9 @@ dolfinx_contact::generate_contact_kernel(
       // For closest point n = -n_y
       for (std::size_t i = 0; i < gdim; i++)
       {
-        n_surf[i] = -c[kd.offsets(2) + q * gdim + i];
+        n_surf[i] = -c[c_offsets[2] + q * gdim + i];
         n_dot += n_phys[i] * n_surf[i];
-        gap += c[kd.offsets(1) + q * gdim + i] * n_surf[i];
+        gap += c[c_offsets[1] + q * gdim + i] * n_surf[i];
       }
 
       compute_normal_strain_basis(epsn, tr, K, dphi, n_surf,
@@ -470,7 +520,7 @@ dolfinx_contact::generate_contact_kernel(
       // compute sig(u)*n_phys
       std::fill(sig_n_u.begin(), sig_n_u.end(), 0.0);
       compute_sigma_n_u(sig_n_u,
-                        c.subspan(kd.offsets(5) + q * gdim * gdim, gdim * gdim),
+                        c.subspan(c_offsets[5] + q * gdim * gdim, gdim * gdim),
                         std::span(n_phys.data(), gdim), mu, lmbda);
 
       compute_sigma_n_basis(sig_n, K, dphi, std::span(n_phys.data(), gdim), mu,
@@ -482,15 +532,15 @@ dolfinx_contact::generate_contact_kernel(
       for (std::size_t j = 0; j < gdim; ++j)
       {
         sign_u += sig_n_u[j] * n_surf[j];
-        jump_un += c[kd.offsets(4) + gdim * q + j] * n_surf[j];
+        jump_un += c[c_offsets[4] + gdim * q + j] * n_surf[j];
       }
-      std::size_t offset_u_opp = kd.offsets(6) + q * bs;
+      std::size_t offset_u_opp = c_offsets[6] + q * bs;
       for (std::size_t j = 0; j < bs; ++j)
         jump_un += -c[offset_u_opp + j] * n_surf[j];
 
       for (std::size_t j = 0; j < bs; ++j)
       {
-        Pt_u[j] = c[kd.offsets(4) + gdim * q + j] - c[offset_u_opp + j]
+        Pt_u[j] = c[c_offsets[4] + gdim * q + j] - c[offset_u_opp + j]
                   - jump_un * n_surf[j];
         Pt_u[j] -= gamma * (sig_n_u[j] - sign_u * n_surf[j]);
       }
@@ -525,7 +575,7 @@ dolfinx_contact::generate_contact_kernel(
           // entries corresponding to v on the other surface
           for (std::size_t k = 0; k < num_links; k++)
           {
-            std::size_t index = kd.offsets(3) + k * num_points * ndofs_cell * bs
+            std::size_t index = c_offsets[3] + k * num_points * ndofs_cell * bs
                                 + i * num_points * bs + q * bs;
             double v_n_opp = c[index + n] * n_surf[n];
 
@@ -560,16 +610,27 @@ dolfinx_contact::generate_contact_kernel(
   /// @param[in] num_links How many cells from opposite surface are connected
   /// with the cell.
   /// @param[in] q_indices The quadrature points to loop over
+  /// @param[in,out] workspace Scratch memory used by the kernel
   kernel_fn<PetscScalar> tresca_jac
-      = [kd, gdim, ndofs_cell, bs](
+      = [kd](
             std::vector<std::vector<PetscScalar>>& A, std::span<const double> c,
             const double* w, const double* coordinate_dofs,
             const std::size_t facet_index, const std::size_t num_links,
-            std::span<const std::int32_t> q_indices)
+            std::span<const std::int32_t> q_indices,
+            KernelWorkspace& workspace)
   {
-    // Retrieve some data from kd
+    // Retrieve some data from kd. The dimensions are compile time constants
+    // for the specialised kernels (see generate_contact_kernel)
+    const std::size_t gdim = GDIM > 0 ? GDIM : kd.gdim();
+    const std::size_t ndofs_cell = NDOFS > 0 ? NDOFS : kd.ndofs_cell();
+    const std::size_t bs = GDIM > 0 ? GDIM : kd.bs();
     const std::uint32_t tdim = kd.tdim();
 
+    // Coefficient offsets of the facet, where the test functions of the
+    // linked cells may be stored ragged
+    std::array<std::size_t, KernelData::max_offsets> c_offsets;
+    kd.facet_offsets(num_links, c.size(), c_offsets);
+
     // NOTE: DOLFINx has 3D input coordinate dofs
     cmdspan2_t coord(coordinate_dofs, kd.num_coordinate_dofs(), 3);
 
@@ -615,13 +676,10 @@ dolfinx_contact::generate_contact_kernel(
     std::span<const double> weights = kd.weights(facet_index);
     std::array<double, 3> n_surf = {0, 0, 0};
     std::array<double, 3> Pt_u = {0, 0, 0};
-    std::vector<double> epsnb(ndofs_cell * gdim);
-    mdspan2_t epsn(epsnb.data(), ndofs_cell, gdim);
-    std::vector<double> trb(ndofs_cell * gdim);
-    mdspan2_t tr(trb.data(), ndofs_cell, gdim);
-    std::vector<double> sig_n_u(gdim);
-    std::vector<double> sig_nb(ndofs_cell * gdim * gdim);
-    mdspan3_t sig_n(sig_nb.data(), ndofs_cell, gdim, gdim);
+    mdspan2_t epsn = workspace.epsn();
+    mdspan2_t tr = workspace.tr();
+    std::span<double> sig_n_u = workspace.sig_n_u();
+    mdspan3_t sig_n = workspace.sig_n();
 
     // Loop over quadrature points
     for (auto q : q_indices)
@@ -639,9 +697,9 @@ dolfinx_contact::generate_contact_kernel(
       // For closest point n = -n_y
       for (std::size_t i = 0; i < gdim; i++)
       {
-        n_surf[i] = -c[kd.offsets(2) + q * gdim + i];
+        n_surf[i] = -c[c_offsets[2] + q * gdim + i];
         n_dot += n_phys[i] * n_surf[i];
-        gap += c[kd.offsets(1) + q * gdim + i] * n_surf[i];
+        gap += c[c_offsets[1] + q * gdim + i] * n_surf[i];
       }
 
       compute_normal_strain_basis(epsn, tr, K, dphi, n_surf,
@@ -650,7 +708,7 @@ dolfinx_contact::generate_contact_kernel(
       // compute sig(u)*n_phys
       std::fill(sig_n_u.begin(), sig_n_u.end(), 0.0);
       compute_sigma_n_u(sig_n_u,
-                        c.subspan(kd.offsets(5) + q * gdim * gdim, gdim * gdim),
+                        c.subspan(c_offsets[5] + q * gdim * gdim, gdim * gdim),
                         std::span(n_phys.data(), gdim), mu, lmbda);
 
       compute_sigma_n_basis(sig_n, K, dphi, std::span(n_phys.data(), gdim), mu,
@@ -662,14 +720,14 @@ dolfinx_contact::generate_contact_kernel(
       for (std::size_t j = 0; j < gdim; ++j)
       {
         sign_u += sig_n_u[j] * n_surf[j];
-        jump_un += c[kd.offsets(4) + gdim * q + j] * n_surf[j];
+        jump_un += c[c_offsets[4] + gdim * q + j] * n_surf[j];
       }
-      std::size_t offset_u_opp = kd.offsets(6) + q * bs;
+      std::size_t offset_u_opp = c_offsets[6] + q * bs;
       for (std::size_t j = 0; j < bs; ++j)
         jump_un += -c[offset_u_opp + j] * n_surf[j];
       for (std::size_t j = 0; j < bs; ++j)
       {
-        Pt_u[j] = c[kd.offsets(4) + gdim * q + j] - c[offset_u_opp + j]
+        Pt_u[j] = c[c_offsets[4] + gdim * q + j] - c[offset_u_opp + j]
                   - jump_un * n_surf[j];
         Pt_u[j] -= gamma * (sig_n_u[j] - sign_u * n_surf[j]);
       }
@@ -726,7 +784,7 @@ dolfinx_contact::generate_contact_kernel(
               // entries corresponding to u and v on the other surface
               for (std::size_t k = 0; k < num_links; k++)
               {
-                std::size_t index = kd.offsets(3)
+                std::size_t index = c_offsets[3]
                                     + k * num_points * ndofs_cell * bs
                                     + j * num_points * bs + q * bs + l;
                 double wn_opp = c[index] * n_surf[l];
@@ -739,7 +797,7 @@ dolfinx_contact::generate_contact_kernel(
                   for (std::size_t n = 0; n < bs; ++n)
                     Pt_w_opp[m] -= Pt_u_proj[n * bs + m] * wn_opp * n_surf[n];
                 }
-                index = kd.offsets(3) + k * num_points * ndofs_cell * bs
+                index = c_offsets[3] + k * num_points * ndofs_cell * bs
                         + i * num_points * bs + q * bs;
                 double v_n_opp = c[index + b] * n_surf[b];
                 // inner(Pt_w_opp, v[X])
@@ -790,17 +848,27 @@ dolfinx_contact::generate_contact_kernel(
   /// @param[in] num_links How many cells from opposite surface are connected
   /// with the cell.
   /// @param[in] q_indices The quadrature points to loop over
+  /// @param[in,out] workspace Scratch memory used by the kernel
   kernel_fn<PetscScalar> coulomb_rhs =
-      [kd, gdim, ndofs_cell,
-       bs](std::vector<std::vector<PetscScalar>>& b,
+      [kd](std::vector<std::vector<PetscScalar>>& b,
            std::span<const PetscScalar> c, const PetscScalar* w,
            const double* coordinate_dofs, const std::size_t facet_index,
-           const std::size_t num_links, std::span<const std::int32_t> q_indices)
+           const std::size_t num_links, std::span<const std::int32_t> q_indices,
+           KernelWorkspace& workspace)
 
   {
-    // Retrieve some data from kd
+    // Retrieve some data from kd. The dimensions are compile time constants
+    // for the specialised kernels (see generate_contact_kernel)
+    const std::size_t gdim = GDIM > 0 ? GDIM : kd.gdim();
+    const std::size_t ndofs_cell = NDOFS > 0 ? NDOFS : kd.ndofs_cell();
+    const std::size_t bs = GDIM > 0 ? GDIM : kd.bs();
     const std::uint32_t tdim = kd.tdim();
 
+    // Coefficient offsets of the facet, where the test functions of the
+    // linked cells may be stored ragged
+    std::array<std::size_t, KernelData::max_offsets> c_offsets;
+    kd.facet_offsets(num_links, c.size(), c_offsets);
+
     // NOTE: DOLFINx has 3D input coordinate dofs
     cmdspan2_t coord(coordinate_dofs, kd.num_coordinate_dofs(), 3);
 
@@ -850,13 +918,10 @@ dolfinx_contact::generate_contact_kernel(
     std::array<double, 3> n_old = {0, 0, 0};
     std::array<double, 3> Pt_u = {0, 0, 0};
     std::array<double, 3> v_rel = {0, 0, 0};
-    std::vector<double> epsnb(ndofs_cell * gdim, 0);
-    mdspan2_t epsn(epsnb.data(), ndofs_cell, gdim);
-    std::vector<double> trb(ndofs_cell * gdim, 0);
-    mdspan2_t tr(trb.data(), ndofs_cell, gdim);
-    std::vector<double> sig_n_u(gdim);
-    std::vector<double> sig_nb(ndofs_cell * gdim * gdim);
-    mdspan3_t sig_n(sig_nb.data(), ndofs_cell, gdim, gdim);
+    mdspan2_t epsn = workspace.epsn();
+    mdspan2_t tr = workspace.tr();
+    std::span<double> sig_n_u = workspace.sig_n_u();
+    mdspan3_t sig_n = workspace.sig_n();
 
     // Loop over quadrature points
     const std::size_t q_start = kd.qp_offsets(facet_index);
@@ -878,10 +943,10 @@ dolfinx_contact::generate_contact_kernel(
       // n_old is the normal from previous load step
       for (std::size_t i = 0; i < gdim; i++)
       {
-        n_surf[i] = -c[kd.offsets(2) + q * gdim + i];
-        n_old[i] = -c[kd.offsets(7) + q * gdim + i];
+        n_surf[i] = -c[c_offsets[2] + q * gdim + i];
+        n_old[i] = -c[c_offsets[7] + q * gdim + i];
         n_dot += n_phys[i] * n_surf[i];
-        gap += c[kd.offsets(1) + q * gdim + i] * n_surf[i];
+        gap += c[c_offsets[1] + q * gdim + i] * n_surf[i];
       }
 
       compute_normal_strain_basis(epsn, tr, K, dphi, n_surf,
@@ -890,7 +955,7 @@ dolfinx_contact::generate_contact_kernel(
       // compute sig(u)*n_phys
       std::fill(sig_n_u.begin(), sig_n_u.end(), 0.0);
       compute_sigma_n_u(sig_n_u,
-                        c.subspan(kd.offsets(5) + q * gdim * gdim, gdim * gdim),
+                        c.subspan(c_offsets[5] + q * gdim * gdim, gdim * gdim),
                         std::span(n_phys.data(), gdim), mu, lmbda);
 
       compute_sigma_n_basis(sig_n, K, dphi, std::span(n_phys.data(), gdim), mu,
@@ -903,17 +968,17 @@ dolfinx_contact::generate_contact_kernel(
       for (std::size_t j = 0; j < gdim; ++j)
       {
         sign_u += sig_n_u[j] * n_surf[j];
-        jump_un += c[kd.offsets(4) + gdim * q + j] * n_surf[j];
+        jump_un += c[c_offsets[4] + gdim * q + j] * n_surf[j];
         ndotn += n_surf[j] * n_old[j];
       }
-      std::size_t offset_u_opp = kd.offsets(6) + q * bs;
+      std::size_t offset_u_opp = c_offsets[6] + q * bs;
       for (std::size_t j = 0; j < bs; ++j)
         jump_un += -c[offset_u_opp + j] * n_surf[j];
 
       // compute relative velocity of surfaces for friction computation
       for (std::size_t j = 0; j < bs; ++j)
       {
-        v_rel[j] = c[kd.offsets(4) + gdim * q + j] - c[offset_u_opp + j]
+        v_rel[j] = c[c_offsets[4] + gdim * q + j] - c[offset_u_opp + j]
                    - jump_un * n_surf[j]
                    - (gap - jump_un) * (n_old[j] - ndotn * n_surf[j]);
       }
@@ -953,7 +1018,7 @@ dolfinx_contact::generate_contact_kernel(
           // entries corresponding to v on the other surface
           for (std::size_t k = 0; k < num_links; k++)
           {
-            std::size_t index = kd.offsets(3) + k * num_points * ndofs_cell * bs
+            std::size_t index = c_offsets[3] + k * num_points * ndofs_cell * bs
                                 + i * num_points * bs + q * bs;
             double v_n_opp = c[index + n] * n_surf[n];
 
@@ -988,16 +1053,27 @@ dolfinx_contact::generate_contact_kernel(
   /// @param[in] num_links How many cells from opposite surface are connected
   /// with the cell.
   /// @param[in] q_indices The quadrature points to loop over
+  /// @param[in,out] workspace Scratch memory used by the kernel
   kernel_fn<PetscScalar> coulomb_jac
-      = [kd, gdim, ndofs_cell, bs](
+      = [kd](
             std::vector<std::vector<PetscScalar>>& A, std::span<const double> c,
             const double* w, const double* coordinate_dofs,
             const std::size_t facet_index, const std::size_t num_links,
-            std::span<const std::int32_t> q_indices)
+            std::span<const std::int32_t> q_indices,
+            KernelWorkspace& workspace)
   {
-    // Retrieve some data from kd
+    // Retrieve some data from kd. The dimensions are compile time constants
+    // for the specialised kernels (see generate_contact_kernel)
+    const std::size_t gdim = GDIM > 0 ? GDIM : kd.gdim();
+    const std::size_t ndofs_cell = NDOFS > 0 ? NDOFS : kd.ndofs_cell();
+    const std::size_t bs = GDIM > 0 ? GDIM : kd.bs();
     const std::uint32_t tdim = kd.tdim();
 
+    // Coefficient offsets of the facet, where the test functions of the
+    // linked cells may be stored ragged
+    std::array<std::size_t, KernelData::max_offsets> c_offsets;
+    kd.facet_offsets(num_links, c.size(), c_offsets);
+
     // NOTE: DOLFINx has 3D input coordinate dofs
     cmdspan2_t coord(coordinate_dofs, kd.num_coordinate_dofs(), 3);
 
@@ -1045,13 +1121,10 @@ dolfinx_contact::generate_contact_kernel(
     std::array<double, 3> n_old = {0, 0, 0};
     std::array<double, 3> Pt_u = {0, 0, 0};
     std::array<double, 3> v_rel = {0, 0, 0};
-    std::vector<double> epsnb(ndofs_cell * gdim);
-    mdspan2_t epsn(epsnb.data(), ndofs_cell, gdim);
-    std::vector<double> trb(ndofs_cell * gdim);
-    mdspan2_t tr(trb.data(), ndofs_cell, gdim);
-    std::vector<double> sig_n_u(gdim);
-    std::vector<double> sig_nb(ndofs_cell * gdim * gdim);
-    mdspan3_t sig_n(sig_nb.data(), ndofs_cell, gdim, gdim);
+    mdspan2_t epsn = workspace.epsn();
+    mdspan2_t tr = workspace.tr();
+    std::span<double> sig_n_u = workspace.sig_n_u();
+    mdspan3_t sig_n = workspace.sig_n();
 
     // Loop over quadrature points
     for (auto q : q_indices)
@@ -1070,10 +1143,10 @@ dolfinx_contact::generate_contact_kernel(
       // n_old is the normal from previous load step
       for (std::size_t i = 0; i < gdim; i++)
       {
-        n_surf[i] = -c[kd.offsets(2) + q * gdim + i];
-        n_old[i] = -c[kd.offsets(7) + q * gdim + i];
+        n_surf[i] = -c[c_offsets[2] + q * gdim + i];
+        n_old[i] = -c[c_offsets[7] + q * gdim + i];
         n_dot += n_phys[i] * n_surf[i];
-        gap += c[kd.offsets(1) + q * gdim + i] * n_surf[i];
+        gap += c[c_offsets[1] + q * gdim + i] * n_surf[i];
       }
 
       compute_normal_strain_basis(epsn, tr, K, dphi, n_surf,
@@ -1082,7 +1155,7 @@ dolfinx_contact::generate_contact_kernel(
       // compute sig(u)*n_phys
       std::fill(sig_n_u.begin(), sig_n_u.end(), 0.0);
       compute_sigma_n_u(sig_n_u,
-                        c.subspan(kd.offsets(5) + q * gdim * gdim, gdim * gdim),
+                        c.subspan(c_offsets[5] + q * gdim * gdim, gdim * gdim),
                         std::span(n_phys.data(), gdim), mu, lmbda);
 
       compute_sigma_n_basis(sig_n, K, dphi, std::span(n_phys.data(), gdim), mu,
@@ -1095,16 +1168,16 @@ dolfinx_contact::generate_contact_kernel(
       for (std::size_t j = 0; j < gdim; ++j)
       {
         sign_u += sig_n_u[j] * n_surf[j];
-        jump_un += c[kd.offsets(4) + gdim * q + j] * n_surf[j];
+        jump_un += c[c_offsets[4] + gdim * q + j] * n_surf[j];
         ndotn += n_surf[j] * n_old[j];
       }
-      std::size_t offset_u_opp = kd.offsets(6) + q * bs;
+      std::size_t offset_u_opp = c_offsets[6] + q * bs;
       for (std::size_t j = 0; j < bs; ++j)
         jump_un += -c[offset_u_opp + j] * n_surf[j];
       // compute relative velocity of surfaces for friction computation
       for (std::size_t j = 0; j < bs; ++j)
       {
-        v_rel[j] = c[kd.offsets(4) + gdim * q + j] - c[offset_u_opp + j]
+        v_rel[j] = c[c_offsets[4] + gdim * q + j] - c[offset_u_opp + j]
                    - jump_un * n_surf[j]
                    - (gap - jump_un) * (n_old[j] - ndotn * n_surf[j]);
       }
@@ -1178,7 +1251,7 @@ dolfinx_contact::generate_contact_kernel(
               // entries corresponding to u and v on the other surface
               for (std::size_t k = 0; k < num_links; k++)
               {
-                std::size_t index = kd.offsets(3)
+                std::size_t index = c_offsets[3]
                                     + k * num_points * ndofs_cell * bs
                                     + j * num_points * bs + q * bs + l;
                 double wn_opp = c[index] * n_surf[l];
@@ -1193,7 +1266,7 @@ dolfinx_contact::generate_contact_kernel(
                                    * (n_surf[n] - n_old[n] + ndotn * n_surf[n])
                                    * wn_opp;
                 }
-                index = kd.offsets(3) + k * num_points * ndofs_cell * bs
+                index = c_offsets[3] + k * num_points * ndofs_cell * bs
                         + i * num_points * bs + q * bs;
                 double v_n_opp = c[index + b] * n_surf[b];
                 // -inner(Pt_w_opp, v[X])
@@ -1270,4 +1343,1228 @@ dolfinx_contact::generate_contact_kernel(
   default:
     throw std::invalid_argument("Unrecognized kernel");
   }
-}
\ No newline at end of file
+}
+
+/// @brief Generate a kernel computing the residual and the Jacobian of the
+/// contact problem in one pass, for a fixed geometric dimension and number
+/// of dofs per cell
+///
+/// See `contact_kernel` for the template arguments and
+/// `generate_contact_system_kernel` for a description of the input arguments
+template <std::size_t GDIM, std::size_t NDOFS>
+system_kernel_fn<PetscScalar> contact_system_kernel(
+    Kernel type, std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    std::shared_ptr<const QuadratureRule> quadrature_rule,
+    const std::size_t max_links)
+{
+  // The friction terms added to the normal terms
+  enum class Friction
+  {
+    none,
+    tresca,
+    coulomb
+  };
+  Friction friction;
+  switch (type)
+  {
+  case Kernel::System:
+    friction = Friction::none;
+    break;
+  case Kernel::TrescaSystem:
+    friction = Friction::tresca;
+    break;
+  case Kernel::CoulombSystem:
+    friction = Friction::coulomb;
+    break;
+  default:
+    throw std::invalid_argument("Unrecognized kernel");
+  }
+
+  KernelData kd = contact_kernel_data(V, quadrature_rule, max_links);
+
+  /// @brief Assemble kernel for the residual and the Jacobian of the
+  /// unbiased contact problem
+  ///
+  /// Computes the contributions of `unbiased_rhs` to `b` and of
+  /// `unbiased_jac` to `A` (see `contact_kernel`), and for Tresca and
+  /// Coulomb friction those of the friction kernels. The geometry, the
+  /// stress of `u` and the normal and tangential terms of the test functions
+  /// are computed once per quadrature point and shared by all terms.
+  /// @param[in,out] b The vector to assemble the residual into
+  /// @param[in,out] A The matrix to assemble the Jacobian into
+  /// @param[in] c The coefficients used in kernel. Assumed to be
+  /// ordered as mu, lmbda, h, gap, normals, test_fn, u, u_opposite.
+  /// @param[in] w The constants used in kernel. Assumed to be ordered as
+  /// `gamma`, `theta`.
+  /// @param[in] coordinate_dofs The physical coordinates of cell. Assumed
+  /// to be padded to 3D, (shape (num_nodes, 3)).
+  /// @param[in] facet_index Local facet index (relative to cell)
+  /// @param[in] num_links How many cells from opposite surface are connected
+  /// with the cell.
+  /// @param[in] q_indices The quadrature points to loop over
+  /// @param[in,out] workspace Scratch memory used by the kernel
+  system_kernel_fn<PetscScalar> unbiased_system
+      = [kd, friction](std::vector<std::vector<PetscScalar>>& b,
+                       std::vector<std::vector<PetscScalar>>& A,
+                       std::span<const PetscScalar> c, const PetscScalar* w,
+                       const double* coordinate_dofs,
+                       const std::size_t facet_index,
+                       const std::size_t num_links,
+                       std::span<const std::int32_t> q_indices,
+                       KernelWorkspace& workspace)
+  {
+    // Retrieve some data from kd. The dimensions are compile time constants
+    // for the specialised kernels (see generate_contact_kernel)
+    const std::size_t gdim = GDIM > 0 ? GDIM : kd.gdim();
+    const std::size_t ndofs_cell = NDOFS > 0 ? NDOFS : kd.ndofs_cell();
+    const std::size_t bs = GDIM > 0 ? GDIM : kd.bs();
+    const std::uint32_t tdim = kd.tdim();
+
+    // Coefficient offsets of the facet, where the test functions of the
+    // linked cells may be stored ragged
+    std::array<std::size_t, KernelData::max_offsets> c_offsets;
+    kd.facet_offsets(num_links, c.size(), c_offsets);
+
+    // NOTE: DOLFINx has 3D input coordinate dofs
+    cmdspan2_t coord(coordinate_dofs, kd.num_coordinate_dofs(), 3);
+
+    // Create data structures for jacobians
+    // We allocate more memory than required, but its better for the compiler
+    std::array<double, 9> Jb;
+    mdspan2_t J(Jb.data(), gdim, tdim);
+    std::array<double, 9> Kb;
+    mdspan2_t K(Kb.data(), tdim, gdim);
+    std::array<double, 6> J_totb;
+    mdspan2_t J_tot(J_totb.data(), gdim, tdim - 1);
+    double detJ = 0;
+    std::array<double, 18> detJ_scratch;
+
+    // Normal vector on physical facet at a single quadrature point
+    std::array<double, 3> n_phys;
+
+    // Pre-compute jacobians and normals for affine meshes
+    if (kd.affine())
+    {
+      detJ = kd.compute_first_facet_jacobian(facet_index, J, K, J_tot,
+                                             detJ_scratch, coord);
+      physical_facet_normal(
+          std::span(n_phys.data(), gdim), K,
+          stdex::submdspan(kd.facet_normals(), facet_index,
+                           MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent));
+    }
+
+    // Extract scaled gamma (h/gamma) and its inverse
+    double gamma = c[3] / w[0];
+    double gamma_inv = w[0] / c[3];
+
+    double theta = w[1];
+    double mu = c[0];
+    double lmbda = c[1];
+    double fric = c[2];
+
+    cmdspan3_t dphi = kd.dphi();
+    cmdspan2_t phi = kd.phi();
+    std::array<std::size_t, 2> q_offset
+        = {kd.qp_offsets(facet_index), kd.qp_offsets(facet_index + 1)};
+    const std::size_t num_points = q_offset.back() - q_offset.front();
+    std::span<const double> weights = kd.weights(facet_index);
+    std::array<double, 3> n_surf = {0, 0, 0};
+    mdspan2_t epsn = workspace.epsn();
+    mdspan2_t tr = workspace.tr();
+    std::span<double> sig_n_u = workspace.sig_n_u();
+    mdspan3_t test_n = workspace.test_fn_n(num_links);
+    mdspan3_t sig_t = workspace.sig_n();
+
+    // Offset of the test function of the ith dof of the kth linked cell at
+    // the qth quadrature point
+    auto test_fn_offset = [&](std::size_t k, std::size_t i, std::size_t q)
+    {
+      return c_offsets[3] + k * num_points * ndofs_cell * bs
+             + i * num_points * bs + q * bs;
+    };
+
+    // Loop over quadrature points
+    for (auto q : q_indices)
+    {
+      const std::size_t q_pos = q_offset.front() + q;
+      // Update Jacobian and physical normal
+      detJ = kd.update_jacobian(q, facet_index, detJ, J, K, J_tot, detJ_scratch,
+                                coord);
+      kd.update_normal(std::span(n_phys.data(), gdim), K, facet_index);
+
+      double n_dot = 0;
+      double gap = 0;
+      // The gap is given by n * (Pi(x) -x)
+      // For raytracing n = n_x
+      // For closest point n = -n_y
+      for (std::size_t i = 0; i < gdim; i++)
+      {
+        n_surf[i] = -c[c_offsets[2] + q * gdim + i];
+        n_dot += n_phys[i] * n_surf[i];
+        gap += c[c_offsets[1] + q * gdim + i] * n_surf[i];
+      }
+
+      compute_normal_strain_basis(epsn, tr, K, dphi, n_surf,
+                                  std::span(n_phys.data(), gdim), q_pos);
+
+      // compute sig(u)*n_phys
+      std::fill(sig_n_u.begin(), sig_n_u.end(), 0.0);
+      compute_sigma_n_u(sig_n_u,
+                        c.subspan(c_offsets[5] + q * gdim * gdim, gdim * gdim),
+                        std::span(n_phys.data(), gdim), mu, lmbda);
+
+      // compute inner(sig(u)*n_phys, n_surf) and inner(u, n_surf)
+      double sign_u = 0;
+      double jump_un = 0;
+      for (std::size_t j = 0; j < gdim; ++j)
+      {
+        sign_u += sig_n_u[j] * n_surf[j];
+        jump_un += c[c_offsets[4] + gdim * q + j] * n_surf[j];
+      }
+      std::size_t offset_u_opp = c_offsets[6] + q * bs;
+      for (std::size_t j = 0; j < bs; ++j)
+        jump_un += -c[offset_u_opp + j] * n_surf[j];
+
+      const double w0 = weights[q] * detJ;
+      const double Pn = (jump_un - gap) - gamma * sign_u;
+      const double Pn_u = R_plus(Pn) * w0;
+      const double dPn_u = dR_plus(Pn);
+
+      // Residual. The normal terms of the test functions are stored for the
+      // Jacobian below
+      for (std::size_t i = 0; i < ndofs_cell; i++)
+      {
+        for (std::size_t n = 0; n < bs; n++)
+        {
+          double v_dot_nsurf = n_surf[n] * phi(q_pos, i);
+          double sign_v = (lmbda * tr(i, n) * n_dot + mu * epsn(i, n));
+          double Pn_v = v_dot_nsurf - gamma * theta * sign_v;
+          test_n(0, i, n) = sign_v;
+          test_n(1, i, n) = Pn_v;
+          b[0][n + i * bs] += 0.5 * gamma_inv * Pn_u * Pn_v;
+          b[0][n + i * bs] -= 0.5 * theta * gamma * sign_u * sign_v * w0;
+
+          // entries corresponding to v on the other surface
+          for (std::size_t k = 0; k < num_links; k++)
+          {
+            double v_n_opp = c[test_fn_offset(k, i, q) + n] * n_surf[n];
+            test_n(k + 2, i, n) = v_n_opp;
+
+            b[k + 1][n + i * bs] -= 0.5 * gamma_inv * v_n_opp * Pn_u;
+          }
+        }
+      }
+
+      // Jacobian, where the trial functions have the same normal terms as
+      // the test functions
+      for (std::size_t j = 0; j < ndofs_cell; j++)
+      {
+        for (std::size_t l = 0; l < bs; l++)
+        {
+          double sign_du = test_n(0, j, l);
+          double Pn_du
+              = (phi(q_pos, j) * n_surf[l] - gamma * sign_du) * dPn_u * w0;
+
+          sign_du *= w0;
+          for (std::size_t i = 0; i < ndofs_cell; i++)
+          {
+            for (std::size_t m = 0; m < bs; m++)
+            {
+              const double sign_v = test_n(0, i, m);
+              const double Pn_v = test_n(1, i, m);
+              const std::size_t entry
+                  = (m + i * bs) * ndofs_cell * bs + l + j * bs;
+              A[0][entry] += 0.5 * gamma_inv * Pn_du * Pn_v
+                             - 0.5 * theta * gamma * sign_du * sign_v;
+
+              // entries corresponding to u and v on the other surface
+              for (std::size_t k = 0; k < num_links; k++)
+              {
+                const double du_n_opp = test_n(k + 2, j, l) * w0 * dPn_u;
+                const double v_n_opp = test_n(k + 2, i, m);
+                A[3 * k + 1][entry] -= 0.5 * gamma_inv * du_n_opp * Pn_v;
+                A[3 * k + 2][entry] -= 0.5 * gamma_inv * Pn_du * v_n_opp;
+                A[3 * k + 3][entry] += 0.5 * gamma_inv * du_n_opp * v_n_opp;
+              }
+            }
+          }
+        }
+      }
+
+      if (friction == Friction::none)
+        continue;
+
+      // Friction terms, see the Tresca and Coulomb kernels in
+      // `contact_kernel`. The tangential stress sigma_t(v) of the test
+      // functions is computed from sigma(v)*n_phys and the normal stress
+      // stored above
+      compute_sigma_n_basis(sig_t, K, dphi, std::span(n_phys.data(), gdim),
+                            mu, lmbda, q_pos);
+      for (std::size_t i = 0; i < ndofs_cell; i++)
+        for (std::size_t n = 0; n < bs; n++)
+          for (std::size_t j = 0; j < bs; j++)
+            sig_t(i, n, j) -= test_n(0, i, n) * n_surf[j];
+
+      // For Coulomb friction, the slip accounts for the tangential part
+      // t_old of the normal n_old of the previous load step. The normal jump
+      // of the trial functions then enters the slip in the direction
+      // n_surf - t_old
+      const bool coulomb = friction == Friction::coulomb;
+      std::array<double, 3> t_old = {0, 0, 0};
+      if (coulomb)
+      {
+        std::array<double, 3> n_old = {0, 0, 0};
+        double ndotn = 0;
+        for (std::size_t j = 0; j < gdim; ++j)
+        {
+          n_old[j] = -c[c_offsets[7] + q * gdim + j];
+          ndotn += n_surf[j] * n_old[j];
+        }
+        for (std::size_t j = 0; j < gdim; ++j)
+          t_old[j] = n_old[j] - ndotn * n_surf[j];
+      }
+
+      // Tangential stress of u and tangential constraint
+      std::array<double, 3> sig_t_u = {0, 0, 0};
+      std::array<double, 3> Pt_u = {0, 0, 0};
+      std::array<double, 3> n_t = {0, 0, 0};
+      for (std::size_t j = 0; j < bs; ++j)
+      {
+        sig_t_u[j] = sig_n_u[j] - sign_u * n_surf[j];
+        Pt_u[j] = c[c_offsets[4] + gdim * q + j] - c[offset_u_opp + j]
+                  - jump_un * n_surf[j] - (gap - jump_un) * t_old[j]
+                  - gamma * sig_t_u[j];
+        n_t[j] = n_surf[j] - t_old[j];
+      }
+
+      // Ball projection and its derivatives. The radius of the ball is
+      // constant for Tresca friction and depends on the normal constraint
+      // for Coulomb friction
+      const double radius = coulomb ? fric * R_plus(Pn) : gamma * fric;
+      std::array<double, 3> Pt_u_proj = ball_projection(Pt_u, radius);
+      std::array<double, 9> d_Pt_u_proj = d_ball_projection(Pt_u, radius, bs);
+      std::array<double, 3> d_alpha_ball = {0, 0, 0};
+      if (coulomb)
+      {
+        d_alpha_ball
+            = d_alpha_ball_projection(Pt_u, radius, dR_plus(Pn) * fric);
+      }
+      double Pt_u_proj_n = 0;
+      for (std::size_t j = 0; j < bs; ++j)
+        Pt_u_proj_n += Pt_u_proj[j] * n_surf[j];
+
+      // The tangential constraint of the test functions, times -1
+      auto Pt_v = [&](std::size_t i, std::size_t n, std::size_t j)
+      {
+        return -n_surf[n] * phi(q_pos, i) * n_surf[j]
+               - theta * gamma * sig_t(i, n, j);
+      };
+
+      // Residual
+      for (std::size_t i = 0; i < ndofs_cell; i++)
+      {
+        for (std::size_t n = 0; n < bs; n++)
+        {
+          double b0 = Pt_u_proj[n] * phi(q_pos, i);
+          double sig_tt = 0;
+          for (std::size_t j = 0; j < bs; j++)
+          {
+            b0 += Pt_u_proj[j] * Pt_v(i, n, j);
+            sig_tt += sig_t_u[j] * sig_t(i, n, j);
+          }
+          b[0][n + i * bs]
+              += 0.5 * gamma_inv * b0 * w0 - 0.5 * w0 * gamma * theta * sig_tt;
+
+          // entries corresponding to v on the other surface
+          for (std::size_t k = 0; k < num_links; k++)
+          {
+            const double v_opp = c[test_fn_offset(k, i, q) + n];
+            b[k + 1][n + i * bs]
+                -= 0.5 * gamma_inv
+                   * (Pt_u_proj[n] * v_opp - Pt_u_proj_n * test_n(k + 2, i, n))
+                   * w0;
+          }
+        }
+      }
+
+      // Jacobian
+      for (std::size_t j = 0; j < ndofs_cell; j++)
+      {
+        for (std::size_t l = 0; l < bs; l++)
+        {
+          const std::size_t col = l + j * bs;
+          const double w_dot_nsurf = n_surf[l] * phi(q_pos, j);
+          const double Pn_w = w_dot_nsurf - gamma * test_n(0, j, l);
+
+          // Pt_w = J_ball * (w_t[X] - gamma * sigma_t(w)) + d_alpha_ball * Pn_w
+          std::array<double, 3> Pt_w = {0, 0, 0};
+          for (std::size_t m = 0; m < bs; ++m)
+          {
+            Pt_w[m] += d_Pt_u_proj[l * bs + m] * phi(q_pos, j)
+                       + d_alpha_ball[m] * Pn_w;
+            for (std::size_t n = 0; n < bs; n++)
+            {
+              Pt_w[m] -= d_Pt_u_proj[n * bs + m]
+                         * (w_dot_nsurf * n_t[n] + gamma * sig_t(j, l, n));
+            }
+          }
+          double Pt_w_n = 0;
+          for (std::size_t n = 0; n < bs; ++n)
+            Pt_w_n += Pt_w[n] * n_surf[n];
+
+          for (std::size_t i = 0; i < ndofs_cell; i++)
+          {
+            for (std::size_t m = 0; m < bs; m++)
+            {
+              double a0 = Pt_w[m] * phi(q_pos, i);
+              double sig_tt = 0;
+              for (std::size_t n = 0; n < bs; n++)
+              {
+                a0 += Pt_w[n] * Pt_v(i, m, n);
+                sig_tt += sig_t(i, m, n) * sig_t(j, l, n);
+              }
+              A[0][(m + i * bs) * ndofs_cell * bs + col]
+                  += 0.5 * gamma_inv * a0 * w0
+                     - 0.5 * gamma * theta * w0 * sig_tt;
+            }
+          }
+
+          // entries corresponding to u and v on the other surface
+          for (std::size_t k = 0; k < num_links; k++)
+          {
+            // Pt_w_opp = J_ball * w_t[Y] + d_alpha_ball * w_n[Y], where the
+            // contributions enter with a negative sign
+            const double w_opp = c[test_fn_offset(k, j, q) + l];
+            const double wn_opp = test_n(k + 2, j, l);
+            std::array<double, 3> Pt_w_opp = {0, 0, 0};
+            for (std::size_t m = 0; m < bs; ++m)
+            {
+              Pt_w_opp[m]
+                  += d_Pt_u_proj[l * bs + m] * w_opp + d_alpha_ball[m] * wn_opp;
+              for (std::size_t n = 0; n < bs; ++n)
+                Pt_w_opp[m] -= d_Pt_u_proj[n * bs + m] * n_t[n] * wn_opp;
+            }
+            double Pt_w_opp_n = 0;
+            for (std::size_t n = 0; n < bs; ++n)
+              Pt_w_opp_n += Pt_w_opp[n] * n_surf[n];
+
+            for (std::size_t i = 0; i < ndofs_cell; i++)
+            {
+              const std::size_t offset_v = test_fn_offset(k, i, q);
+              for (std::size_t m = 0; m < bs; m++)
+              {
+                const std::size_t entry = (m + i * bs) * ndofs_cell * bs + col;
+                const double v_opp = c[offset_v + m];
+                const double v_n_opp = test_n(k + 2, i, m);
+                double a1 = Pt_w_opp[m] * phi(q_pos, i);
+                for (std::size_t n = 0; n < bs; n++)
+                  a1 += Pt_w_opp[n] * Pt_v(i, m, n);
+                A[3 * k + 1][entry] -= 0.5 * gamma_inv * a1 * w0;
+                A[3 * k + 2][entry]
+                    -= 0.5 * gamma_inv * (Pt_w[m] * v_opp - Pt_w_n * v_n_opp)
+                       * w0;
+                A[3 * k + 3][entry]
+                    += 0.5 * gamma_inv
+                       * (Pt_w_opp[m] * v_opp - Pt_w_opp_n * v_n_opp) * w0;
+              }
+            }
+          }
+        }
+      }
+    }
+  };
+
+  return unbiased_system;
+}
+
+/// @brief Generate a kernel applying the Jacobian of the contact problem to
+/// a vector, for a fixed geometric dimension and number of dofs per cell
+///
+/// See `contact_kernel` for the template arguments and
+/// `generate_contact_action_kernel` for a description of the input arguments
+template <std::size_t GDIM, std::size_t NDOFS>
+action_kernel_fn<PetscScalar> contact_action_kernel(
+    Kernel type, std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    std::shared_ptr<const QuadratureRule> quadrature_rule,
+    const std::size_t max_links)
+{
+  // The friction terms added to the normal terms, see
+  // `contact_system_kernel`
+  enum class Friction
+  {
+    none,
+    tresca,
+    coulomb
+  };
+  Friction friction;
+  switch (type)
+  {
+  case Kernel::System:
+    friction = Friction::none;
+    break;
+  case Kernel::TrescaSystem:
+    friction = Friction::tresca;
+    break;
+  case Kernel::CoulombSystem:
+    friction = Friction::coulomb;
+    break;
+  default:
+    throw std::invalid_argument("Unrecognized kernel");
+  }
+
+  KernelData kd = contact_kernel_data(V, quadrature_rule, max_links);
+
+  /// @brief Kernel applying the Jacobian of the unbiased contact problem
+  ///
+  /// Adds the element matrices of `unbiased_system` (see
+  /// `contact_system_kernel`) applied to `x` to `y`. The element matrices
+  /// are not formed: at each quadrature point the trial function terms of
+  /// the Jacobian (the normal and tangential constraint and stress) are
+  /// contracted with `x`, which leaves one vector per term that the test
+  /// functions are multiplied with. This costs O(ndofs) instead of
+  /// O(ndofs^2) operations per quadrature point.
+  /// @param[in,out] y The element vectors to add to
+  /// @param[in] x The entries of the vector on the cell followed by the
+  /// entries on each linked cell
+  /// @param[in] c The coefficients used in kernel, see `unbiased_system`
+  /// @param[in] w The constants used in kernel, see `unbiased_system`
+  /// @param[in] coordinate_dofs The physical coordinates of cell. Assumed
+  /// to be padded to 3D, (shape (num_nodes, 3)).
+  /// @param[in] facet_index Local facet index (relative to cell)
+  /// @param[in] num_links How many cells from opposite surface are connected
+  /// with the cell.
+  /// @param[in] q_indices The quadrature points to loop over
+  /// @param[in,out] workspace Scratch memory used by the kernel
+  action_kernel_fn<PetscScalar> unbiased_action
+      = [kd, friction](std::vector<std::vector<PetscScalar>>& y,
+                       std::span<const PetscScalar> x,
+                       std::span<const PetscScalar> c, const PetscScalar* w,
+                       const double* coordinate_dofs,
+                       const std::size_t facet_index,
+                       const std::size_t num_links,
+                       std::span<const std::int32_t> q_indices,
+                       KernelWorkspace& workspace)
+  {
+    // Retrieve some data from kd. The dimensions are compile time constants
+    // for the specialised kernels (see generate_contact_kernel)
+    const std::size_t gdim = GDIM > 0 ? GDIM : kd.gdim();
+    const std::size_t ndofs_cell = NDOFS > 0 ? NDOFS : kd.ndofs_cell();
+    const std::size_t bs = GDIM > 0 ? GDIM : kd.bs();
+    const std::uint32_t tdim = kd.tdim();
+
+    // Coefficient offsets of the facet, where the test functions of the
+    // linked cells may be stored ragged
+    std::array<std::size_t, KernelData::max_offsets> c_offsets;
+    kd.facet_offsets(num_links, c.size(), c_offsets);
+
+    // NOTE: DOLFINx has 3D input coordinate dofs
+    cmdspan2_t coord(coordinate_dofs, kd.num_coordinate_dofs(), 3);
+
+    // Create data structures for jacobians
+    // We allocate more memory than required, but its better for the compiler
+    std::array<double, 9> Jb;
+    mdspan2_t J(Jb.data(), gdim, tdim);
+    std::array<double, 9> Kb;
+    mdspan2_t K(Kb.data(), tdim, gdim);
+    std::array<double, 6> J_totb;
+    mdspan2_t J_tot(J_totb.data(), gdim, tdim - 1);
+    double detJ = 0;
+    std::array<double, 18> detJ_scratch;
+
+    // Normal vector on physical facet at a single quadrature point
+    std::array<double, 3> n_phys;
+
+    // Pre-compute jacobians and normals for affine meshes
+    if (kd.affine())
+    {
+      detJ = kd.compute_first_facet_jacobian(facet_index, J, K, J_tot,
+                                             detJ_scratch, coord);
+      physical_facet_normal(
+          std::span(n_phys.data(), gdim), K,
+          stdex::submdspan(kd.facet_normals(), facet_index,
+                           MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent));
+    }
+
+    // Extract scaled gamma (h/gamma) and its inverse
+    double gamma = c[3] / w[0];
+    double gamma_inv = w[0] / c[3];
+
+    double theta = w[1];
+    double mu = c[0];
+    double lmbda = c[1];
+    double fric = c[2];
+
+    cmdspan3_t dphi = kd.dphi();
+    cmdspan2_t phi = kd.phi();
+    std::array<std::size_t, 2> q_offset
+        = {kd.qp_offsets(facet_index), kd.qp_offsets(facet_index + 1)};
+    const std::size_t num_points = q_offset.back() - q_offset.front();
+    std::span<const double> weights = kd.weights(facet_index);
+    std::array<double, 3> n_surf = {0, 0, 0};
+    mdspan2_t epsn = workspace.epsn();
+    mdspan2_t tr = workspace.tr();
+    std::span<double> sig_n_u = workspace.sig_n_u();
+    mdspan3_t test_n = workspace.test_fn_n(num_links);
+    mdspan3_t sig_t = workspace.sig_n();
+
+    // Offset of the test function of the ith dof of the kth linked cell at
+    // the qth quadrature point
+    auto test_fn_offset = [&](std::size_t k, std::size_t i, std::size_t q)
+    {
+      return c_offsets[3] + k * num_points * ndofs_cell * bs
+             + i * num_points * bs + q * bs;
+    };
+
+    // Entries of x on the cell (k = 0) and the linked cells (k > 0)
+    const std::size_t num_dofs = ndofs_cell * bs;
+    auto x_k = [&](std::size_t k, std::size_t i, std::size_t n)
+    { return x[k * num_dofs + i * bs + n]; };
+
+    // Value and normal component of x on each linked cell
+    mdspan2_t x_opp = workspace.x_opp(num_links);
+
+    // Loop over quadrature points
+    for (auto q : q_indices)
+    {
+      const std::size_t q_pos = q_offset.front() + q;
+      // Update Jacobian and physical normal
+      detJ = kd.update_jacobian(q, facet_index, detJ, J, K, J_tot, detJ_scratch,
+                                coord);
+      kd.update_normal(std::span(n_phys.data(), gdim), K, facet_index);
+
+      double n_dot = 0;
+      double gap = 0;
+      for (std::size_t i = 0; i < gdim; i++)
+      {
+        n_surf[i] = -c[c_offsets[2] + q * gdim + i];
+        n_dot += n_phys[i] * n_surf[i];
+        gap += c[c_offsets[1] + q * gdim + i] * n_surf[i];
+      }
+
+      compute_normal_strain_basis(epsn, tr, K, dphi, n_surf,
+                                  std::span(n_phys.data(), gdim), q_pos);
+
+      // compute sig(u)*n_phys
+      std::fill(sig_n_u.begin(), sig_n_u.end(), 0.0);
+      compute_sigma_n_u(sig_n_u,
+                        c.subspan(c_offsets[5] + q * gdim * gdim, gdim * gdim),
+                        std::span(n_phys.data(), gdim), mu, lmbda);
+
+      // compute inner(sig(u)*n_phys, n_surf) and inner(u, n_surf)
+      double sign_u = 0;
+      double jump_un = 0;
+      for (std::size_t j = 0; j < gdim; ++j)
+      {
+        sign_u += sig_n_u[j] * n_surf[j];
+        jump_un += c[c_offsets[4] + gdim * q + j] * n_surf[j];
+      }
+      std::size_t offset_u_opp = c_offsets[6] + q * bs;
+      for (std::size_t j = 0; j < bs; ++j)
+        jump_un += -c[offset_u_opp + j] * n_surf[j];
+
+      const double w0 = weights[q] * detJ;
+      const double Pn = (jump_un - gap) - gamma * sign_u;
+      const double dPn_u = dR_plus(Pn);
+
+      // Normal terms of the test functions, and their contraction with x,
+      // which gives the trial function terms applied to x: the value x_q of
+      // x on the cell, its normal stress sign_x and the value and normal
+      // component x_opp on the linked cells
+      std::array<double, 3> x_q = {0, 0, 0};
+      double sign_x = 0;
+      for (std::size_t i = 0; i < ndofs_cell; i++)
+      {
+        for (std::size_t n = 0; n < bs; n++)
+        {
+          double v_dot_nsurf = n_surf[n] * phi(q_pos, i);
+          double sign_v = (lmbda * tr(i, n) * n_dot + mu * epsn(i, n));
+          test_n(0, i, n) = sign_v;
+          test_n(1, i, n) = v_dot_nsurf - gamma * theta * sign_v;
+          x_q[n] += phi(q_pos, i) * x_k(0, i, n);
+          sign_x += sign_v * x_k(0, i, n);
+        }
+      }
+      double x_n = 0;
+      for (std::size_t n = 0; n < bs; n++)
+        x_n += x_q[n] * n_surf[n];
+      double xn_opp_sum = 0;
+      for (std::size_t k = 0; k < num_links; k++)
+      {
+        for (std::size_t n = 0; n <= bs; n++)
+          x_opp(k, n) = 0;
+        for (std::size_t i = 0; i < ndofs_cell; i++)
+        {
+          const std::size_t offset_v = test_fn_offset(k, i, q);
+          for (std::size_t n = 0; n < bs; n++)
+          {
+            test_n(k + 2, i, n) = c[offset_v + n] * n_surf[n];
+            x_opp(k, n) += c[offset_v + n] * x_k(k + 1, i, n);
+          }
+        }
+        for (std::size_t n = 0; n < bs; n++)
+          x_opp(k, bs) += x_opp(k, n) * n_surf[n];
+        xn_opp_sum += x_opp(k, bs);
+      }
+
+      // Normal terms, see the Jacobian of `unbiased_system`
+      const double Pn_x = (x_n - gamma * sign_x) * dPn_u * w0;
+      for (std::size_t i = 0; i < ndofs_cell; i++)
+      {
+        for (std::size_t m = 0; m < bs; m++)
+        {
+          y[0][m + i * bs]
+              += 0.5 * gamma_inv * (Pn_x - xn_opp_sum * dPn_u * w0)
+                     * test_n(1, i, m)
+                 - 0.5 * theta * gamma * sign_x * w0 * test_n(0, i, m);
+          for (std::size_t k = 0; k < num_links; k++)
+          {
+            y[k + 1][m + i * bs] -= 0.5 * gamma_inv
+                                    * (Pn_x - x_opp(k, bs) * dPn_u * w0)
+                                    * test_n(k + 2, i, m);
+          }
+        }
+      }
+
+      if (friction == Friction::none)
+        continue;
+
+      // Friction terms, see `unbiased_system`
+      compute_sigma_n_basis(sig_t, K, dphi, std::span(n_phys.data(), gdim),
+                            mu, lmbda, q_pos);
+      for (std::size_t i = 0; i < ndofs_cell; i++)
+        for (std::size_t n = 0; n < bs; n++)
+          for (std::size_t j = 0; j < bs; j++)
+            sig_t(i, n, j) -= test_n(0, i, n) * n_surf[j];
+
+      const bool coulomb = friction == Friction::coulomb;
+      std::array<double, 3> t_old = {0, 0, 0};
+      if (coulomb)
+      {
+        std::array<double, 3> n_old = {0, 0, 0};
+        double ndotn = 0;
+        for (std::size_t j = 0; j < gdim; ++j)
+        {
+          n_old[j] = -c[c_offsets[7] + q * gdim + j];
+          ndotn += n_surf[j] * n_old[j];
+        }
+        for (std::size_t j = 0; j < gdim; ++j)
+          t_old[j] = n_old[j] - ndotn * n_surf[j];
+      }
+
+      std::array<double, 3> Pt_u = {0, 0, 0};
+      std::array<double, 3> n_t = {0, 0, 0};
+      for (std::size_t j = 0; j < bs; ++j)
+      {
+        const double sig_t_u = sig_n_u[j] - sign_u * n_surf[j];
+        Pt_u[j] = c[c_offsets[4] + gdim * q + j] - c[offset_u_opp + j]
+                  - jump_un * n_surf[j] - (gap - jump_un) * t_old[j]
+                  - gamma * sig_t_u;
+        n_t[j] = n_surf[j] - t_old[j];
+      }
+
+      const double radius = coulomb ? fric * R_plus(Pn) : gamma * fric;
+      std::array<double, 9> d_Pt_u_proj = d_ball_projection(Pt_u, radius, bs);
+      std::array<double, 3> d_alpha_ball = {0, 0, 0};
+      if (coulomb)
+      {
+        d_alpha_ball
+            = d_alpha_ball_projection(Pt_u, radius, dR_plus(Pn) * fric);
+      }
+
+      // Tangential stress of x
+      std::array<double, 3> sig_t_x = {0, 0, 0};
+      for (std::size_t j = 0; j < ndofs_cell; j++)
+        for (std::size_t l = 0; l < bs; l++)
+          for (std::size_t n = 0; n < bs; n++)
+            sig_t_x[n] += sig_t(j, l, n) * x_k(0, j, l);
+
+      // Tangential constraint of x on the cell, Pt_x, and on each linked
+      // cell, which replaces the value of x in x_opp. The sum over the links
+      // is subtracted from Pt_x to give Pt_x_tot
+      std::array<double, 3> Pt_x = {0, 0, 0};
+      for (std::size_t m = 0; m < bs; ++m)
+      {
+        Pt_x[m] += d_alpha_ball[m] * (x_n - gamma * sign_x);
+        for (std::size_t n = 0; n < bs; n++)
+        {
+          Pt_x[m] += d_Pt_u_proj[n * bs + m]
+                     * (x_q[n] - x_n * n_t[n] - gamma * sig_t_x[n]);
+        }
+      }
+      std::array<double, 3> Pt_x_tot = Pt_x;
+      for (std::size_t k = 0; k < num_links; k++)
+      {
+        std::array<double, 3> Pt_x_opp = {0, 0, 0};
+        for (std::size_t m = 0; m < bs; ++m)
+        {
+          Pt_x_opp[m] += d_alpha_ball[m] * x_opp(k, bs);
+          for (std::size_t n = 0; n < bs; n++)
+          {
+            Pt_x_opp[m] += d_Pt_u_proj[n * bs + m]
+                           * (x_opp(k, n) - n_t[n] * x_opp(k, bs));
+          }
+        }
+        for (std::size_t m = 0; m < bs; ++m)
+        {
+          x_opp(k, m) = Pt_x_opp[m];
+          Pt_x_tot[m] -= Pt_x_opp[m];
+        }
+      }
+
+      for (std::size_t i = 0; i < ndofs_cell; i++)
+      {
+        for (std::size_t m = 0; m < bs; m++)
+        {
+          double a0 = Pt_x_tot[m] * phi(q_pos, i);
+          double sig_tt = 0;
+          for (std::size_t n = 0; n < bs; n++)
+          {
+            a0 += Pt_x_tot[n]
+                  * (-n_surf[m] * phi(q_pos, i) * n_surf[n]
+                     - theta * gamma * sig_t(i, m, n));
+            sig_tt += sig_t(i, m, n) * sig_t_x[n];
+          }
+          y[0][m + i * bs] += 0.5 * gamma_inv * a0 * w0
+                              - 0.5 * gamma * theta * w0 * sig_tt;
+        }
+      }
+
+      // entries corresponding to v on the other surface
+      for (std::size_t k = 0; k < num_links; k++)
+      {
+        std::array<double, 3> Pt_x_jump = {0, 0, 0};
+        double Pt_x_jump_n = 0;
+        for (std::size_t n = 0; n < bs; n++)
+        {
+          Pt_x_jump[n] = Pt_x[n] - x_opp(k, n);
+          Pt_x_jump_n += Pt_x_jump[n] * n_surf[n];
+        }
+        for (std::size_t i = 0; i < ndofs_cell; i++)
+        {
+          const std::size_t offset_v = test_fn_offset(k, i, q);
+          for (std::size_t m = 0; m < bs; m++)
+          {
+            y[k + 1][m + i * bs]
+                -= 0.5 * gamma_inv
+                   * (Pt_x_jump[m] * c[offset_v + m]
+                      - Pt_x_jump_n * test_n(k + 2, i, m))
+                   * w0;
+          }
+        }
+      }
+    }
+  };
+
+  return unbiased_action;
+}
+
+/// @brief Generate a batched contact kernel for frictionless contact
+///
+/// Batched version of `unbiased_rhs` and `unbiased_jac` (see
+/// `contact_kernel`), evaluating up to `kernel_batch_size` facets at once,
+/// see `batched_kernel_fn`. The test functions on the linked cells are
+/// interleaved before the quadrature loop, and all data inside the loop is
+/// stored with the facet as the fastest index. The positive part of the
+/// normal constraint is taken lane by lane, and unused lanes and quadrature
+/// points without a linked facet have zero weight.
+/// @note Assumes affine geometry and `bs == tdim == gdim == GDIM`.
+/// See `generate_contact_kernel` for a description of the input arguments
+template <std::size_t GDIM, std::size_t NDOFS>
+batched_kernel_fn<PetscScalar> batched_contact_kernel(
+    Kernel type, std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    std::shared_ptr<const QuadratureRule> quadrature_rule,
+    const std::size_t max_links)
+{
+  constexpr std::size_t W = kernel_batch_size;
+  constexpr std::size_t bs = GDIM;
+  // Size of an element vector
+  constexpr std::size_t ndofs = NDOFS * bs;
+  if (type != Kernel::Rhs and type != Kernel::Jac)
+    throw std::invalid_argument("Unrecognized kernel");
+  const bool jac = type == Kernel::Jac;
+
+  KernelData kd = contact_kernel_data(V, quadrature_rule, max_links);
+  const std::size_t num_points
+      = quadrature_rule->offset()[1] - quadrature_rule->offset()[0];
+
+  /// @brief Assemble kernel for the residual or the Jacobian of the unbiased
+  /// contact problem for a batch of facets
+  ///
+  /// See `unbiased_rhs` and `unbiased_jac` for the terms, and
+  /// `batched_kernel_fn` for the input arguments
+  return [kd, num_points, jac](
+             std::span<std::vector<std::vector<PetscScalar>>> A,
+             std::span<const std::span<const PetscScalar>> c,
+             const PetscScalar* w, std::span<const double> coordinate_dofs,
+             std::span<const std::size_t> facet_indices,
+             std::span<const std::size_t> num_links,
+             std::span<const PetscScalar> q_factors,
+             std::vector<PetscScalar>& scratch)
+  {
+    const std::size_t num_facets = facet_indices.size();
+    assert(num_facets <= W);
+    const double theta = w[1];
+    const std::size_t num_coordinate_dofs = kd.num_coordinate_dofs();
+
+    // Size of the test functions of one linked cell
+    const std::size_t link_size = NDOFS * num_points * bs;
+
+    // Data that is constant on each facet
+    std::array<double, W> mu = {};
+    std::array<double, W> lmbda = {};
+    std::array<double, W> gamma = {};
+    std::array<double, W> gamma_inv = {};
+    std::array<double, W> detJ = {};
+    std::array<double, GDIM * GDIM * W> K = {};
+    std::array<double, GDIM * W> n_phys = {};
+    std::array<std::array<double, GDIM>, W> n_facet = {};
+    std::array<std::array<std::size_t, KernelData::max_offsets>, W> c_offsets;
+    std::size_t batch_links = 0;
+    for (std::size_t l = 0; l < num_facets; ++l)
+    {
+      kd.facet_offsets(num_links[l], c[l].size(), c_offsets[l]);
+      batch_links = std::max(batch_links, num_links[l]);
+      mu[l] = c[l][0];
+      lmbda[l] = c[l][1];
+      gamma[l] = c[l][3] / w[0];     // h/gamma
+      gamma_inv[l] = w[0] / c[l][3]; // gamma/h
+
+      // The Jacobian and the normal are constant on affine cells
+      std::array<double, 9> Jb;
+      mdspan2_t J(Jb.data(), GDIM, GDIM);
+      std::array<double, 9> Kb;
+      mdspan2_t K_l(Kb.data(), GDIM, GDIM);
+      std::array<double, 6> J_totb;
+      mdspan2_t J_tot(J_totb.data(), GDIM, GDIM - 1);
+      std::array<double, 18> detJ_scratch;
+      cmdspan2_t coord(coordinate_dofs.data() + l * num_coordinate_dofs * 3,
+                       num_coordinate_dofs, 3);
+      detJ[l] = kd.compute_first_facet_jacobian(facet_indices[l], J, K_l,
+                                                J_tot, detJ_scratch, coord);
+      physical_facet_normal(
+          std::span<double>(n_facet[l]), K_l,
+          stdex::submdspan(kd.facet_normals(), facet_indices[l],
+                           MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent));
+      for (std::size_t j = 0; j < GDIM; ++j)
+      {
+        n_phys[j * W + l] = n_facet[l][j];
+        for (std::size_t k = 0; k < GDIM; ++k)
+          K[(k * GDIM + j) * W + l] = K_l(k, j);
+      }
+    }
+
+    // Interleave the test functions on the linked cells, shape (batch_links,
+    // NDOFS, num_points, bs, W). The blocks of links missing on a facet are
+    // zero and do not contribute.
+    const std::size_t c_size = batch_links * link_size * W;
+    const std::size_t vn_size = batch_links * ndofs * W;
+    const std::size_t T_size = jac ? (3 * batch_links + 1) * ndofs * ndofs * W
+                                   : (batch_links + 1) * ndofs * W;
+    scratch.assign(c_size + vn_size + T_size, 0);
+    const double* cb = scratch.data();
+    double* v_n_opp = scratch.data() + c_size;
+    double* Tb = v_n_opp + vn_size;
+    for (std::size_t l = 0; l < num_facets; ++l)
+    {
+      const std::size_t c0 = c_offsets[l][3];
+      for (std::size_t i = 0; i < num_links[l] * link_size; ++i)
+        scratch[i * W + l] = c[l][c0 + i];
+    }
+
+    // Access to the interleaved data, returning a pointer to the W lanes
+    auto v_opp = [&](std::size_t k, std::size_t i, std::size_t q,
+                     std::size_t n)
+    { return cb + (k * link_size + (i * num_points + q) * bs + n) * W; };
+    auto vn_lanes = [&](std::size_t k, std::size_t row)
+    { return v_n_opp + (k * ndofs + row) * W; };
+    auto A_lanes = [&](std::size_t block, std::size_t row, std::size_t col)
+    { return Tb + ((block * ndofs + row) * ndofs + col) * W; };
+    auto b_lanes = [&](std::size_t block, std::size_t row)
+    { return Tb + (block * ndofs + row) * W; };
+
+    // Temporary data structures used inside quadrature loop
+    s_cmdspan2_t phi_ref = kd.phi();
+    s_cmdspan3_t dphi_ref = kd.dphi();
+    std::array<double, W> w0;
+    std::array<double, W> n_dot;
+    std::array<double, W> Pn;
+    std::array<double, NDOFS * W> phi;
+    std::array<double, GDIM * NDOFS * W> dphi;
+    std::array<double, GDIM * W> n_surf;
+    std::array<double, ndofs * W> epsn;
+    std::array<double, ndofs * W> tr;
+    std::array<double, ndofs * W> sign_v;
+    std::array<double, ndofs * W> Pn_v;
+
+    for (std::size_t q = 0; q < num_points; ++q)
+    {
+      // Gather the basis functions, weights and coefficients of the facets
+      w0.fill(0);
+      n_dot.fill(0);
+      Pn.fill(0);
+      phi.fill(0);
+      dphi.fill(0);
+      n_surf.fill(0);
+      std::array<double, W> sign_u = {};
+      for (std::size_t l = 0; l < num_facets; ++l)
+      {
+        const double factor = q_factors[l * num_points + q];
+        if (factor == 0)
+          continue;
+        const std::size_t q_pos = kd.qp_offsets(facet_indices[l]) + q;
+        w0[l] = kd.weights(facet_indices[l])[q] * detJ[l] * factor;
+        for (std::size_t i = 0; i < NDOFS; ++i)
+        {
+          phi[i * W + l] = phi_ref(q_pos, i);
+          for (std::size_t k = 0; k < GDIM; ++k)
+            dphi[(k * NDOFS + i) * W + l] = dphi_ref(k, q_pos, i);
+        }
+
+        // The gap is given by n * (Pi(x) -x)
+        // For raytracing n = n_x
+        // For closest point n = -n_y
+        std::span<const PetscScalar> c_l = c[l];
+        const std::array<std::size_t, KernelData::max_offsets>& off
+            = c_offsets[l];
+        std::array<double, GDIM> n;
+        double gap = 0;
+        for (std::size_t j = 0; j < GDIM; ++j)
+        {
+          n[j] = -c_l[off[2] + q * GDIM + j];
+          n_surf[j * W + l] = n[j];
+          n_dot[l] += n_facet[l][j] * n[j];
+          gap += c_l[off[1] + q * GDIM + j] * n[j];
+        }
+
+        // compute inner(sig(u)*n_phys, n_surf) and the jump of u in the
+        // direction n_surf
+        std::array<double, GDIM> sig_n_u = {};
+        compute_sigma_n_u(sig_n_u,
+                          c_l.subspan(off[5] + q * GDIM * GDIM, GDIM * GDIM),
+                          n_facet[l], mu[l], lmbda[l]);
+        double jump_un = 0;
+        for (std::size_t j = 0; j < GDIM; ++j)
+        {
+          sign_u[l] += sig_n_u[j] * n[j];
+          jump_un += (c_l[off[4] + GDIM * q + j] - c_l[off[6] + q * bs + j])
+                     * n[j];
+        }
+        Pn[l] = (jump_un - gap) - gamma[l] * sign_u[l];
+      }
+      if (std::all_of(w0.begin(), w0.end(), [](double x) { return x == 0; }))
+        continue;
+
+      compute_normal_strain_basis<W, GDIM, NDOFS>(epsn, tr, K, dphi, n_surf,
+                                                  n_phys);
+
+      // Normal terms of the test functions, which are also those of the
+      // trial functions
+      for (std::size_t i = 0; i < NDOFS; i++)
+      {
+        const double* phi_i = phi.data() + i * W;
+        for (std::size_t n = 0; n < bs; n++)
+        {
+          const std::size_t row = n + i * bs;
+          const double* n_n = n_surf.data() + n * W;
+          double* s_v = sign_v.data() + row * W;
+          double* P_v = Pn_v.data() + row * W;
+          for (std::size_t l = 0; l < W; ++l)
+          {
+            s_v[l] = lmbda[l] * tr[row * W + l] * n_dot[l]
+                     + mu[l] * epsn[row * W + l];
+            P_v[l] = n_n[l] * phi_i[l] - gamma[l] * theta * s_v[l];
+          }
+          for (std::size_t k = 0; k < batch_links; k++)
+          {
+            const double* v_o = v_opp(k, i, q, n);
+            double* vn = vn_lanes(k, row);
+            for (std::size_t l = 0; l < W; ++l)
+              vn[l] = v_o[l] * n_n[l];
+          }
+        }
+      }
+
+      if (!jac)
+      {
+        // R_plus of the normal constraint of each facet
+        std::array<double, W> Pn_u;
+        for (std::size_t l = 0; l < W; ++l)
+          Pn_u[l] = std::max(Pn[l], 0.0) * w0[l];
+
+        for (std::size_t row = 0; row < ndofs; row++)
+        {
+          const double* s_v = sign_v.data() + row * W;
+          const double* P_v = Pn_v.data() + row * W;
+          double* b0 = b_lanes(0, row);
+          for (std::size_t l = 0; l < W; ++l)
+          {
+            b0[l] += 0.5 * gamma_inv[l] * Pn_u[l] * P_v[l]
+                     - 0.5 * theta * gamma[l] * sign_u[l] * s_v[l] * w0[l];
+          }
+
+          // entries corresponding to v on the other surface
+          for (std::size_t k = 0; k < batch_links; k++)
+          {
+            const double* vn = vn_lanes(k, row);
+            double* bk = b_lanes(k + 1, row);
+            for (std::size_t l = 0; l < W; ++l)
+              bk[l] -= 0.5 * gamma_inv[l] * vn[l] * Pn_u[l];
+          }
+        }
+        continue;
+      }
+
+      // dR_plus of the normal constraint of each facet, times the weight
+      std::array<double, W> dPn_u;
+      for (std::size_t l = 0; l < W; ++l)
+        dPn_u[l] = (Pn[l] > 0 ? 1.0 : 0.0) * w0[l];
+
+      for (std::size_t j = 0; j < NDOFS; j++)
+      {
+        const double* phi_j = phi.data() + j * W;
+        for (std::size_t m = 0; m < bs; m++)
+        {
+          const std::size_t col = m + j * bs;
+          const double* n_m = n_surf.data() + m * W;
+          const double* s_u = sign_v.data() + col * W;
+          std::array<double, W> Pn_du;
+          std::array<double, W> sign_du;
+          for (std::size_t l = 0; l < W; ++l)
+          {
+            Pn_du[l] = (phi_j[l] * n_m[l] - gamma[l] * s_u[l]) * dPn_u[l];
+            sign_du[l] = s_u[l] * w0[l];
+          }
+
+          for (std::size_t row = 0; row < ndofs; row++)
+          {
+            const double* s_v = sign_v.data() + row * W;
+            const double* P_v = Pn_v.data() + row * W;
+            double* A0 = A_lanes(0, row, col);
+            for (std::size_t l = 0; l < W; ++l)
+            {
+              A0[l] += 0.5 * gamma_inv[l] * Pn_du[l] * P_v[l]
+                       - 0.5 * theta * gamma[l] * sign_du[l] * s_v[l];
+            }
+
+            // entries corresponding to u and v on the other surface
+            for (std::size_t k = 0; k < batch_links; k++)
+            {
+              const double* du_n = vn_lanes(k, col);
+              const double* v_n = vn_lanes(k, row);
+              double* A1 = A_lanes(3 * k + 1, row, col);
+              double* A2 = A_lanes(3 * k + 2, row, col);
+              double* A3 = A_lanes(3 * k + 3, row, col);
+              for (std::size_t l = 0; l < W; ++l)
+              {
+                const double du_n_opp = du_n[l] * dPn_u[l];
+                A1[l] -= 0.5 * gamma_inv[l] * du_n_opp * P_v[l];
+                A2[l] -= 0.5 * gamma_inv[l] * Pn_du[l] * v_n[l];
+                A3[l] += 0.5 * gamma_inv[l] * du_n_opp * v_n[l];
+              }
+            }
+          }
+        }
+      }
+    }
+
+    // Add the element tensors of each facet
+    const std::size_t block_size = jac ? ndofs * ndofs : ndofs;
+    for (std::size_t l = 0; l < num_facets; ++l)
+    {
+      const std::size_t num_blocks
+          = jac ? 3 * num_links[l] + 1 : num_links[l] + 1;
+      for (std::size_t block = 0; block < num_blocks; ++block)
+      {
+        std::vector<PetscScalar>& Ae = A[l][block];
+        const double* Tb_block = Tb + block * block_size * W;
+        for (std::size_t e = 0; e < block_size; ++e)
+          Ae[e] += Tb_block[e * W + l];
+      }
+    }
+  };
+}
+} // namespace
+
+//----------------------------------------------------------------------------
+dolfinx_contact::kernel_fn<PetscScalar>
+dolfinx_contact::generate_contact_kernel(
+    dolfinx_contact::Kernel type,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    std::shared_ptr<const dolfinx_contact::QuadratureRule> quadrature_rule,
+    const std::size_t max_links)
+{
+  return dispatch_dimensions(
+      *V,
+      [&](auto gdim, auto ndofs)
+      {
+        return contact_kernel<decltype(gdim)::value, decltype(ndofs)::value>(
+            type, V, quadrature_rule, max_links);
+      });
+}
+//----------------------------------------------------------------------------
+dolfinx_contact::system_kernel_fn<PetscScalar>
+dolfinx_contact::generate_contact_system_kernel(
+    dolfinx_contact::Kernel type,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    std::shared_ptr<const dolfinx_contact::QuadratureRule> quadrature_rule,
+    const std::size_t max_links)
+{
+  return dispatch_dimensions(
+      *V,
+      [&](auto gdim, auto ndofs)
+      {
+        return contact_system_kernel<decltype(gdim)::value,
+                                     decltype(ndofs)::value>(
+            type, V, quadrature_rule, max_links);
+      });
+}
+//----------------------------------------------------------------------------
+dolfinx_contact::action_kernel_fn<PetscScalar>
+dolfinx_contact::generate_contact_action_kernel(
+    dolfinx_contact::Kernel type,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    std::shared_ptr<const dolfinx_contact::QuadratureRule> quadrature_rule,
+    const std::size_t max_links)
+{
+  return dispatch_dimensions(
+      *V,
+      [&](auto gdim, auto ndofs)
+      {
+        return contact_action_kernel<decltype(gdim)::value,
+                                     decltype(ndofs)::value>(
+            type, V, quadrature_rule, max_links);
+      });
+}
+//----------------------------------------------------------------------------
+dolfinx_contact::batched_kernel_fn<PetscScalar>
+dolfinx_contact::generate_batched_contact_kernel(
+    dolfinx_contact::Kernel type,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    std::shared_ptr<const dolfinx_contact::QuadratureRule> quadrature_rule,
+    const std::size_t max_links)
+{
+  // Only affine cells with compile time loop bounds are batched
+  std::shared_ptr<const dolfinx::mesh::Mesh<double>> mesh = V->mesh();
+  assert(mesh);
+  if ((type != dolfinx_contact::Kernel::Rhs
+       and type != dolfinx_contact::Kernel::Jac)
+      or !mesh->geometry().cmaps()[0].is_affine())
+  {
+    return nullptr;
+  }
+
+  return dispatch_dimensions(
+      *V,
+      [&](auto gdim, auto ndofs) -> batched_kernel_fn<PetscScalar>
+      {
+        constexpr std::size_t GDIM = decltype(gdim)::value;
+        constexpr std::size_t NDOFS = decltype(ndofs)::value;
+        if constexpr (GDIM == 0)
+          return nullptr;
+        else
+        {
+          return batched_contact_kernel<GDIM, NDOFS>(type, V, quadrature_rule,
+                                                     max_links);
+        }
+      });
+}
@@ -33,6 +33,8 @@
 /// packed at dofs.
 /// @note The vector valued coefficents `test_fn`, `grad(test_fn)`, `u`,
 /// `u_opposite`, `grad(u_opposite)` have dimension `bs == gdim`.
+/// @note For P1/P2 elements on triangles and tetrahedra and Q1 elements on
+/// hexahedra, a kernel with compile time loop bounds is returned.
 namespace dolfinx_contact
 {
 dolfinx_contact::kernel_fn<PetscScalar> generate_contact_kernel(
@@ -40,4 +42,63 @@ dolfinx_contact::kernel_fn<PetscScalar> generate_contact_kernel(
     std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
     std::shared_ptr<const dolfinx_contact::QuadratureRule> quadrature_rule,
     const std::size_t max_links);
+
+/// @brief Generate contact kernel computing the residual and the Jacobian in
+/// one pass
+///
+/// The kernel adds the element vectors of the `Rhs` kernel to its first
+/// argument and the element matrices of the `Jac` kernel to its second
+/// argument (see `system_kernel_fn`). `TrescaSystem` and `CoulombSystem`
+/// also add the terms of the `TrescaRhs`/`TrescaJac` and
+/// `CoulombRhs`/`CoulombJac` kernels. The work shared by all terms is done
+/// once per quadrature point.
+/// @param[in] type The kernel type (`System`, `TrescaSystem`,
+/// `CoulombSystem`)
+/// @param[in] V               The function space
+/// @param[in] quadrature_rule The quadrature rule
+/// @param[in] max_links       The maximum number of facets linked to one cell
+/// @note See `generate_contact_kernel` for the expected coefficients
+dolfinx_contact::system_kernel_fn<PetscScalar> generate_contact_system_kernel(
+    dolfinx_contact::Kernel type,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    std::shared_ptr<const dolfinx_contact::QuadratureRule> quadrature_rule,
+    const std::size_t max_links);
+
+/// @brief Generate contact kernel applying the Jacobian to a vector
+///
+/// The kernel adds the element matrices of the system kernel of the same
+/// type (see `generate_contact_system_kernel`) applied to the entries of a
+/// vector on the cell and the linked cells to the element vectors, see
+/// `action_kernel_fn`. The element matrices are not formed, the trial
+/// function terms are contracted with the vector at each quadrature point.
+/// @param[in] type The kernel type (`System`, `TrescaSystem`,
+/// `CoulombSystem`)
+/// @param[in] V               The function space
+/// @param[in] quadrature_rule The quadrature rule
+/// @param[in] max_links       The maximum number of facets linked to one cell
+/// @note See `generate_contact_kernel` for the expected coefficients
+dolfinx_contact::action_kernel_fn<PetscScalar> generate_contact_action_kernel(
+    dolfinx_contact::Kernel type,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    std::shared_ptr<const dolfinx_contact::QuadratureRule> quadrature_rule,
+    const std::size_t max_links);
+
+/// @brief Generate a batched contact kernel for frictionless contact
+///
+/// The kernel evaluates `kernel_batch_size` facets at once, with one SIMD
+/// lane per facet, see `batched_kernel_fn`.
+/// @param[in] type The kernel type. Only `Rhs` and `Jac` are batched.
+/// @param[in] V               The function space
+/// @param[in] quadrature_rule The quadrature rule
+/// @param[in] max_links       The maximum number of facets linked to one cell
+/// @returns The kernel, or an empty function if there is no batched kernel
+/// for the kernel type and element. Batched kernels exist for P1 and P2
+/// elements on affine triangles and tetrahedra.
+/// @note See `generate_contact_kernel` for the expected coefficients
+dolfinx_contact::batched_kernel_fn<PetscScalar>
+generate_batched_contact_kernel(
+    dolfinx_contact::Kernel type,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    std::shared_ptr<const dolfinx_contact::QuadratureRule> quadrature_rule,
+    const std::size_t max_links);
 } // namespace dolfinx_contact
\ No newline at end of file
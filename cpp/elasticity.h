@@ -7,9 +7,13 @@
 // This file contains helper functions that are useful for writing elasticity
 // kernels
 
+#pragma once
+
 #include "QuadratureRule.h"
-#include <span>
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <span>
 
 namespace dolfinx_contact
 {
@@ -78,6 +82,142 @@ void compute_sigma_n_opp(mdspan4_t sig_n_opp, std::span<const double> grad_v,
                          const double lmbda, const std::size_t q,
                          const std::size_t num_q_points);
 
+/// @brief Compute sigma(v)*n from the physical gradients of the test
+/// functions at a quadrature point of W facets at once
+///
+/// Batched version of `compute_sigma_n_opp`. The data of the facets is
+/// interleaved, i.e. the facet is the last (fastest) index, such that the
+/// innermost loops run over the facets and vectorise.
+/// @param[in, out] sig_n sigma(v)*n, shape (NDOFS, GDIM, GDIM, W), see
+/// `compute_sigma_n_basis`
+/// @param[in] grad_v The gradients of the test functions, shape (NDOFS,
+/// GDIM, W)
+/// @param[in] n      The normal vectors, shape (GDIM, W)
+/// @param[in] mu     The first Lame parameter of each facet
+/// @param[in] lmbda  The second Lame parameter of each facet
+/// @note Assumes bs == gdim
+template <std::size_t W, std::size_t GDIM, std::size_t NDOFS>
+void compute_sigma_n_opp(std::span<double, NDOFS * GDIM * GDIM * W> sig_n,
+                         std::span<const double, NDOFS * GDIM * W> grad_v,
+                         std::span<const double, GDIM * W> n,
+                         std::span<const double, W> mu,
+                         std::span<const double, W> lmbda)
+{
+  for (std::size_t i = 0; i < NDOFS; ++i)
+  {
+    const double* dv = grad_v.data() + i * GDIM * W;
+
+    // Compute dot(grad(v), n)
+    std::array<double, W> dv_dot_n = {};
+    for (std::size_t j = 0; j < GDIM; ++j)
+      for (std::size_t l = 0; l < W; ++l)
+        dv_dot_n[l] += dv[j * W + l] * n[j * W + l];
+
+    // Fill sig_n
+    for (std::size_t j = 0; j < GDIM; ++j)
+    {
+      for (std::size_t k = 0; k < GDIM; ++k)
+      {
+        double* sig = sig_n.data() + ((i * GDIM + j) * GDIM + k) * W;
+        for (std::size_t l = 0; l < W; ++l)
+        {
+          sig[l] = lmbda[l] * dv[j * W + l] * n[k * W + l]
+                   + mu[l] * n[j * W + l] * dv[k * W + l];
+        }
+        if (j == k)
+        {
+          for (std::size_t l = 0; l < W; ++l)
+            sig[l] += mu[l] * dv_dot_n[l];
+        }
+      }
+    }
+  }
+}
+
+/// @brief Compute sigma(v)*n for all test functions at a quadrature point of
+/// W facets at once
+///
+/// Batched version of `compute_sigma_n_basis`, see `compute_sigma_n_opp`
+/// for the layout of the data.
+/// @param[in, out] sig_n sigma(v)*n, shape (NDOFS, GDIM, GDIM, W)
+/// @param[in] K      The inverse jacobians, shape (GDIM, GDIM, W)
+/// @param[in] dphi   The reference gradients of the basis functions at the
+/// quadrature point, shape (GDIM, NDOFS, W)
+/// @param[in] n      The normal vectors, shape (GDIM, W)
+/// @param[in] mu     The first Lame parameter of each facet
+/// @param[in] lmbda  The second Lame parameter of each facet
+/// @note Assumes bs == tdim == gdim
+template <std::size_t W, std::size_t GDIM, std::size_t NDOFS>
+void compute_sigma_n_basis(std::span<double, NDOFS * GDIM * GDIM * W> sig_n,
+                           std::span<const double, GDIM * GDIM * W> K,
+                           std::span<const double, GDIM * NDOFS * W> dphi,
+                           std::span<const double, GDIM * W> n,
+                           std::span<const double, W> mu,
+                           std::span<const double, W> lmbda)
+{
+  // Compute grad(v)
+  std::array<double, NDOFS * GDIM * W> grad_v = {};
+  for (std::size_t i = 0; i < NDOFS; ++i)
+    for (std::size_t j = 0; j < GDIM; ++j)
+      for (std::size_t k = 0; k < GDIM; ++k)
+        for (std::size_t l = 0; l < W; ++l)
+          grad_v[(i * GDIM + j) * W + l]
+              += K[(k * GDIM + j) * W + l] * dphi[(k * NDOFS + i) * W + l];
+
+  compute_sigma_n_opp<W, GDIM, NDOFS>(sig_n, grad_v, n, mu, lmbda);
+}
+
+/// @brief compute dot(eps(v)*n_2, n_1) and tr(eps) for all basis functions
+/// at a quadrature point of W facets at once
+///
+/// Batched version of `compute_normal_strain_basis`, see
+/// `compute_sigma_n_opp` for the layout of the data.
+/// @param[in, out] epsn dot(eps*n_1, n_2), shape (NDOFS, GDIM, W)
+/// @param[in, out] tr   tr(eps), shape (NDOFS, GDIM, W)
+/// @param[in] K         The inverse jacobians, shape (GDIM, GDIM, W)
+/// @param[in] dphi      The reference gradients of the basis functions at the
+/// quadrature point, shape (GDIM, NDOFS, W)
+/// @param[in] n_1       1st normal vectors, typically n_surf, shape (GDIM, W)
+/// @param[in] n_2       2nd normal vectors, typically n_phys, shape (GDIM, W)
+/// @note Assumes bs == tdim == gdim
+template <std::size_t W, std::size_t GDIM, std::size_t NDOFS>
+void compute_normal_strain_basis(std::span<double, NDOFS * GDIM * W> epsn,
+                                 std::span<double, NDOFS * GDIM * W> tr,
+                                 std::span<const double, GDIM * GDIM * W> K,
+                                 std::span<const double, GDIM * NDOFS * W> dphi,
+                                 std::span<const double, GDIM * W> n_1,
+                                 std::span<const double, GDIM * W> n_2)
+{
+  for (std::size_t i = 0; i < NDOFS; ++i)
+  {
+    // Compute grad(phi_i), which is tr(eps(phi_i e_j)) for the jth component
+    double* dv = tr.data() + i * GDIM * W;
+    std::fill_n(dv, GDIM * W, 0.0);
+    for (std::size_t j = 0; j < GDIM; ++j)
+      for (std::size_t k = 0; k < GDIM; ++k)
+        for (std::size_t l = 0; l < W; ++l)
+          dv[j * W + l]
+              += K[(k * GDIM + j) * W + l] * dphi[(k * NDOFS + i) * W + l];
+
+    // Compute dot(grad(phi_i), n_1) and dot(grad(phi_i), n_2)
+    std::array<double, W> dv_n1 = {};
+    std::array<double, W> dv_n2 = {};
+    for (std::size_t j = 0; j < GDIM; ++j)
+    {
+      for (std::size_t l = 0; l < W; ++l)
+      {
+        dv_n1[l] += dv[j * W + l] * n_1[j * W + l];
+        dv_n2[l] += dv[j * W + l] * n_2[j * W + l];
+      }
+    }
+
+    double* en = epsn.data() + i * GDIM * W;
+    for (std::size_t j = 0; j < GDIM; ++j)
+      for (std::size_t l = 0; l < W; ++l)
+        en[j * W + l] = dv_n2[l] * n_1[j * W + l] + n_2[j * W + l] * dv_n1[l];
+  }
+}
+
 /// @brief Compute contact stress sigma(u)*n_x from grad(u), n_x
 ///
 /// all input data packed at quadrature points for each facet
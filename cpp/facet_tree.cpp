@@ -0,0 +1,325 @@
+// Copyright (C) 2023 The DOLFINx_Contact authors
+//
+// This file is part of DOLFINx_CONTACT
+//
+// SPDX-License-Identifier:    MIT
+
+#include "facet_tree.h"
+#include "geometric_quantities.h"
+#include "utils.h"
+#include <algorithm>
+#include <dolfinx/geometry/gjk.h>
+#include <functional>
+#include <limits>
+#include <numeric>
+
+namespace
+{
+/// Sum of the side lengths of a bounding box stored as (min, max). Unlike
+/// the surface area, this is non-zero for flat boxes, e.g. in 2D
+double box_size(std::span<const double, 6> b)
+{
+  return (b[3] - b[0]) + (b[4] - b[1]) + (b[5] - b[2]);
+}
+
+/// Squared distance from a point to a bounding box stored as (min, max)
+double box_distance(std::span<const double, 6> b, std::span<const double, 3> x)
+{
+  double d = 0;
+  for (std::size_t k = 0; k < 3; ++k)
+  {
+    const double dk = std::max({b[k] - x[k], 0.0, x[k] - b[3 + k]});
+    d += dk * dk;
+  }
+  return d;
+}
+
+/// Set the bounding box c to the union of the boxes a and b
+void box_union(std::span<const double, 6> a, std::span<const double, 6> b,
+               std::span<double, 6> c)
+{
+  for (std::size_t k = 0; k < 3; ++k)
+  {
+    c[k] = std::min(a[k], b[k]);
+    c[3 + k] = std::max(a[3 + k], b[3 + k]);
+  }
+}
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+dolfinx_contact::FacetTree::FacetTree(const dolfinx::mesh::Mesh<double>& mesh,
+                                      std::span<const std::int32_t> facets,
+                                      double rebuild_ratio)
+    : _facets(facets.begin(), facets.end()),
+      _facet_dofs(dolfinx_contact::entities_to_geometry_dofs(
+          mesh, mesh.topology()->dim() - 1, facets)),
+      _rebuild_ratio(rebuild_ratio)
+{
+  const int tdim = mesh.topology()->dim();
+  const dolfinx::fem::ElementDofLayout layout
+      = mesh.geometry().cmaps()[0].create_dof_layout();
+  _num_facet_dofs = layout.num_entity_closure_dofs(tdim - 1);
+  _linear = _num_facet_dofs == (std::size_t)tdim;
+
+  update_coordinates(mesh);
+  build();
+}
+//-----------------------------------------------------------------------------
+bool dolfinx_contact::FacetTree::update(const dolfinx::mesh::Mesh<double>& mesh)
+{
+  update_coordinates(mesh);
+  if (_facets.empty())
+    return false;
+
+  // Refit bottom-up. Children are stored before their parents
+  for (std::size_t i = 0; i < _children.size(); ++i)
+  {
+    std::span<double, 6> box(_boxes.data() + 6 * i, 6);
+    auto [c0, c1] = _children[i];
+    if (c0 < 0)
+    {
+      std::copy_n(std::next(_facet_boxes.begin(), 6 * c1), 6, box.begin());
+    }
+    else
+    {
+      box_union(std::span<const double, 6>(_boxes.data() + 6 * c0, 6),
+                std::span<const double, 6>(_boxes.data() + 6 * c1, 6), box);
+    }
+  }
+
+  if (relative_cost() > _rebuild_ratio * _build_cost)
+  {
+    build();
+    return true;
+  }
+  return false;
+}
+//-----------------------------------------------------------------------------
+std::vector<std::int32_t> dolfinx_contact::FacetTree::compute_closest_facets(
+    std::span<const double> points) const
+{
+  const std::size_t num_points = points.size() / 3;
+  std::vector<std::int32_t> closest(num_points, -1);
+  if (_facets.empty())
+    return closest;
+
+  auto box = [this](std::int32_t node)
+  { return std::span<const double, 6>(_boxes.data() + 6 * node, 6); };
+
+  // Branch and bound search, visiting the closest child first
+  std::vector<std::int32_t> stack;
+  for (std::size_t i = 0; i < num_points; ++i)
+  {
+    std::span<const double, 3> x(points.data() + 3 * i, 3);
+    double min_dist = std::numeric_limits<double>::max();
+    stack.assign(1, (std::int32_t)_children.size() - 1);
+    while (!stack.empty())
+    {
+      const std::int32_t node = stack.back();
+      stack.pop_back();
+      if (box_distance(box(node), x) >= min_dist)
+        continue;
+
+      auto [c0, c1] = _children[node];
+      if (c0 < 0)
+      {
+        if (double dist = facet_distance(c1, x); dist < min_dist)
+        {
+          min_dist = dist;
+          closest[i] = _facets[c1];
+        }
+        continue;
+      }
+
+      if (box_distance(box(c0), x) < box_distance(box(c1), x))
+        std::swap(c0, c1);
+      stack.push_back(c0);
+      stack.push_back(c1);
+    }
+  }
+  return closest;
+}
+//-----------------------------------------------------------------------------
+std::vector<std::int32_t> dolfinx_contact::FacetTree::compute_facets_within(
+    std::span<const double> points, double radius) const
+{
+  std::vector<std::int32_t> facets;
+  if (_facets.empty())
+    return facets;
+
+  const double r2 = radius * radius;
+  std::vector<std::int32_t> stack;
+  for (std::size_t i = 0; i < points.size() / 3; ++i)
+  {
+    std::span<const double, 3> x(points.data() + 3 * i, 3);
+    stack.assign(1, (std::int32_t)_children.size() - 1);
+    while (!stack.empty())
+    {
+      const std::int32_t node = stack.back();
+      stack.pop_back();
+      if (box_distance(
+              std::span<const double, 6>(_boxes.data() + 6 * node, 6), x)
+          > r2)
+      {
+        continue;
+      }
+
+      auto [c0, c1] = _children[node];
+      if (c0 < 0)
+      {
+        if (facet_distance(c1, x) <= r2)
+          facets.push_back(_facets[c1]);
+      }
+      else
+      {
+        stack.push_back(c0);
+        stack.push_back(c1);
+      }
+    }
+  }
+
+  std::sort(facets.begin(), facets.end());
+  facets.erase(std::unique(facets.begin(), facets.end()), facets.end());
+  return facets;
+}
+//-----------------------------------------------------------------------------
+void dolfinx_contact::FacetTree::build()
+{
+  _children.clear();
+  _boxes.clear();
+  if (_facets.empty())
+    return;
+  _children.reserve(2 * _facets.size() - 1);
+  _boxes.reserve(6 * (2 * _facets.size() - 1));
+
+  std::vector<double> midpoints(3 * _facets.size());
+  for (std::size_t i = 0; i < _facets.size(); ++i)
+    for (std::size_t k = 0; k < 3; ++k)
+      midpoints[3 * i + k]
+          = 0.5 * (_facet_boxes[6 * i + k] + _facet_boxes[6 * i + 3 + k]);
+
+  // Recursively split the facets at the median of their midpoints along
+  // the axis where the midpoints have the largest extent
+  std::vector<std::int32_t> positions(_facets.size());
+  std::iota(positions.begin(), positions.end(), 0);
+  std::function<std::int32_t(std::span<std::int32_t>)> build_node
+      = [&](std::span<std::int32_t> p) -> std::int32_t
+  {
+    if (p.size() == 1)
+    {
+      _children.push_back({-1, p.front()});
+      _boxes.insert(_boxes.end(), std::next(_facet_boxes.begin(), 6 * p[0]),
+                    std::next(_facet_boxes.begin(), 6 * (p[0] + 1)));
+      return (std::int32_t)_children.size() - 1;
+    }
+
+    std::array<double, 6> extent
+        = {std::numeric_limits<double>::max(),
+           std::numeric_limits<double>::max(),
+           std::numeric_limits<double>::max(),
+           std::numeric_limits<double>::lowest(),
+           std::numeric_limits<double>::lowest(),
+           std::numeric_limits<double>::lowest()};
+    for (std::int32_t f : p)
+    {
+      for (std::size_t k = 0; k < 3; ++k)
+      {
+        extent[k] = std::min(extent[k], midpoints[3 * f + k]);
+        extent[3 + k] = std::max(extent[3 + k], midpoints[3 * f + k]);
+      }
+    }
+    std::size_t axis = 0;
+    for (std::size_t k = 1; k < 3; ++k)
+    {
+      if (extent[3 + k] - extent[k] > extent[3 + axis] - extent[axis])
+        axis = k;
+    }
+    auto middle = std::next(p.begin(), p.size() / 2);
+    std::nth_element(p.begin(), middle, p.end(),
+                     [&midpoints, axis](std::int32_t a, std::int32_t b) {
+                       return midpoints[3 * a + axis]
+                              < midpoints[3 * b + axis];
+                     });
+
+    const std::int32_t c0 = build_node(p.first(p.size() / 2));
+    const std::int32_t c1 = build_node(p.subspan(p.size() / 2));
+    _children.push_back({c0, c1});
+    _boxes.resize(_boxes.size() + 6);
+    box_union(std::span<const double, 6>(_boxes.data() + 6 * c0, 6),
+              std::span<const double, 6>(_boxes.data() + 6 * c1, 6),
+              std::span<double, 6>(_boxes.data() + _boxes.size() - 6, 6));
+    return (std::int32_t)_children.size() - 1;
+  };
+  build_node(positions);
+
+  _build_cost = relative_cost();
+}
+//-----------------------------------------------------------------------------
+void dolfinx_contact::FacetTree::update_coordinates(
+    const dolfinx::mesh::Mesh<double>& mesh)
+{
+  std::span<const double> x = mesh.geometry().x();
+  _facet_x.resize(_facets.size() * _num_facet_dofs * 3);
+  _facet_boxes.resize(6 * _facets.size());
+  for (std::size_t i = 0; i < _facets.size(); ++i)
+  {
+    auto dofs = _facet_dofs.links((int)i);
+    assert(dofs.size() == _num_facet_dofs);
+    std::span<double, 6> box(_facet_boxes.data() + 6 * i, 6);
+    std::copy_n(std::next(x.begin(), 3 * dofs.front()), 3, box.begin());
+    std::copy_n(std::next(x.begin(), 3 * dofs.front()), 3,
+                std::next(box.begin(), 3));
+    for (std::size_t j = 0; j < dofs.size(); ++j)
+    {
+      for (std::size_t k = 0; k < 3; ++k)
+      {
+        const double xk = x[3 * dofs[j] + k];
+        _facet_x[(i * _num_facet_dofs + j) * 3 + k] = xk;
+        box[k] = std::min(box[k], xk);
+        box[3 + k] = std::max(box[3 + k], xk);
+      }
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+double dolfinx_contact::FacetTree::relative_cost() const
+{
+  if (_children.empty())
+    return 0;
+  const double root_size = box_size(
+      std::span<const double, 6>(_boxes.data() + _boxes.size() - 6, 6));
+  if (root_size <= 0)
+    return 0;
+  double size = 0;
+  for (std::size_t i = 0; i < _children.size(); ++i)
+  {
+    if (_children[i][0] >= 0)
+      size += box_size(std::span<const double, 6>(_boxes.data() + 6 * i, 6));
+  }
+  return size / root_size;
+}
+//-----------------------------------------------------------------------------
+double
+dolfinx_contact::FacetTree::facet_distance(std::size_t facet,
+                                           std::span<const double, 3> x) const
+{
+  std::span<const double> facet_x(
+      _facet_x.data() + facet * _num_facet_dofs * 3, _num_facet_dofs * 3);
+  std::array<double, 3> d;
+  if (_linear)
+  {
+    std::array<double, 3> y;
+    dolfinx_contact::closest_point_linear_facets(facet_x, _num_facet_dofs, x,
+                                                 y);
+    for (std::size_t k = 0; k < 3; ++k)
+      d[k] = y[k] - x[k];
+  }
+  else
+  {
+    d = dolfinx::geometry::compute_distance_gjk(
+        facet_x, std::span<const double>(x.data(), 3));
+  }
+  return d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,114 @@
+// Copyright (C) 2023 The DOLFINx_Contact authors
+//
+// This file is part of DOLFINx_CONTACT
+//
+// SPDX-License-Identifier:    MIT
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <dolfinx/graph/AdjacencyList.h>
+#include <dolfinx/mesh/Mesh.h>
+#include <span>
+#include <vector>
+
+namespace dolfinx_contact
+{
+
+/// @brief Persistent bounding volume hierarchy over a set of facets
+///
+/// The tree is used for closest facet searches on a contact surface. When
+/// the geometry of the mesh moves, but the topology is unchanged, the
+/// bounding boxes are refitted bottom-up instead of rebuilding the tree. The
+/// tree is only rebuilt if the refitted boxes overlap too much, measured by
+/// the sum of the side lengths of the internal boxes relative to the side
+/// lengths of the root box. Unlike the surface area, this measure does not
+/// vanish for flat boxes, e.g. in 2D.
+class FacetTree
+{
+public:
+  /// @brief Build the tree
+  /// @param[in] mesh The mesh
+  /// @param[in] facets The facets (local to process) in the tree
+  /// @param[in] rebuild_ratio The tree is rebuilt on `update` if the summed
+  /// side lengths of the internal boxes, relative to those of the root box,
+  /// have grown by more than this factor since the last build
+  FacetTree(const dolfinx::mesh::Mesh<double>& mesh,
+            std::span<const std::int32_t> facets, double rebuild_ratio = 2.0);
+
+  /// @brief Update the bounding boxes to the current mesh geometry
+  /// @param[in] mesh The mesh the tree was built on, with updated geometry
+  /// @returns True if the tree was rebuilt, false if it was refitted
+  bool update(const dolfinx::mesh::Mesh<double>& mesh);
+
+  /// @brief Compute the closest facet in the tree for a set of points
+  ///
+  /// The distance to a facet is the distance to the convex hull of its
+  /// geometry nodes.
+  /// @param[in] points The points, shape (num_points, 3). Flattened
+  /// row-major
+  /// @returns The closest facet (local to process) for each point
+  std::vector<std::int32_t>
+  compute_closest_facets(std::span<const double> points) const;
+
+  /// @brief Compute the facets in the tree within a distance of a set of
+  /// points
+  /// @param[in] points The points, shape (num_points, 3). Flattened
+  /// row-major
+  /// @param[in] radius The distance
+  /// @returns The facets (local to process) with a distance of at most
+  /// `radius` to any of the points, sorted and unique
+  std::vector<std::int32_t>
+  compute_facets_within(std::span<const double> points, double radius) const;
+
+  /// Return the facets in the tree
+  std::span<const std::int32_t> facets() const { return _facets; }
+
+  /// Return the number of nodes in the tree
+  std::size_t num_nodes() const { return _children.size(); }
+
+private:
+  // Build the tree from the current facet bounding boxes
+  void build();
+
+  // Copy the coordinates of the facets from the mesh geometry and compute
+  // their bounding boxes
+  void update_coordinates(const dolfinx::mesh::Mesh<double>& mesh);
+
+  // Sum of the side lengths of the internal boxes relative to the sum of
+  // the side lengths of the root box
+  double relative_cost() const;
+
+  // Squared distance from a point to a facet
+  double facet_distance(std::size_t facet, std::span<const double, 3> x) const;
+
+  // Facets in the tree and their geometry dofs
+  std::vector<std::int32_t> _facets;
+  dolfinx::graph::AdjacencyList<std::int32_t> _facet_dofs;
+
+  // Coordinates of the geometry dofs of each facet, shape (num_facets,
+  // num_facet_dofs, 3)
+  std::vector<double> _facet_x;
+  std::size_t _num_facet_dofs;
+
+  // True if the facets are segments or flat triangles
+  bool _linear;
+
+  // Bounding boxes of the facets, shape (num_facets, 6) as (min, max)
+  std::vector<double> _facet_boxes;
+
+  // Children of each node, stored such that children come before their
+  // parent. For leaves the first entry is -1 and the second entry the
+  // position of the facet in `_facets`
+  std::vector<std::array<std::int32_t, 2>> _children;
+
+  // Bounding box of each node, shape (num_nodes, 6) as (min, max)
+  std::vector<double> _boxes;
+
+  // Relative cost of the tree when it was last built
+  double _build_cost = 0;
+  double _rebuild_ratio;
+};
+
+} // namespace dolfinx_contact
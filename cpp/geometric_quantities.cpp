@@ -8,6 +8,118 @@
 
 using namespace dolfinx_contact;
 
+namespace
+{
+/// Number of points processed together by `closest_point_linear_facets`
+constexpr std::size_t block_size = 16;
+
+/// Triangles where the squared sine of the smallest angle between two edges
+/// is below this tolerance are treated as degenerate
+constexpr double degenerate_tol = 1e-12;
+
+/// Points and facet vertices of a block, stored as structure of arrays
+struct LinearFacetBlock
+{
+  std::array<std::array<double, block_size>, 3> p;
+  std::array<std::array<std::array<double, block_size>, 3>, 3> v;
+  std::array<std::array<double, block_size>, 3> x;
+};
+
+/// Closest point on the segment [a, b] to p
+/// @returns The squared distance between p and the closest point
+inline double closest_on_segment(double ax, double ay, double az, double bx,
+                                 double by, double bz, double px, double py,
+                                 double pz, double& cx, double& cy, double& cz)
+{
+  const double abx = bx - ax;
+  const double aby = by - ay;
+  const double abz = bz - az;
+  const double ab2 = abx * abx + aby * aby + abz * abz;
+
+  // A segment of zero length is the point a
+  const double inv_ab2 = ab2 > 0 ? 1.0 / ab2 : 0.0;
+  double t = ((px - ax) * abx + (py - ay) * aby + (pz - az) * abz) * inv_ab2;
+  t = std::min(std::max(t, 0.0), 1.0);
+  cx = ax + t * abx;
+  cy = ay + t * aby;
+  cz = az + t * abz;
+  return (px - cx) * (px - cx) + (py - cy) * (py - cy) + (pz - cz) * (pz - cz);
+}
+
+/// Compute the closest points on the segments of the first n entries of a
+/// block
+void closest_on_segments(LinearFacetBlock& b, std::size_t n)
+{
+  const auto& a = b.v[0];
+  const auto& c = b.v[1];
+  for (std::size_t l = 0; l < n; ++l)
+  {
+    closest_on_segment(a[0][l], a[1][l], a[2][l], c[0][l], c[1][l], c[2][l],
+                       b.p[0][l], b.p[1][l], b.p[2][l], b.x[0][l], b.x[1][l],
+                       b.x[2][l]);
+  }
+}
+
+/// Compute the closest points on the triangles of the first n entries of
+/// a block. If the projection of the point onto the plane of the triangle
+/// is outside the triangle, the closest point is on one of its edges. All
+/// candidates are computed to keep the loop free of branches. Degenerate
+/// (or sliver) triangles have no well defined plane, and as they are
+/// covered by their edges, only the edges are used.
+void closest_on_triangles(LinearFacetBlock& b, std::size_t n)
+{
+  const auto& [v0, v1, v2] = b.v;
+  for (std::size_t l = 0; l < n; ++l)
+  {
+    const double abx = v1[0][l] - v0[0][l];
+    const double aby = v1[1][l] - v0[1][l];
+    const double abz = v1[2][l] - v0[2][l];
+    const double acx = v2[0][l] - v0[0][l];
+    const double acy = v2[1][l] - v0[1][l];
+    const double acz = v2[2][l] - v0[2][l];
+    const double apx = b.p[0][l] - v0[0][l];
+    const double apy = b.p[1][l] - v0[1][l];
+    const double apz = b.p[2][l] - v0[2][l];
+
+    // Barycentric coordinates of the projection onto the plane
+    const double d00 = abx * abx + aby * aby + abz * abz;
+    const double d01 = abx * acx + aby * acy + abz * acz;
+    const double d11 = acx * acx + acy * acy + acz * acz;
+    const double d20 = apx * abx + apy * aby + apz * abz;
+    const double d21 = apx * acx + apy * acy + apz * acz;
+    const double denom = d00 * d11 - d01 * d01;
+    const bool degenerate = !(denom > degenerate_tol * d00 * d11);
+    const double inv_denom = degenerate ? 0.0 : 1.0 / denom;
+    const double s = (d11 * d20 - d01 * d21) * inv_denom;
+    const double t = (d00 * d21 - d01 * d20) * inv_denom;
+    const bool inside
+        = !degenerate and (s >= 0) and (t >= 0) and (s + t <= 1);
+
+    // Closest points on the edges
+    std::array<double, 3> e0, e1, e2;
+    const double dist0 = closest_on_segment(
+        v0[0][l], v0[1][l], v0[2][l], v1[0][l], v1[1][l], v1[2][l], b.p[0][l],
+        b.p[1][l], b.p[2][l], e0[0], e0[1], e0[2]);
+    const double dist1 = closest_on_segment(
+        v1[0][l], v1[1][l], v1[2][l], v2[0][l], v2[1][l], v2[2][l], b.p[0][l],
+        b.p[1][l], b.p[2][l], e1[0], e1[1], e1[2]);
+    const double dist2 = closest_on_segment(
+        v2[0][l], v2[1][l], v2[2][l], v0[0][l], v0[1][l], v0[2][l], b.p[0][l],
+        b.p[1][l], b.p[2][l], e2[0], e2[1], e2[2]);
+    const bool first = (dist0 <= dist1) and (dist0 <= dist2);
+    const bool second = !first and (dist1 <= dist2);
+    for (std::size_t k = 0; k < 3; ++k)
+    {
+      const double edge = first ? e0[k] : (second ? e1[k] : e2[k]);
+      const double plane = v0[k][l] + s * (v1[k][l] - v0[k][l])
+                           + t * (v2[k][l] - v0[k][l]);
+      b.x[k][l] = inside ? plane : edge;
+    }
+  }
+}
+
+} // namespace
+
 std::vector<double> dolfinx_contact::allocate_pull_back_nonaffine(
     const dolfinx::fem::CoordinateElement<double>& cmap, int gdim, int tdim)
 {
@@ -226,3 +338,45 @@ dolfinx_contact::compute_circumradius(const dolfinx::mesh::Mesh<double>& mesh,
                                 + dolfinx::mesh::to_string(cell_type));
   }
 }
+//-----------------------------------------------------------------------------
+void dolfinx_contact::closest_point_linear_facets(
+    std::span<const double> facet_x, std::size_t num_vertices,
+    std::span<const double> points, std::span<double> closest)
+{
+  if (num_vertices != 2 and num_vertices != 3)
+  {
+    throw std::invalid_argument(
+        "Closest point is only implemented for segments and triangles");
+  }
+  const std::size_t num_points = points.size() / 3;
+  assert(facet_x.size() == num_points * num_vertices * 3);
+  assert(closest.size() == points.size());
+
+  LinearFacetBlock block;
+  for (std::size_t i0 = 0; i0 < num_points; i0 += block_size)
+  {
+    const std::size_t n = std::min(block_size, num_points - i0);
+
+    // Pack block as structure of arrays
+    for (std::size_t l = 0; l < n; ++l)
+    {
+      for (std::size_t k = 0; k < 3; ++k)
+      {
+        block.p[k][l] = points[3 * (i0 + l) + k];
+        for (std::size_t j = 0; j < num_vertices; ++j)
+        {
+          block.v[j][k][l] = facet_x[((i0 + l) * num_vertices + j) * 3 + k];
+        }
+      }
+    }
+
+    if (num_vertices == 2)
+      closest_on_segments(block, n);
+    else
+      closest_on_triangles(block, n);
+
+    for (std::size_t l = 0; l < n; ++l)
+      for (std::size_t k = 0; k < 3; ++k)
+        closest[3 * (i0 + l) + k] = block.x[k][l];
+  }
+}
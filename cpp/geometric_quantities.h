@@ -103,6 +103,24 @@ void physical_facet_normal(E&& physical_normal, F&& K, G&& reference_normal)
                 [norm](auto& ni) { ni = ni / norm; });
 }
 
+/// @brief Compute the closest point on a set of linear facets
+///
+/// For each point, compute the closest point on the segment (2 vertices) or
+/// triangle (3 vertices) associated with it. The points are processed in
+/// blocks stored as structure of arrays, such that the computation can be
+/// vectorized by the compiler. For curved facets, use the GJK algorithm.
+/// Degenerate facets are handled through their edges (or vertices).
+/// @param[in] facet_x The vertices of the facet associated with each
+/// point, shape (num_points, num_vertices, 3). Flattened row-major
+/// @param[in] num_vertices The number of vertices of each facet (2 or 3)
+/// @param[in] points The points, shape (num_points, 3). Flattened row-major
+/// @param[out] closest The closest point on each facet, shape (num_points,
+/// 3). Flattened row-major
+void closest_point_linear_facets(std::span<const double> facet_x,
+                                 std::size_t num_vertices,
+                                 std::span<const double> points,
+                                 std::span<double> closest);
+
 //-----------------------------------------------------------------------------
 
 } // namespace dolfinx_contact
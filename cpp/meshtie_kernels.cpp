@@ -5,22 +5,33 @@
 // SPDX-License-Identifier:    MIT
 
 #include "meshtie_kernels.h"
-dolfinx_contact::kernel_fn<PetscScalar>
-dolfinx_contact::generate_meshtie_kernel(
-    dolfinx_contact::Kernel type,
-    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
-    std::shared_ptr<const dolfinx_contact::QuadratureRule> quadrature_rule,
-    const std::vector<std::size_t>& cstrides)
+
+using namespace dolfinx_contact;
+
+namespace
+{
+/// @brief Generate meshtie kernel for a fixed geometric dimension and number
+/// of dofs per cell
+///
+/// If `GDIM` and `NDOFS` are non-zero, the loop bounds over the spatial
+/// dimension, block size and cell dofs are known at compile time. Zero means
+/// that the value is read from the function space at runtime.
+/// @note For `GDIM > 0` it is assumed that `bs == tdim == gdim`.
+/// See `generate_meshtie_kernel` for a description of the input arguments
+template <std::size_t GDIM, std::size_t NDOFS>
+kernel_fn<PetscScalar>
+meshtie_kernel(Kernel type,
+               std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+               std::shared_ptr<const QuadratureRule> quadrature_rule,
+               const std::vector<std::size_t>& cstrides, std::size_t max_links)
 {
   std::shared_ptr<const dolfinx::mesh::Mesh<double>> mesh = V->mesh();
   assert(mesh);
-  const std::size_t gdim = mesh->geometry().dim(); // geometrical dimension
-  const std::size_t bs = V->dofmap()->bs();
   // NOTE: Assuming same number of quadrature points on each cell
   dolfinx_contact::error::check_cell_type(mesh->topology()->cell_types()[0]);
-  const std::size_t ndofs_cell = V->dofmap()->element_dof_layout().num_dofs();
 
   auto kd = dolfinx_contact::KernelData(V, quadrature_rule, cstrides);
+  kd.set_link_coefficients(1, 3, max_links);
   /// @brief Assemble kernel for RHS gluing two objects with Nitsche
   ///
   /// Assemble of the residual of the unbiased contact problem into vector
@@ -33,16 +44,25 @@ dolfinx_contact::generate_meshtie_kernel(
   /// @param[in] coordinate_dofs The physical coordinates of cell. Assumed to
   /// be padded to 3D, (shape (num_nodes, 3)).
   kernel_fn<PetscScalar> meshtie_rhs
-      = [kd, gdim, bs,
-         ndofs_cell](std::vector<std::vector<PetscScalar>>& b,
-                     std::span<const PetscScalar> c, const PetscScalar* w,
-                     const double* coordinate_dofs,
-                     const std::size_t facet_index, const std::size_t num_links,
-                     std::span<const std::int32_t> q_indices)
+      = [kd](std::vector<std::vector<PetscScalar>>& b,
+             std::span<const PetscScalar> c, const PetscScalar* w,
+             const double* coordinate_dofs, const std::size_t facet_index,
+             const std::size_t num_links,
+             std::span<const std::int32_t> q_indices,
+             KernelWorkspace& workspace)
   {
-    // Retrieve some data from kd
+    // Retrieve some data from kd. The dimensions are compile time constants
+    // for the specialised kernels (see generate_meshtie_kernel)
+    const std::size_t gdim = GDIM > 0 ? GDIM : kd.gdim();
+    const std::size_t ndofs_cell = NDOFS > 0 ? NDOFS : kd.ndofs_cell();
+    const std::size_t bs = GDIM > 0 ? GDIM : kd.bs();
     auto tdim = std::size_t(kd.tdim());
 
+    // Coefficient offsets of the facet, where the test functions (and their
+    // gradients) of the linked cells may be stored ragged
+    std::array<std::size_t, KernelData::max_offsets> c_offsets;
+    kd.facet_offsets(num_links, c.size(), c_offsets);
+
     // NOTE: DOLFINx has 3D input coordinate dofs
     cmdspan2_t coord(coordinate_dofs, kd.num_coordinate_dofs(), 3);
 
@@ -86,12 +106,10 @@ dolfinx_contact::generate_meshtie_kernel(
     std::span<const double> weights = kd.weights(facet_index);
 
     // Temporary data structures used inside quadrature loop
-    std::vector<double> sig_nb(ndofs_cell * gdim * gdim);
-    std::vector<double> sig_n_oppb(num_links * ndofs_cell * gdim * gdim);
-    std::vector<double> sig_n_u(gdim);
-    std::vector<double> jump_u(gdim);
-    mdspan3_t sig_n(sig_nb.data(), ndofs_cell, gdim, gdim);
-    mdspan4_t sig_n_opp(sig_n_oppb.data(), num_links, ndofs_cell, gdim, gdim);
+    std::span<double> sig_n_u = workspace.sig_n_u();
+    std::span<double> jump_u = workspace.jump_u();
+    mdspan3_t sig_n = workspace.sig_n();
+    mdspan4_t sig_n_opp = workspace.sig_n_opp(num_links);
 
     // Loop over quadrature points
     std::array<std::size_t, 2> q_offset
@@ -108,22 +126,22 @@ dolfinx_contact::generate_meshtie_kernel(
       compute_sigma_n_basis(sig_n, K, dphi, std::span(n_phys.data(), gdim), mu,
                             lmbda, q_pos);
       compute_sigma_n_opp(
-          sig_n_opp, c.subspan(kd.offsets(2), kd.offsets(3) - kd.offsets(2)),
+          sig_n_opp, c.subspan(c_offsets[2], c_offsets[3] - c_offsets[2]),
           std::span(n_phys.data(), gdim), mu, lmbda, q, num_points);
 
       // compute u, sig_n(u)
       std::fill(sig_n_u.begin(), sig_n_u.end(), 0.0);
       compute_sigma_n_u(sig_n_u,
-                        c.subspan(kd.offsets(4) + q * gdim * gdim, gdim * gdim),
+                        c.subspan(c_offsets[4] + q * gdim * gdim, gdim * gdim),
                         std::span(n_phys.data(), gdim), mu, lmbda);
       // avg(sig_n(u)):  sig_n(u) +=  sig_n(u_opposite)
       compute_sigma_n_u(sig_n_u,
-                        c.subspan(kd.offsets(6) + q * gdim * gdim, gdim * gdim),
+                        c.subspan(c_offsets[6] + q * gdim * gdim, gdim * gdim),
                         std::span(n_phys.data(), gdim), mu, lmbda);
 
       // compute [[u]] = jump(u) = u - u_opp
-      std::size_t offset_u_opp = kd.offsets(5) + q * bs;
-      std::size_t offset_u = kd.offsets(3) + q * bs;
+      std::size_t offset_u_opp = c_offsets[5] + q * bs;
+      std::size_t offset_u = c_offsets[3] + q * bs;
       for (std::size_t j = 0; j < bs; ++j)
         jump_u[j] = c[offset_u + j] - c[offset_u_opp + j];
       const double w0 = 0.5 * weights[q] * detJ;
@@ -145,7 +163,7 @@ dolfinx_contact::generate_meshtie_kernel(
           // entries corresponding to v on the other surface
           for (std::size_t k = 0; k < num_links; k++)
           {
-            std::size_t index = kd.offsets(1) + k * num_points * ndofs_cell * bs
+            std::size_t index = c_offsets[1] + k * num_points * ndofs_cell * bs
                                 + i * num_points * bs + q * bs + n;
 
             // -inner(-avg(sig(u)n) + gamma[[u]], v_opposite)
@@ -174,16 +192,25 @@ dolfinx_contact::generate_meshtie_kernel(
   /// @param[in] coordinate_dofs The physical coordinates of cell. Assumed to
   /// be padded to 3D, (shape (num_nodes, 3)).
   kernel_fn<PetscScalar> meshtie_thermo_elastic
-      = [kd, gdim, bs,
-         ndofs_cell](std::vector<std::vector<PetscScalar>>& b,
-                     std::span<const PetscScalar> c, const PetscScalar* w,
-                     const double* coordinate_dofs,
-                     const std::size_t facet_index, const std::size_t num_links,
-                     std::span<const std::int32_t> q_indices)
+      = [kd](std::vector<std::vector<PetscScalar>>& b,
+             std::span<const PetscScalar> c, const PetscScalar* w,
+             const double* coordinate_dofs, const std::size_t facet_index,
+             const std::size_t num_links,
+             std::span<const std::int32_t> q_indices,
+             [[maybe_unused]] KernelWorkspace& workspace)
   {
-    // Retrieve some data from kd
+    // Retrieve some data from kd. The dimensions are compile time constants
+    // for the specialised kernels (see generate_meshtie_kernel)
+    const std::size_t gdim = GDIM > 0 ? GDIM : kd.gdim();
+    const std::size_t ndofs_cell = NDOFS > 0 ? NDOFS : kd.ndofs_cell();
+    const std::size_t bs = GDIM > 0 ? GDIM : kd.bs();
     auto tdim = std::size_t(kd.tdim());
 
+    // Coefficient offsets of the facet, where the test functions (and their
+    // gradients) of the linked cells may be stored ragged
+    std::array<std::size_t, KernelData::max_offsets> c_offsets;
+    kd.facet_offsets(num_links, c.size(), c_offsets);
+
     // NOTE: DOLFINx has 3D input coordinate dofs
     cmdspan2_t coord(coordinate_dofs, kd.num_coordinate_dofs(), 3);
 
@@ -239,7 +266,7 @@ dolfinx_contact::generate_meshtie_kernel(
 
       const double w0 = 0.5 * weights[q] * detJ;
 
-      double avg_T = 0.5 * (c[kd.offsets(7) + q] + c[kd.offsets(8) + q]);
+      double avg_T = 0.5 * (c[c_offsets[7] + q] + c[c_offsets[8] + q]);
       // Fill contributions of facet with itself
 
       for (std::size_t i = 0; i < ndofs_cell; i++)
@@ -252,7 +279,7 @@ dolfinx_contact::generate_meshtie_kernel(
           // entries corresponding to v on the other surface
           for (std::size_t k = 0; k < num_links; k++)
           {
-            std::size_t index = kd.offsets(1) + k * num_points * ndofs_cell * bs
+            std::size_t index = c_offsets[1] + k * num_points * ndofs_cell * bs
                                 + i * num_points * bs + q * bs + n;
 
             // -inner(-avg(sig(u)n) + gamma[[u]], v_opposite)
@@ -275,14 +302,24 @@ dolfinx_contact::generate_meshtie_kernel(
   /// @param[in] coordinate_dofs The physical coordinates of cell. Assumed
   /// to be padded to 3D, (shape (num_nodes, 3)).
   kernel_fn<PetscScalar> meshtie_jac
-      = [kd, gdim, bs, ndofs_cell](
+      = [kd](
             std::vector<std::vector<PetscScalar>>& A, std::span<const double> c,
             const double* w, const double* coordinate_dofs,
             const std::size_t facet_index, const std::size_t num_links,
-            std::span<const std::int32_t> q_indices)
+            std::span<const std::int32_t> q_indices,
+            KernelWorkspace& workspace)
   {
-    // Retrieve some data from kd
+    // Retrieve some data from kd. The dimensions are compile time constants
+    // for the specialised kernels (see generate_meshtie_kernel)
+    const std::size_t gdim = GDIM > 0 ? GDIM : kd.gdim();
+    const std::size_t ndofs_cell = NDOFS > 0 ? NDOFS : kd.ndofs_cell();
+    const std::size_t bs = GDIM > 0 ? GDIM : kd.bs();
     auto tdim = std::size_t(kd.tdim());
+
+    // Coefficient offsets of the facet, where the test functions (and their
+    // gradients) of the linked cells may be stored ragged
+    std::array<std::size_t, KernelData::max_offsets> c_offsets;
+    kd.facet_offsets(num_links, c.size(), c_offsets);
     // NOTE: DOLFINx has 3D input coordinate dofs
     cmdspan2_t coord(coordinate_dofs, kd.num_coordinate_dofs(), 3);
 
@@ -326,10 +363,8 @@ dolfinx_contact::generate_meshtie_kernel(
     std::span<const double> weights = kd.weights(facet_index);
 
     // Temporary data structures used inside quadrature loop
-    std::vector<double> sig_nb(ndofs_cell * gdim * gdim);
-    std::vector<double> sig_n_oppb(num_links * ndofs_cell * gdim * gdim);
-    mdspan3_t sig_n(sig_nb.data(), ndofs_cell, gdim, gdim);
-    mdspan4_t sig_n_opp(sig_n_oppb.data(), num_links, ndofs_cell, gdim, gdim);
+    mdspan3_t sig_n = workspace.sig_n();
+    mdspan4_t sig_n_opp = workspace.sig_n_opp(num_links);
 
     // Loop over quadrature points
     std::array<std::size_t, 2> q_offset
@@ -345,7 +380,7 @@ dolfinx_contact::generate_meshtie_kernel(
       compute_sigma_n_basis(sig_n, K, dphi, std::span(n_phys.data(), gdim), mu,
                             lmbda, q_pos);
       compute_sigma_n_opp(
-          sig_n_opp, c.subspan(kd.offsets(2), kd.offsets(3) - kd.offsets(2)),
+          sig_n_opp, c.subspan(c_offsets[2], c_offsets[3] - c_offsets[2]),
           std::span(n_phys.data(), gdim), mu, lmbda, q, num_points);
 
       const double w0 = 0.5 * weights[q] * detJ;
@@ -364,10 +399,10 @@ dolfinx_contact::generate_meshtie_kernel(
             // corresponds to same block index
             for (std::size_t k = 0; k < num_links; k++)
             {
-              std::size_t index_u = kd.offsets(1)
+              std::size_t index_u = c_offsets[1]
                                     + k * num_points * ndofs_cell * bs
                                     + j * num_points * bs + q * bs + l;
-              std::size_t index_v = kd.offsets(1)
+              std::size_t index_v = c_offsets[1]
                                     + k * num_points * ndofs_cell * bs
                                     + i * num_points * bs + q * bs + l;
 
@@ -394,10 +429,10 @@ dolfinx_contact::generate_meshtie_kernel(
               // entries corresponding to u and v on the other surface
               for (std::size_t k = 0; k < num_links; k++)
               {
-                std::size_t index_u = kd.offsets(1)
+                std::size_t index_u = c_offsets[1]
                                       + k * num_points * ndofs_cell * bs
                                       + j * num_points * bs + q * bs + l;
-                std::size_t index_v = kd.offsets(1)
+                std::size_t index_v = c_offsets[1]
                                       + k * num_points * ndofs_cell * bs
                                       + i * num_points * bs + q * bs + b;
                 // -0.5 inner(sig(u_opp), v) +0.5 theta inner(sig(v), u_opp)
@@ -437,12 +472,317 @@ dolfinx_contact::generate_meshtie_kernel(
   }
 }
 
+/// @brief Generate the batched meshtie Jacobian kernel for a fixed geometric
+/// dimension and number of dofs per cell
+///
+/// The kernel evaluates `kernel_batch_size` facets at once, with one lane
+/// per facet. The test functions of the linked cells of the facets are
+/// interleaved before the quadrature loop, and all data inside the loop is
+/// stored with the facet as the fastest index. Unused lanes are zero.
+/// @note Assumes affine geometry and `bs == tdim == gdim == GDIM`.
+/// See `generate_meshtie_kernel` for a description of the input arguments
+template <std::size_t GDIM, std::size_t NDOFS>
+batched_kernel_fn<PetscScalar>
+batched_meshtie_jac(std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+                    std::shared_ptr<const QuadratureRule> quadrature_rule,
+                    const std::vector<std::size_t>& cstrides,
+                    std::size_t max_links)
+{
+  constexpr std::size_t W = kernel_batch_size;
+  constexpr std::size_t bs = GDIM;
+  // Size of an element vector
+  constexpr std::size_t ndofs = NDOFS * bs;
+
+  auto kd = dolfinx_contact::KernelData(V, quadrature_rule, cstrides);
+  kd.set_link_coefficients(1, 3, max_links);
+  const std::size_t num_points
+      = quadrature_rule->offset()[1] - quadrature_rule->offset()[0];
+
+  /// @brief Assemble kernel for Jacobian (LHS) for gluing two problems with
+  /// Nitsche for a batch of facets
+  ///
+  /// See `meshtie_jac` for the terms, and `batched_kernel_fn` for the input
+  /// arguments
+  return [kd, num_points](std::span<std::vector<std::vector<PetscScalar>>> A,
+                          std::span<const std::span<const PetscScalar>> c,
+                          const PetscScalar* w,
+                          std::span<const double> coordinate_dofs,
+                          std::span<const std::size_t> facet_indices,
+                          std::span<const std::size_t> num_links,
+                          std::span<const PetscScalar> q_factors,
+                          std::vector<PetscScalar>& scratch)
+  {
+    const std::size_t num_facets = facet_indices.size();
+    assert(num_facets <= W);
+    const double theta = w[1];
+    const std::size_t num_coordinate_dofs = kd.num_coordinate_dofs();
+
+    // Size of the test functions (and their gradients) of one linked cell
+    const std::size_t link_size = NDOFS * num_points * bs;
+
+    // Data that is constant on each facet
+    std::array<double, W> mu = {};
+    std::array<double, W> lmbda = {};
+    std::array<double, W> gamma = {};
+    std::array<double, W> detJ = {};
+    std::array<double, GDIM * GDIM * W> K = {};
+    std::array<double, GDIM * W> n_phys = {};
+    std::array<std::array<std::size_t, KernelData::max_offsets>, W> c_offsets;
+    std::size_t batch_links = 0;
+    for (std::size_t l = 0; l < num_facets; ++l)
+    {
+      kd.facet_offsets(num_links[l], c[l].size(), c_offsets[l]);
+      batch_links = std::max(batch_links, num_links[l]);
+      mu[l] = c[l][0];
+      lmbda[l] = c[l][1];
+      gamma[l] = w[0] / c[l][2]; // gamma/h
+
+      // The Jacobian and the normal are constant on affine cells
+      std::array<double, 9> Jb;
+      mdspan2_t J(Jb.data(), GDIM, GDIM);
+      std::array<double, 9> Kb;
+      mdspan2_t K_l(Kb.data(), GDIM, GDIM);
+      std::array<double, 6> J_totb;
+      mdspan2_t J_tot(J_totb.data(), GDIM, GDIM - 1);
+      std::array<double, 18> detJ_scratch;
+      cmdspan2_t coord(coordinate_dofs.data() + l * num_coordinate_dofs * 3,
+                       num_coordinate_dofs, 3);
+      detJ[l] = kd.compute_first_facet_jacobian(facet_indices[l], J, K_l,
+                                                J_tot, detJ_scratch, coord);
+      std::array<double, GDIM> n;
+      dolfinx_contact::physical_facet_normal(
+          std::span<double>(n), K_l,
+          stdex::submdspan(kd.facet_normals(), facet_indices[l],
+                           MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent));
+      for (std::size_t j = 0; j < GDIM; ++j)
+      {
+        n_phys[j * W + l] = n[j];
+        for (std::size_t k = 0; k < GDIM; ++k)
+          K[(k * GDIM + j) * W + l] = K_l(k, j);
+      }
+    }
+
+    // Interleave the test functions and their gradients on the linked
+    // cells, shape (2, batch_links, NDOFS, num_points, bs, W). The blocks of
+    // links missing on a facet are zero and do not contribute.
+    constexpr std::size_t sig_size = NDOFS * GDIM * GDIM * W;
+    const std::size_t c_size = 2 * batch_links * link_size * W;
+    const std::size_t A_size = (3 * batch_links + 1) * ndofs * ndofs * W;
+    scratch.assign(c_size + batch_links * sig_size + A_size, 0);
+    const double* cb = scratch.data();
+    double* sig_n_opp = scratch.data() + c_size;
+    double* Ab = sig_n_opp + batch_links * sig_size;
+    for (std::size_t l = 0; l < num_facets; ++l)
+    {
+      for (std::size_t m = 0; m < 2; ++m)
+      {
+        const std::size_t c0 = c_offsets[l][m + 1];
+        const std::size_t cb0 = m * batch_links * link_size;
+        for (std::size_t i = 0; i < num_links[l] * link_size; ++i)
+          scratch[(cb0 + i) * W + l] = c[l][c0 + i];
+      }
+    }
+
+    // Access to the interleaved data, returning a pointer to the W lanes
+    auto v_opp = [&](std::size_t k, std::size_t i, std::size_t q,
+                     std::size_t n)
+    { return cb + (k * link_size + (i * num_points + q) * bs + n) * W; };
+    auto A_lanes = [&](std::size_t block, std::size_t row, std::size_t col)
+    { return Ab + ((block * ndofs + row) * ndofs + col) * W; };
+
+    // Temporary data structures used inside quadrature loop
+    s_cmdspan2_t phi_ref = kd.phi();
+    s_cmdspan3_t dphi_ref = kd.dphi();
+    std::array<double, W> w0;
+    std::array<double, NDOFS * W> phi;
+    std::array<double, GDIM * NDOFS * W> dphi;
+    std::array<double, NDOFS * GDIM * W> grad_v;
+    std::array<double, sig_size> sig_n;
+
+    for (std::size_t q = 0; q < num_points; ++q)
+    {
+      // Gather the basis functions and weights of the facets
+      w0.fill(0);
+      phi.fill(0);
+      dphi.fill(0);
+      for (std::size_t l = 0; l < num_facets; ++l)
+      {
+        const std::size_t q_pos = kd.qp_offsets(facet_indices[l]) + q;
+        w0[l] = 0.5 * kd.weights(facet_indices[l])[q] * detJ[l]
+                * q_factors[l * num_points + q];
+        for (std::size_t i = 0; i < NDOFS; ++i)
+        {
+          phi[i * W + l] = phi_ref(q_pos, i);
+          for (std::size_t k = 0; k < GDIM; ++k)
+            dphi[(k * NDOFS + i) * W + l] = dphi_ref(k, q_pos, i);
+        }
+      }
+      if (std::all_of(w0.begin(), w0.end(), [](double x) { return x == 0; }))
+        continue;
+
+      compute_sigma_n_basis<W, GDIM, NDOFS>(sig_n, K, dphi, n_phys, mu, lmbda);
+      for (std::size_t k = 0; k < batch_links; ++k)
+      {
+        for (std::size_t i = 0; i < NDOFS; ++i)
+        {
+          std::copy_n(v_opp(batch_links + k, i, q, 0), GDIM * W,
+                      std::next(grad_v.begin(), i * GDIM * W));
+        }
+        compute_sigma_n_opp<W, GDIM, NDOFS>(
+            std::span<double, sig_size>(sig_n_opp + k * sig_size, sig_size),
+            grad_v, n_phys, mu, lmbda);
+      }
+      auto sig = [&](std::size_t i, std::size_t b, std::size_t m)
+      { return sig_n.data() + ((i * GDIM + b) * GDIM + m) * W; };
+      auto sig_opp
+          = [&](std::size_t k, std::size_t i, std::size_t b, std::size_t m)
+      { return sig_n_opp + k * sig_size + ((i * GDIM + b) * GDIM + m) * W; };
+
+      for (std::size_t j = 0; j < NDOFS; j++)
+      {
+        const double* phi_j = phi.data() + j * W;
+        for (std::size_t m = 0; m < bs; m++)
+        {
+          const std::size_t col = m + j * bs;
+          for (std::size_t i = 0; i < NDOFS; i++)
+          {
+            const double* phi_i = phi.data() + i * W;
+
+            // gamma inner(u, v)
+            double* A0 = A_lanes(0, m + i * bs, col);
+            for (std::size_t l = 0; l < W; ++l)
+              A0[l] += gamma[l] * phi_j[l] * phi_i[l] * w0[l];
+
+            // inner products of test and trial functions only non-zero if
+            // dof corresponds to same block index
+            for (std::size_t k = 0; k < batch_links; k++)
+            {
+              const double* u_o = v_opp(k, j, q, m);
+              const double* v_o = v_opp(k, i, q, m);
+              double* A1 = A_lanes(3 * k + 1, m + i * bs, col);
+              double* A2 = A_lanes(3 * k + 2, m + i * bs, col);
+              double* A3 = A_lanes(3 * k + 3, m + i * bs, col);
+              for (std::size_t l = 0; l < W; ++l)
+              {
+                A1[l] -= gamma[l] * u_o[l] * phi_i[l] * w0[l];
+                A2[l] -= gamma[l] * phi_j[l] * v_o[l] * w0[l];
+                A3[l] += gamma[l] * u_o[l] * v_o[l] * w0[l];
+              }
+            }
+
+            for (std::size_t b = 0; b < bs; b++)
+            {
+              // -0.5 inner(sig(u)n, v) - 0.5 theta inner(sig(v), u)
+              const std::size_t row = b + i * bs;
+              const double* s_u = sig(j, m, b);
+              const double* s_v = sig(i, b, m);
+              A0 = A_lanes(0, row, col);
+              for (std::size_t l = 0; l < W; ++l)
+              {
+                A0[l] += (-0.5 * s_u[l] * phi_i[l]
+                          - 0.5 * theta * s_v[l] * phi_j[l])
+                         * w0[l];
+              }
+
+              // entries corresponding to u and v on the other surface
+              for (std::size_t k = 0; k < batch_links; k++)
+              {
+                const double* u_o = v_opp(k, j, q, m);
+                const double* v_o = v_opp(k, i, q, b);
+                const double* so_u = sig_opp(k, j, m, b);
+                const double* so_v = sig_opp(k, i, b, m);
+                double* A1 = A_lanes(3 * k + 1, row, col);
+                double* A2 = A_lanes(3 * k + 2, row, col);
+                double* A3 = A_lanes(3 * k + 3, row, col);
+                for (std::size_t l = 0; l < W; ++l)
+                {
+                  A1[l] += (-0.5 * so_u[l] * phi_i[l]
+                            + 0.5 * theta * s_v[l] * u_o[l])
+                           * w0[l];
+                  A2[l] += (0.5 * s_u[l] * v_o[l]
+                            - 0.5 * theta * so_v[l] * phi_j[l])
+                           * w0[l];
+                  A3[l] += (0.5 * so_u[l] * v_o[l]
+                            + 0.5 * theta * so_v[l] * u_o[l])
+                           * w0[l];
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+
+    // Add the element tensors of each facet
+    for (std::size_t l = 0; l < num_facets; ++l)
+    {
+      for (std::size_t block = 0; block < 3 * num_links[l] + 1; ++block)
+      {
+        std::vector<PetscScalar>& Ae = A[l][block];
+        const double* Ab_block = Ab + block * ndofs * ndofs * W;
+        for (std::size_t e = 0; e < ndofs * ndofs; ++e)
+          Ae[e] += Ab_block[e * W + l];
+      }
+    }
+  };
+}
+} // namespace
+
+//----------------------------------------------------------------------------
+dolfinx_contact::kernel_fn<PetscScalar>
+dolfinx_contact::generate_meshtie_kernel(
+    dolfinx_contact::Kernel type,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    std::shared_ptr<const dolfinx_contact::QuadratureRule> quadrature_rule,
+    const std::vector<std::size_t>& cstrides, std::size_t max_links)
+{
+  return dispatch_dimensions(
+      *V,
+      [&](auto gdim, auto ndofs)
+      {
+        return meshtie_kernel<decltype(gdim)::value, decltype(ndofs)::value>(
+            type, V, quadrature_rule, cstrides, max_links);
+      });
+}
+//----------------------------------------------------------------------------
+dolfinx_contact::batched_kernel_fn<PetscScalar>
+dolfinx_contact::generate_batched_meshtie_kernel(
+    dolfinx_contact::Kernel type,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    std::shared_ptr<const dolfinx_contact::QuadratureRule> quadrature_rule,
+    const std::vector<std::size_t>& cstrides, std::size_t max_links)
+{
+  // Only affine cells with compile time loop bounds are batched
+  std::shared_ptr<const dolfinx::mesh::Mesh<double>> mesh = V->mesh();
+  assert(mesh);
+  if (type != dolfinx_contact::Kernel::MeshTieJac
+      or !mesh->geometry().cmaps()[0].is_affine())
+  {
+    return nullptr;
+  }
+
+  return dispatch_dimensions(
+      *V,
+      [&](auto gdim, auto ndofs) -> batched_kernel_fn<PetscScalar>
+      {
+        constexpr std::size_t GDIM = decltype(gdim)::value;
+        constexpr std::size_t NDOFS = decltype(ndofs)::value;
+        if constexpr (GDIM == 0)
+          return nullptr;
+        else
+        {
+          return batched_meshtie_jac<GDIM, NDOFS>(V, quadrature_rule, cstrides,
+                                                  max_links);
+        }
+      });
+}
+//----------------------------------------------------------------------------
 dolfinx_contact::kernel_fn<PetscScalar>
 dolfinx_contact::generate_poisson_kernel(
     dolfinx_contact::Kernel type,
     std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
     std::shared_ptr<const dolfinx_contact::QuadratureRule> quadrature_rule,
-    const std::vector<std::size_t>& cstrides)
+    const std::vector<std::size_t>& cstrides, std::size_t max_links)
 {
   std::shared_ptr<const dolfinx::mesh::Mesh<double>> mesh = V->mesh();
   assert(mesh);
@@ -458,6 +798,7 @@ dolfinx_contact::generate_poisson_kernel(
   const std::size_t ndofs_cell = V->dofmap()->element_dof_layout().num_dofs();
 
   auto kd = dolfinx_contact::KernelData(V, quadrature_rule, cstrides);
+  kd.set_link_coefficients(1, 3, max_links);
   /// @brief Assemble kernel for RHS gluing two objects with Nitsche
   ///
   /// Assemble of the residual of the unbiased contact problem into vector
@@ -475,11 +816,17 @@ dolfinx_contact::generate_poisson_kernel(
                      std::span<const PetscScalar> c, const PetscScalar* w,
                      const double* coordinate_dofs,
                      const std::size_t facet_index, const std::size_t num_links,
-                     std::span<const std::int32_t> q_indices)
+                     std::span<const std::int32_t> q_indices,
+                     [[maybe_unused]] KernelWorkspace& workspace)
   {
     // Retrieve some data from kd
     auto tdim = std::size_t(kd.tdim());
 
+    // Coefficient offsets of the facet, where the test functions (and their
+    // gradients) of the linked cells may be stored ragged
+    std::array<std::size_t, KernelData::max_offsets> c_offsets;
+    kd.facet_offsets(num_links, c.size(), c_offsets);
+
     // NOTE: DOLFINx has 3D input coordinate dofs
     cmdspan2_t coord(coordinate_dofs, kd.num_coordinate_dofs(), 3);
 
@@ -540,9 +887,9 @@ dolfinx_contact::generate_poisson_kernel(
       kd.update_normal(std::span(n_phys.data(), gdim), K, facet_index);
 
       // compute [[u]] = jump(u) = u - u_opp
-      std::size_t offset_gradu_opp = kd.offsets(6) + q * gdim;
-      std::size_t offset_gradu = kd.offsets(4) + q * gdim;
-      jump_T = c[kd.offsets(3) + q] - c[kd.offsets(5) + q];
+      std::size_t offset_gradu_opp = c_offsets[6] + q * gdim;
+      std::size_t offset_gradu = c_offsets[4] + q * gdim;
+      jump_T = c[c_offsets[3] + q] - c[c_offsets[5] + q];
       avg_grad_T_n = 0;
       for (std::size_t j = 0; j < gdim; ++j)
         avg_grad_T_n += 0.5 * (c[offset_gradu + j] + c[offset_gradu_opp + j])
@@ -567,13 +914,13 @@ dolfinx_contact::generate_poisson_kernel(
         // entries corresponding to v on the other surface
         for (std::size_t k = 0; k < num_links; k++)
         {
-          std::size_t index = kd.offsets(1) + k * num_points * ndofs_cell
+          std::size_t index = c_offsets[1] + k * num_points * ndofs_cell
                               + i * num_points + q;
 
           // inner(avg(grad(T)), n_phys) * v_opp - gamma * [[T]] *v_opp
           b[k + 1][i] += (avg_grad_T_n - gamma * jump_T) * c[index] * w0;
 
-          index = kd.offsets(2) + k * num_points * ndofs_cell * gdim
+          index = c_offsets[2] + k * num_points * ndofs_cell * gdim
                   + i * gdim * num_points + q * gdim;
           // -theta * 0.5 * inner(grad (v_opp), n_phys) * [[T]]
           for (std::size_t g = 0; g < gdim; ++g)
@@ -601,10 +948,16 @@ dolfinx_contact::generate_poisson_kernel(
             std::vector<std::vector<PetscScalar>>& A, std::span<const double> c,
             const double* w, const double* coordinate_dofs,
             const std::size_t facet_index, const std::size_t num_links,
-            std::span<const std::int32_t> q_indices)
+            std::span<const std::int32_t> q_indices,
+            [[maybe_unused]] KernelWorkspace& workspace)
   {
     // Retrieve some data from kd
     auto tdim = std::size_t(kd.tdim());
+
+    // Coefficient offsets of the facet, where the test functions (and their
+    // gradients) of the linked cells may be stored ragged
+    std::array<std::size_t, KernelData::max_offsets> c_offsets;
+    kd.facet_offsets(num_links, c.size(), c_offsets);
     // NOTE: DOLFINx has 3D input coordinate dofs
     cmdspan2_t coord(coordinate_dofs, kd.num_coordinate_dofs(), 3);
 
@@ -685,9 +1038,9 @@ dolfinx_contact::generate_poisson_kernel(
 
           for (std::size_t k = 0; k < num_links; k++)
           {
-            std::size_t index_w = kd.offsets(1) + k * num_points * ndofs_cell
+            std::size_t index_w = c_offsets[1] + k * num_points * ndofs_cell
                                   + j * num_points + q;
-            std::size_t index_v = kd.offsets(1) + k * num_points * ndofs_cell
+            std::size_t index_v = c_offsets[1] + k * num_points * ndofs_cell
                                   + i * num_points + q;
 
             // - gamma * w_opp * v + theta * 0.5 * inner(grad (v), n_phys) *
@@ -702,10 +1055,10 @@ dolfinx_contact::generate_poisson_kernel(
             A[3 * k + 3][i * ndofs_cell + j]
                 += gamma * c[index_w] * c[index_v] * w0;
 
-            std::size_t index_w_grad = kd.offsets(2)
+            std::size_t index_w_grad = c_offsets[2]
                                        + k * num_points * ndofs_cell * gdim
                                        + j * gdim * num_points + q * gdim;
-            std::size_t index_v_grad = kd.offsets(2)
+            std::size_t index_v_grad = c_offsets[2]
                                        + k * num_points * ndofs_cell * gdim
                                        + i * gdim * num_points + q * gdim;
             for (std::size_t g = 0; g < gdim; ++g)
@@ -31,12 +31,33 @@ namespace dolfinx_contact
 /// @note  All other coefficients are packed at quadrature points.
 /// @note The vector valued coefficents `test_fn`, `grad(test_fn)`, `u`,
 /// `u_opposite`, `grad(u_opposite)` have dimension `bs == gdim`.
+/// @note For P1/P2 elements on triangles and tetrahedra and Q1 elements on
+/// hexahedra, a kernel with compile time loop bounds is returned.
 dolfinx_contact::kernel_fn<PetscScalar> generate_meshtie_kernel(
     dolfinx_contact::Kernel type,
     std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
     std::shared_ptr<const dolfinx_contact::QuadratureRule> quadrature_rule,
-    const std::vector<std::size_t>& cstrides);
+    const std::vector<std::size_t>& cstrides, std::size_t max_links);
 
+/// @brief Generate a batched meshtie kernel for elasticity
+///
+/// The kernel evaluates `kernel_batch_size` facets at once, with one SIMD
+/// lane per facet, see `batched_kernel_fn`. This pays off for low order
+/// elements, where the work per facet is too small to vectorise.
+/// @param[in] type The kernel type. Only `MeshTieJac` is batched.
+/// @param[in] V               The function space
+/// @param[in] quadrature_rule The quadrature rule
+/// @param[in] cstrides        The strides of the coefficients, see
+/// `generate_meshtie_kernel`
+/// @param[in] max_links       The maximum number of facets linked to one cell
+/// @returns The kernel, or an empty function if there is no batched kernel
+/// for the kernel type and element. Batched kernels exist for P1 and P2
+/// elements on affine triangles and tetrahedra.
+dolfinx_contact::batched_kernel_fn<PetscScalar> generate_batched_meshtie_kernel(
+    dolfinx_contact::Kernel type,
+    std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+    std::shared_ptr<const dolfinx_contact::QuadratureRule> quadrature_rule,
+    const std::vector<std::size_t>& cstrides, std::size_t max_links);
 
 /// @brief Generate meshtie kernel for poisson
 ///
@@ -57,5 +78,5 @@ dolfinx_contact::kernel_fn<PetscScalar> generate_poisson_kernel(
     dolfinx_contact::Kernel type,
     std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
     std::shared_ptr<const dolfinx_contact::QuadratureRule> quadrature_rule,
-    const std::vector<std::size_t>& cstrides);
+    const std::vector<std::size_t>& cstrides, std::size_t max_links);
 } // namespace dolfinx_contact
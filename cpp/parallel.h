@@ -0,0 +1,78 @@
+// Copyright (C) 2024 The DOLFINx_Contact authors
+//
+// This file is part of DOLFINx_CONTACT
+//
+// SPDX-License-Identifier:    MIT
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace dolfinx_contact
+{
+namespace impl
+{
+/// Set on the threads running the chunks of a concurrent `parallel_for`
+inline thread_local bool in_parallel_region = false;
+} // namespace impl
+
+/// @brief Check if the calling thread runs one of several concurrent chunks
+/// of a `parallel_for`
+///
+/// DOLFINx timers are not thread-safe, so timers are only created outside
+/// of concurrent regions.
+inline bool in_parallel_region() { return impl::in_parallel_region; }
+
+/// @brief Split the range [0, n) into contiguous chunks and process the
+/// chunks concurrently
+///
+/// @param[in] n The size of the range
+/// @param[in] num_threads The number of threads. If `num_threads < 2`, or
+/// the range is too small, `f` is called on the calling thread.
+/// @param[in] f The function to call for each chunk, with signature
+/// `f(thread_index, begin, end)`
+/// @note Exceptions thrown by `f` are re-thrown on the calling thread after
+/// all threads have been joined.
+template <typename F>
+void parallel_for(std::size_t n, int num_threads, F&& f)
+{
+  const std::size_t nt
+      = std::min(n, (std::size_t)std::max(num_threads, 1));
+  if (nt < 2)
+  {
+    f(std::size_t(0), std::size_t(0), n);
+    return;
+  }
+
+  std::vector<std::exception_ptr> errors(nt);
+  std::vector<std::jthread> threads;
+  threads.reserve(nt - 1);
+  auto run = [&f, &errors, n, nt](std::size_t i)
+  {
+    const bool in_region = impl::in_parallel_region;
+    impl::in_parallel_region = true;
+    try
+    {
+      f(i, i * n / nt, (i + 1) * n / nt);
+    }
+    catch (...)
+    {
+      errors[i] = std::current_exception();
+    }
+    impl::in_parallel_region = in_region;
+  };
+  for (std::size_t i = 1; i < nt; ++i)
+    threads.emplace_back(run, i);
+  run(0);
+  threads.clear();
+
+  for (auto& e : errors)
+    if (e)
+      std::rethrow_exception(e);
+}
+
+} // namespace dolfinx_contact
@@ -14,6 +14,8 @@
 #include "parallel_mesh_ghosting.h"
 #include "point_cloud.h"
 
+#include <limits>
+#include <numeric>
 #include <set>
 
 namespace
@@ -323,96 +325,120 @@ dolfinx_contact::compute_ghost_cell_destinations(
     }
   }
 
-  // 2. Send midpoints to process zero
-  int count = facet_midpoint.size();
-  std::vector<int> all_counts;
-  if (rank == 0)
-    all_counts.resize(size);
-  MPI_Gather(&count, 1, MPI_INT, all_counts.data(), 1, MPI_INT, 0, mesh.comm());
-  std::vector<int> offsets = {0};
-  for (auto c : all_counts)
-    offsets.push_back(offsets.back() + c);
-
-  std::vector<double> x_all_flat(offsets.back());
-  MPI_Gatherv(facet_midpoint.data(), facet_midpoint.size(), MPI_DOUBLE,
-              x_all_flat.data(), all_counts.data(), offsets.data(), MPI_DOUBLE,
-              0, mesh.comm());
-
-  // For each facet, get a list of neighbor processes
-  // These are only built on process zero
-  std::vector<int> nbr_procs;
-  std::vector<int> nbr_offsets = {0};
-
-  if (rank == 0)
+  // 2. Compute bounding box of the midpoints on each process. Processes
+  // without marked facets get an empty (inverted) box.
+  constexpr double dmax = std::numeric_limits<double>::max();
+  std::array<double, 6> bbox = {dmax, dmax, dmax, -dmax, -dmax, -dmax};
+  for (int i = 0; i < num_facets; ++i)
   {
-    LOG(WARNING) << "Point cloud search on root process";
-
-    std::for_each(offsets.begin(), offsets.end(), [](int& i) { i /= 3; });
-
-    // Find all pairs of facets within radius R
-    auto x_near = dolfinx_contact::point_cloud_pairs(x_all_flat, R);
-
-    int i = 0;
-    std::vector<int> neighbor_p;
-    std::vector<int> pr;
+    for (int k = 0; k < 3; ++k)
+    {
+      bbox[k] = std::min(bbox[k], facet_midpoint[3 * i + k]);
+      bbox[k + 3] = std::max(bbox[k + 3], facet_midpoint[3 * i + k]);
+    }
+  }
+  std::vector<double> all_bboxes(6 * size);
+  MPI_Allgather(bbox.data(), 6, MPI_DOUBLE, all_bboxes.data(), 6, MPI_DOUBLE,
+                mesh.comm());
+
+  // Check if point (or box) x is within distance R of the box of process p
+  // (measured in the max-norm)
+  auto in_padded_box = [&all_bboxes, R](int p, std::span<const double> lo,
+                                        std::span<const double> hi)
+  {
+    const double* b = all_bboxes.data() + 6 * p;
+    for (int k = 0; k < 3; ++k)
+      if (lo[k] > b[k + 3] + R or hi[k] < b[k] - R)
+        return false;
+    return true;
+  };
 
+  // 3. Find neighbouring processes, i.e. processes with overlapping padded
+  // bounding boxes. This relation is symmetric.
+  std::vector<int> neighbors;
+  if (num_facets > 0)
+  {
     for (int p = 0; p < size; ++p)
     {
-      assert(all_counts[p] % 3 == 0);
-      const int num_facets_p = all_counts[p] / 3;
-
-      // Reserve space for 'offsets' for this process
-      neighbor_p.resize(num_facets_p + 1, 0);
+      if (p != rank
+          and in_padded_box(p, std::span(bbox.data(), 3),
+                            std::span(bbox.data() + 3, 3)))
+      {
+        neighbors.push_back(p);
+      }
+    }
+  }
 
-      for (int j = 0; j < num_facets_p; ++j)
+  // 4. Send the midpoints within distance R of the bounding box of each
+  // neighbour to that neighbour
+  std::vector<int> send_sizes(neighbors.size(), 0);
+  std::vector<double> send_x;
+  for (std::size_t n = 0; n < neighbors.size(); ++n)
+  {
+    for (int i = 0; i < num_facets; ++i)
+    {
+      std::span<const double> xi(facet_midpoint.data() + 3 * i, 3);
+      if (in_padded_box(neighbors[n], xi, xi))
       {
-        pr.clear();
-        for (int n : x_near.links(i))
-        {
-          // Find which process this facet came from
-          int q = std::distance(
-                      offsets.begin(),
-                      std::upper_bound(offsets.begin(), offsets.end(), n))
-                  - 1;
-
-          // Add to the sendback list, if not the same process
-          if (q != p)
-          {
-            if (std::find(pr.begin(), pr.end(), q) == pr.end())
-            {
-              pr.push_back(q);
-              std::sort(pr.begin(), pr.end());
-            }
-          }
-        }
-        neighbor_p.insert(neighbor_p.end(), pr.begin(), pr.end());
-        neighbor_p[j + 1] = neighbor_p.size() - (num_facets_p + 1);
-        ++i;
+        send_x.insert(send_x.end(), xi.begin(), xi.end());
+        send_sizes[n] += 3;
       }
-      nbr_procs.insert(nbr_procs.end(), neighbor_p.begin(), neighbor_p.end());
-      nbr_offsets.push_back(nbr_procs.size());
     }
   }
 
-  // Scatter back sharing data to original process
-  std::vector<int> dsizes(size);
-  for (int i = 0; i < size; ++i)
-    dsizes[i] = nbr_offsets[i + 1] - nbr_offsets[i];
-  int my_recv_size;
-  MPI_Scatter(dsizes.data(), 1, MPI_INT, &my_recv_size, 1, MPI_INT, 0,
-              mesh.comm());
-
-  std::vector<int> my_recv_data(my_recv_size);
-  MPI_Scatterv(nbr_procs.data(), dsizes.data(), nbr_offsets.data(), MPI_INT,
-               my_recv_data.data(), my_recv_size, MPI_INT, 0, mesh.comm());
-
-  // Unpack received data to get additional destinations for each facet /
-  // cell
-  std::vector<int> doffsets(my_recv_data.begin(),
-                            std::next(my_recv_data.begin(), num_facets + 1));
-
-  std::vector<int> cell_dests(std::next(my_recv_data.begin(), num_facets + 1),
-                              my_recv_data.end());
+  MPI_Comm neighbor_comm;
+  MPI_Dist_graph_create_adjacent(
+      mesh.comm(), neighbors.size(), neighbors.data(), MPI_UNWEIGHTED,
+      neighbors.size(), neighbors.data(), MPI_UNWEIGHTED, MPI_INFO_NULL, false,
+      &neighbor_comm);
+
+  // Reserve memory to avoid passing null pointers to MPI
+  std::vector<int> recv_sizes(neighbors.size(), 0);
+  send_sizes.reserve(1);
+  recv_sizes.reserve(1);
+  MPI_Neighbor_alltoall(send_sizes.data(), 1, MPI_INT, recv_sizes.data(), 1,
+                        MPI_INT, neighbor_comm);
+
+  std::vector<int> send_offsets(neighbors.size() + 1, 0);
+  std::partial_sum(send_sizes.begin(), send_sizes.end(),
+                   std::next(send_offsets.begin()));
+  std::vector<int> recv_offsets(neighbors.size() + 1, 0);
+  std::partial_sum(recv_sizes.begin(), recv_sizes.end(),
+                   std::next(recv_offsets.begin()));
+
+  std::vector<double> recv_x(recv_offsets.back());
+  MPI_Neighbor_alltoallv(send_x.data(), send_sizes.data(), send_offsets.data(),
+                         MPI_DOUBLE, recv_x.data(), recv_sizes.data(),
+                         recv_offsets.data(), MPI_DOUBLE, neighbor_comm);
+  MPI_Comm_free(&neighbor_comm);
+
+  // 5. For each local facet, find the neighbouring processes owning a
+  // facet with midpoint within radius R
+  LOG(WARNING) << "Point cloud search on neighbouring midpoints";
+  const dolfinx_contact::PointGrid grid(facet_midpoint, R);
+  std::vector<std::vector<int>> dests(num_facets);
+  std::vector<std::int32_t> near;
+  for (std::size_t n = 0; n < neighbors.size(); ++n)
+  {
+    for (int j = recv_offsets[n]; j < recv_offsets[n + 1]; j += 3)
+    {
+      near.clear();
+      grid.find_neighbours(std::span<const double, 3>(recv_x.data() + j, 3), R,
+                           near);
+      for (std::int32_t i : near)
+        if (dests[i].empty() or dests[i].back() != neighbors[n])
+          dests[i].push_back(neighbors[n]);
+    }
+  }
+
+  // Neighbours are visited in ascending order, so each list is sorted
+  std::vector<int> doffsets = {0};
+  std::vector<int> cell_dests;
+  for (const std::vector<int>& d : dests)
+  {
+    cell_dests.insert(cell_dests.end(), d.begin(), d.end());
+    doffsets.push_back(cell_dests.size());
+  }
 
   return dolfinx::graph::AdjacencyList<std::int32_t>(cell_dests, doffsets);
 }
@@ -12,6 +12,10 @@
 namespace dolfinx_contact
 {
   /// Compute destinations
+  ///
+  /// For each marked facet, compute the other processes owning a marked
+  /// facet with midpoint within distance R. Midpoints are only exchanged
+  /// between processes with overlapping (padded) bounding boxes.
   dolfinx::graph::AdjacencyList<std::int32_t>
     compute_ghost_cell_destinations(const dolfinx::mesh::Mesh<double>& mesh,
                                     std::span<const std::int32_t> marker_subset, double R);
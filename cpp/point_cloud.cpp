@@ -5,14 +5,176 @@
 // SPDX-License-Identifier:    MIT
 
 #include "point_cloud.h"
+#include "parallel.h"
 #include <dolfinx/graph/AdjacencyList.h>
 
 #include <algorithm>
 #include <array>
+#include <cassert>
+#include <cmath>
+#include <numeric>
 #include <vector>
 
+//-----------------------------------------------------------------------------
+dolfinx_contact::PointGrid::PointGrid(std::span<const double> x, double h,
+                                      int num_threads)
+    : _h(h), _x0({0, 0, 0}), _n({1, 1, 1}), _x(x.begin(), x.end())
+{
+  assert(x.size() % 3 == 0);
+  const std::size_t npoints = x.size() / 3;
+  if (npoints == 0)
+  {
+    _offsets = {0};
+    return;
+  }
+
+  // Compute bounding box of the points
+  std::array<double, 3> x1;
+  std::copy_n(x.begin(), 3, _x0.begin());
+  std::copy_n(x.begin(), 3, x1.begin());
+  for (std::size_t i = 1; i < npoints; ++i)
+  {
+    for (std::size_t k = 0; k < 3; ++k)
+    {
+      _x0[k] = std::min(_x0[k], x[3 * i + k]);
+      x1[k] = std::max(x1[k], x[3 * i + k]);
+    }
+  }
+
+  // Compute number of grid cells in each direction. The cell width is
+  // increased if the linear cell index would overflow
+  if (_h > 0)
+  {
+    constexpr double max_cells = 1e18;
+    double total_cells = max_cells;
+    while (total_cells >= max_cells)
+    {
+      total_cells = 1;
+      for (std::size_t k = 0; k < 3; ++k)
+      {
+        _n[k] = std::int64_t((x1[k] - _x0[k]) / _h) + 1;
+        total_cells *= double(_n[k]);
+      }
+      if (total_cells >= max_cells)
+        _h *= 2;
+    }
+  }
+
+  // Compute grid cell of each point
+  std::vector<std::int64_t> point_cells(npoints, 0);
+  if (_h > 0)
+  {
+    dolfinx_contact::parallel_for(
+        npoints, num_threads,
+        [&](std::size_t, std::size_t i0, std::size_t i1)
+        {
+          std::array<std::int64_t, 3> c;
+          for (std::size_t i = i0; i < i1; ++i)
+          {
+            for (std::size_t k = 0; k < 3; ++k)
+            {
+              c[k] = std::min(std::int64_t((x[3 * i + k] - _x0[k]) / _h),
+                              _n[k] - 1);
+            }
+            point_cells[i] = cell_index(c);
+          }
+        });
+  }
+
+  // Sort points by grid cell and compress to the non-empty cells
+  _points.resize(npoints);
+  std::iota(_points.begin(), _points.end(), 0);
+  std::stable_sort(_points.begin(), _points.end(),
+                   [&point_cells](std::int32_t a, std::int32_t b)
+                   { return point_cells[a] < point_cells[b]; });
+  for (std::size_t i = 0; i < npoints; ++i)
+  {
+    const std::int64_t cell = point_cells[_points[i]];
+    if (_cells.empty() || _cells.back() != cell)
+    {
+      _cells.push_back(cell);
+      _offsets.push_back((std::int32_t)i);
+    }
+  }
+  _offsets.push_back((std::int32_t)npoints);
+}
+//-----------------------------------------------------------------------------
+void dolfinx_contact::PointGrid::find_neighbours(
+    std::span<const double, 3> y, double r,
+    std::vector<std::int32_t>& neighbours) const
+{
+  const std::int32_t npoints = _x.size() / 3;
+  if (r < 0)
+  {
+    // Return all points for negative radius / no radius
+    for (std::int32_t i = 0; i < npoints; ++i)
+      neighbours.push_back(i);
+    return;
+  }
+
+  const double r2 = r * r;
+  auto check_point = [&](std::int32_t p)
+  {
+    const double* xp = _x.data() + 3 * p;
+    const double dx = xp[0] - y[0];
+    const double dy = xp[1] - y[1];
+    const double dz = xp[2] - y[2];
+    if (dx * dx + dy * dy + dz * dz < r2)
+      neighbours.push_back(p);
+  };
+
+  // Find range of grid cells intersecting the bounding box of the ball
+  std::array<std::int64_t, 3> c0 = {0, 0, 0};
+  std::array<std::int64_t, 3> c1 = {0, 0, 0};
+  double num_cells = 1;
+  if (_h > 0)
+  {
+    for (std::size_t k = 0; k < 3; ++k)
+    {
+      const double lo = std::floor((y[k] - r - _x0[k]) / _h);
+      const double hi = std::floor((y[k] + r - _x0[k]) / _h);
+      if (hi < 0 || lo > double(_n[k] - 1))
+        return;
+      c0[k] = std::int64_t(std::max(lo, 0.0));
+      c1[k] = std::int64_t(std::min(hi, double(_n[k] - 1)));
+      num_cells *= double(c1[k] - c0[k] + 1);
+    }
+  }
+
+  // If the ball covers more grid cells than there are non-empty cells,
+  // a brute force search is cheaper
+  if (num_cells > double(_cells.size()))
+  {
+    for (std::int32_t i = 0; i < npoints; ++i)
+      check_point(i);
+    return;
+  }
+
+  // Grid cells along the first axis have consecutive linear indices,
+  // so each row of cells is a contiguous range in `_cells`
+  for (std::int64_t k = c0[2]; k <= c1[2]; ++k)
+  {
+    for (std::int64_t j = c0[1]; j <= c1[1]; ++j)
+    {
+      const std::int64_t last = cell_index({c1[0], j, k});
+      auto it = std::lower_bound(_cells.begin(), _cells.end(),
+                                 cell_index({c0[0], j, k}));
+      for (; it != _cells.end() && *it <= last; ++it)
+      {
+        const std::size_t pos = std::distance(_cells.begin(), it);
+        for (std::int32_t p = _offsets[pos]; p < _offsets[pos + 1]; ++p)
+          check_point(_points[p]);
+      }
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+namespace
+{
+/// Find all pairs of points within distance r by sorting along the first
+/// axis and sweeping
 dolfinx::graph::AdjacencyList<std::int32_t>
-dolfinx_contact::point_cloud_pairs(std::span<const double> x, double r)
+point_cloud_pairs_sweep(std::span<const double> x, double r)
 {
   // Find all neighbors of each point which are within a radius r.
 
@@ -48,7 +210,7 @@ dolfinx_contact::point_cloud_pairs(std::span<const double> x, double r)
       ++idx;
     }
     idx = x_rev[i] - 1;
-    while (idx > 0)
+    while (idx >= 0)
     {
       const double* xj = x.data() + x_fwd[idx] * 3;
       const double* xi = x.data() + i * 3;
@@ -62,8 +224,77 @@ dolfinx_contact::point_cloud_pairs(std::span<const double> x, double r)
         x_near.push_back(x_fwd[idx]);
       --idx;
     }
+    std::sort(std::next(x_near.begin(), offsets.back()), x_near.end());
     offsets.push_back(x_near.size());
   }
 
   return dolfinx::graph::AdjacencyList<std::int32_t>(x_near, offsets);
 }
+
+/// Find all pairs of points within distance r by bucketing the points in a
+/// uniform grid of cell width r
+dolfinx::graph::AdjacencyList<std::int32_t>
+point_cloud_pairs_grid(std::span<const double> x, double r, int num_threads)
+{
+  assert(x.size() % 3 == 0);
+  const std::size_t npoints = x.size() / 3;
+  if (r <= 0)
+  {
+    return dolfinx::graph::AdjacencyList<std::int32_t>(
+        std::vector<std::int32_t>(), std::vector<std::int32_t>(npoints + 1, 0));
+  }
+  const dolfinx_contact::PointGrid grid(x, r, num_threads);
+
+  // Each thread searches for the neighbours of a contiguous range of
+  // points, and the results are concatenated afterwards
+  const std::size_t nt = std::max(
+      std::size_t(1), std::min(npoints, (std::size_t)std::max(num_threads, 1)));
+  std::vector<std::vector<std::int32_t>> thread_near(nt);
+  std::vector<std::int32_t> num_near(npoints);
+  dolfinx_contact::parallel_for(
+      npoints, num_threads,
+      [&](std::size_t t, std::size_t i0, std::size_t i1)
+      {
+        std::vector<std::int32_t>& x_near = thread_near[t];
+        for (std::size_t i = i0; i < i1; ++i)
+        {
+          const std::size_t pos = x_near.size();
+          grid.find_neighbours(std::span<const double, 3>(x.data() + 3 * i, 3),
+                               r, x_near);
+
+          // Remove point itself and sort
+          x_near.erase(std::remove(std::next(x_near.begin(), pos),
+                                   x_near.end(), (std::int32_t)i),
+                       x_near.end());
+          std::sort(std::next(x_near.begin(), pos), x_near.end());
+          num_near[i] = x_near.size() - pos;
+        }
+      });
+
+  std::vector<std::int32_t> offsets(npoints + 1, 0);
+  std::partial_sum(num_near.begin(), num_near.end(),
+                   std::next(offsets.begin()));
+  std::vector<std::int32_t> x_near;
+  x_near.reserve(offsets.back());
+  for (const std::vector<std::int32_t>& near : thread_near)
+    x_near.insert(x_near.end(), near.begin(), near.end());
+
+  return dolfinx::graph::AdjacencyList<std::int32_t>(std::move(x_near),
+                                                     std::move(offsets));
+}
+} // namespace
+//-----------------------------------------------------------------------------
+dolfinx::graph::AdjacencyList<std::int32_t>
+dolfinx_contact::point_cloud_pairs(std::span<const double> x, double r,
+                                   PointCloudSearch method, int num_threads)
+{
+  switch (method)
+  {
+  case PointCloudSearch::Sweep:
+    return point_cloud_pairs_sweep(x, r);
+  case PointCloudSearch::Grid:
+    return point_cloud_pairs_grid(x, r, num_threads);
+  default:
+    throw std::invalid_argument("Unknown point cloud search method");
+  }
+}
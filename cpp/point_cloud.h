@@ -4,17 +4,90 @@
 //
 // SPDX-License-Identifier:    MIT
 
+#pragma once
+
+#include <array>
+#include <cstdint>
 #include <dolfinx/graph/AdjacencyList.h>
 #include <span>
 #include <vector>
 
 namespace dolfinx_contact
 {
+/// Algorithm used to find near neighbours in a point cloud
+enum class PointCloudSearch
+{
+  Sweep, // Sort along the first axis and sweep
+  Grid   // Bucket points in a uniform grid
+};
+
+/// @brief Uniform grid (cell list) for fixed radius searches in a point cloud
+///
+/// The points are bucketed into cubic grid cells of width `h`. Only
+/// non-empty grid cells are stored (sorted by their linear index), so the
+/// memory usage is O(num_points) independent of the extent of the cloud.
+class PointGrid
+{
+public:
+  /// @brief Bucket a set of points
+  /// @param[in] x List of points in 3D flattened row major
+  /// @param[in] h The width of the grid cells. If `h <= 0` all points are
+  /// put in a single grid cell.
+  /// @param[in] num_threads Number of threads used to bucket the points
+  PointGrid(std::span<const double> x, double h, int num_threads = 1);
+
+  /// @brief Find all points strictly within distance r of a point y
+  /// @param[in] y The point (3D)
+  /// @param[in] r Search distance. If negative, all points are returned
+  /// @param[in,out] neighbours The indices of the points within radius `r`
+  /// of `y` are appended to this list (in no particular order)
+  void find_neighbours(std::span<const double, 3> y, double r,
+                       std::vector<std::int32_t>& neighbours) const;
+
+  /// Return the number of points in the grid
+  std::size_t num_points() const { return _x.size() / 3; }
+
+private:
+  // Linear index of the grid cell with integer coordinates c
+  std::int64_t cell_index(const std::array<std::int64_t, 3>& c) const
+  {
+    return c[0] + _n[0] * (c[1] + _n[1] * c[2]);
+  }
+
+  // Width of grid cells
+  double _h;
+
+  // Lower corner of the bounding box of the points
+  std::array<double, 3> _x0;
+
+  // Number of grid cells in each direction
+  std::array<std::int64_t, 3> _n;
+
+  // Sorted linear indices of the non-empty grid cells
+  std::vector<std::int64_t> _cells;
+
+  // The points in the ith non-empty cell are
+  // _points[_offsets[i]:_offsets[i+1]]
+  std::vector<std::int32_t> _offsets;
+  std::vector<std::int32_t> _points;
+
+  // Copy of the point coordinates, flattened row major
+  std::vector<double> _x;
+};
+
 /// @brief Compute near neighbours in list of points
 /// @param x List of points in 3D flattened row major
 /// @param r Search distance
+/// @param method The search algorithm. `Sweep` sorts the points along the
+/// first axis, which degenerates to O(N^2) if the points are clustered in
+/// that direction. `Grid` buckets the points in a uniform grid with cell width
+/// `r` and is O(N) for points with bounded density.
+/// @param num_threads Number of threads used by the `Grid` search
 ///
-/// @return For each point, the list of other points within radius r.
+/// @return For each point, the list of other points within radius r (sorted
+/// by index).
 dolfinx::graph::AdjacencyList<std::int32_t>
-point_cloud_pairs(std::span<const double> x, double r);
+point_cloud_pairs(std::span<const double> x, double r,
+                  PointCloudSearch method = PointCloudSearch::Grid,
+                  int num_threads = 1);
 } // namespace dolfinx_contact
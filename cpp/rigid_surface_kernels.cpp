@@ -71,7 +71,8 @@ dolfinx_contact::generate_rigid_surface_kernel(
             std::span<const PetscScalar> c, const PetscScalar* w,
             const double* coordinate_dofs, const std::size_t facet_index,
             [[maybe_unused]] const std::size_t num_links,
-            [[maybe_unused]] std::span<const std::int32_t> q_indices)
+            [[maybe_unused]] std::span<const std::int32_t> q_indices,
+            dolfinx_contact::KernelWorkspace& workspace)
   {
     // Retrieve some data from kd
     const std::size_t bs = kd.bs();
@@ -128,11 +129,9 @@ dolfinx_contact::generate_rigid_surface_kernel(
     std::span<const double> weights = kd.weights(facet_index);
 
     // Temporary work arrays
-    std::vector<double> epsnb(ndofs_cell * gdim);
-    dolfinx_contact::mdspan2_t epsn(epsnb.data(), ndofs_cell, gdim);
-    std::vector<double> trb(ndofs_cell * gdim);
-    dolfinx_contact::mdspan2_t tr(trb.data(), ndofs_cell, gdim);
-    std::vector<double> sig_n_u(gdim);
+    dolfinx_contact::mdspan2_t epsn = workspace.epsn();
+    dolfinx_contact::mdspan2_t tr = workspace.tr();
+    std::span<double> sig_n_u = workspace.sig_n_u();
 
     // Extract reference to the tabulated basis function
     dolfinx_contact::cmdspan2_t phi = kd.phi();
@@ -229,7 +228,8 @@ dolfinx_contact::generate_rigid_surface_kernel(
             const PetscScalar* w, const double* coordinate_dofs,
             const std::size_t facet_index,
             [[maybe_unused]] const std::size_t num_links,
-            [[maybe_unused]] std::span<const std::int32_t> q_indices)
+            [[maybe_unused]] std::span<const std::int32_t> q_indices,
+            dolfinx_contact::KernelWorkspace& workspace)
   {
     // Retrieve some data from kd
     const std::size_t bs = kd.bs();
@@ -288,11 +288,9 @@ dolfinx_contact::generate_rigid_surface_kernel(
     std::span<const double> weights = kd.weights(facet_index);
 
     // Temporary work arrays
-    std::vector<double> epsnb(ndofs_cell * gdim);
-    dolfinx_contact::mdspan2_t epsn(epsnb.data(), ndofs_cell, gdim);
-    std::vector<double> trb(ndofs_cell * gdim);
-    dolfinx_contact::mdspan2_t tr(trb.data(), ndofs_cell, gdim);
-    std::vector<double> sig_n_u(gdim);
+    dolfinx_contact::mdspan2_t epsn = workspace.epsn();
+    dolfinx_contact::mdspan2_t tr = workspace.tr();
+    std::span<double> sig_n_u = workspace.sig_n_u();
 
     // Extract reference to the tabulated basis function
     dolfinx_contact::cmdspan2_t phi = kd.phi();
@@ -69,6 +69,104 @@ dolfinx_contact::read_mesh(const std::string& filename,
   return std::make_tuple(mesh, domain1, facet1);
 }
 //-----------------------------------------------------------------------------
+namespace
+{
+/// Pull back a set of points x on a non-affine cell with Newton's method.
+/// All points that have not yet converged are updated together, so that the
+/// coordinate element is tabulated only once per iteration.
+/// @param[in,out] X The pull back of x. Shape (num_points, tdim)
+/// @param[in] x The physical points. Shape (num_points, gdim)
+/// @param[in] coordinate_dofs The geometry coordinates of the cell
+/// @param[in] cmap The coordinate element
+/// @param[in] tol The tolerance for convergence of the Newton update
+/// @param[in] max_iter The maximum number of Newton iterations
+void pull_back_nonaffine(dolfinx_contact::mdspan2_t X,
+                         dolfinx_contact::cmdspan2_t x,
+                         dolfinx_contact::cmdspan2_t coordinate_dofs,
+                         const dolfinx::fem::CoordinateElement<double>& cmap,
+                         const double tol = 1e-8, const int max_iter = 15)
+{
+  namespace stdex = std::experimental;
+  const std::size_t num_points = x.extent(0);
+  const std::size_t tdim = X.extent(1);
+  const std::size_t gdim = x.extent(1);
+  const std::size_t num_dofs_g = coordinate_dofs.extent(0);
+
+  // Use origin of reference element as initial guess
+  for (std::size_t i = 0; i < X.extent(0); ++i)
+    for (std::size_t j = 0; j < X.extent(1); ++j)
+      X(i, j) = 0;
+
+  // Points that have not converged yet
+  std::vector<std::int32_t> active(num_points);
+  std::iota(active.begin(), active.end(), 0);
+
+  std::vector<double> Xk(num_points * tdim);
+  std::vector<double> basis_buffer;
+  std::array<double, 9> Jb;
+  std::array<double, 9> Kb;
+  dolfinx_contact::mdspan2_t J(Jb.data(), gdim, tdim);
+  dolfinx_contact::mdspan2_t K(Kb.data(), tdim, gdim);
+  std::array<double, 3> xk;
+  std::array<double, 3> dX;
+  for (int k = 0; k < max_iter && !active.empty(); ++k)
+  {
+    // Tabulate coordinate element at current iterate of all active points
+    const std::size_t num_active = active.size();
+    for (std::size_t i = 0; i < num_active; ++i)
+      for (std::size_t j = 0; j < tdim; ++j)
+        Xk[i * tdim + j] = X(active[i], j);
+    const std::array<std::size_t, 4> c_shape
+        = cmap.tabulate_shape(1, num_active);
+    basis_buffer.resize(
+        std::reduce(c_shape.cbegin(), c_shape.cend(), 1, std::multiplies{}));
+    cmap.tabulate(1, std::span(Xk.data(), num_active * tdim),
+                  {num_active, tdim}, basis_buffer);
+    dolfinx_contact::cmdspan4_t c_basis(basis_buffer.data(), c_shape);
+
+    std::size_t num_unconverged = 0;
+    for (std::size_t i = 0; i < num_active; ++i)
+    {
+      const std::int32_t p = active[i];
+
+      // Push forward current iterate
+      std::fill(xk.begin(), xk.end(), 0);
+      for (std::size_t l = 0; l < num_dofs_g; ++l)
+        for (std::size_t j = 0; j < gdim; ++j)
+          xk[j] += c_basis(0, i, l, 0) * coordinate_dofs(l, j);
+
+      // Compute Jacobian and its (pseudo-)inverse at current iterate
+      std::fill(Jb.begin(), Jb.end(), 0);
+      auto dphi
+          = stdex::submdspan(c_basis, std::pair{1, tdim + 1}, i,
+                             MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent, 0);
+      dolfinx::fem::CoordinateElement<double>::compute_jacobian(
+          dphi, coordinate_dofs, J);
+      dolfinx::fem::CoordinateElement<double>::compute_jacobian_inverse(J, K);
+
+      // Newton update
+      double norm_dX = 0;
+      for (std::size_t j = 0; j < tdim; ++j)
+      {
+        dX[j] = 0;
+        for (std::size_t l = 0; l < gdim; ++l)
+          dX[j] += K(j, l) * (x(p, l) - xk[l]);
+        X(p, j) += dX[j];
+        norm_dX += dX[j] * dX[j];
+      }
+      if (norm_dX >= tol * tol)
+        active[num_unconverged++] = p;
+    }
+    active.resize(num_unconverged);
+  }
+  if (!active.empty())
+  {
+    throw std::runtime_error(
+        "Newton method failed to converge for non-affine geometry");
+  }
+}
+} // namespace
+//-----------------------------------------------------------------------------
 void dolfinx_contact::pull_back(
     dolfinx_contact::mdspan3_t J, dolfinx_contact::mdspan3_t K,
     std::span<double> detJ, std::span<double> X, dolfinx_contact::cmdspan2_t x,
@@ -153,7 +251,7 @@ void dolfinx_contact::pull_back(
           J(i, j, k) = 0;
 
     dolfinx_contact::mdspan2_t Xs(X.data(), num_points, tdim);
-    cmap.pull_back_nonaffine(Xs, x, coordinate_dofs);
+    pull_back_nonaffine(Xs, x, coordinate_dofs, cmap);
 
     /// Tabulate coordinate basis at pull back points to compute the Jacobian,
     /// inverse and determinant
@@ -268,6 +366,16 @@ void dolfinx_contact::update_geometry(
                  std::plus<double>());
 }
 //-------------------------------------------------------------------------------------
+std::vector<std::int32_t>
+dolfinx_contact::strided_positions(std::size_t num_entities,
+                                   std::size_t cstride, std::size_t offset)
+{
+  std::vector<std::int32_t> positions(num_entities);
+  for (std::size_t i = 0; i < num_entities; ++i)
+    positions[i] = (std::int32_t)(i * cstride + offset);
+  return positions;
+}
+//-------------------------------------------------------------------------------------
 double dolfinx_contact::R_plus(double x) { return 0.5 * (std::abs(x) + x); }
 //-------------------------------------------------------------------------------------
 double dolfinx_contact::R_minus(double x) { return 0.5 * (x - std::abs(x)); }
@@ -802,6 +910,54 @@ dolfinx_contact::entities_to_geometry_dofs(
   return dolfinx::graph::AdjacencyList<std::int32_t>(geometry_indices, offsets);
 }
 //--------------------------------------------------------------------------------------
+dolfinx::graph::AdjacencyList<std::int32_t>
+dolfinx_contact::compute_facet_patches(const dolfinx::mesh::Mesh<double>& mesh,
+                                       std::span<const std::int32_t> facets)
+{
+  const int tdim = mesh.topology()->dim();
+  const dolfinx::graph::AdjacencyList<std::int32_t> facets_geometry
+      = dolfinx_contact::entities_to_geometry_dofs(mesh, tdim - 1, facets);
+
+  // Invert the facet to geometry node map, restricted to the input facets
+  const std::size_t num_nodes = mesh.geometry().x().size() / 3;
+  std::vector<std::int32_t> node_offsets(num_nodes + 1, 0);
+  for (std::int32_t node : facets_geometry.array())
+    node_offsets[node + 1]++;
+  std::partial_sum(node_offsets.begin(), node_offsets.end(),
+                   node_offsets.begin());
+  std::vector<std::int32_t> node_facets(node_offsets.back());
+  {
+    std::vector<std::int32_t> pos(node_offsets.begin(),
+                                  std::prev(node_offsets.end()));
+    for (std::size_t i = 0; i < facets.size(); ++i)
+      for (std::int32_t node : facets_geometry.links(i))
+        node_facets[pos[node]++] = (std::int32_t)i;
+  }
+
+  // Collect all facets sharing at least one node with each facet
+  std::vector<std::int32_t> patches;
+  std::vector<std::int32_t> offsets(1, 0);
+  offsets.reserve(facets.size() + 1);
+  std::vector<std::int32_t> patch;
+  for (std::size_t i = 0; i < facets.size(); ++i)
+  {
+    patch.clear();
+    for (std::int32_t node : facets_geometry.links(i))
+    {
+      patch.insert(patch.end(),
+                   std::next(node_facets.begin(), node_offsets[node]),
+                   std::next(node_facets.begin(), node_offsets[node + 1]));
+    }
+    std::sort(patch.begin(), patch.end());
+    patch.erase(std::unique(patch.begin(), patch.end()), patch.end());
+    patches.insert(patches.end(), patch.begin(), patch.end());
+    offsets.push_back((std::int32_t)patches.size());
+  }
+
+  return dolfinx::graph::AdjacencyList<std::int32_t>(std::move(patches),
+                                                     std::move(offsets));
+}
+//--------------------------------------------------------------------------------------
 std::vector<int32_t> dolfinx_contact::facet_indices_from_pair(
     std::span<const std::int32_t> facet_pairs,
     const dolfinx::mesh::Mesh<double>& mesh)
@@ -830,46 +986,36 @@ std::vector<int32_t> dolfinx_contact::facet_indices_from_pair(
 }
 //-------------------------------------------------------------------------------------
 std::vector<std::size_t> dolfinx_contact::find_candidate_facets(
-    const dolfinx::mesh::Mesh<double>& quadrature_mesh,
-    const dolfinx::mesh::Mesh<double>& candidate_mesh,
-    const std::int32_t quadrature_facet,
-    std::span<const std::int32_t> candidate_facets, const double radius = -1.)
+    std::span<const double, 3> quadrature_midpoint,
+    std::span<const double> candidate_midpoints,
+    const dolfinx_contact::PointGrid& candidate_grid, const double radius)
 {
-  std::array<std::int32_t, 1> q_facet = {quadrature_facet};
-  // Find midpoints of quadrature and candidate facets
-  std::vector<double> quadrature_midpoints = dolfinx::mesh::compute_midpoints(
-      quadrature_mesh, quadrature_mesh.topology()->dim() - 1,
-      std::span<int32_t>(q_facet.data(), q_facet.size()));
-  std::vector<double> candidate_midpoints = dolfinx::mesh::compute_midpoints(
-      candidate_mesh, candidate_mesh.topology()->dim() - 1, candidate_facets);
+  assert(candidate_grid.num_points() == candidate_midpoints.size() / 3);
 
-  double r2 = radius * radius; // radius squared
-  double dist; // used for squared distance between two midpoints
-  double diff; // used for squared difference between two coordinates
-  std::vector<std::size_t> cand_patch;
-  std::vector<double> dists;
-  for (std::size_t i = 0; i < candidate_facets.size(); ++i)
-  {
+  // Find candidate facets whose midpoint is within the radius
+  std::vector<std::int32_t> cand_patch;
+  candidate_grid.find_neighbours(quadrature_midpoint, radius, cand_patch);
 
-    // compute distance betweeen midpoints of ith candidate facet
-    // and jth quadrature facet
-    dist = 0;
+  // compute squared distance between midpoints for sorting
+  std::vector<double> dists(cand_patch.size());
+  for (std::size_t i = 0; i < cand_patch.size(); ++i)
+  {
+    double dist = 0;
     for (std::size_t k = 0; k < 3; ++k)
     {
-      diff = std::abs(quadrature_midpoints[k] - candidate_midpoints[i * 3 + k]);
+      double diff
+          = quadrature_midpoint[k] - candidate_midpoints[cand_patch[i] * 3 + k];
       dist += diff * diff;
     }
-    if (radius < 0 || dist < r2)
-    {
-      cand_patch.push_back(i); // save index of facet within facet array
-      dists.push_back(dist);   // save distance for sorting
-    }
+    dists[i] = dist;
   }
+
   // sort indices according to distance of facet
   std::vector<int> perm(cand_patch.size());
   std::iota(perm.begin(), perm.end(), 0); // Initializing
-  std::sort(perm.begin(), perm.end(),
-            [&](int i, int j) { return dists[i] < dists[j]; });
+  std::sort(perm.begin(), perm.end(), [&](int i, int j)
+            { return std::tie(dists[i], cand_patch[i])
+                     < std::tie(dists[j], cand_patch[j]); });
   std::vector<size_t> sorted_patch(cand_patch.size());
   for (std::size_t i = 0; i < cand_patch.size(); ++i)
     sorted_patch[i] = cand_patch[perm[i]];
@@ -930,7 +1076,9 @@ void dolfinx_contact::compute_physical_points(
     std::span<const std::int32_t> facets, std::span<const std::size_t> offsets,
     dolfinx_contact::cmdspan4_t phi, std::span<double> qp_phys)
 {
-  dolfinx::common::Timer timer("~Contact: Compute Physical points");
+  std::optional<dolfinx::common::Timer> timer;
+  if (!in_parallel_region())
+    timer.emplace("~Contact: Compute Physical points");
 
   // Geometrical info
   const dolfinx::mesh::Geometry<double>& geometry = mesh.geometry();
@@ -988,9 +1136,10 @@ dolfinx_contact::compute_distance_map(
     const dolfinx::mesh::Mesh<double>& candidate_mesh,
     std::span<const std::int32_t> candidate_facets,
     const dolfinx_contact::QuadratureRule& q_rule,
-    dolfinx_contact::ContactMode mode, const double radius)
+    dolfinx_contact::ContactMode mode, const double radius,
+    const int num_threads, std::span<const std::int32_t> seeds,
+    const dolfinx_contact::FacetTree* tree)
 {
-  dolfinx::common::Timer t("~Contact: compute distance map");
   const dolfinx::mesh::Geometry<double>& geometry = quadrature_mesh.geometry();
   const dolfinx::fem::CoordinateElement<double>& cmap = geometry.cmaps()[0];
 
@@ -1062,7 +1211,8 @@ dolfinx_contact::compute_distance_map(
       {
         auto [closest_entities, reference_points, shape]
             = dolfinx_contact::compute_projection_map<2, 2>(
-                candidate_mesh, candidate_facets, padded_qpsb);
+                candidate_mesh, candidate_facets, padded_qpsb, seeds,
+                tree);
         return {dolfinx::graph::AdjacencyList<std::int32_t>(closest_entities,
                                                             offsets),
                 reference_points, shape};
@@ -1071,7 +1221,8 @@ dolfinx_contact::compute_distance_map(
       {
         auto [closest_entities, reference_points, shape]
             = dolfinx_contact::compute_projection_map<2, 3>(
-                candidate_mesh, candidate_facets, padded_qpsb);
+                candidate_mesh, candidate_facets, padded_qpsb, seeds,
+                tree);
         return {dolfinx::graph::AdjacencyList<std::int32_t>(closest_entities,
                                                             offsets),
                 reference_points, shape};
@@ -1081,7 +1232,7 @@ dolfinx_contact::compute_distance_map(
     {
       auto [closest_entities, reference_points, shape]
           = dolfinx_contact::compute_projection_map<3, 3>(
-              candidate_mesh, candidate_facets, padded_qpsb);
+              candidate_mesh, candidate_facets, padded_qpsb, seeds, tree);
       return {dolfinx::graph::AdjacencyList<std::int32_t>(closest_entities,
                                                           offsets),
               reference_points, shape};
@@ -1098,13 +1249,13 @@ dolfinx_contact::compute_distance_map(
       {
         return dolfinx_contact::compute_raytracing_map<2, 2>(
             quadrature_mesh, quadrature_facets, q_rule, candidate_mesh,
-            candidate_facets, radius);
+            candidate_facets, radius, num_threads, seeds);
       }
       else if (gdim == 3)
       {
         return dolfinx_contact::compute_raytracing_map<2, 3>(
             quadrature_mesh, quadrature_facets, q_rule, candidate_mesh,
-            candidate_facets, radius);
+            candidate_facets, radius, num_threads, seeds);
       }
       else
         throw std::runtime_error("Invalid gdim: " + std::to_string(gdim));
@@ -1113,7 +1264,7 @@ dolfinx_contact::compute_distance_map(
     {
       return dolfinx_contact::compute_raytracing_map<3, 3>(
           quadrature_mesh, quadrature_facets, q_rule, candidate_mesh,
-          candidate_facets, radius);
+          candidate_facets, radius, num_threads, seeds);
     }
     else
       throw std::runtime_error("Invalid tdim: " + std::to_string(tdim));
@@ -9,7 +9,10 @@
 #include "QuadratureRule.h"
 #include "RayTracing.h"
 #include "error_handling.h"
+#include "facet_tree.h"
 #include "geometric_quantities.h"
+#include "parallel.h"
+#include "point_cloud.h"
 #include <basix/cell.h>
 #include <basix/finite-element.h>
 #include <basix/quadrature.h>
@@ -28,6 +31,11 @@
 #include <dolfinx/la/utils.h>
 #include <dolfinx/mesh/Mesh.h>
 #include <dolfinx/mesh/MeshTags.h>
+#include <exception>
+#include <limits>
+#include <optional>
+#include <thread>
+#include <tuple>
 
 using T = PetscScalar;
 using U = typename dolfinx::scalar_value_type_t<T>;
@@ -51,7 +59,10 @@ enum class Kernel
   TrescaRhs,
   TrescaJac,
   CoulombRhs,
-  CoulombJac
+  CoulombJac,
+  System,
+  TrescaSystem,
+  CoulombSystem
 };
 
 enum class Problem
@@ -79,13 +90,58 @@ read_mesh(const std::string& filename,
           const std::string& volume_markers = "volume markers",
           const std::string& facet_markers = "facet markers");
 
+class KernelWorkspace;
+
 // NOTE: this function should change signature to T * ,..... , num_links,
 // num_dofs_per_link
 template <typename T>
 using kernel_fn
     = std::function<void(std::vector<std::vector<T>>&, std::span<const T>,
                          const T*, const double*, const std::size_t,
-                         const std::size_t, std::span<const std::int32_t>)>;
+                         const std::size_t, std::span<const std::int32_t>,
+                         KernelWorkspace&)>;
+
+/// @brief Kernel computing the element vectors and the element matrices of
+/// a facet in one pass
+///
+/// The arguments are the element vectors and the element matrices (added to,
+/// as for `kernel_fn`), followed by the arguments of `kernel_fn`
+template <typename T>
+using system_kernel_fn = std::function<void(
+    std::vector<std::vector<T>>&, std::vector<std::vector<T>>&,
+    std::span<const T>, const T*, const double*, const std::size_t,
+    const std::size_t, std::span<const std::int32_t>, KernelWorkspace&)>;
+
+/// @brief Kernel applying the element matrices of a facet to a vector
+///
+/// The arguments are the element vectors (added to, with the blocks of the
+/// element vectors of `kernel_fn`), the entries of the vector on the cell of
+/// the facet followed by the entries on each linked cell, and the arguments
+/// of `kernel_fn` after the element tensors
+template <typename T>
+using action_kernel_fn = std::function<void(
+    std::vector<std::vector<T>>&, std::span<const T>, std::span<const T>,
+    const T*, const double*, const std::size_t, const std::size_t,
+    std::span<const std::int32_t>, KernelWorkspace&)>;
+
+/// Number of facets evaluated at once by a batched kernel, one SIMD lane
+/// (of 256 bits) per facet
+constexpr std::size_t kernel_batch_size = 4;
+
+/// @brief Kernel evaluating up to `kernel_batch_size` facets at once
+///
+/// The arguments are the element tensors of each facet (added to, as for
+/// `kernel_fn`), the coefficients of each facet, the constants, the
+/// coordinate dofs of the cells, shape (num_facets, num_dofs_g, 3), the
+/// local index of each facet, the number of cells linked to each facet (see
+/// `KernelData::facet_offsets`), a factor for each quadrature point of each
+/// facet, shape (num_facets, num_q_points), which is zero for the
+/// quadrature points to skip, and scratch memory
+template <typename T>
+using batched_kernel_fn = std::function<void(
+    std::span<std::vector<std::vector<T>>>, std::span<const std::span<const T>>,
+    const T*, std::span<const double>, std::span<const std::size_t>,
+    std::span<const std::size_t>, std::span<const T>, std::vector<T>&)>;
 
 /// This function computes the pull back for a set of points x on a cell
 /// described by coordinate_dofs as well as the corresponding Jacobian, their
@@ -127,6 +183,18 @@ sort_cells(const std::span<const std::int32_t>& cells,
 void update_geometry(const dolfinx::fem::Function<PetscScalar>& u,
                      std::shared_ptr<dolfinx::mesh::Mesh<double>> mesh);
 
+/// Compute the positions of the data of each entity in a coefficient array
+/// with a fixed number of coefficients per entity
+/// @param[in] num_entities The number of entities
+/// @param[in] cstride The number of coefficients per entity
+/// @param[in] offset The position of the data within the coefficients of an
+/// entity
+/// @returns positions The data of the ith entity starts at `positions[i] =
+/// i * cstride + offset`
+std::vector<std::int32_t> strided_positions(std::size_t num_entities,
+                                            std::size_t cstride,
+                                            std::size_t offset = 0);
+
 /// Compute the positive restriction of a double, i.e. f(x)= x if x>0 else 0
 double R_plus(double x);
 
@@ -265,23 +333,39 @@ dolfinx::graph::AdjacencyList<std::int32_t>
 entities_to_geometry_dofs(const mesh::Mesh<double>& mesh, int dim,
                           const std::span<const std::int32_t>& entity_list);
 
-/// @brief find candidate facets within a given radius of quadrature facet
+/// @brief Compute the neighbourhood of each facet in a set of facets
 ///
-/// Given one quadrature facet and a list of candidate facets return
-/// the indices of only those candidate facet within the given radius
-/// sorted according to the distance measured at the midpoints
+/// Two facets are neighbours if they share a geometry node. Only facets in
+/// the input set are considered.
 ///
 /// @param[in] mesh The mesh
-/// @param[in] quadrature facet Single quadrature facet
-/// @param[in] candidate_facets Candidate facets
-/// @param[in] radius The search radius
+/// @param[in] facets List of facets (indices local to process)
+/// @returns An adjacency list where the i-th link contains the positions in
+/// `facets` of all facets neighbouring the i-th input facet (including the
+/// facet itself), sorted
+dolfinx::graph::AdjacencyList<std::int32_t>
+compute_facet_patches(const dolfinx::mesh::Mesh<double>& mesh,
+                      std::span<const std::int32_t> facets);
+
+/// @brief find candidate facets within a given radius of quadrature facet
+///
+/// Given the midpoint of one quadrature facet and the midpoints of the
+/// candidate facets return the indices of only those candidate facet within
+/// the given radius sorted according to the distance measured at the
+/// midpoints
+///
+/// @param[in] quadrature_midpoint Midpoint of the quadrature facet (padded to
+/// 3D)
+/// @param[in] candidate_midpoints Midpoints of the candidate facets. Shape
+/// (num_candidate_facets, 3). Flattened row-major
+/// @param[in] candidate_grid Spatial index of `candidate_midpoints`
+/// @param[in] radius The search radius. If negative, all candidate facets are
+/// returned
 /// @return sorted indices of candidate facets within radius of quadrature facet
 std::vector<std::size_t>
-find_candidate_facets(const dolfinx::mesh::Mesh<double>& quadrature_mesh,
-                      const dolfinx::mesh::Mesh<double>& candidate_mesh,
-                      const std::int32_t quadrature_facet,
-                      std::span<const std::int32_t> candidate_facets,
-                      const double radius);
+find_candidate_facets(std::span<const double, 3> quadrature_midpoint,
+                      std::span<const double> candidate_midpoints,
+                      const PointGrid& candidate_grid, const double radius);
 /// @brief find candidate facets within a given radius of quadratuere facets
 ///
 /// Given a list of quadrature facets and a list of candidate facets return
@@ -327,6 +411,16 @@ void compute_physical_points(const dolfinx::mesh::Mesh<double>& mesh,
 /// @param[in] q_rule The quadrature rule for the input facets
 /// @param[in] mode The contact mode, either closest point or ray-tracing
 /// @param[in] radius The search radius. Only used for ray-tracing at the moment
+/// @param[in] num_threads The number of threads. Only used for ray-tracing
+/// at the moment
+/// @param[in] seeds Optional initial guess (facet index local to process, or
+/// -1) of the closest facet for each quadrature point, typically the facet
+/// map of the previous search. Shape (num_facets, num_q_points). The search
+/// is then restricted to the neighbourhood of the seeds, falling back to the
+/// global search for points where the local search fails.
+/// @param[in] tree Optional persistent search tree over the candidate facets,
+/// used for the global closest point search. If not supplied, a tree is
+/// built on every call. Not used for ray-tracing.
 /// @returns A tuple (closest_facets, reference_points) where `closest_facets`
 /// is an adjacency list for each input facet in quadrature facets, where the
 /// links indicate which facet on the other mesh is closest for each quadrature
@@ -340,7 +434,10 @@ compute_distance_map(const dolfinx::mesh::Mesh<double>& quadrature_mesh,
                      const dolfinx::mesh::Mesh<double>& candidate_mesh,
                      std::span<const std::int32_t> candidate_facets,
                      const QuadratureRule& q_rule,
-                     dolfinx_contact::ContactMode mode, const double radius);
+                     dolfinx_contact::ContactMode mode, const double radius,
+                     const int num_threads = 1,
+                     std::span<const std::int32_t> seeds = {},
+                     const FacetTree* tree = nullptr);
 
 /// Compute facet indices from given pairs (cell, local__facet)
 /// @param[in] facet_pairs The facets given as pair (cell, local_facet).
@@ -360,6 +457,13 @@ facet_indices_from_pair(std::span<const std::int32_t> facet_pairs,
 /// `quadrature_mesh`. Flattened row major.
 /// @param[in] points The points to compute the closest entity from.
 /// Shape (num_quadrature_points, 3). Flattened row-major
+/// @param[in] seeds Optional initial guess (facet index local to process, or
+/// -1) of the closest facet for each point, e.g. the result of a previous
+/// search. For a seeded point, only the facets within two layers of the seed
+/// are searched. The local result is accepted if it lies within the first
+/// layer, otherwise the point falls back to the global search.
+/// @param[in] tree Optional search tree over the facets in `facet_tuples`
+/// for the global search. If not supplied, a tree is built on every call
 /// @returns A tuple (closest_facets, reference_points), where
 /// `closest_entities[i]` is the closest entity in `facet_tuples` for the ith
 /// input point
@@ -368,7 +472,9 @@ std::tuple<std::vector<std::int32_t>, std::vector<double>,
            std::array<std::size_t, 2>>
 compute_projection_map(const dolfinx::mesh::Mesh<double>& mesh,
                        std::span<const std::int32_t> facet_tuples,
-                       std::span<const double> points)
+                       std::span<const double> points,
+                       std::span<const std::int32_t> seeds = {},
+                       const FacetTree* tree = nullptr)
 {
 
   assert(tdim == mesh.topology()->dim());
@@ -401,15 +507,181 @@ compute_projection_map(const dolfinx::mesh::Mesh<double>& mesh,
     facets[j] = local_facets[facet_tuples[i + 1]];
   }
 
-  // Compute closest entity for each point
-  dolfinx::geometry::BoundingBoxTree bbox(mesh, tdim - 1, facets);
-  dolfinx::geometry::BoundingBoxTree midpoint_tree
-      = dolfinx::geometry::create_midpoint_tree(mesh, tdim - 1, facets);
-  std::vector<std::int32_t> closest_facets
-      = dolfinx::geometry::compute_closest_entity(bbox, midpoint_tree, mesh,
-                                                  points);
-  std::vector<double> candidate_x(num_points * 3);
   std::span<const double> mesh_geometry = mesh.geometry().x();
+
+  // Search the neighbourhood of the seeds. Points without a seed, or whose
+  // closest facet is on the boundary of the neighbourhood, are collected for
+  // the global search
+  std::vector<std::int32_t> closest_facets(num_points, -1);
+  std::vector<std::int32_t> global_points;
+  if (seeds.empty())
+  {
+    global_points.resize(num_points);
+    std::iota(global_points.begin(), global_points.end(), 0);
+  }
+  else
+  {
+    assert(seeds.size() == num_points);
+    auto f_map = mesh.topology()->index_map(tdim - 1);
+    assert(f_map);
+    const std::int32_t num_mesh_facets
+        = f_map->size_local() + f_map->num_ghosts();
+    std::vector<std::int32_t> facet_position(num_mesh_facets, -1);
+    for (std::size_t j = 0; j < facets.size(); ++j)
+      facet_position[facets[j]] = (std::int32_t)j;
+
+    const dolfinx::graph::AdjacencyList<std::int32_t> patches
+        = dolfinx_contact::compute_facet_patches(mesh, facets);
+    const dolfinx::graph::AdjacencyList<std::int32_t> facets_geometry
+        = dolfinx_contact::entities_to_geometry_dofs(mesh, tdim - 1, facets);
+
+    std::vector<std::int32_t> patch;
+    std::vector<double> coordinate_dofs;
+    std::vector<double> patch_points;
+    std::vector<double> patch_x;
+    for (std::size_t i = 0; i < num_points; ++i)
+    {
+      const std::int32_t seed
+          = (seeds[i] < 0 || seeds[i] >= num_mesh_facets)
+                ? -1
+                : facet_position[seeds[i]];
+      if (seed < 0)
+      {
+        global_points.push_back((std::int32_t)i);
+        continue;
+      }
+
+      // Facets within two layers of the seed
+      patch.clear();
+      for (std::int32_t f : patches.links(seed))
+      {
+        auto neighbours = patches.links(f);
+        patch.insert(patch.end(), neighbours.begin(), neighbours.end());
+      }
+      std::sort(patch.begin(), patch.end());
+      patch.erase(std::unique(patch.begin(), patch.end()), patch.end());
+
+      double min_dist = std::numeric_limits<double>::max();
+      std::int32_t closest = -1;
+      const std::size_t num_facet_dofs
+          = facets_geometry.links(patch.front()).size();
+      if (num_facet_dofs == tdim)
+      {
+        // Closest points on all linear facets of the patch at once
+        coordinate_dofs.resize(3 * num_facet_dofs * patch.size());
+        patch_points.resize(3 * patch.size());
+        patch_x.resize(3 * patch.size());
+        for (std::size_t j = 0; j < patch.size(); ++j)
+        {
+          auto facet_dofs = facets_geometry.links(patch[j]);
+          for (std::size_t l = 0; l < num_facet_dofs; ++l)
+          {
+            std::copy_n(
+                std::next(mesh_geometry.begin(), 3 * facet_dofs[l]), 3,
+                std::next(coordinate_dofs.begin(),
+                          3 * (j * num_facet_dofs + l)));
+          }
+          std::copy_n(std::next(points.begin(), 3 * i), 3,
+                      std::next(patch_points.begin(), 3 * j));
+        }
+        dolfinx_contact::closest_point_linear_facets(
+            coordinate_dofs, num_facet_dofs, patch_points, patch_x);
+        for (std::size_t j = 0; j < patch.size(); ++j)
+        {
+          double dist = 0;
+          for (std::size_t k = 0; k < 3; ++k)
+          {
+            dist += (patch_x[3 * j + k] - patch_points[3 * j + k])
+                    * (patch_x[3 * j + k] - patch_points[3 * j + k]);
+          }
+          if (dist < min_dist)
+          {
+            min_dist = dist;
+            closest = patch[j];
+          }
+        }
+      }
+      else
+      {
+        for (std::int32_t f : patch)
+        {
+          auto facet_dofs = facets_geometry.links(f);
+          coordinate_dofs.resize(3 * facet_dofs.size());
+          for (std::size_t l = 0; l < facet_dofs.size(); ++l)
+          {
+            std::copy_n(std::next(mesh_geometry.begin(), 3 * facet_dofs[l]),
+                        3, std::next(coordinate_dofs.begin(), 3 * l));
+          }
+          std::array<double, 3> dist_vec
+              = dolfinx::geometry::compute_distance_gjk(
+                  std::span<const double>(coordinate_dofs),
+                  std::span(points.data() + 3 * i, 3));
+          const double dist = dist_vec[0] * dist_vec[0]
+                              + dist_vec[1] * dist_vec[1]
+                              + dist_vec[2] * dist_vec[2];
+          if (dist < min_dist)
+          {
+            min_dist = dist;
+            closest = f;
+          }
+        }
+      }
+
+      auto ring = patches.links(seed);
+      if (std::binary_search(ring.begin(), ring.end(), closest))
+        closest_facets[i] = facets[closest];
+      else
+        global_points.push_back((std::int32_t)i);
+    }
+  }
+
+  // Compute closest entity for the remaining points
+  if (!global_points.empty() and tree)
+  {
+    assert(tree->facets().size() == facets.size());
+    if (global_points.size() == num_points)
+      closest_facets = tree->compute_closest_facets(points);
+    else
+    {
+      std::vector<double> global_x(3 * global_points.size());
+      for (std::size_t j = 0; j < global_points.size(); ++j)
+      {
+        std::copy_n(std::next(points.begin(), 3 * global_points[j]), 3,
+                    std::next(global_x.begin(), 3 * j));
+      }
+      std::vector<std::int32_t> global_facets
+          = tree->compute_closest_facets(global_x);
+      for (std::size_t j = 0; j < global_points.size(); ++j)
+        closest_facets[global_points[j]] = global_facets[j];
+    }
+  }
+  else if (!global_points.empty())
+  {
+    dolfinx::geometry::BoundingBoxTree bbox(mesh, tdim - 1, facets);
+    dolfinx::geometry::BoundingBoxTree midpoint_tree
+        = dolfinx::geometry::create_midpoint_tree(mesh, tdim - 1, facets);
+    if (global_points.size() == num_points)
+    {
+      closest_facets = dolfinx::geometry::compute_closest_entity(
+          bbox, midpoint_tree, mesh, points);
+    }
+    else
+    {
+      std::vector<double> global_x(3 * global_points.size());
+      for (std::size_t j = 0; j < global_points.size(); ++j)
+      {
+        std::copy_n(std::next(points.begin(), 3 * global_points[j]), 3,
+                    std::next(global_x.begin(), 3 * j));
+      }
+      std::vector<std::int32_t> global_facets
+          = dolfinx::geometry::compute_closest_entity(
+              bbox, midpoint_tree, mesh, std::span<const double>(global_x));
+      for (std::size_t j = 0; j < global_points.size(); ++j)
+        closest_facets[global_points[j]] = global_facets[j];
+    }
+  }
+
+  std::vector<double> candidate_x(num_points * 3);
   const dolfinx::fem::CoordinateElement<double>& cmap
       = mesh.geometry().cmaps()[0];
   {
@@ -436,64 +708,103 @@ compute_projection_map(const dolfinx::mesh::Mesh<double>& mesh,
                                                      closest_facets);
     assert(facets_geometry.num_nodes() == (int)num_points);
 
-    // Compute physical points for each facet
-    std::vector<double> coordinate_dofs(3 * num_facet_dofs);
-    for (std::size_t i = 0; i < num_points; ++i)
+    // Segments and flat triangles (facets of affine cells and 2D
+    // quadrilaterals) have a closed form closest point, which is computed
+    // for all points at once
+    if (num_facet_dofs == tdim)
     {
-      // Get the geometry dofs for the ith facet, qth
-      // quadrature point
-      auto candidate_facet_dofs = facets_geometry.links(i);
-      assert(num_facet_dofs == candidate_facet_dofs.size());
-
-      // Get the (geometrical) coordinates of the facets
-      for (std::size_t l = 0; l < num_facet_dofs; ++l)
+      std::vector<double> facet_x(3 * num_facet_dofs * num_points);
+      for (std::size_t i = 0; i < num_points; ++i)
       {
-        std::copy_n(
-            std::next(mesh_geometry.begin(), 3 * candidate_facet_dofs[l]), 3,
-            std::next(coordinate_dofs.begin(), 3 * l));
+        auto candidate_facet_dofs = facets_geometry.links(i);
+        assert(num_facet_dofs == candidate_facet_dofs.size());
+        for (std::size_t l = 0; l < num_facet_dofs; ++l)
+        {
+          std::copy_n(
+              std::next(mesh_geometry.begin(), 3 * candidate_facet_dofs[l]), 3,
+              std::next(facet_x.begin(), 3 * (i * num_facet_dofs + l)));
+        }
       }
+      dolfinx_contact::closest_point_linear_facets(facet_x, num_facet_dofs,
+                                                   points, candidate_x);
+    }
+    else
+    {
+      // Compute physical points for each facet
+      std::vector<double> coordinate_dofs(3 * num_facet_dofs);
+      for (std::size_t i = 0; i < num_points; ++i)
+      {
+        // Get the geometry dofs for the ith facet, qth
+        // quadrature point
+        auto candidate_facet_dofs = facets_geometry.links(i);
+        assert(num_facet_dofs == candidate_facet_dofs.size());
 
-      // Compute distance between convex hull of facet and point
-      std::array<double, 3> dist_vec = dolfinx::geometry::compute_distance_gjk(
-          std::span<const double>(coordinate_dofs),
-          std::span(points.data() + 3 * i, 3));
+        // Get the (geometrical) coordinates of the facets
+        for (std::size_t l = 0; l < num_facet_dofs; ++l)
+        {
+          std::copy_n(
+              std::next(mesh_geometry.begin(), 3 * candidate_facet_dofs[l]), 3,
+              std::next(coordinate_dofs.begin(), 3 * l));
+        }
+
+        // Compute distance between convex hull of facet and point
+        std::array<double, 3> dist_vec
+            = dolfinx::geometry::compute_distance_gjk(
+                std::span<const double>(coordinate_dofs),
+                std::span(points.data() + 3 * i, 3));
 
-      // Compute point on closest facet
-      for (std::size_t l = 0; l < 3; ++l)
-        candidate_x[3 * i + l] = points[3 * i + l] + dist_vec[l];
+        // Compute point on closest facet
+        for (std::size_t l = 0; l < 3; ++l)
+          candidate_x[3 * i + l] = points[3 * i + l] + dist_vec[l];
+      }
     }
   }
 
   // Pull back to reference point for each facet on the surface
+  if (num_points > 0)
   {
-    // Temporary data structures used in loop over each
-    // quadrature point on each facet
-    std::array<double, 9> Jb;
-    mdspan3_t J(Jb.data(), 1, gdim, tdim);
-    std::array<double, 9> Kb;
-    mdspan3_t K(Kb.data(), 1, tdim, gdim);
-    std::array<double, 1> detJ;
+    auto f_to_c = mesh.topology()->connectivity(tdim - 1, tdim);
+    if (!f_to_c)
+      throw std::runtime_error("Missing facet to cell connectivity");
+
+    // Group points by the cell connected to their closest facet, such that
+    // all points in a cell are pulled back together
+    std::vector<std::int32_t> closest_cells(num_points);
+    for (std::size_t i = 0; i < num_points; ++i)
+    {
+      auto cells = f_to_c->links(closest_facets[i]);
+      assert(cells.size() == 1);
+      closest_cells[i] = cells.front();
+    }
+    std::vector<std::int32_t> perm(num_points);
+    auto [unique_cells, cell_offsets]
+        = dolfinx_contact::sort_cells(closest_cells, perm);
+    std::size_t max_points = 0;
+    for (std::size_t c = 0; c < unique_cells.size(); ++c)
+    {
+      max_points = std::max(
+          max_points, std::size_t(cell_offsets[c + 1] - cell_offsets[c]));
+    }
+
+    // Temporary data structures used in loop over each cell
+    std::vector<double> Jb(max_points * gdim * tdim);
+    std::vector<double> Kb(max_points * tdim * gdim);
+    std::vector<double> detJ(max_points);
+    std::vector<double> xb(max_points * gdim);
+    std::vector<double> Xb(max_points * tdim);
 
-    std::array<double, gdim> x;
-    std::array<double, tdim> X;
     const std::size_t num_dofs_g = cmap.dim();
     stdex::mdspan<const std::int32_t,
                   MDSPAN_IMPL_STANDARD_NAMESPACE::dextents<std::size_t, 2>>
         x_dofmap = mesh.geometry().dofmap();
     std::vector<double> coordinate_dofsb(num_dofs_g * gdim);
     cmdspan2_t coordinate_dofs(coordinate_dofsb.data(), num_dofs_g, gdim);
-    auto f_to_c = mesh.topology()->connectivity(tdim - 1, tdim);
-    if (!f_to_c)
-      throw std::runtime_error("Missing facet to cell connectivity");
-    for (std::size_t i = 0; i < closest_facets.size(); ++i)
+    for (std::size_t c = 0; c < unique_cells.size(); ++c)
     {
-      // Get cell connected to facet
-      auto cells = f_to_c->links(closest_facets[i]);
-      assert(cells.size() == 1);
-
       // Pack coordinate dofs
       auto x_dofs = stdex::submdspan(
-          x_dofmap, cells.front(), MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent);
+          x_dofmap, unique_cells[c],
+          MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent);
       assert(x_dofs.size() == num_dofs_g);
       for (std::size_t j = 0; j < num_dofs_g; ++j)
       {
@@ -501,18 +812,30 @@ compute_projection_map(const dolfinx::mesh::Mesh<double>& mesh,
                     std::next(coordinate_dofsb.begin(), j * gdim));
       }
 
-      // Copy closest point in physical space
-      std::fill(x.begin(), x.end(), 0);
-      std::copy_n(std::next(candidate_x.begin(), 3 * i), gdim, x.begin());
+      // Gather closest points in physical space for all points in cell
+      const std::size_t num_cell_points = cell_offsets[c + 1] - cell_offsets[c];
+      for (std::size_t k = 0; k < num_cell_points; ++k)
+      {
+        const std::int32_t i = perm[cell_offsets[c] + k];
+        std::copy_n(std::next(candidate_x.begin(), 3 * i), gdim,
+                    std::next(xb.begin(), k * gdim));
+      }
 
-      // NOTE: Would benefit from pulling back all points
-      // in a single cell at the same time
-      // Pull back coordinates
-      std::fill(Jb.begin(), Jb.end(), 0);
-      pull_back(J, K, detJ, X, cmdspan2_t(x.data(), 1, gdim), coordinate_dofs,
+      // Pull back coordinates. For affine cells the inverse Jacobian is
+      // computed once per cell
+      mdspan3_t J(Jb.data(), num_cell_points, gdim, tdim);
+      mdspan3_t K(Kb.data(), num_cell_points, tdim, gdim);
+      pull_back(J, K, detJ, std::span(Xb.data(), num_cell_points * tdim),
+                cmdspan2_t(xb.data(), num_cell_points, gdim), coordinate_dofs,
                 cmap);
+
       // Copy into output
-      std::copy_n(X.begin(), tdim, std::next(candidate_X.begin(), i * tdim));
+      for (std::size_t k = 0; k < num_cell_points; ++k)
+      {
+        const std::int32_t i = perm[cell_offsets[c] + k];
+        std::copy_n(std::next(Xb.begin(), k * tdim), tdim,
+                    std::next(candidate_X.begin(), i * tdim));
+      }
     }
   }
   return {closest_facets, candidate_X, {candidate_X.size() / tdim, tdim}};
@@ -539,6 +862,15 @@ compute_projection_map(const dolfinx::mesh::Mesh<double>& mesh,
 /// tuples (cell_index, local_facet_index) for the
 /// `quadrature_mesh`. Flattened row major.
 /// @param[in] radius The search radius
+/// @param[in] num_threads The number of threads used to ray-trace the
+/// quadrature facets. The closest point projection of the quadrature points
+/// for which the ray-tracing fails is done on the calling thread
+/// @param[in] seeds Optional initial guess (facet index local to process, or
+/// -1) of the colliding facet for each quadrature point, e.g. the facet map
+/// of a previous search. Shape (num_facets, num_q_points). If given, each
+/// quadrature point is first ray-traced onto the neighbours of the seeds on
+/// its facet, and only if this fails onto all candidates within the search
+/// radius.
 /// @returns A tuple (facet_map, reference_points), where
 /// `facet_map` is an AdjacencyList from the ith facet
 /// tuple in `quadrature_facets` to the facet (index local
@@ -555,9 +887,13 @@ compute_raytracing_map(const dolfinx::mesh::Mesh<double>& quadrature_mesh,
                        const QuadratureRule& q_rule,
                        const dolfinx::mesh::Mesh<double>& candidate_mesh,
                        std::span<const std::int32_t> candidate_facets,
-                       const double search_radius = -1.)
+                       const double search_radius = -1.,
+                       const int num_threads = 1,
+                       std::span<const std::int32_t> seeds = {})
 {
-  dolfinx::common::Timer timer("~Raytracing");
+  std::optional<dolfinx::common::Timer> timer;
+  if (!in_parallel_region())
+    timer.emplace("~Raytracing");
   assert(candidate_mesh.geometry().dim() == gdim);
   assert(quadrature_mesh.geometry().dim() == gdim);
   assert(candidate_mesh.topology()->dim() == tdim);
@@ -574,13 +910,28 @@ compute_raytracing_map(const dolfinx::mesh::Mesh<double>& quadrature_mesh,
       quadrature_facets, quadrature_mesh);
   std::vector<std::int32_t> c_facets = dolfinx_contact::facet_indices_from_pair(
       candidate_facets, candidate_mesh);
-  // Structures used for computing physical normal
-  std::array<double, 9> Jb;
-  mdspan2_t J(Jb.data(), gdim, tdim);
-  std::array<double, 9> Kb;
-  mdspan2_t K(Kb.data(), tdim, gdim);
-  std::array<double, 9> Kcb;
-  mdspan2_t K_c(Kcb.data(), tdim, gdim);
+
+  // Compute facet midpoints once and bucket the candidate midpoints in a
+  // uniform grid with cell width equal to the candidate search radius
+  const std::vector<double> q_midpoints
+      = dolfinx::mesh::compute_midpoints(quadrature_mesh, tdim - 1, q_facets);
+  const std::vector<double> c_midpoints
+      = dolfinx::mesh::compute_midpoints(candidate_mesh, tdim - 1, c_facets);
+  const PointGrid c_grid(c_midpoints, 2 * search_radius);
+
+  // Neighbourhoods of the candidate facets, used to seed the search
+  std::vector<std::int32_t> c_position;
+  dolfinx::graph::AdjacencyList<std::int32_t> c_patches(0);
+  if (!seeds.empty())
+  {
+    assert(seeds.size() == quadrature_facets.size() / 2 * num_q_points);
+    auto f_map = candidate_mesh.topology()->index_map(tdim - 1);
+    assert(f_map);
+    c_position.assign(f_map->size_local() + f_map->num_ghosts(), -1);
+    for (std::size_t j = 0; j < c_facets.size(); ++j)
+      c_position[c_facets[j]] = (std::int32_t)j;
+    c_patches = dolfinx_contact::compute_facet_patches(candidate_mesh, c_facets);
+  }
 
   // Get relevant information from quadrature mesh
   const dolfinx::mesh::Geometry<double>& geom_q = quadrature_mesh.geometry();
@@ -592,8 +943,6 @@ compute_raytracing_map(const dolfinx::mesh::Mesh<double>& quadrature_mesh,
                 MDSPAN_IMPL_STANDARD_NAMESPACE::dextents<std::size_t, 2>>
       q_dofmap = geom_q.dofmap();
   const std::size_t num_nodes_q = cmap_q.dim();
-  std::vector<double> coordinate_dofs_qb(num_nodes_q * gdim);
-  cmdspan2_t coordinate_dofs_q(coordinate_dofs_qb.data(), num_nodes_q, gdim);
   auto [reference_normals, rn_shape]
       = basix::cell::facet_outward_normals<double>(
           dolfinx::mesh::cell_type_to_basix_type(top_q->cell_types()[0]));
@@ -624,13 +973,9 @@ compute_raytracing_map(const dolfinx::mesh::Mesh<double>& quadrature_mesh,
 
   const std::array<std::size_t, 4> basis_shape_c = cmap_c.tabulate_shape(1, 1);
   const std::size_t num_nodes_c = cmap_c.dim();
-  std::vector<double> coordinate_dofs_c(num_nodes_c * gdim);
-  std::vector<double> basis_values_c(std::reduce(
-      basis_shape_c.begin(), basis_shape_c.end(), 1, std::multiplies{}));
-  std::array<double, 3> normal_c;
 
-  // Variable to hold jth point for Jacbian computation
-  std::array<double, 3> normal;
+  // Output arrays. Each quadrature facet is processed by exactly one thread,
+  // which writes to the entries of that facet only
   std::vector<std::int32_t> colliding_facet(
       quadrature_facets.size() / 2 * num_q_points, -1);
   std::vector<double> reference_points(
@@ -656,70 +1001,42 @@ compute_raytracing_map(const dolfinx::mesh::Mesh<double>& quadrature_mesh,
   const std::vector<std::vector<int>> bfacets
       = basix::cell::topology(basix_cell)[tdim - 1];
 
-  NewtonStorage<tdim, gdim> allocated_memory;
-  auto tangents = allocated_memory.tangents();
-  auto point = allocated_memory.point();
-  auto dxi = allocated_memory.dxi();
-  auto X_fin = allocated_memory.X_k();
-
-  // This array stores for the current facet for which quadrature point no
-  // valid contact point is determined
-  std::vector<std::size_t> missing_matches(num_q_points);
-
-  for (std::size_t i = 0; i < quadrature_facets.size(); i += 2)
+  // Ray-trace the quadrature points on the quadrature facets [f0, f1)
+  auto raytrace_facets = [&](std::size_t f0, std::size_t f1)
   {
-    std::size_t count_missing_matches = 0; // counter for missing contact points
-
-    // Determine candidate facets within search radius
-    // FIXME: This is not the most efficient way of finding close facets
-    std::vector<size_t> cand_patch
-        = find_candidate_facets(quadrature_mesh, candidate_mesh,
-                                q_facets[i / 2], c_facets, 2 * search_radius);
-
-    // Pack coordinate dofs
-    auto x_dofs = stdex::submdspan(q_dofmap, quadrature_facets[i],
-                                   MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent);
-    assert(x_dofs.size() == num_nodes_q);
-    for (std::size_t j = 0; j < num_nodes_q; ++j)
-    {
-      std::copy_n(std::next(q_x.begin(), 3 * x_dofs[j]), gdim,
-                  std::next(coordinate_dofs_qb.begin(), j * gdim));
-    }
-    const std::int32_t facet_index = quadrature_facets[i + 1];
-    for (std::size_t j = 0; j < num_q_points; ++j)
+    // Structures used for computing physical normal
+    std::array<double, 9> Jb;
+    mdspan2_t J(Jb.data(), gdim, tdim);
+    std::array<double, 9> Kb;
+    mdspan2_t K(Kb.data(), tdim, gdim);
+    std::array<double, 9> Kcb;
+    mdspan2_t K_c(Kcb.data(), tdim, gdim);
+
+    std::vector<double> coordinate_dofs_qb(num_nodes_q * gdim);
+    cmdspan2_t coordinate_dofs_q(coordinate_dofs_qb.data(), num_nodes_q, gdim);
+    std::vector<double> coordinate_dofs_c(num_nodes_c * gdim);
+    std::vector<double> basis_values_c(std::reduce(
+        basis_shape_c.begin(), basis_shape_c.end(), 1, std::multiplies{}));
+    std::array<double, 3> normal_c;
+
+    // Variable to hold jth point for Jacbian computation
+    std::array<double, 3> normal;
+
+    NewtonStorage<tdim, gdim> allocated_memory;
+    auto tangents = allocated_memory.tangents();
+    auto point = allocated_memory.point();
+    auto dxi = allocated_memory.dxi();
+    auto X_fin = allocated_memory.X_k();
+
+    // Ray-trace the current point onto a patch of candidate facets. Returns
+    // the position (in the candidate facets) of the first facet with a valid
+    // contact point, or -1 if there is none
+    auto trace_patch = [&](std::span<const std::size_t> patch) -> std::int64_t
     {
-
-      auto dphi_q = stdex::submdspan(
-          basis_values_q, std::pair{1, (std::size_t)tdim + 1},
-          std::size_t(num_q_points * facet_index + j),
-          MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent, 0);
-      std::fill(Jb.begin(), Jb.end(), 0);
-      dolfinx::fem::CoordinateElement<double>::compute_jacobian(
-          dphi_q, coordinate_dofs_q, J);
-      dolfinx::fem::CoordinateElement<double>::compute_jacobian_inverse(J, K);
-
-      // Push forward normal using covariant Piola
-      // transform
-      std::fill(normal.begin(), normal.end(), 0);
-      physical_facet_normal(
-          std::span(normal.data(), gdim), K,
-          std::span(reference_normals.data() + rn_shape[1] * facet_index,
-                    rn_shape[1]));
-
-      // Copy data regarding quadrature point into allocated memory for
-      // raytracing
-      std::copy_n(std::next(quadrature_points.cbegin(),
-                            (i / 2 * num_q_points + j) * gdim),
-                  gdim, point.begin());
-      impl::compute_tangents<gdim>(std::span<double, gdim>(normal.data(), gdim),
-                                   tangents);
-
-      std::size_t cell_idx = -1;
-      int status = 0;
-      for (std::size_t c = 0; c < cand_patch.size(); ++c)
+      for (std::size_t c : patch)
       {
-        std::int32_t cell = candidate_facets[2 * cand_patch[c]];
-        std::int32_t facet_index_c = candidate_facets[2 * cand_patch[c] + 1];
+        std::int32_t cell = candidate_facets[2 * c];
+        std::int32_t facet_index_c = candidate_facets[2 * c + 1];
         // Get cell geometry for candidate cell, reusing
         // coordinate dofs to store new coordinate
         auto x_dofs_c = stdex::submdspan(
@@ -752,7 +1069,7 @@ compute_raytracing_map(const dolfinx::mesh::Mesh<double>& quadrature_mesh,
           }
         };
 
-        status = raytracing_cell<tdim, gdim>(
+        int status = raytracing_cell<tdim, gdim>(
             allocated_memory, basis_values_c, basis_shape_c, 25, 1e-8, cmap_c,
             cell_type, coordinate_dofs_c, reference_map);
 
@@ -782,76 +1099,213 @@ compute_raytracing_map(const dolfinx::mesh::Mesh<double>& quadrature_mesh,
 
         // check criteria for valid contact pair
         // 1. Compatible normals (normals pointing in opposite directions)
-        // 2. Point within search radius
-        if (dot > 0 || (search_radius > 0 && norm > search_radius))
+        // 2. Point within search radius (norm is the squared length of the
+        // ray)
+        if (dot > 0
+            || (search_radius > 0 && norm > search_radius * search_radius))
           status = -5;
         if (status > 0)
+          return (std::int64_t)c;
+      }
+      return -1;
+    };
+
+    // This array stores for the current facet for which quadrature point no
+    // valid contact point is determined
+    std::vector<std::size_t> missing_matches(num_q_points);
+    std::vector<std::size_t> seed_patch;
+    std::vector<std::pair<double, std::size_t>> seed_distances;
+    std::vector<std::size_t> cand_patch;
+
+    for (std::size_t i = 2 * f0; i < 2 * f1; i += 2)
+    {
+      std::size_t count_missing_matches
+          = 0; // counter for missing contact points
+
+      // Candidate facets neighbouring the seeds of this facet, sorted by the
+      // distance of their midpoints to the midpoint of the quadrature facet
+      std::span<const double, 3> q_midpoint(q_midpoints.data() + 3 * (i / 2),
+                                            3);
+      seed_patch.clear();
+      for (std::size_t j = 0; j < num_q_points && !seeds.empty(); ++j)
+      {
+        const std::int32_t seed = seeds[i / 2 * num_q_points + j];
+        if (seed < 0 || seed >= (std::int32_t)c_position.size()
+            || c_position[seed] < 0)
         {
-          cell_idx = cand_patch[c];
-          // Break loop
-          c = cand_patch.size();
+          continue;
         }
+        for (std::int32_t c : c_patches.links(c_position[seed]))
+          seed_patch.push_back(c);
       }
-      if (status > 0)
+      std::sort(seed_patch.begin(), seed_patch.end());
+      seed_patch.erase(std::unique(seed_patch.begin(), seed_patch.end()),
+                       seed_patch.end());
+      seed_distances.clear();
+      for (std::size_t c : seed_patch)
       {
-        colliding_facet[i / 2 * num_q_points + j] = c_facets[cell_idx];
-        std::copy_n(X_fin.begin(), tdim,
-                    std::next(reference_points.begin(),
-                              tdim * (i / 2 * num_q_points + j)));
+        double dist = 0;
+        for (std::size_t k = 0; k < 3; ++k)
+        {
+          const double d = c_midpoints[3 * c + k] - q_midpoint[k];
+          dist += d * d;
+        }
+        seed_distances.emplace_back(dist, c);
       }
-      else
+      std::sort(seed_distances.begin(), seed_distances.end());
+      for (std::size_t c = 0; c < seed_distances.size(); ++c)
+        seed_patch[c] = seed_distances[c].second;
+
+      // Determine candidate facets within search radius. Only done if
+      // needed when the search is seeded
+      bool global_search = false;
+      auto find_global_patch = [&]()
       {
-        // save quadrature points with no valid contact point
-        missing_matches[count_missing_matches] = j;
-        count_missing_matches += 1;
-      }
-    }
-    // If contact points are found for some, but not all quadrature points
-    // Use closest point projection to add contact points for remainig
-    // quadrature points
-    if (count_missing_matches > 0 && count_missing_matches < num_q_points)
-    {
-      std::vector<std::int32_t> cand_facets_patch(2 * cand_patch.size());
-      std::vector<double> padded_qpsb(count_missing_matches * 3);
-      dolfinx_contact::mdspan2_t padded_qps(padded_qpsb.data(),
-                                            count_missing_matches, 3);
-      dolfinx_contact::cmdspan3_t qps(quadrature_points.data(),
-                                      quadrature_facets.size() / 2,
-                                      num_q_points, gdim);
-
-      // Retrieve remaining quadrature points
-      for (std::size_t j = 0; j < padded_qps.extent(0); ++j)
-        for (std::size_t k = 0; k < qps.extent(2); ++k)
-          padded_qps(j, k) = qps(i / 2, missing_matches[j], k);
-
-      // Retrieve candidate facets as (cell, local_facet) pair
-      for (std::size_t c = 0; c < cand_patch.size(); ++c)
+        if (!global_search)
+        {
+          cand_patch = find_candidate_facets(q_midpoint, c_midpoints, c_grid,
+                                             2 * search_radius);
+          global_search = true;
+        }
+      };
+      if (seeds.empty())
+        find_global_patch();
+
+      // Pack coordinate dofs
+      auto x_dofs
+          = stdex::submdspan(q_dofmap, quadrature_facets[i],
+                             MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent);
+      assert(x_dofs.size() == num_nodes_q);
+      for (std::size_t j = 0; j < num_nodes_q; ++j)
       {
-        cand_facets_patch[2 * c] = candidate_facets[2 * cand_patch[c]];
-        cand_facets_patch[2 * c + 1] = candidate_facets[2 * cand_patch[c] + 1];
+        std::copy_n(std::next(q_x.begin(), 3 * x_dofs[j]), gdim,
+                    std::next(coordinate_dofs_qb.begin(), j * gdim));
       }
-      // find closest enities
-      auto [closest_entities, reference_points_2, shape_2]
-          = compute_projection_map<tdim, gdim>(candidate_mesh,
-                                               cand_facets_patch, padded_qpsb);
+      const std::int32_t facet_index = quadrature_facets[i + 1];
+      for (std::size_t j = 0; j < num_q_points; ++j)
+      {
 
-      // insert facets and reference points into the relevant arrays
-      for (std::size_t j = 0; j < count_missing_matches; ++j)
+        auto dphi_q = stdex::submdspan(
+            basis_values_q, std::pair{1, (std::size_t)tdim + 1},
+            std::size_t(num_q_points * facet_index + j),
+            MDSPAN_IMPL_STANDARD_NAMESPACE::full_extent, 0);
+        std::fill(Jb.begin(), Jb.end(), 0);
+        dolfinx::fem::CoordinateElement<double>::compute_jacobian(
+            dphi_q, coordinate_dofs_q, J);
+        dolfinx::fem::CoordinateElement<double>::compute_jacobian_inverse(J,
+                                                                          K);
+
+        // Push forward normal using covariant Piola
+        // transform
+        std::fill(normal.begin(), normal.end(), 0);
+        physical_facet_normal(
+            std::span(normal.data(), gdim), K,
+            std::span(reference_normals.data() + rn_shape[1] * facet_index,
+                      rn_shape[1]));
+
+        // Copy data regarding quadrature point into allocated memory for
+        // raytracing
+        std::copy_n(std::next(quadrature_points.cbegin(),
+                              (i / 2 * num_q_points + j) * gdim),
+                    gdim, point.begin());
+        impl::compute_tangents<gdim>(
+            std::span<double, gdim>(normal.data(), gdim), tangents);
+
+        // Try the neighbourhood of the seeds first and fall back to all
+        // candidates within the search radius
+        std::int64_t cell_idx = trace_patch(seed_patch);
+        if (cell_idx < 0)
+        {
+          find_global_patch();
+          cell_idx = trace_patch(cand_patch);
+        }
+        if (cell_idx >= 0)
+        {
+          colliding_facet[i / 2 * num_q_points + j] = c_facets[cell_idx];
+          std::copy_n(X_fin.begin(), tdim,
+                      std::next(reference_points.begin(),
+                                tdim * (i / 2 * num_q_points + j)));
+        }
+        else
+        {
+          // save quadrature points with no valid contact point
+          missing_matches[count_missing_matches] = j;
+          count_missing_matches += 1;
+        }
+      }
+      // If contact points are found for some, but not all quadrature points,
+      // the remaining points are marked for the closest point projection
+      // below
+      if (count_missing_matches > 0 && count_missing_matches < num_q_points)
       {
-        colliding_facet[i / 2 * num_q_points + missing_matches[j]]
-            = closest_entities[j];
-        std::copy_n(
-            std::next(reference_points_2.begin(), j * tdim), tdim,
-            std::next(reference_points.begin(),
-                      tdim * (i / 2 * num_q_points + missing_matches[j])));
+        for (std::size_t j = 0; j < count_missing_matches; ++j)
+          colliding_facet[i / 2 * num_q_points + missing_matches[j]] = -2;
       }
     }
+  };
+
+  // Quadrature facets are independent, so they are distributed over the
+  // threads in contiguous chunks
+  parallel_for(quadrature_facets.size() / 2, num_threads,
+               [&raytrace_facets](std::size_t, std::size_t f0, std::size_t f1)
+               { raytrace_facets(f0, f1); });
+
+  // Use closest point projection to add contact points for the marked
+  // quadrature points. This is done after the threaded region, as
+  // compute_projection_map builds dolfinx bounding box trees, which may
+  // create connectivity on the shared candidate mesh
+  std::vector<std::size_t> missing_matches;
+  for (std::size_t f = 0; f < quadrature_facets.size() / 2; ++f)
+  {
+    missing_matches.clear();
+    for (std::size_t j = 0; j < num_q_points; ++j)
+      if (colliding_facet[f * num_q_points + j] == -2)
+        missing_matches.push_back(j);
+    if (missing_matches.empty())
+      continue;
+
+    std::span<const double, 3> q_midpoint(q_midpoints.data() + 3 * f, 3);
+    const std::vector<std::size_t> cand_patch = find_candidate_facets(
+        q_midpoint, c_midpoints, c_grid, 2 * search_radius);
+    std::vector<std::int32_t> cand_facets_patch(2 * cand_patch.size());
+    std::vector<double> padded_qpsb(missing_matches.size() * 3);
+    dolfinx_contact::mdspan2_t padded_qps(padded_qpsb.data(),
+                                          missing_matches.size(), 3);
+    dolfinx_contact::cmdspan3_t qps(quadrature_points.data(),
+                                    quadrature_facets.size() / 2, num_q_points,
+                                    gdim);
+
+    // Retrieve remaining quadrature points
+    for (std::size_t j = 0; j < padded_qps.extent(0); ++j)
+      for (std::size_t k = 0; k < qps.extent(2); ++k)
+        padded_qps(j, k) = qps(f, missing_matches[j], k);
+
+    // Retrieve candidate facets as (cell, local_facet) pair
+    for (std::size_t c = 0; c < cand_patch.size(); ++c)
+    {
+      cand_facets_patch[2 * c] = candidate_facets[2 * cand_patch[c]];
+      cand_facets_patch[2 * c + 1] = candidate_facets[2 * cand_patch[c] + 1];
+    }
+    // find closest enities
+    auto [closest_entities, reference_points_2, shape_2]
+        = compute_projection_map<tdim, gdim>(candidate_mesh, cand_facets_patch,
+                                             padded_qpsb);
+
+    // insert facets and reference points into the relevant arrays
+    for (std::size_t j = 0; j < missing_matches.size(); ++j)
+    {
+      colliding_facet[f * num_q_points + missing_matches[j]]
+          = closest_entities[j];
+      std::copy_n(std::next(reference_points_2.begin(), j * tdim), tdim,
+                  std::next(reference_points.begin(),
+                            tdim * (f * num_q_points + missing_matches[j])));
+    }
   }
+
   std::vector<std::int32_t> offset(quadrature_facets.size() / 2 + 1);
   std::iota(offset.begin(), offset.end(), 0);
   std::for_each(offset.begin(), offset.end(),
                 [num_q_points](auto& i) { i *= num_q_points; });
-  timer.stop();
   return {dolfinx::graph::AdjacencyList<std::int32_t>(colliding_facet, offset),
           reference_points,
           std::array<std::size_t, 2>{reference_points.size() / tdim, tdim}};
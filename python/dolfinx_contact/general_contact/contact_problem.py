@@ -7,7 +7,7 @@ import numpy as np
 import numpy.typing as npt  # noqa: F401
 from typing import Any, Tuple  # noqa: F401
 from dolfinx import default_scalar_type  # noqa: F401
-from dolfinx import common, cpp, fem
+from dolfinx import common, cpp, fem, la
 from dolfinx import mesh as _mesh
 from petsc4py import PETSc
 
@@ -24,13 +24,15 @@ class FrictionLaw(Enum):
 
 
 class ContactProblem(dolfinx_contact.cpp.Contact):
-    __slots__ = ["_matrix_kernels", "_vector_kernels", "coeffs", "_consts", "q_deg",
-                 "_num_pairs", "_cstrides", "entities", "_normals", "search_method",
-                 "_grad_u", "_num_q_points"]
+    __slots__ = ["_matrix_kernels", "_vector_kernels", "_system_kernel", "_action_kernel", "_batched_kernels",
+                 "coeffs", "_consts", "q_deg", "_num_pairs", "_cstrides", "entities", "_normals", "search_method",
+                 "_grad_u", "_num_q_points", "_packers", "direct_insertion", "_insertion_maps"]
 
     def __init__(self, markers: list[_mesh.MeshTags], surfaces: Any,
                  contact_pairs: list[Tuple[int, int]], mesh: _mesh.Mesh, quadrature_degree: int,
-                 search_method: list[dolfinx_contact.cpp.ContactMode], search_radius: np.float64 = np.float64(-1.0)):
+                 search_method: list[dolfinx_contact.cpp.ContactMode], search_radius: np.float64 = np.float64(-1.0),
+                 incremental_search: bool = False, automatic_search_radius: bool = False,
+                 direct_insertion: bool = False):
         """
         This class initialises the contact class and provides convenience functions
         for generating the integration kernels and integration data for frictional contact
@@ -46,6 +48,15 @@ class ContactProblem(dolfinx_contact.cpp.Contact):
             search_method:     List containing for each contact pair whether Raytracing or CPP (Closest Point
                                Projection) is used for contact search
             search_radius:     Restricts the search radius for contact detection. Only used in raytracing
+            incremental_search: If True, update_contact_detection seeds the search for each quadrature
+                               point with the facet found by the previous search and its neighbours, and
+                               only falls back to the global search where this fails
+            automatic_search_radius: If True, the search radius for raytracing is estimated for each pair on
+                               every contact detection from the facet sizes, the largest gap and the
+                               displacement since the previous detection. Overrides search_radius
+            direct_insertion:  If True, assemble_matrix adds the contact element matrices directly at
+                               precomputed positions in the values of the matrix once it has been
+                               assembled. The positions are recomputed when the contact detection changes
 
         """
         # create contact class
@@ -56,9 +67,10 @@ class ContactProblem(dolfinx_contact.cpp.Contact):
                              search_method=search_method)
 
         self.set_search_radius(search_radius)
+        self.set_automatic_search_radius(automatic_search_radius)
         # Perform contact detection
-        for j in range(len(contact_pairs)):
-            self.create_distance_map(j)
+        self.create_distance_maps()
+        self.set_incremental_search(incremental_search)
 
         self.q_deg = quadrature_degree
         self._num_pairs = len(contact_pairs)
@@ -71,6 +83,28 @@ class ContactProblem(dolfinx_contact.cpp.Contact):
 
         self.search_method = search_method
         self.coeffs = []  # type: list[npt.NDArray[default_scalar_type]]
+        self._packers = {}  # type: dict[Tuple[int, Any], Tuple[dolfinx_contact.cpp.QuadraturePacker, bool]]
+        self.direct_insertion = direct_insertion
+        self._insertion_maps = {}  # type: dict[int, Tuple[int, dolfinx_contact.cpp.CSRInsertionMap]]
+
+    def quadrature_packer(self, i: int, V: fem.FunctionSpace,
+                          gradient: bool = False) -> dolfinx_contact.cpp.QuadraturePacker:
+        """
+        Return a packer for functions in V at the quadrature points of the integration
+        surface of pair i. The packer caches the tabulated basis functions and is created
+        on first use.
+        Args:
+            i : index of contact pair
+            V : the function space
+            gradient : if True, the packer can also pack gradients
+        """
+        key = (i, V._cpp_object)
+        packer, has_gradient = self._packers.get(key, (None, False))
+        if packer is None or (gradient and not has_gradient):
+            packer = dolfinx_contact.cpp.QuadraturePacker(
+                V._cpp_object, self.q_deg, self.entities[i], gradient=gradient)
+            self._packers[key] = (packer, gradient)
+        return packer
 
     @common.timed("~Contact: Update coefficients")
     def update_contact_data(self, du: fem.Function):
@@ -88,18 +122,17 @@ class ContactProblem(dolfinx_contact.cpp.Contact):
             for i in range(self._num_pairs):
                 offset0 = 4 + self._num_q_points[i] * gdim * (2 + ndofs_cell * max_links)
                 offset1 = offset0 + self._num_q_points[i] * gdim
+                packer = self.quadrature_packer(i, du.function_space, gradient=True)
                 # Pack du on integration surface
-                self.coeffs[i][:, offset0:offset1] = dolfinx_contact.cpp.pack_coefficient_quadrature(
-                    du._cpp_object, self.q_deg, self.entities[i])[:, :]
+                packer.pack(du._cpp_object, self.coeffs[i], offset0)
                 offset0 = offset1
                 offset1 = offset0 + self._num_q_points[i] * gdim * gdim
                 # Pack grad(u + du) on integration surface
-                self.coeffs[i][:, offset0:offset1] = dolfinx_contact.cpp.pack_gradient_quadrature(
-                    du._cpp_object, self.q_deg, self.entities[i])[:, :] + self._grad_u[i][:, :]
+                packer.pack_gradient(du._cpp_object, self.coeffs[i], offset0)
+                self.coeffs[i][:, offset0:offset1] += self._grad_u[i]
                 offset0 = offset1
-                offset1 = offset0 + self._num_q_points[i] * gdim
                 # Pack du on contacting surface
-                self.coeffs[i][:, offset0:offset1] = self.pack_u_contact(i, du._cpp_object)[:, :]
+                self.pack_u_contact(i, du._cpp_object, self.coeffs[i], offset0)
 
     def pack_normals(self, i: int):
         """
@@ -143,7 +176,7 @@ class ContactProblem(dolfinx_contact.cpp.Contact):
 
     def generate_contact_data(self, friction_law: FrictionLaw, function_space: fem.FunctionSpaceBase,
                               coefficients: dict[str, fem.Function],
-                              gamma: float, theta: float) -> None:
+                              gamma: float, theta: float, batched: bool = True) -> None:
         """
         This function generates the integration kernels and initialises the input data for the
         integration kernels.
@@ -156,6 +189,8 @@ class ContactProblem(dolfinx_contact.cpp.Contact):
                           u: previous displacement (assumed to be zero if not provided)
                           du: the displacement update function
             gamma, theta: Nitsche parameters
+            batched: If True, the frictionless parts of assemble_matrix and assemble_vector use kernels
+                     evaluating several facets at once where they exist for the element
         """
         # generate kernels
         self._matrix_kernels = []
@@ -175,6 +210,17 @@ class ContactProblem(dolfinx_contact.cpp.Contact):
                     kt.TrescaJac, function_space._cpp_object))
                 self._vector_kernels.append(self.generate_kernel(
                     kt.TrescaRhs, function_space._cpp_object))
+            system_kernel = {FrictionLaw.Frictionless: kt.System, FrictionLaw.Coulomb: kt.CoulombSystem,
+                             FrictionLaw.Tresca: kt.TrescaSystem}[friction_law]
+            # The friction system kernels include the frictionless terms
+            self._system_kernel = self.generate_system_kernel(system_kernel, function_space._cpp_object)
+            # Kernel applying the jacobian of the system kernel without forming the element matrices
+            self._action_kernel = self.generate_action_kernel(system_kernel, function_space._cpp_object)
+            # Batched replacements of the frictionless kernels _matrix_kernels[0] and _vector_kernels[0]
+            self._batched_kernels = [None, None]
+            if batched:
+                self._batched_kernels = [self.generate_batched_kernel(kt.Jac, function_space._cpp_object),
+                                         self.generate_batched_kernel(kt.Rhs, function_space._cpp_object)]
 
         # pack constants
         self._consts = np.array([gamma, theta], dtype=np.float64)
@@ -197,6 +243,8 @@ class ContactProblem(dolfinx_contact.cpp.Contact):
                             np.arange(0, ncells, dtype=np.int32))
         h.x.array[:ncells] = h_vals[:]
 
+        # The coefficients are padded to max_links linked cells per facet, such that the packed
+        # quantities are columns of the arrays that are updated in place (see update_contact_data)
         new_model = False
         if len(self.coeffs) == 0:
             new_model = True
@@ -204,8 +252,8 @@ class ContactProblem(dolfinx_contact.cpp.Contact):
                            for i in range(self._num_pairs)]
 
         with common.Timer("~Contact: Pack coeffs (mu, lmbda, fric, h)"):
+            self.create_distance_maps()
             for i in range(self._num_pairs):
-                self.create_distance_map(i)
                 for j, key in enumerate(keys):
                     self.coeffs[i][:, j] = dolfinx_contact.cpp.pack_coefficient_quadrature(
                         coefficients[key]._cpp_object, 0, self.entities[i])[:, 0]
@@ -214,24 +262,14 @@ class ContactProblem(dolfinx_contact.cpp.Contact):
 
         # Pack gap, normals and test functions on each surface
         self._num_q_points = []
-        max_links = self.max_links()
-        ndofs_cell = len(function_space.dofmap.cell_dofs(0))
         with common.Timer("~Contact: Pack gap, normals, testfunction"):
             for i in range(self._num_pairs):
-                normals = self.pack_normals(i)
-                self._num_q_points.append(normals.shape[1] // gdim)
-                offset0 = 4
-                offset1 = offset0 + self._num_q_points[i] * gdim
-                self.coeffs[i][:, offset0:offset1] = self.pack_gap(i)
-                offset0 = offset1
-                offset1 = offset0 + self._num_q_points[i] * gdim
-                self.coeffs[i][:, offset0:offset1] = normals[:, :]
-                offset0 = offset1
-                offset1 = offset0 + self._num_q_points[i] * gdim * max_links * ndofs_cell
-                self.coeffs[i][:, offset0:offset1] = self.pack_test_functions(
-                    i, function_space._cpp_object)
+                self._num_q_points.append(self.num_q_points())
+                self.pack_contact_data(i, function_space._cpp_object, self.coeffs[i], 4)
                 if new_model:
-                    self.coeffs[i][:, -normals.shape[1]:] = normals[:, :]
+                    offset0 = 4 + self._num_q_points[i] * gdim
+                    offset1 = offset0 + self._num_q_points[i] * gdim
+                    self.coeffs[i][:, -self._num_q_points[i] * gdim:] = self.coeffs[i][:, offset0:offset1]
 
         # pack grad u
         # This is to track grad_u if several load steps are used
@@ -244,8 +282,8 @@ class ContactProblem(dolfinx_contact.cpp.Contact):
         if coefficients.get("u") is not None:
             with common.Timer("~~Contact: Pack grad(u)"):
                 for i in range(self._num_pairs):
-                    self._grad_u[i][:, :] = dolfinx_contact.cpp.pack_gradient_quadrature(
-                        coefficients["u"]._cpp_object, self.q_deg, self.entities[i])[:, :]
+                    packer = self.quadrature_packer(i, coefficients["u"].function_space, gradient=True)
+                    self._grad_u[i][:, :] = packer.pack_gradient(coefficients["u"]._cpp_object)[:, :]
 
         if coefficients.get("du") is not None:
             self.update_contact_data(coefficients["du"])
@@ -257,8 +295,7 @@ class ContactProblem(dolfinx_contact.cpp.Contact):
         Args: u - The displacement
         """
         self.update_submesh_geometry(u._cpp_object)
-        for j in range(self._num_pairs):
-            self.create_distance_map(j)
+        self.create_distance_maps()
 
         max_links = self.max_links()
         ndofs_cell = len(u.function_space.dofmap.cell_dofs(0))
@@ -274,23 +311,14 @@ class ContactProblem(dolfinx_contact.cpp.Contact):
         # Pack gap, normals and test functions on each surface
         with common.Timer("~Contact: Pack gap, normals, testfunction"):
             for i in range(num_pairs):
-                offset0 = 4
-                offset1 = offset0 + self._num_q_points[i] * gdim
-                self.coeffs[i][:, offset0:offset1] = self.pack_gap(i)
-                offset0 = offset1
-                offset1 = offset0 + self._num_q_points[i] * gdim
-                self.coeffs[i][:, offset0:offset1] = self.pack_normals(i)[:, :]
-                offset0 = offset1
-                offset1 = offset0 + self._num_q_points[i] * gdim * max_links * ndofs_cell
-                self.coeffs[i][:, offset0:offset1] = self.pack_test_functions(
-                    i, u.function_space._cpp_object)
+                self.pack_contact_data(i, u.function_space._cpp_object, self.coeffs[i], 4)
 
         # pack grad u
         self._grad_u = []
         with common.Timer("~~Contact: Pack grad(u)"):
             for i in range(num_pairs):
-                self._grad_u.append(dolfinx_contact.cpp.pack_gradient_quadrature(
-                    u._cpp_object, self.q_deg, self.entities[i]))
+                packer = self.quadrature_packer(i, u.function_space, gradient=True)
+                self._grad_u.append(packer.pack_gradient(u._cpp_object))
 
     def update_nitsche_parameters(self, gamma: float, theta: float) -> None:
         """
@@ -311,13 +339,26 @@ class ContactProblem(dolfinx_contact.cpp.Contact):
             h.append(np.sum(self.coeffs[i][:, 3]) / self.coeffs[i].shape[0])
         return h
 
-    def create_matrix(self, j_form: fem.Form):
+    def create_matrix(self, j_form: fem.Form, halo: float = -1.0):
         """
         This function creates a PETSc matrix with the correct sparsity pattern
         for the current contact detection
         Args: j_form - The jacobian form
+              halo - If non-negative, the sparsity pattern also couples each facet to all facets
+                     of the opposite surface within this distance. The matrix can then be reused
+                     as long as sparsity_pattern_fits() returns True after the contact detection.
+                     Like the contact detection, the halo only contains the facets on the process
         """
-        return super().create_matrix(j_form._cpp_object)
+        return super().create_matrix(j_form._cpp_object, halo=halo)
+
+    def create_sparsity_pattern(self, j_form: fem.Form, halo: float = -1.0):
+        """
+        This function creates the sparsity pattern of the jacobian form and the contact coupling
+        for the current contact detection, e.g. for creating a dolfinx.la.MatrixCSR
+        Args: j_form - The jacobian form
+              halo - see create_matrix
+        """
+        return super().create_sparsity_pattern(j_form._cpp_object, halo=halo)
 
     def assemble_vector(self, b: PETSc.Vec,  # type: ignore
                         function_space: fem.FunctionSpaceBase) -> None:
@@ -326,8 +367,11 @@ class ContactProblem(dolfinx_contact.cpp.Contact):
         Args: b - the vector to be assembled into
               function_space - the underlying displacement function space
         """
+        kernels = self._vector_kernels.copy()
+        if self._batched_kernels[1] is not None:
+            kernels[0] = self._batched_kernels[1]
         for i in range(self._num_pairs):
-            for kernel in self._vector_kernels:
+            for kernel in kernels:
                 super().assemble_vector(
                     b, i, kernel, self.coeffs[i], self._consts, function_space._cpp_object)
 
@@ -339,10 +383,87 @@ class ContactProblem(dolfinx_contact.cpp.Contact):
         Args: a_mat - the matrix to be assembled into
               function_space - the underlying displacement function space
         """
+        kernels = self._matrix_kernels.copy()
+        if self._batched_kernels[0] is not None:
+            kernels[0] = self._batched_kernels[0]
         for i in range(self._num_pairs):
-            for kernel in self._matrix_kernels:
-                super().assemble_matrix(
-                    a_mat, i, kernel, self.coeffs[i], self._consts, function_space._cpp_object)
+            insertion_map = self.insertion_map(i, a_mat, function_space) if self.direct_insertion else None
+            for kernel in kernels:
+                if insertion_map is None:
+                    super().assemble_matrix(
+                        a_mat, i, kernel, self.coeffs[i], self._consts, function_space._cpp_object)
+                else:
+                    super().assemble_matrix(
+                        a_mat, insertion_map, i, kernel, self.coeffs[i], self._consts, function_space._cpp_object)
+
+    @common.timed("~Contact: Assemble system")
+    def assemble_system(self, a_mat: PETSc.Mat, b: PETSc.Vec,  # type: ignore
+                        function_space: fem.FunctionSpaceBase) -> None:
+        """
+        This function assembles the contact contributions to the lhs matrix and the rhs vector
+        in one pass over the contact facets. It is equivalent to calling assemble_matrix and
+        assemble_vector
+        Args: a_mat - the matrix to be assembled into
+              b - the vector to be assembled into
+              function_space - the underlying displacement function space
+        """
+        for i in range(self._num_pairs):
+            insertion_map = self.insertion_map(i, a_mat, function_space) if self.direct_insertion else None
+            if insertion_map is None:
+                super().assemble_system(
+                    a_mat, b, i, self._system_kernel, self.coeffs[i], self._consts, function_space._cpp_object)
+            else:
+                super().assemble_system(a_mat, insertion_map, b, i, self._system_kernel, self.coeffs[i],
+                                        self._consts, function_space._cpp_object)
+
+    def apply_matrix(self, x: PETSc.Vec, y: PETSc.Vec,  # type: ignore
+                     function_space: fem.FunctionSpaceBase) -> None:
+        """
+        This function adds the action of the lhs matrix for the contact contribution to y, y += A x,
+        without forming the element matrices
+        Args: x - the local form of the vector to apply the matrix to, with up to date ghost values
+              y - the local form of the vector to add to. The ghost contributions have to be
+                  accumulated on the owning processes afterwards
+              function_space - the underlying displacement function space
+        """
+        for i in range(self._num_pairs):
+            super().apply_matrix(
+                x, y, i, self._action_kernel, self.coeffs[i], self._consts, function_space._cpp_object)
+
+    def create_matrix_free_jacobian(self, a_mat: PETSc.Mat,  # type: ignore
+                                    function_space: fem.FunctionSpaceBase) -> PETSc.Mat:  # type: ignore
+        """
+        This function creates a PETSc shell matrix applying the jacobian of the contact problem, i.e.
+        a_mat plus the contact contribution. The contact contribution is applied from the current
+        contact data (see apply_matrix), such that a_mat only needs the sparsity pattern of the
+        bulk problem. The shell matrix can not be factorised, and a_mat or an assembled jacobian
+        should be used to build the preconditioner
+        Args: a_mat - the assembled matrix of the bulk problem
+              function_space - the underlying displacement function space
+        """
+        ctx = MatrixFreeJacobian(self, a_mat, function_space)
+        mat = PETSc.Mat().createPython(a_mat.getSizes(), ctx, comm=a_mat.comm)  # type: ignore
+        mat.setUp()
+        return mat
+
+    def insertion_map(self, i: int, a_mat: PETSc.Mat,  # type: ignore
+                      function_space: fem.FunctionSpaceBase) -> Any:
+        """
+        Return the positions of the contact element matrices of pair i in the values of a_mat.
+        The positions are cached and recomputed if the contact detection or the sparsity pattern
+        of the matrix has changed. Returns None if the matrix has not been assembled yet
+        Args: i - index of contact pair
+              a_mat - the matrix
+              function_space - the underlying displacement function space
+        """
+        mat_id, insertion_map = self._insertion_maps.get(i, (None, None))
+        if mat_id == a_mat.id and super().insertion_map_valid(i, insertion_map, a_mat):
+            return insertion_map
+        if a_mat.getInfo()["assemblies"] == 0:
+            return None
+        insertion_map = super().create_insertion_map(i, a_mat, function_space._cpp_object)
+        self._insertion_maps[i] = (a_mat.id, insertion_map)
+        return insertion_map
 
     def crop_invalid_points(self, tol: float) -> None:
         """
@@ -354,3 +475,36 @@ class ContactProblem(dolfinx_contact.cpp.Contact):
             cstride = self._num_q_points[i] * gdim
             super().crop_invalid_points(i, self.coeffs[i][:, 4:4 + cstride],
                                         self.coeffs[i][:, 4 + cstride:4 + 2 * cstride], tol)
+
+
+class MatrixFreeJacobian:
+    __slots__ = ["_contact_problem", "_a_mat", "_function_space", "_x", "_y"]
+
+    def __init__(self, contact_problem: ContactProblem, a_mat: PETSc.Mat,  # type: ignore
+                 function_space: fem.FunctionSpaceBase):
+        """
+        Context of a PETSc shell matrix applying the jacobian of a contact problem, see
+        ContactProblem.create_matrix_free_jacobian
+        Args: contact_problem - the contact problem
+              a_mat - the assembled matrix of the bulk problem
+              function_space - the underlying displacement function space
+        """
+        self._contact_problem = contact_problem
+        self._a_mat = a_mat
+        self._function_space = function_space
+        index_map = function_space.dofmap.index_map
+        bs = function_space.dofmap.index_map_bs
+        self._x = la.create_petsc_vector(index_map, bs)
+        self._y = la.create_petsc_vector(index_map, bs)
+
+    def mult(self, mat: PETSc.Mat, x: PETSc.Vec, y: PETSc.Vec) -> None:  # type: ignore
+        self._a_mat.mult(x, y)
+
+        # The contact contribution needs the ghost values of x and adds to the ghost entries of y
+        x.copy(self._x)
+        self._x.ghostUpdate(addv=PETSc.InsertMode.INSERT, mode=PETSc.ScatterMode.FORWARD)  # type: ignore
+        with self._x.localForm() as x_local, self._y.localForm() as y_local:
+            y_local.set(0.0)
+            self._contact_problem.apply_matrix(x_local, y_local, self._function_space)
+        self._y.ghostUpdate(addv=PETSc.InsertMode.ADD, mode=PETSc.ScatterMode.REVERSE)  # type: ignore
+        y.axpy(1.0, self._y)
@@ -38,4 +38,58 @@ private:
   dolfinx_contact::kernel_fn<PetscScalar> _kernel;
 };
 
+/// Wrapper of kernels computing element vectors and matrices in one pass,
+/// see `KernelWrapper`
+class SystemKernelWrapper
+{
+public:
+  /// Wrap a Kernel
+  SystemKernelWrapper(dolfinx_contact::system_kernel_fn<PetscScalar> kernel)
+      : _kernel(kernel)
+  {
+  }
+
+  /// Get the C++ kernel
+  dolfinx_contact::system_kernel_fn<PetscScalar> get() { return _kernel; }
+
+private:
+  dolfinx_contact::system_kernel_fn<PetscScalar> _kernel;
+};
+
+/// Wrapper of kernels evaluating several facets at once, see
+/// `KernelWrapper`
+class BatchedKernelWrapper
+{
+public:
+  /// Wrap a Kernel
+  BatchedKernelWrapper(dolfinx_contact::batched_kernel_fn<PetscScalar> kernel)
+      : _kernel(kernel)
+  {
+  }
+
+  /// Get the C++ kernel
+  dolfinx_contact::batched_kernel_fn<PetscScalar> get() { return _kernel; }
+
+private:
+  dolfinx_contact::batched_kernel_fn<PetscScalar> _kernel;
+};
+
+/// Wrapper of kernels applying element matrices to a vector, see
+/// `KernelWrapper`
+class ActionKernelWrapper
+{
+public:
+  /// Wrap a Kernel
+  ActionKernelWrapper(dolfinx_contact::action_kernel_fn<PetscScalar> kernel)
+      : _kernel(kernel)
+  {
+  }
+
+  /// Get the C++ kernel
+  dolfinx_contact::action_kernel_fn<PetscScalar> get() { return _kernel; }
+
+private:
+  dolfinx_contact::action_kernel_fn<PetscScalar> _kernel;
+};
+
 } // namespace contact_wrappers
@@ -7,6 +7,8 @@
 #include "kernelwrapper.h"
 #include <array.h>
 #include <caster_petsc.h>
+#include <dolfinx/la/MatrixCSR.h>
+#include <dolfinx/la/SparsityPattern.h>
 #include <dolfinx/la/petsc.h>
 #include <dolfinx/mesh/MeshTags.h>
 #include <dolfinx_contact/Contact.h>
@@ -25,12 +27,48 @@
 #include <pybind11/operators.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <mutex>
 
 #define STRINGIFY(x) #x
 #define MACRO_STRINGIFY(x) STRINGIFY(x)
 
 namespace py = pybind11;
 
+namespace
+{
+/// Create a function for adding blocks of values to a PETSc matrix. The
+/// contact assemblers may call it from several threads, while PETSc
+/// insertion is not thread-safe, so the calls are serialised.
+std::function<int(const std::span<const std::int32_t>&,
+                  const std::span<const std::int32_t>&,
+                  const std::span<const PetscScalar>&)>
+set_block_fn_serialised(Mat A)
+{
+  return [set_fn = dolfinx::la::petsc::Matrix::set_block_fn(A, ADD_VALUES),
+          mutex = std::make_shared<std::mutex>()](
+             const std::span<const std::int32_t>& rows,
+             const std::span<const std::int32_t>& cols,
+             const std::span<const PetscScalar>& vals) mutable
+  {
+    std::scoped_lock lock(*mutex);
+    return set_fn(rows, cols, vals);
+  };
+}
+
+/// Compute the positions of the data of each row of a 2D coefficient array
+/// when `width` values are written to the columns `[offset, offset+width)`
+std::vector<std::int32_t>
+row_positions(const py::array_t<PetscScalar, py::array::c_style>& c,
+              std::size_t offset, std::size_t width)
+{
+  if (c.ndim() != 2)
+    throw std::invalid_argument("Coefficient array has to be 2D");
+  if (offset + width > (std::size_t)c.shape(1))
+    throw std::invalid_argument("Coefficient array has too few columns");
+  return dolfinx_contact::strided_positions(c.shape(0), c.shape(1), offset);
+}
+} // namespace
+
 PYBIND11_MODULE(cpp, m)
 {
   // Load basix and dolfinx to use Pybindings
@@ -48,6 +86,21 @@ PYBIND11_MODULE(cpp, m)
   py::class_<contact_wrappers::KernelWrapper,
              std::shared_ptr<contact_wrappers::KernelWrapper>>(
       m, "KernelWrapper", "Wrapper for C++ contact integration kernels");
+  py::class_<contact_wrappers::SystemKernelWrapper,
+             std::shared_ptr<contact_wrappers::SystemKernelWrapper>>(
+      m, "SystemKernelWrapper",
+      "Wrapper for C++ contact integration kernels computing the residual and "
+      "the Jacobian in one pass");
+
+  py::class_<contact_wrappers::BatchedKernelWrapper,
+             std::shared_ptr<contact_wrappers::BatchedKernelWrapper>>(
+      m, "BatchedKernelWrapper",
+      "Wrapper for C++ contact integration kernels evaluating several facets "
+      "at once");
+  py::class_<contact_wrappers::ActionKernelWrapper,
+             std::shared_ptr<contact_wrappers::ActionKernelWrapper>>(
+      m, "ActionKernelWrapper",
+      "Wrapper for C++ contact kernels applying the Jacobian to a vector");
 
   py::enum_<dolfinx_contact::ContactMode>(m, "ContactMode")
       .value("ClosestPoint", dolfinx_contact::ContactMode::ClosestPoint)
@@ -101,6 +154,16 @@ PYBIND11_MODULE(cpp, m)
              return dolfinx_wrappers::as_pyarray(std::move(_weights));
            });
 
+  py::class_<dolfinx_contact::CSRInsertionMap,
+             std::shared_ptr<dolfinx_contact::CSRInsertionMap>>(
+      m, "CSRInsertionMap",
+      "Positions of the contact element matrices in the values of a matrix")
+      .def_property_readonly("num_blocks",
+                             &dolfinx_contact::CSRInsertionMap::num_blocks)
+      .def_property_readonly(
+          "num_direct_blocks",
+          &dolfinx_contact::CSRInsertionMap::num_direct_blocks);
+
   // Contact
   py::class_<dolfinx_contact::Contact,
              std::shared_ptr<dolfinx_contact::Contact>>(m, "Contact",
@@ -122,6 +185,7 @@ PYBIND11_MODULE(cpp, m)
              self.create_distance_map(pair);
              return;
            })
+      .def("create_distance_maps", &dolfinx_contact::Contact::create_distance_maps)
       .def("pack_gap_plane",
            [](dolfinx_contact::Contact& self, int origin_meshtag, double g)
            {
@@ -141,10 +205,19 @@ PYBIND11_MODULE(cpp, m)
       .def(
           "create_matrix",
           [](dolfinx_contact::Contact& self, dolfinx::fem::Form<PetscScalar>& a,
-             std::string type) { return self.create_petsc_matrix(a, type); },
+             std::string type, double halo)
+          { return self.create_petsc_matrix(a, type, halo); },
           py::return_value_policy::take_ownership, py::arg("a"),
-          py::arg("type") = std::string(),
+          py::arg("type") = std::string(), py::arg("halo") = -1.0,
           "Create a PETSc Mat for two-sided contact.")
+      .def("create_sparsity_pattern",
+           &dolfinx_contact::Contact::create_sparsity_pattern, py::arg("a"),
+           py::arg("halo") = -1.0,
+           "Create the sparsity pattern of a form and the contact coupling")
+      .def("sparsity_pattern_fits",
+           &dolfinx_contact::Contact::sparsity_pattern_fits,
+           "Check if the current contact coupling fits the sparsity pattern "
+           "of the last matrix created")
       .def("qp_phys",
            [](dolfinx_contact::Contact& self, int origin_meshtag, int facet)
            {
@@ -228,11 +301,100 @@ PYBIND11_MODULE(cpp, m)
            &dolfinx_contact::Contact::set_quadrature_rule)
       .def("set_search_radius",
            &dolfinx_contact::Contact::set_search_radius)
+      .def("set_automatic_search_radius",
+           &dolfinx_contact::Contact::set_automatic_search_radius)
+      .def("automatic_search_radius",
+           &dolfinx_contact::Contact::automatic_search_radius)
+      .def("search_radius", &dolfinx_contact::Contact::search_radius,
+           py::arg("pair"))
+      .def("set_num_threads", &dolfinx_contact::Contact::set_num_threads)
+      .def("num_threads", &dolfinx_contact::Contact::num_threads)
+      .def("set_incremental_search",
+           &dolfinx_contact::Contact::set_incremental_search)
+      .def("incremental_search",
+           &dolfinx_contact::Contact::incremental_search)
       .def("generate_kernel",
            [](dolfinx_contact::Contact& self, dolfinx_contact::Kernel type,
               std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V) {
              return contact_wrappers::KernelWrapper(self.generate_kernel(type, V));
            })
+      .def("generate_system_kernel",
+           [](dolfinx_contact::Contact& self, dolfinx_contact::Kernel type,
+              std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+           {
+             return contact_wrappers::SystemKernelWrapper(
+                 self.generate_system_kernel(type, V));
+           })
+      .def("generate_action_kernel",
+           [](dolfinx_contact::Contact& self, dolfinx_contact::Kernel type,
+              std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+           {
+             return contact_wrappers::ActionKernelWrapper(
+                 self.generate_action_kernel(type, V));
+           })
+      .def("generate_batched_kernel",
+           [](dolfinx_contact::Contact& self, dolfinx_contact::Kernel type,
+              std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+               -> std::optional<contact_wrappers::BatchedKernelWrapper>
+           {
+             dolfinx_contact::batched_kernel_fn<PetscScalar> kernel
+                 = self.generate_batched_kernel(type, V);
+             if (!kernel)
+               return std::nullopt;
+             return contact_wrappers::BatchedKernelWrapper(kernel);
+           }, "Generate a kernel evaluating several facets at once. Returns "
+              "None if there is none for the kernel type and element")
+      .def("assemble_system",
+           [](dolfinx_contact::Contact& self, Mat A,
+              py::array_t<PetscScalar, py::array::c_style>& b,
+              int origin_meshtag, contact_wrappers::SystemKernelWrapper& kernel,
+              const py::array_t<PetscScalar, py::array::c_style>& coeffs,
+              const py::array_t<PetscScalar, py::array::c_style>& constants,
+              std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+           {
+             auto ker = kernel.get();
+             self.assemble_system(
+                 set_block_fn_serialised(A),
+                 std::span(b.mutable_data(), b.size()), origin_meshtag, ker,
+                 std::span(coeffs.data(), coeffs.size()), coeffs.shape(1),
+                 std::span(constants.data(), constants.size()), V);
+           }, "Assemble the residual and the Jacobian in one pass")
+      .def("assemble_system",
+           [](dolfinx_contact::Contact& self, Mat A,
+              py::array_t<PetscScalar, py::array::c_style>& b,
+              int origin_meshtag, contact_wrappers::SystemKernelWrapper& kernel,
+              const py::array_t<PetscScalar, py::array::c_style>& coeffs,
+              const py::array_t<std::int32_t, py::array::c_style>& offsets,
+              const py::array_t<PetscScalar, py::array::c_style>& constants,
+              std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+           {
+             auto ker = kernel.get();
+             self.assemble_system(
+                 set_block_fn_serialised(A),
+                 std::span(b.mutable_data(), b.size()), origin_meshtag, ker,
+                 std::span(coeffs.data(), coeffs.size()),
+                 std::span(offsets.data(), offsets.size()),
+                 std::span(constants.data(), constants.size()), V);
+           }, "Assemble the residual and the Jacobian in one pass with "
+              "coefficients in the ragged layout")
+      .def("assemble_system",
+           [](dolfinx_contact::Contact& self, Mat A,
+              const dolfinx_contact::CSRInsertionMap& insertion_map,
+              py::array_t<PetscScalar, py::array::c_style>& b,
+              int origin_meshtag, contact_wrappers::SystemKernelWrapper& kernel,
+              const py::array_t<PetscScalar, py::array::c_style>& coeffs,
+              const py::array_t<PetscScalar, py::array::c_style>& constants,
+              std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+           {
+             auto ker = kernel.get();
+             self.assemble_system(
+                 A, insertion_map, set_block_fn_serialised(A),
+                 std::span(b.mutable_data(), b.size()), origin_meshtag, ker,
+                 std::span(coeffs.data(), coeffs.size()), coeffs.shape(1),
+                 std::span(constants.data(), constants.size()), V);
+           }, "Assemble the residual and the Jacobian in one pass, adding the "
+              "element matrices directly at the positions given by an "
+              "insertion map")
 
       .def("assemble_matrix",
            [](dolfinx_contact::Contact& self, Mat A,
@@ -243,7 +405,7 @@ PYBIND11_MODULE(cpp, m)
            {
              auto ker = kernel.get();
              self.assemble_matrix(
-                 dolfinx::la::petsc::Matrix::set_block_fn(A, ADD_VALUES),
+                 set_block_fn_serialised(A),
                  origin_meshtag, ker,
                  std::span<const PetscScalar>(coeffs.data(), coeffs.size()),
                  coeffs.shape(1),
@@ -264,6 +426,171 @@ PYBIND11_MODULE(cpp, m)
                  coeffs.shape(1),
                  std::span(constants.data(), constants.size()), V);
            })
+      .def("assemble_matrix",
+           [](dolfinx_contact::Contact& self, Mat A,
+              int origin_meshtag, contact_wrappers::KernelWrapper& kernel,
+              const py::array_t<PetscScalar, py::array::c_style>& coeffs,
+              const py::array_t<std::int32_t, py::array::c_style>& offsets,
+              const py::array_t<PetscScalar, py::array::c_style>& constants,
+              std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+           {
+             auto ker = kernel.get();
+             self.assemble_matrix(
+                 set_block_fn_serialised(A),
+                 origin_meshtag, ker,
+                 std::span<const PetscScalar>(coeffs.data(), coeffs.size()),
+                 std::span(offsets.data(), offsets.size()),
+                 std::span(constants.data(), constants.shape(0)), V);
+           }, "Assemble matrix with coefficients in the ragged layout")
+      .def("assemble_matrix",
+           [](dolfinx_contact::Contact& self, Mat A,
+              int origin_meshtag,
+              contact_wrappers::BatchedKernelWrapper& kernel,
+              const py::array_t<PetscScalar, py::array::c_style>& coeffs,
+              const py::array_t<PetscScalar, py::array::c_style>& constants,
+              std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+           {
+             auto ker = kernel.get();
+             self.assemble_matrix(
+                 set_block_fn_serialised(A),
+                 origin_meshtag, ker,
+                 std::span<const PetscScalar>(coeffs.data(), coeffs.size()),
+                 coeffs.shape(1),
+                 std::span(constants.data(), constants.shape(0)), V);
+           }, "Assemble matrix with a batched kernel")
+      .def("assemble_vector",
+           [](dolfinx_contact::Contact& self,
+              py::array_t<PetscScalar, py::array::c_style>& b,
+              int origin_meshtag,
+              contact_wrappers::BatchedKernelWrapper& kernel,
+              const py::array_t<PetscScalar, py::array::c_style>& coeffs,
+              const py::array_t<PetscScalar, py::array::c_style>& constants,
+              std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+           {
+             auto ker = kernel.get();
+             self.assemble_vector(
+                 std::span(b.mutable_data(), b.size()), origin_meshtag, ker,
+                 std::span(coeffs.data(), coeffs.size()),
+                 coeffs.shape(1),
+                 std::span(constants.data(), constants.size()), V);
+           }, "Assemble vector with a batched kernel")
+      .def("apply_matrix",
+           [](dolfinx_contact::Contact& self,
+              const py::array_t<PetscScalar, py::array::c_style>& x,
+              py::array_t<PetscScalar, py::array::c_style>& y,
+              int origin_meshtag, contact_wrappers::ActionKernelWrapper& kernel,
+              const py::array_t<PetscScalar, py::array::c_style>& coeffs,
+              const py::array_t<PetscScalar, py::array::c_style>& constants,
+              std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+           {
+             auto ker = kernel.get();
+             self.apply_matrix(
+                 std::span(x.data(), x.size()),
+                 std::span(y.mutable_data(), y.size()), origin_meshtag, ker,
+                 std::span<const PetscScalar>(coeffs.data(), coeffs.size()),
+                 coeffs.shape(1),
+                 std::span(constants.data(), constants.size()), V);
+           }, "Apply the contact matrix of a pair to a vector, y += A x")
+      .def("create_insertion_map",
+           [](const dolfinx_contact::Contact& self, int pair, Mat A,
+              std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+           {
+             return std::make_shared<dolfinx_contact::CSRInsertionMap>(
+                 self.create_insertion_map(pair, A, V));
+           },
+           py::arg("pair"), py::arg("A"), py::arg("V"),
+           "Compute the positions of the contact element matrices of a pair "
+           "in the values of an assembled AIJ matrix")
+      .def("create_insertion_map",
+           [](const dolfinx_contact::Contact& self, int pair,
+              const dolfinx::la::MatrixCSR<PetscScalar>& A,
+              std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+           {
+             return std::make_shared<dolfinx_contact::CSRInsertionMap>(
+                 self.create_insertion_map(pair, A, V));
+           },
+           py::arg("pair"), py::arg("A"), py::arg("V"),
+           "Compute the positions of the contact element matrices of a pair "
+           "in the values of a CSR matrix")
+      .def("insertion_map_valid",
+           py::overload_cast<int, const dolfinx_contact::CSRInsertionMap&,
+                             Mat>(
+               &dolfinx_contact::Contact::insertion_map_valid, py::const_),
+           py::arg("pair"), py::arg("insertion_map"), py::arg("A"))
+      .def("insertion_map_valid",
+           py::overload_cast<int, const dolfinx_contact::CSRInsertionMap&,
+                             const dolfinx::la::MatrixCSR<PetscScalar>&>(
+               &dolfinx_contact::Contact::insertion_map_valid, py::const_),
+           py::arg("pair"), py::arg("insertion_map"), py::arg("A"))
+      .def("assemble_matrix",
+           [](dolfinx_contact::Contact& self,
+              dolfinx::la::MatrixCSR<PetscScalar>& A,
+              const dolfinx_contact::CSRInsertionMap& insertion_map,
+              int origin_meshtag, contact_wrappers::KernelWrapper& kernel,
+              const py::array_t<PetscScalar, py::array::c_style>& coeffs,
+              const py::array_t<PetscScalar, py::array::c_style>& constants,
+              std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+           {
+             auto ker = kernel.get();
+             self.assemble_matrix(
+                 A, insertion_map, origin_meshtag, ker,
+                 std::span<const PetscScalar>(coeffs.data(), coeffs.size()),
+                 coeffs.shape(1),
+                 std::span(constants.data(), constants.shape(0)), V);
+           }, "Assemble matrix, adding the element matrices directly to the "
+              "values of a CSR matrix at the positions given by an insertion "
+              "map")
+      .def("assemble_matrix",
+           [](dolfinx_contact::Contact& self, Mat A,
+              const dolfinx_contact::CSRInsertionMap& insertion_map,
+              int origin_meshtag, contact_wrappers::KernelWrapper& kernel,
+              const py::array_t<PetscScalar, py::array::c_style>& coeffs,
+              const py::array_t<PetscScalar, py::array::c_style>& constants,
+              std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+           {
+             auto ker = kernel.get();
+             self.assemble_matrix(
+                 A, insertion_map, set_block_fn_serialised(A),
+                 origin_meshtag, ker,
+                 std::span<const PetscScalar>(coeffs.data(), coeffs.size()),
+                 coeffs.shape(1),
+                 std::span(constants.data(), constants.shape(0)), V);
+           }, "Assemble matrix, adding the element matrices directly at the "
+              "positions given by an insertion map")
+      .def("assemble_matrix",
+           [](dolfinx_contact::Contact& self, Mat A,
+              const dolfinx_contact::CSRInsertionMap& insertion_map,
+              int origin_meshtag,
+              contact_wrappers::BatchedKernelWrapper& kernel,
+              const py::array_t<PetscScalar, py::array::c_style>& coeffs,
+              const py::array_t<PetscScalar, py::array::c_style>& constants,
+              std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+           {
+             auto ker = kernel.get();
+             self.assemble_matrix(
+                 A, insertion_map, set_block_fn_serialised(A),
+                 origin_meshtag, ker,
+                 std::span<const PetscScalar>(coeffs.data(), coeffs.size()),
+                 coeffs.shape(1),
+                 std::span(constants.data(), constants.shape(0)), V);
+           }, "Assemble matrix with a batched kernel, adding the element "
+              "matrices directly at the positions given by an insertion map")
+      .def("assemble_vector",
+           [](dolfinx_contact::Contact& self,
+              py::array_t<PetscScalar, py::array::c_style>& b,
+              int origin_meshtag, contact_wrappers::KernelWrapper& kernel,
+              const py::array_t<PetscScalar, py::array::c_style>& coeffs,
+              const py::array_t<std::int32_t, py::array::c_style>& offsets,
+              const py::array_t<PetscScalar, py::array::c_style>& constants,
+              std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+           {
+             auto ker = kernel.get();
+             self.assemble_vector(
+                 std::span(b.mutable_data(), b.size()), origin_meshtag, ker,
+                 std::span(coeffs.data(), coeffs.size()),
+                 std::span(offsets.data(), offsets.size()),
+                 std::span(constants.data(), constants.size()), V);
+           }, "Assemble vector with coefficients in the ragged layout")
       .def("pack_test_functions",
            [](dolfinx_contact::Contact& self, int origin_meshtag,
               std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
@@ -284,6 +611,26 @@ PYBIND11_MODULE(cpp, m)
             return dolfinx_wrappers::as_pyarray(std::move(coeffs),
                                                 std::array{shape0, cstride});
           })
+      .def("pack_test_functions_ragged",
+           [](dolfinx_contact::Contact& self, int origin_meshtag,
+              std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+           {
+             auto [coeffs, offsets]
+                 = self.pack_test_functions_ragged(origin_meshtag, V);
+             return py::make_tuple(
+                 dolfinx_wrappers::as_pyarray(std::move(coeffs)),
+                 dolfinx_wrappers::as_pyarray(std::move(offsets)));
+           })
+      .def("pack_grad_test_functions_ragged",
+           [](dolfinx_contact::Contact& self, int origin_meshtag,
+              std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V)
+           {
+             auto [coeffs, offsets]
+                 = self.pack_grad_test_functions_ragged(origin_meshtag, V);
+             return py::make_tuple(
+                 dolfinx_wrappers::as_pyarray(std::move(coeffs)),
+                 dolfinx_wrappers::as_pyarray(std::move(offsets)));
+           })
       .def("pack_ny",
            [](dolfinx_contact::Contact& self, int origin_meshtag)
            {
@@ -292,6 +639,22 @@ PYBIND11_MODULE(cpp, m)
              return dolfinx_wrappers::as_pyarray(std::move(coeffs),
                                                  std::array{shape0, cstride});
            })
+      .def(
+          "pack_contact_data",
+          [](dolfinx_contact::Contact& self, int origin_meshtag,
+             std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+             py::array_t<PetscScalar, py::array::c_style>& c, int offset)
+          {
+            if (c.ndim() != 2)
+              throw std::invalid_argument("Coefficient array has to be 2D");
+            self.pack_contact_data(
+                origin_meshtag, V, std::span(c.mutable_data(), c.size()),
+                c.shape(1), offset);
+          },
+          py::arg("pair"), py::arg("V"), py::arg("c").noconvert(),
+          py::arg("offset"),
+          "Pack gap, normals and test functions into the columns "
+          "c[:, offset:] of the kernel coefficients in a single pass")
       .def("pack_nx",
            [](dolfinx_contact::Contact& self, int origin_meshtag)
            {
@@ -312,6 +675,22 @@ PYBIND11_MODULE(cpp, m)
                                                 std::array{shape0, cstride});
           },
           py::arg("origin_meshtag"), py::arg("u"))
+      .def(
+          "pack_u_contact",
+          [](dolfinx_contact::Contact& self, int origin_meshtag,
+             std::shared_ptr<dolfinx::fem::Function<PetscScalar>> u,
+             py::array_t<PetscScalar, py::array::c_style>& c, int offset)
+          {
+            const std::size_t width
+                = self.num_q_points() * u->function_space()->element()->block_size();
+            std::vector<std::int32_t> positions = row_positions(c, offset, width);
+            self.pack_u_contact(origin_meshtag, u,
+                                std::span(c.mutable_data(), c.size()),
+                                positions);
+          },
+          py::arg("origin_meshtag"), py::arg("u"), py::arg("c").noconvert(),
+          py::arg("offset"),
+          "Pack u on the opposite surface into the columns c[:, offset:]")
       .def(
           "pack_grad_u_contact",
           [](dolfinx_contact::Contact& self, int origin_meshtag,
@@ -323,6 +702,25 @@ PYBIND11_MODULE(cpp, m)
             return dolfinx_wrappers::as_pyarray(std::move(coeffs),
                                                 std::array{shape0, cstride});
           })
+      .def(
+          "pack_grad_u_contact",
+          [](dolfinx_contact::Contact& self, int origin_meshtag,
+             std::shared_ptr<dolfinx::fem::Function<PetscScalar>> u,
+             py::array_t<PetscScalar, py::array::c_style>& c, int offset)
+          {
+            std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V
+                = u->function_space();
+            const std::size_t width = self.num_q_points()
+                                      * V->element()->block_size()
+                                      * V->mesh()->geometry().dim();
+            std::vector<std::int32_t> positions = row_positions(c, offset, width);
+            self.pack_grad_u_contact(origin_meshtag, u,
+                                     std::span(c.mutable_data(), c.size()),
+                                     positions);
+          },
+          py::arg("origin_meshtag"), py::arg("u"), py::arg("c").noconvert(),
+          py::arg("offset"),
+          "Pack grad(u) on the opposite surface into the columns c[:, offset:]")
       .def("update_submesh_geometry",
            &dolfinx_contact::Contact::update_submesh_geometry)
       .def("crop_invalid_points",
@@ -331,7 +729,8 @@ PYBIND11_MODULE(cpp, m)
             return self.crop_invalid_points(pair, std::span(gap.data(), gap.size()),
             std::span(n_y.data(), n_y.size()), tol);
            })
-      .def("max_links", [] (dolfinx_contact::Contact& self) {return self.max_links();});
+      .def("max_links", [] (dolfinx_contact::Contact& self) {return self.max_links();})
+      .def("num_q_points", &dolfinx_contact::Contact::num_q_points);
   m.def(
       "generate_rigid_surface_kernel",
       [](std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
@@ -351,6 +750,9 @@ PYBIND11_MODULE(cpp, m)
       .value("TrescaJac", dolfinx_contact::Kernel::TrescaJac)
       .value("CoulombRhs", dolfinx_contact::Kernel::CoulombRhs)
       .value("CoulombJac", dolfinx_contact::Kernel::CoulombJac)
+      .value("System", dolfinx_contact::Kernel::System)
+      .value("TrescaSystem", dolfinx_contact::Kernel::TrescaSystem)
+      .value("CoulombSystem", dolfinx_contact::Kernel::CoulombSystem)
       .value("MeshTieRhs", dolfinx_contact::Kernel::MeshTieRhs)
       .value("MeshTieJac", dolfinx_contact::Kernel::MeshTieJac)
       .value("ThermoElasticRhs", dolfinx_contact::Kernel::ThermoElasticRhs);
@@ -368,16 +770,21 @@ PYBIND11_MODULE(cpp, m)
                     const int>(),
            py::arg("markers"), py::arg("surfaces"), py::arg("contact_pairs"),
            py::arg("mesh"), py::arg("quadrature_degree") = 3)
+      .def("set_num_threads", &dolfinx_contact::MeshTie::set_num_threads)
+      .def("num_threads", &dolfinx_contact::MeshTie::num_threads)
+      .def("set_batched_kernels",
+           &dolfinx_contact::MeshTie::set_batched_kernels)
+      .def("batched_kernels", &dolfinx_contact::MeshTie::batched_kernels)
       .def(
           "coeffs",
           [](dolfinx_contact::MeshTie& self, int pair)
           {
-            auto [coeffs, cstride] = self.coeffs(pair);
-            std::array<std::size_t, 2> shape_out
-                = {coeffs.size() / cstride, cstride};
-            return dolfinx_wrappers::as_pyarray(std::move(coeffs), shape_out);
+            auto [coeffs, offsets] = self.coeffs(pair);
+            return py::make_tuple(
+                dolfinx_wrappers::as_pyarray(std::move(coeffs)),
+                dolfinx_wrappers::as_pyarray(std::move(offsets)));
           },
-          "Get packed coefficients")
+          "Get packed coefficients and the offsets of each facet")
       .def("generate_kernel_data",
            &dolfinx_contact::MeshTie::generate_kernel_data,
            py::arg("problem_type"), py::arg("functionspace"), py::arg("coefficients"),
@@ -393,8 +800,7 @@ PYBIND11_MODULE(cpp, m)
               std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
               dolfinx_contact::Problem problemtype)
            {
-             self.assemble_matrix(
-                 dolfinx::la::petsc::Matrix::set_block_fn(A, ADD_VALUES), V, problemtype);
+             self.assemble_matrix(set_block_fn_serialised(A), V, problemtype);
            })
       .def("assemble_vector",
            [](dolfinx_contact::MeshTie& self,
@@ -469,6 +875,76 @@ PYBIND11_MODULE(cpp, m)
           }
         });
 
+  py::class_<dolfinx_contact::QuadraturePacker,
+             std::shared_ptr<dolfinx_contact::QuadraturePacker>>(
+      m, "QuadraturePacker",
+      "Pack coefficients at the quadrature points of a fixed set of entities")
+      .def(py::init(
+               [](std::shared_ptr<const dolfinx::fem::FunctionSpace<double>> V,
+                  int q,
+                  const py::array_t<std::int32_t, py::array::c_style>& entities,
+                  bool gradient)
+               {
+                 auto e_span = std::span<const std::int32_t>(entities.data(),
+                                                             entities.size());
+                 dolfinx::fem::IntegralType integral;
+                 if (entities.ndim() == 1)
+                   integral = dolfinx::fem::IntegralType::cell;
+                 else if (entities.ndim() == 2)
+                   integral = dolfinx::fem::IntegralType::exterior_facet;
+                 else
+                   throw std::invalid_argument("Unsupported entities");
+                 return std::make_shared<dolfinx_contact::QuadraturePacker>(
+                     V, q, e_span, integral, gradient);
+               }),
+           py::arg("V"), py::arg("q"), py::arg("entities"),
+           py::arg("gradient") = false)
+      .def("pack",
+           [](const dolfinx_contact::QuadraturePacker& self,
+              const dolfinx::fem::Function<PetscScalar>& coeff)
+           {
+             auto [coeffs, cstride] = self.pack(coeff);
+             int shape0 = (int)self.num_entities();
+             return dolfinx_wrappers::as_pyarray(std::move(coeffs),
+                                                 std::array{shape0, cstride});
+           })
+      .def("pack_gradient",
+           [](const dolfinx_contact::QuadraturePacker& self,
+              const dolfinx::fem::Function<PetscScalar>& coeff)
+           {
+             auto [coeffs, cstride] = self.pack_gradient(coeff);
+             int shape0 = (int)self.num_entities();
+             return dolfinx_wrappers::as_pyarray(std::move(coeffs),
+                                                 std::array{shape0, cstride});
+           })
+      .def(
+          "pack",
+          [](const dolfinx_contact::QuadraturePacker& self,
+             const dolfinx::fem::Function<PetscScalar>& coeff,
+             py::array_t<PetscScalar, py::array::c_style>& c, int offset)
+          {
+            std::vector<std::int32_t> positions
+                = row_positions(c, offset, self.value_stride());
+            self.pack(coeff, std::span(c.mutable_data(), c.size()), positions);
+          },
+          py::arg("coeff"), py::arg("c").noconvert(), py::arg("offset"),
+          "Pack the coefficient into the columns c[:, offset:]")
+      .def(
+          "pack_gradient",
+          [](const dolfinx_contact::QuadraturePacker& self,
+             const dolfinx::fem::Function<PetscScalar>& coeff,
+             py::array_t<PetscScalar, py::array::c_style>& c, int offset)
+          {
+            std::vector<std::int32_t> positions
+                = row_positions(c, offset, self.gradient_stride());
+            self.pack_gradient(coeff, std::span(c.mutable_data(), c.size()),
+                               positions);
+          },
+          py::arg("coeff"), py::arg("c").noconvert(), py::arg("offset"),
+          "Pack the gradient of the coefficient into the columns c[:, offset:]")
+      .def_property_readonly("function_space",
+                             &dolfinx_contact::QuadraturePacker::function_space);
+
   m.def(
       "pack_circumradius",
       [](const dolfinx::mesh::Mesh<double>& mesh,
@@ -532,12 +1008,22 @@ PYBIND11_MODULE(cpp, m)
       py::arg("mesh"), py::arg("quadrature_facets"),
       py::arg("candidate_facets"), py::arg("radius") = -1.0);
 
-  m.def("point_cloud_pairs",
-        [](py::array_t<double, py::array::c_style>& points, double r)
-        {
-          std::span<const double> point_span(points.data(), points.size());
-          return dolfinx_contact::point_cloud_pairs(point_span, r);
-        });
+  py::enum_<dolfinx_contact::PointCloudSearch>(m, "PointCloudSearch")
+      .value("Sweep", dolfinx_contact::PointCloudSearch::Sweep)
+      .value("Grid", dolfinx_contact::PointCloudSearch::Grid);
+
+  m.def(
+      "point_cloud_pairs",
+      [](py::array_t<double, py::array::c_style>& points, double r,
+         dolfinx_contact::PointCloudSearch method, int num_threads)
+      {
+        std::span<const double> point_span(points.data(), points.size());
+        return dolfinx_contact::point_cloud_pairs(point_span, r, method,
+                                                  num_threads);
+      },
+      py::arg("points"), py::arg("r"),
+      py::arg("method") = dolfinx_contact::PointCloudSearch::Grid,
+      py::arg("num_threads") = 1);
 
   m.def(
       "compute_ghost_cell_destinations",
@@ -604,6 +1090,30 @@ PYBIND11_MODULE(cpp, m)
               num_q_points, num_facets, gdim, mu, lmbda);
         });
 
+  m.def(
+      "closest_point_linear_facets",
+      [](const py::array_t<double, py::array::c_style>& facet_x,
+         const py::array_t<double, py::array::c_style>& points)
+      {
+        if (facet_x.ndim() != 3 or facet_x.shape(2) != 3 or points.ndim() != 2
+            or points.shape(1) != 3 or facet_x.shape(0) != points.shape(0))
+        {
+          throw std::invalid_argument(
+              "Expected facets of shape (num_points, num_vertices, 3) and "
+              "points of shape (num_points, 3)");
+        }
+        std::vector<double> closest(points.size());
+        dolfinx_contact::closest_point_linear_facets(
+            std::span<const double>(facet_x.data(), facet_x.size()),
+            facet_x.shape(1),
+            std::span<const double>(points.data(), points.size()), closest);
+        std::array<std::size_t, 2> shape = {std::size_t(points.shape(0)), 3};
+        return dolfinx_wrappers::as_pyarray(std::move(closest), shape);
+      },
+      py::arg("facet_x"), py::arg("points"),
+      "Compute the closest point on the linear facet associated with each "
+      "point");
+
   m.def("entities_to_geometry_dofs",
         [](const dolfinx::mesh::Mesh<double>& mesh, int dim,
           py::array_t<std::int32_t, py::array::c_style>&  entity_list)
@@ -136,6 +136,59 @@ def test_pack_coeff_on_facet(quadrature_degree, space, degree):
                                    expr_vals[i, gdim * cstride * local_index:gdim * cstride * (local_index + 1)])
 
 
+@pytest.mark.parametrize("quadrature_degree", range(1, 4))
+@pytest.mark.parametrize("degree", range(1, 4))
+@pytest.mark.parametrize("space", ["Lagrange", "N1curl"])
+def test_quadrature_packer(quadrature_degree, space, degree):
+    N = 10
+    mesh = create_unit_square(MPI.COMM_WORLD, N, N)
+    if space == "Lagrange":
+        V = VectorFunctionSpace(mesh, (space, degree))
+    else:
+        V = FunctionSpace(mesh, (space, degree))
+    gradient = space == "Lagrange"
+
+    facets = locate_entities_boundary(mesh, mesh.topology.dim - 1,
+                                      lambda x: np.logical_or(np.isclose(x[0], 0.0),
+                                                              np.isclose(x[0], 1.0)))
+    integration_entities, num_local = dolfinx_contact.compute_active_entities(mesh._cpp_object, facets,
+                                                                              IntegralType.exterior_facet)
+    integration_entities = integration_entities[:num_local]
+    packer = dolfinx_contact.cpp.QuadraturePacker(V._cpp_object, quadrature_degree, integration_entities,
+                                                  gradient=gradient)
+
+    # Reference values at the quadrature points of each facet using Expression
+    tdim = mesh.topology.dim
+    q_rule = dolfinx_contact.QuadratureRule(mesh.topology.cell_types[0], quadrature_degree, tdim - 1,
+                                            basix.QuadratureType.Default)
+    q_points = q_rule.points()
+    num_points = q_rule.points(0).shape[0]
+    cells = integration_entities[:, 0]
+    local_facets = integration_entities[:, 1]
+
+    def facet_values(expr_vals, stride):
+        return np.array([expr_vals[i, stride * f:stride * (f + 1)] for i, f in enumerate(local_facets)])
+
+    # The packer is reused for several functions in the same space
+    v = Function(V)
+    for f in [lambda x: (x[1], -x[0]), lambda x: (x[0]**2, x[0] * x[1])]:
+        v.interpolate(f)
+        coeffs = facet_values(Expression(v, q_points).eval(mesh, cells), num_points * 2)
+        assert np.allclose(packer.pack(v._cpp_object), coeffs)
+
+        # Pack in place into the columns of a larger array
+        c = np.full((coeffs.shape[0], coeffs.shape[1] + 3), -1.0)
+        packer.pack(v._cpp_object, c, 2)
+        assert np.allclose(c[:, 2:-1], coeffs)
+        assert np.allclose(c[:, :2], -1.0) and np.allclose(c[:, -1], -1.0)
+        if gradient:
+            coeffs = facet_values(Expression(grad(v), q_points).eval(mesh, cells), num_points * 4)
+            assert np.allclose(packer.pack_gradient(v._cpp_object), coeffs)
+            c = np.zeros((coeffs.shape[0], coeffs.shape[1] + 1))
+            packer.pack_gradient(v._cpp_object, c, 1)
+            assert np.allclose(c[:, 1:], coeffs)
+
+
 @pytest.mark.parametrize("quadrature_degree", range(1, 5))
 @pytest.mark.parametrize("degree", range(1, 5))
 def test_sub_coeff(quadrature_degree, degree):
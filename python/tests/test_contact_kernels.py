@@ -33,7 +33,8 @@ def R_minus(x):
 @pytest.mark.parametrize("dim", [2, 3])
 @pytest.mark.parametrize("P", [1, 2, 3, 4])
 @pytest.mark.parametrize("Q", [0, 1, 2])
-def test_vector_surface_kernel(dim, kernel_type, P, Q):
+@pytest.mark.parametrize("num_threads", [1, 3])
+def test_vector_surface_kernel(dim, kernel_type, P, Q, num_threads):
     N = 20 if dim == 2 else 5
     mesh = create_unit_square(MPI.COMM_WORLD, N, N) if dim == 2 else create_unit_cube(MPI.COMM_WORLD, N, N, N)
 
@@ -153,6 +154,7 @@ def test_vector_surface_kernel(dim, kernel_type, P, Q):
     kernel = dolfinx_contact.cpp.generate_rigid_surface_kernel(V._cpp_object, kernel_type, q_rule)
 
     b2.zeroEntries()
+    contact.set_num_threads(num_threads)
     contact.assemble_vector(b2, 0, kernel, coeffs, consts, V._cpp_object)
     assemble_vector(b2, L_custom)
     b2.assemble()
@@ -163,7 +165,8 @@ def test_vector_surface_kernel(dim, kernel_type, P, Q):
 @pytest.mark.parametrize("dim", [2, 3])
 @pytest.mark.parametrize("P", [1, 2, 3, 4])
 @pytest.mark.parametrize("Q", [0, 1, 2])
-def test_matrix_surface_kernel(dim, kernel_type, P, Q):
+@pytest.mark.parametrize("num_threads", [1, 3])
+def test_matrix_surface_kernel(dim, kernel_type, P, Q, num_threads):
     N = 20 if dim == 2 else 5
     mesh = create_unit_square(MPI.COMM_WORLD, N, N) if dim == 2 else create_unit_cube(MPI.COMM_WORLD, N, N, N)
 
@@ -283,6 +286,7 @@ def test_matrix_surface_kernel(dim, kernel_type, P, Q):
         V._cpp_object, kernel_type, q_rule)
     B.zeroEntries()
 
+    contact.set_num_threads(num_threads)
     contact.assemble_matrix(B, 0, kernel, coeffs, consts, V._cpp_object)
     assemble_matrix(B, a_custom)
     B.assemble()
@@ -283,3 +283,65 @@ def test_packing(ct, gap, q_deg, delta, surface, disp):
             compare_test_fn(V, test_fn[f], grad_test_fn[f], q_indices, link, x_ref, cell)
             compare_u(V, u, u_packed[f], grad_u[f], q_indices, x_ref, cell)
             assert_zero_test_fn(V, test_fn[f], grad_test_fn[f], num_q_points, zero_ind, link, cell)
+
+    # The ragged layout only stores the (gradients of) test functions of the
+    # cells linked to each facet
+    test_fn_r, test_offsets = contact.pack_test_functions_ragged(0, V._cpp_object)
+    grad_test_fn_r, grad_offsets = contact.pack_grad_test_functions_ragged(0, V._cpp_object)
+    assert len(test_offsets) == len(s_facets) + 1
+    for f in range(len(s_facets)):
+        n = test_offsets[f + 1] - test_offsets[f]
+        assert np.allclose(test_fn_r[test_offsets[f]:test_offsets[f + 1]], test_fn[f][:n])
+        assert np.allclose(test_fn[f][n:], 0)
+        n = grad_offsets[f + 1] - grad_offsets[f]
+        assert np.allclose(grad_test_fn_r[grad_offsets[f]:grad_offsets[f + 1]], grad_test_fn[f][:n])
+        assert np.allclose(grad_test_fn[f][n:], 0)
+
+    # The fused packing writes gap, normals and test functions into the
+    # kernel coefficient layout in a single pass
+    normals = contact.pack_ny(0)
+    offset = 3
+    c = np.full((gap.shape[0], offset + gap.shape[1] + normals.shape[1] + test_fn.shape[1] + 2), -1.0)
+    contact.pack_contact_data(0, V._cpp_object, c, offset)
+    offset1 = offset + gap.shape[1]
+    offset2 = offset1 + normals.shape[1]
+    assert np.allclose(c[:, offset:offset1], gap)
+    assert np.allclose(c[:, offset1:offset2], normals)
+    assert np.allclose(c[:, offset2:offset2 + test_fn.shape[1]], test_fn)
+    assert np.allclose(c[:, :offset], -1.0)
+    assert np.allclose(c[:, offset2 + test_fn.shape[1]:], -1.0)
+
+    # With ray-tracing, the fused packing uses the negative outward normal of
+    # the quadrature facet instead of the normal of the opposite surface
+    rt_contact = dolfinx_contact.cpp.Contact([facet_marker._cpp_object], surfaces, [(s, o)], mesh._cpp_object,
+                                             [dolfinx_contact.cpp.ContactMode.Raytracing], quadrature_degree=q_deg)
+    if disp:
+        rt_contact.update_submesh_geometry(u._cpp_object)
+    rt_contact.create_distance_map(0)
+    rt_gap = rt_contact.pack_gap(0)
+    rt_test_fn = rt_contact.pack_test_functions(0, V._cpp_object)
+    rt_normals = -rt_contact.pack_nx(0)
+    c = np.full((rt_gap.shape[0], offset + rt_gap.shape[1] + rt_normals.shape[1] + rt_test_fn.shape[1]), -1.0)
+    rt_contact.pack_contact_data(0, V._cpp_object, c, offset)
+    assert np.allclose(c[:, offset:offset1], rt_gap)
+    assert np.allclose(c[:, offset1:offset2], rt_normals)
+    assert np.allclose(c[:, offset2:], rt_test_fn)
+    assert np.allclose(c[:, :offset], -1.0)
+
+    # Pack u and grad(u) on the opposite surface in place
+    c = np.full((u_packed.shape[0], u_packed.shape[1] + grad_u.shape[1] + 1), -1.0)
+    contact.pack_u_contact(0, u._cpp_object, c, 1)
+    contact.pack_grad_u_contact(0, u._cpp_object, c, 1 + u_packed.shape[1])
+    assert np.allclose(c[:, 0], -1.0)
+    assert np.allclose(c[:, 1:1 + u_packed.shape[1]], u_packed)
+    assert np.allclose(c[:, 1 + u_packed.shape[1]:], grad_u)
+
+    # A search tree built before the geometry update is refitted, and gives
+    # the same closest points as a tree built on the updated geometry
+    if disp:
+        contact = dolfinx_contact.cpp.Contact([facet_marker._cpp_object], surfaces, [
+                                              (s, o)], mesh._cpp_object, search_mode, quadrature_degree=q_deg)
+        contact.create_distance_map(0)
+        contact.update_submesh_geometry(u._cpp_object)
+        contact.create_distance_map(0)
+        assert np.allclose(contact.pack_gap(0), gap)
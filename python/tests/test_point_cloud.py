@@ -0,0 +1,30 @@
+# Copyright (C) 2024 The DOLFINx_Contact authors
+#
+# SPDX-License-Identifier:    MIT
+#
+# This test checks that the near neighbour search in a point cloud gives the same result as a
+# brute force search for all search methods
+
+import dolfinx_contact.cpp
+import numpy as np
+import pytest
+
+
+@pytest.mark.parametrize("method", [dolfinx_contact.cpp.PointCloudSearch.Sweep,
+                                    dolfinx_contact.cpp.PointCloudSearch.Grid])
+@pytest.mark.parametrize("planar", [True, False])
+@pytest.mark.parametrize("num_threads", [1, 4])
+def test_point_cloud_pairs(method, planar, num_threads):
+    rng = np.random.default_rng(2)
+    points = rng.random((200, 3))
+    if planar:
+        # All points in a plane normal to the x-axis
+        points[:, 0] = 0.3
+    r = 0.15
+    pairs = dolfinx_contact.cpp.point_cloud_pairs(points, r, method, num_threads)
+
+    for i, x in enumerate(points):
+        dist = np.linalg.norm(points - x, axis=1)
+        exact = np.flatnonzero(dist < r)
+        exact = exact[exact != i]
+        assert np.all(pairs.links(i) == exact)
@@ -9,6 +9,7 @@
 
 import numpy as np
 import pytest
+import dolfinx.geometry
 from dolfinx.graph import adjacencylist
 from dolfinx.io import XDMFFile
 from dolfinx.mesh import meshtags, locate_entities_boundary
@@ -110,3 +111,23 @@ def test_projection(q_deg, surf, dim):
     # Test if angle between -normal and gap function is less than 6.5 degrees
     # Is better accuracy needed?
     assert np.allclose(n_dot, np.ones(n_dot.shape))
+
+
+@pytest.mark.parametrize("num_vertices", [2, 3])
+def test_closest_point_linear_facets(num_vertices):
+    rng = np.random.default_rng(3)
+    num_points = 50
+    facet_x = rng.random((num_points, num_vertices, 3))
+    points = 2 * rng.random((num_points, 3)) - 0.5
+
+    # Degenerate facets: coinciding vertices, collinear vertices and slivers
+    facet_x[0, 1] = facet_x[0, 0]
+    facet_x[1, :] = facet_x[1, 0]
+    facet_x[2, -1] = 0.3 * facet_x[2, 0] + 0.7 * facet_x[2, 1]
+    facet_x[3, -1] = 0.5 * (facet_x[3, 0] + facet_x[3, 1]) + 1e-9 * rng.random(3)
+
+    closest = dolfinx_contact.cpp.closest_point_linear_facets(facet_x, points)
+    assert np.all(np.isfinite(closest))
+    for i in range(num_points):
+        distance = dolfinx.geometry.compute_distance_gjk(facet_x[i], points[i])
+        assert np.allclose(closest[i], points[i] + distance)
@@ -5,13 +5,44 @@
 # This test check that the ray-tracing routines give the same result as the closest point projection
 # when a solution is found (It is not guaranteed that a ray hits the mesh on all processes in parallel)
 
+import os
+
+import basix
 import dolfinx_contact
+from dolfinx_contact.meshing import convert_mesh, create_box_mesh_3D
 from mpi4py import MPI
 import dolfinx
 import numpy as np
 import pytest
 import ufl
 
+os.system("mkdir -p meshes")
+
+
+def create_box_surfaces(name, res):
+    """
+    Create the two boxes of create_box_mesh_3D, meshed with resolution res and stored in meshes/name, and
+    mark the surfaces facing each other (see test_projection.py) with 1 and 2
+    Returns the mesh, the facet markers and the surfaces for a contact pair between the two markers
+    """
+    fname = f"meshes/{name}"
+    create_box_mesh_3D(filename=f"{fname}.msh", res=res, offset=0.0)
+    convert_mesh(fname, fname, gdim=3)
+    with dolfinx.io.XDMFFile(MPI.COMM_WORLD, f"{fname}.xdmf", "r") as xdmf:
+        mesh = xdmf.read_mesh()
+    tdim = mesh.topology.dim
+    mesh.topology.create_connectivity(tdim - 1, 0)
+    mesh.topology.create_connectivity(tdim - 1, tdim)
+
+    facets_0 = dolfinx.mesh.locate_entities_boundary(mesh, tdim - 1, lambda x: np.isclose(x[2], 0))
+    facets_1 = dolfinx.mesh.locate_entities_boundary(mesh, tdim - 1, lambda x: np.isclose(x[2], -0.1))
+    indices = np.concatenate([facets_0, facets_1])
+    values = np.hstack([np.full(len(facets_0), 1, dtype=np.int32), np.full(len(facets_1), 2, dtype=np.int32)])
+    sorted_ind = np.argsort(indices)
+    facet_marker = dolfinx.mesh.meshtags(mesh, tdim - 1, indices[sorted_ind], values[sorted_ind])
+    surfaces = dolfinx.graph.adjacencylist(np.array([1, 2], dtype=np.int32), np.array([0, 2], dtype=np.int32))
+    return mesh, facet_marker, surfaces
+
 
 @pytest.mark.parametrize("cell_type", [dolfinx.mesh.CellType.hexahedron, dolfinx.mesh.CellType.tetrahedron])
 def test_raytracing_3D(cell_type):
@@ -178,3 +209,216 @@ def test_raytracing_manifold(cell_type):
     integral_pairs = integral_pairs[:num_local]
     status, cell_idx, x, X = dolfinx_contact.cpp.raytracing(mesh._cpp_object, origin, normal, integral_pairs, 10, 1e-6)
     assert np.allclose(x, exact_point)
+
+
+@pytest.mark.parametrize("cell_type", [dolfinx.mesh.CellType.triangle, dolfinx.mesh.CellType.tetrahedron])
+def test_raytracing_affine_newton(cell_type):
+    """The closed form intersection with affine cells agrees with Newton's method, which is used
+    for the same cells described by a quadratic geometry"""
+    rng = np.random.default_rng(7)
+    tdim = 2 if cell_type == dolfinx.mesh.CellType.triangle else 3
+    vertices = rng.random((tdim + 1, tdim))
+
+    # Nodes of the quadratic geometry at the (straight) edge midpoints, in
+    # the ordering of the edges of the reference cell
+    basix_cell = basix.cell.string_to_type(cell_type.name)
+    edges = basix.topology(basix_cell)[1]
+    nodes = np.vstack([vertices] + [0.5 * (vertices[e[0]] + vertices[e[1]]) for e in edges])
+
+    meshes = []
+    for degree, x in zip([1, 2], [vertices, nodes]):
+        domain = ufl.Mesh(ufl.VectorElement("Lagrange", cell_type.name, degree))
+        cells = np.arange(x.shape[0], dtype=np.int32).reshape(1, -1)
+        meshes.append(dolfinx.mesh.create_mesh(MPI.COMM_SELF, cells, x, domain))
+
+    for facet, facet_vertices in enumerate(basix.topology(basix_cell)[tdim - 1]):
+        integral_pairs = np.array([[0, facet]], dtype=np.int32)
+        for _ in range(10):
+            # Aim at a random point in the plane of the facet, which may be
+            # outside the facet
+            weights = rng.random(tdim) * 1.4 - 0.2
+            weights[0] = 1 - np.sum(weights[1:])
+            target = weights @ vertices[facet_vertices]
+            direction = rng.random(tdim) - 0.5
+            direction /= np.linalg.norm(direction)
+            origin = target - 0.3 * direction
+
+            affine = dolfinx_contact.cpp.raytracing(meshes[0]._cpp_object, origin, direction, integral_pairs, 25,
+                                                    1e-10)
+            newton = dolfinx_contact.cpp.raytracing(meshes[1]._cpp_object, origin, direction, integral_pairs, 25,
+                                                    1e-10)
+            inside = np.all(weights > 1e-6)
+            outside = np.any(weights < -1e-6)
+            if inside:
+                assert affine[0] > 0 and newton[0] > 0
+            elif outside:
+                assert affine[0] < 0 and newton[0] < 0
+            if affine[0] > 0 and newton[0] > 0:
+                assert np.allclose(affine[2], target)
+                assert np.allclose(newton[2], target)
+                assert np.allclose(affine[3], newton[3])
+
+
+@pytest.mark.parametrize("radius", [-1.0, 0.5])
+@pytest.mark.parametrize("num_threads", [2, 3])
+def test_raytracing_threads(radius, num_threads):
+    mesh, facet_marker, surfaces = create_box_surfaces("box_3D_threads", 1.0)
+    search_mode = [dolfinx_contact.cpp.ContactMode.Raytracing, dolfinx_contact.cpp.ContactMode.Raytracing]
+
+    # Ray-tracing in serial and with several threads should give identical results
+    gaps = []
+    maps = []
+    for threads in [1, num_threads]:
+        contact = dolfinx_contact.cpp.Contact([facet_marker._cpp_object], surfaces, [(0, 1), (1, 0)],
+                                              mesh._cpp_object, search_mode, quadrature_degree=3)
+        contact.set_search_radius(radius)
+        contact.set_num_threads(threads)
+        assert contact.num_threads() == threads
+        contact.create_distance_map(0)
+        maps.append(contact.facet_map(0).array)
+        gaps.append(contact.pack_gap(0))
+    assert np.all(maps[0] == maps[1])
+    assert np.allclose(gaps[0], gaps[1])
+
+
+@pytest.mark.parametrize("automatic_radius", [False, True])
+@pytest.mark.parametrize("num_threads", [2, 3])
+def test_concurrent_pairs(num_threads, automatic_radius):
+    # With the automatic search radius both pairs estimate their radius, which needs communication. Run with
+    # several processes (mpirun -np 2 python3 -m pytest test_raytracing.py -k concurrent_pairs) to check that the
+    # pairs processed concurrently communicate in the same order on all processes
+    mesh, facet_marker, surfaces = create_box_surfaces("box_3D_pairs", 1.0)
+    search_mode = [dolfinx_contact.cpp.ContactMode.Raytracing, dolfinx_contact.cpp.ContactMode.ClosestPoint]
+    if automatic_radius:
+        search_mode[1] = dolfinx_contact.cpp.ContactMode.Raytracing
+
+    # Processing the pairs one by one in serial and concurrently should give identical results. With the
+    # automatic search radius, the first search is unbounded and the second uses the estimated radius
+    gaps = []
+    maps = []
+    radii = []
+    for threads in [1, num_threads]:
+        contact = dolfinx_contact.cpp.Contact([facet_marker._cpp_object], surfaces, [(0, 1), (1, 0)],
+                                              mesh._cpp_object, search_mode, quadrature_degree=3)
+        contact.set_num_threads(threads)
+        contact.set_automatic_search_radius(automatic_radius)
+        for _ in range(2 if automatic_radius else 1):
+            if threads == 1:
+                for pair in range(2):
+                    contact.create_distance_map(pair)
+            else:
+                contact.create_distance_maps()
+        maps.append([contact.facet_map(pair).array for pair in range(2)])
+        gaps.append([contact.pack_gap(pair) for pair in range(2)])
+        radii.append([contact.search_radius(pair) for pair in range(2)])
+    for pair in range(2):
+        assert np.all(maps[0][pair] == maps[1][pair])
+        assert np.allclose(gaps[0][pair], gaps[1][pair])
+        assert np.isclose(radii[0][pair], radii[1][pair])
+
+
+@pytest.mark.parametrize("mode", [dolfinx_contact.cpp.ContactMode.Raytracing,
+                                  dolfinx_contact.cpp.ContactMode.ClosestPoint])
+def test_incremental_search(mode):
+    mesh, facet_marker, surfaces = create_box_surfaces("box_3D_incremental", 1.0)
+
+    contact = dolfinx_contact.cpp.Contact([facet_marker._cpp_object], surfaces, [(0, 1), (1, 0)],
+                                          mesh._cpp_object, [mode, mode], quadrature_degree=3)
+    contact.create_distance_map(0)
+    gap = contact.pack_gap(0)
+
+    # Seeding the search with the previous facet map should not change the result
+    contact.set_incremental_search(True)
+    assert contact.incremental_search()
+    contact.create_distance_map(0)
+    assert np.allclose(contact.pack_gap(0), gap)
+
+
+def test_automatic_search_radius():
+    mesh, facet_marker, surfaces = create_box_surfaces("box_3D_radius", 1.0)
+    search_mode = [dolfinx_contact.cpp.ContactMode.Raytracing, dolfinx_contact.cpp.ContactMode.Raytracing]
+
+    contact = dolfinx_contact.cpp.Contact([facet_marker._cpp_object], surfaces, [(0, 1), (1, 0)],
+                                          mesh._cpp_object, search_mode, quadrature_degree=3)
+    contact.create_distance_map(0)
+    gap = contact.pack_gap(0)
+    facet_map = contact.facet_map(0).array
+
+    # The first search is unbounded, the following are restricted to the
+    # estimated radius and should find the same contact points
+    contact.set_automatic_search_radius(True)
+    assert contact.automatic_search_radius()
+    contact.create_distance_map(0)
+    assert contact.search_radius(0) < 0
+    contact.create_distance_map(0)
+    if np.any(facet_map >= 0):
+        assert contact.search_radius(0) > 0
+    assert np.all(contact.facet_map(0).array == facet_map)
+    assert np.allclose(contact.pack_gap(0), gap)
+
+    # A rigid translation of the mesh leaves the gaps unchanged, and the
+    # estimated radius, which is linear in the gap and the displacement,
+    # grows by the safety factor times twice the translation. The
+    # translation is large enough for the length of the rays to exceed 1
+    radius = contact.search_radius(0)
+    assert radius > 0
+    d = 0.6
+    V = dolfinx.fem.VectorFunctionSpace(mesh, ("Lagrange", 1))
+    u = dolfinx.fem.Function(V)
+    u.interpolate(lambda x: np.vstack([np.zeros_like(x[0]), np.zeros_like(x[0]), np.full_like(x[0], d)]))
+    contact.update_submesh_geometry(u._cpp_object)
+    contact.create_distance_map(0)
+    assert np.isclose(contact.search_radius(0), radius + 1.5 * 2 * d)
+    assert np.all(contact.facet_map(0).array == facet_map)
+    assert np.allclose(contact.pack_gap(0), gap)
+
+    # The displacement is accounted for by the search, and the next estimate
+    # is based on the gaps only
+    contact.create_distance_map(0)
+    assert np.isclose(contact.search_radius(0), radius)
+
+    # Setting the radius explicitly disables the estimate
+    contact.set_search_radius(-1.0)
+    assert not contact.automatic_search_radius()
+
+
+def test_sparsity_pattern_halo():
+    mesh, facet_marker, surfaces = create_box_surfaces("box_3D_halo", 0.25)
+    search_mode = [dolfinx_contact.cpp.ContactMode.Raytracing, dolfinx_contact.cpp.ContactMode.Raytracing]
+    contact = dolfinx_contact.cpp.Contact([facet_marker._cpp_object], surfaces, [(0, 1), (1, 0)],
+                                          mesh._cpp_object, search_mode, quadrature_degree=3)
+    for pair in range(2):
+        contact.create_distance_map(pair)
+
+    V = dolfinx.fem.VectorFunctionSpace(mesh, ("Lagrange", 1))
+    a = dolfinx.fem.form(ufl.inner(ufl.TrialFunction(V), ufl.TestFunction(V)) * ufl.dx)
+    halo = 0.15
+    A = contact.create_matrix(a._cpp_object, halo=halo)
+    assert contact.sparsity_pattern_fits()
+
+    # Slide the upper box along the contact surfaces and redo the contact detection
+    def slide(s):
+        u = dolfinx.fem.Function(V)
+        u.interpolate(lambda x: np.vstack([np.where(x[2] > -0.05, s, 0.0), np.zeros_like(x[0]),
+                                           np.zeros_like(x[0])]))
+        contact.update_submesh_geometry(u._cpp_object)
+        for pair in range(2):
+            contact.create_distance_map(pair)
+
+    # The new partners are at a distance of at most sqrt(0.1**2 + s**2) < halo from the quadrature points the
+    # pattern was created for
+    slide(0.05)
+    assert contact.sparsity_pattern_fits()
+
+    # The new partners on the finely meshed upper surface are further than the halo from the points on the lower
+    # surface. The contact detection is local to each process, so there may be no partners in parallel
+    slide(0.3)
+    found = np.any(contact.facet_map(1).array >= 0)
+    if mesh.comm.allreduce(found, op=MPI.LOR):
+        assert not contact.sparsity_pattern_fits()
+
+    # A new matrix with the same halo fits the current contact coupling
+    A.destroy()
+    A = contact.create_matrix(a._cpp_object, halo=halo)
+    assert contact.sparsity_pattern_fits()
+    A.destroy()
@@ -23,12 +23,14 @@ from basix.ufl import element
 from dolfinx.cpp.mesh import to_type
 import dolfinx.fem as _fem
 from dolfinx.graph import adjacencylist
+from dolfinx.la import BlockMode, matrix_csr
 from dolfinx.mesh import (CellType, locate_entities_boundary, locate_entities, create_mesh,
-                          compute_midpoints, meshtags)
+                          compute_midpoints, meshtags, create_unit_square, create_unit_cube)
 from mpi4py import MPI
+from petsc4py import PETSc
 
 from dolfinx_contact.general_contact.contact_problem import ContactProblem, FrictionLaw
-from dolfinx_contact.cpp import (ContactMode, MeshTie, Problem, Kernel)
+from dolfinx_contact.cpp import (Contact, ContactMode, MeshTie, Problem, Kernel)
 from dolfinx_contact.helpers import (R_minus, dR_minus, R_plus, dR_plus, epsilon,
                                      lame_parameters, sigma_func, tangential_proj,
                                      ball_projection, d_ball_projection,
@@ -353,6 +355,81 @@ def create_facet_markers(mesh, facets_cg):
     return meshtags(mesh, tdim - 1, indices[sorted_facets], values[sorted_facets])
 
 
+def create_contact_problem(ct, gap, frictionlaw, search=ContactMode.ClosestPoint, quadrature_degree=1, theta=1):
+    '''This function creates the contact problem for the custom assembly of the two elements
+       in create_meshes, and the forms of the bulk problem used to create its vector and matrix'''
+    E = 1e3
+    nu = 0.1
+    gamma = 10
+    mu_func, lambda_func = lame_parameters(False)
+    mu = mu_func(E, nu)
+    lmbda = lambda_func(E, nu)
+    sigma = sigma_func(mu, lmbda)
+
+    _, mesh = create_meshes(ct, gap)
+    gdim = mesh.geometry.dim
+    tdim = mesh.topology.dim
+    V = _fem.functionspace(mesh, ("Lagrange", 1, (gdim,)))
+    cells, facets_cg = locate_contact_facets_custom(V, gap)
+
+    def _u0(x):
+        values = np.zeros((gdim, x.shape[1]))
+        for i in range(tdim):
+            values[i] = np.sin(x[i]) + 1
+        return values
+
+    def _u2(x):
+        values = np.zeros((gdim, x.shape[1]))
+        for i in range(tdim):
+            values[i] = np.sin(x[i] + gap) + 2 if i == tdim - 1 else np.sin(x[i]) + 2
+        return values
+
+    u = _fem.Function(V)
+    du = _fem.Function(V)
+    du.interpolate(_u0, cells[0])
+    du.interpolate(_u2, cells[1])
+    du.x.scatter_forward()
+    v = ufl.TestFunction(V)
+    w = ufl.TrialFunction(V)
+    dx = ufl.Measure("dx", domain=mesh)
+    F = _fem.form(ufl.inner(sigma(du), epsilon(v)) * dx)
+    J = _fem.form(ufl.inner(sigma(w), epsilon(v)) * dx)
+
+    V0 = _fem.functionspace(mesh, ("DG", 0))
+    mu0 = _fem.Function(V0)
+    lmbda0 = _fem.Function(V0)
+    fric = _fem.Function(V0)
+    mu0.interpolate(lambda x: np.full((1, x.shape[1]), mu))
+    lmbda0.interpolate(lambda x: np.full((1, x.shape[1]), lmbda))
+    fric.interpolate(lambda x: np.full((1, x.shape[1]), 0.1))
+
+    facet_marker = create_facet_markers(mesh, facets_cg)
+    surfaces = adjacencylist(np.array([0, 1], dtype=np.int32), np.array([0, 2], dtype=np.int32))
+    contact_problem = ContactProblem([facet_marker], surfaces, [(0, 1), (1, 0)],
+                                     mesh, quadrature_degree, [search, search])
+    contact_problem.generate_contact_data(frictionlaw, V, {"u": u, "du": du, "mu": mu0,
+                                                           "lambda": lmbda0, "fric": fric},
+                                          E * gamma, theta)
+    return contact_problem, V, F, J
+
+
+def to_dense(A):
+    ai, aj, av = A.getValuesCSR()
+    return scipy.sparse.csr_matrix((av, aj, ai), shape=A.getSize()).todense()
+
+
+def assemble_contact(contact_problem, V, F, J):
+    '''Assemble the contact contributions to a vector and a matrix with the default assembly'''
+    b = _fem.petsc.create_vector(F)
+    b.zeroEntries()
+    contact_problem.assemble_vector(b, V)
+    A = contact_problem.create_matrix(J)
+    A.zeroEntries()
+    contact_problem.assemble_matrix(A, V)
+    A.assemble()
+    return b, A
+
+
 @pytest.mark.parametrize("ct", ["triangle", "quadrilateral", "tetrahedron", "hexahedron"])
 @pytest.mark.parametrize("gap", [0.5, -0.5])
 @pytest.mark.parametrize("quadrature_degree", [1, 5])
@@ -547,6 +624,159 @@ def test_contact_kernels(ct, gap, quadrature_degree, theta, frictionlaw, search)
         assert np.allclose(C_sp[ind_dg, :][:, ind_dg], B_sp)
 
 
+@pytest.mark.parametrize("ct", ["triangle", "quadrilateral", "tetrahedron", "hexahedron"])
+@pytest.mark.parametrize("frictionlaw", [FrictionLaw.Frictionless, FrictionLaw.Coulomb, FrictionLaw.Tresca])
+def test_direct_insertion(ct, frictionlaw):
+    contact_problem, V, F, J = create_contact_problem(ct, 0.5, frictionlaw)
+    _, A = assemble_contact(contact_problem, V, F, J)
+
+    # Reassemble jacobian, adding the element matrices directly to the values of the matrix
+    contact_problem.direct_insertion = True
+    A_direct = A.duplicate()
+    A_direct.zeroEntries()
+    contact_problem.assemble_matrix(A_direct, V)
+    A_direct.assemble()
+    A_direct.zeroEntries()
+    contact_problem.assemble_matrix(A_direct, V)
+    A_direct.assemble()
+    assert contact_problem.insertion_map(0, A_direct, V) is not None
+    assert np.allclose(to_dense(A_direct), to_dense(A))
+
+
+@pytest.mark.skipif(MPI.COMM_WORLD.size > 1,
+                    reason="This test should only be run in serial.")
+@pytest.mark.parametrize("ct", ["triangle", "tetrahedron"])
+def test_insertion_map_valid(ct):
+    contact_problem, V, F, J = create_contact_problem(ct, 0.5, FrictionLaw.Frictionless)
+    _, A = assemble_contact(contact_problem, V, F, J)
+    for i in range(2):
+        insertion_map = contact_problem.insertion_map(i, A, V)
+        assert insertion_map.num_direct_blocks == insertion_map.num_blocks
+
+    # A map is rejected for a copy of the matrix and for a matrix with the same number of values
+    # but a different pattern
+    ai, aj, av = A.getValuesCSR()
+    row = next(r for r in range(len(ai) - 1) if ai[r + 1] - ai[r] < A.getSize()[1])
+    cols = aj[ai[row]:ai[row + 1]]
+    cols[0] = np.setdiff1d(np.arange(A.getSize()[1]), cols)[0]
+    aj[ai[row]:ai[row + 1]] = np.sort(cols)
+    A_moved = PETSc.Mat().createAIJ(A.getSize(), csr=(ai, aj, av), comm=MPI.COMM_SELF)
+    A_moved.assemble()
+    A_copy = A.copy()
+    insertion_map = contact_problem.insertion_map(0, A, V)
+    assert contact_problem.insertion_map_valid(0, insertion_map, A)
+    assert not contact_problem.insertion_map_valid(0, insertion_map, A_copy)
+    assert not contact_problem.insertion_map_valid(0, insertion_map, A_moved)
+    with pytest.raises(ValueError):
+        Contact.assemble_matrix(contact_problem, A_moved, insertion_map, 0, contact_problem._matrix_kernels[0],
+                                contact_problem.coeffs[0], contact_problem._consts, V._cpp_object)
+
+
+@pytest.mark.parametrize("ct", ["triangle", "quadrilateral", "tetrahedron", "hexahedron"])
+@pytest.mark.parametrize("gap", [0.5, -0.5])
+def test_halo_matrix(ct, gap):
+    contact_problem, V, F, J = create_contact_problem(ct, gap, FrictionLaw.Frictionless)
+    _, A = assemble_contact(contact_problem, V, F, J)
+
+    # A matrix with a halo around the contact coupling holds the same values
+    assert contact_problem.sparsity_pattern_fits()
+    A_halo = contact_problem.create_matrix(J, halo=2 * abs(gap))
+    assert contact_problem.sparsity_pattern_fits()
+    A_halo.zeroEntries()
+    contact_problem.assemble_matrix(A_halo, V)
+    A_halo.assemble()
+    assert np.allclose(to_dense(A_halo), to_dense(A))
+
+
+@pytest.mark.parametrize("ct", ["triangle", "quadrilateral", "tetrahedron", "hexahedron"])
+@pytest.mark.parametrize("frictionlaw", [FrictionLaw.Frictionless, FrictionLaw.Coulomb, FrictionLaw.Tresca])
+@pytest.mark.parametrize("direct_insertion", [False, True])
+def test_assemble_system(ct, frictionlaw, direct_insertion):
+    contact_problem, V, F, J = create_contact_problem(ct, 0.5, frictionlaw)
+    b, A = assemble_contact(contact_problem, V, F, J)
+
+    # Assembling residual and jacobian in one pass gives the same values. With direct insertion,
+    # the second assembly adds the element matrices directly to the values of the matrix
+    contact_problem.direct_insertion = direct_insertion
+    A_sys = contact_problem.create_matrix(J)
+    b_sys = b.duplicate()
+    for _ in range(2):
+        A_sys.zeroEntries()
+        b_sys.zeroEntries()
+        contact_problem.assemble_system(A_sys, b_sys, V)
+        A_sys.assemble()
+        assert np.allclose(b_sys.array, b.array)
+        assert np.allclose(to_dense(A_sys), to_dense(A))
+    assert (contact_problem.insertion_map(0, A_sys, V) is not None) == direct_insertion
+
+
+@pytest.mark.parametrize("ct", ["triangle", "quadrilateral", "tetrahedron", "hexahedron"])
+@pytest.mark.parametrize("frictionlaw", [FrictionLaw.Frictionless, FrictionLaw.Coulomb, FrictionLaw.Tresca])
+def test_ragged_system(ct, frictionlaw):
+    contact_problem, V, F, J = create_contact_problem(ct, 0.5, frictionlaw)
+    b, A = assemble_contact(contact_problem, V, F, J)
+
+    # The ragged coefficient layout gives the same system
+    A_sys = contact_problem.create_matrix(J)
+    A_sys.zeroEntries()
+    b_sys = b.duplicate()
+    b_sys.zeroEntries()
+    for i in range(2):
+        coeffs = contact_problem.coeffs[i]
+        offsets = np.arange(coeffs.shape[0] + 1, dtype=np.int32) * coeffs.shape[1]
+        Contact.assemble_system(contact_problem, A_sys, b_sys.array, i, contact_problem._system_kernel,
+                                coeffs.reshape(-1), offsets, contact_problem._consts, V._cpp_object)
+    A_sys.assemble()
+    assert np.allclose(b_sys.array, b.array)
+    assert np.allclose(to_dense(A_sys), to_dense(A))
+
+
+@pytest.mark.parametrize("ct", ["triangle", "tetrahedron"])
+@pytest.mark.parametrize("frictionlaw", [FrictionLaw.Frictionless, FrictionLaw.Coulomb, FrictionLaw.Tresca])
+def test_matrix_free_shell(ct, frictionlaw):
+    contact_problem, V, F, J = create_contact_problem(ct, 0.5, frictionlaw)
+    _, A = assemble_contact(contact_problem, V, F, J)
+
+    # The matrix-free jacobian applies the contact contribution on top of the given matrix
+    A_free = contact_problem.create_matrix_free_jacobian(A, V)
+    x = A.createVecRight()
+    x.setArray(np.random.default_rng(1).random(x.getLocalSize()))
+    y_free = A.createVecLeft()
+    A_free.mult(x, y_free)
+    y = A.createVecLeft()
+    A.mult(x, y)
+    assert np.allclose(y_free.array, 2 * y.array)
+
+
+@pytest.mark.skipif(MPI.COMM_WORLD.size > 1,
+                    reason="This test should only be run in serial.")
+@pytest.mark.parametrize("ct", ["triangle", "tetrahedron"])
+@pytest.mark.parametrize("block_mode", [BlockMode.compact, BlockMode.expanded])
+def test_insertion_map_csr(ct, block_mode):
+    contact_problem, V, F, J = create_contact_problem(ct, 0.5, FrictionLaw.Frictionless)
+    _, A = assemble_contact(contact_problem, V, F, J)
+
+    # Adding the element matrices directly to the values of a CSR matrix gives the AIJ matrix
+    A_csr = matrix_csr(contact_problem.create_sparsity_pattern(J), block_mode=block_mode)
+    for i in range(2):
+        insertion_map = Contact.create_insertion_map(contact_problem, i, A_csr._cpp_object, V._cpp_object)
+        assert insertion_map.num_direct_blocks == insertion_map.num_blocks
+        assert Contact.insertion_map_valid(contact_problem, i, insertion_map, A_csr._cpp_object)
+        Contact.assemble_matrix(contact_problem, A_csr._cpp_object, insertion_map, i,
+                                contact_problem._matrix_kernels[0], contact_problem.coeffs[i],
+                                contact_problem._consts, V._cpp_object)
+    A_csr.scatter_reverse()
+    assert np.allclose(A_csr.to_dense(), to_dense(A))
+
+    # A map is rejected for another matrix and by assemble_matrix
+    A_other = matrix_csr(contact_problem.create_sparsity_pattern(J), block_mode=block_mode)
+    assert not Contact.insertion_map_valid(contact_problem, 1, insertion_map, A_other._cpp_object)
+    with pytest.raises(ValueError):
+        Contact.assemble_matrix(contact_problem, A_other._cpp_object, insertion_map, 1,
+                                contact_problem._matrix_kernels[0], contact_problem.coeffs[1],
+                                contact_problem._consts, V._cpp_object)
+
+
 def poisson_dg(u0, v0, h, n, kdt, gamma, theta, dS):
     F = gamma / h('+') * ufl.inner(ufl.jump(u0), ufl.jump(v0)) * dS + \
         gamma / h('-') * ufl.inner(ufl.jump(u0), ufl.jump(v0)) * dS -\
@@ -582,7 +812,8 @@ def tied_dg_T(u0, v0, T0, h, n, gamma, theta, sigma, sigma_T, dS):
 @pytest.mark.parametrize("quadrature_degree", [1, 5])
 @pytest.mark.parametrize("theta", [1, 0, -1])
 @pytest.mark.parametrize("problem", [Problem.Poisson, Problem.Elasticity, Problem.ThermoElasticity])
-def test_meshtie_kernels(ct, gap, quadrature_degree, theta, problem):
+@pytest.mark.parametrize("num_threads", [1, 3])
+def test_meshtie_kernels(ct, gap, quadrature_degree, theta, problem, num_threads):
 
     # Problem parameters
     kdt = 5
@@ -740,6 +971,8 @@ def test_meshtie_kernels(ct, gap, quadrature_degree, theta, problem):
     # initialise meshties
     meshties = MeshTie([facet_marker._cpp_object], surfaces, [(0, 1), (1, 0)],
                        mesh_custom._cpp_object, quadrature_degree=quadrature_degree)
+    meshties.set_num_threads(num_threads)
+    assert meshties.num_threads() == num_threads
     meshties.generate_kernel_data(problem, V_custom._cpp_object, coeffs, gamma, theta)
 
     # Generate residual data structures
@@ -773,3 +1006,157 @@ def test_meshtie_kernels(ct, gap, quadrature_degree, theta, problem):
     B_sp = scipy.sparse.csr_matrix((bv, bj, bi), shape=A1.getSize()).todense()
 
     assert np.allclose(A_sp[:, ind_dg][ind_dg, :], B_sp)
+
+
+def create_opposite_surfaces(ct, degree):
+    '''This function creates a unit square/cube with contact surfaces on opposite sides and
+       the coefficients of a contact problem on it. The normal jump of the displacement du
+       closes the gap on parts of the surfaces only, and it has a tangential jump
+       Returns: the function space, the facet markers, the surfaces, the coefficients and
+                Young's modulus'''
+    if ct == "triangle":
+        mesh = create_unit_square(MPI.COMM_WORLD, 6, 6)
+    else:
+        mesh = create_unit_cube(MPI.COMM_WORLD, 3, 3, 3)
+    tdim = mesh.topology.dim
+    gdim = mesh.geometry.dim
+    V = _fem.functionspace(mesh, ("Lagrange", degree, (gdim,)))
+
+    facets_0 = locate_entities_boundary(mesh, tdim - 1, lambda x: np.isclose(x[0], 0))
+    facets_1 = locate_entities_boundary(mesh, tdim - 1, lambda x: np.isclose(x[0], 1))
+    facet_marker = create_facet_markers(mesh, [facets_0, facets_1])
+    surfaces = adjacencylist(np.array([0, 1], dtype=np.int32), np.array([0, 2], dtype=np.int32))
+
+    def _u(x):
+        values = np.zeros((gdim, x.shape[1]))
+        values[0] = 3 * np.sin(6 * x[1]) * (x[0] - 0.5)
+        values[1] = 0.1 * x[0]
+        return values
+    u = _fem.Function(V)
+    u.interpolate(_u)
+
+    E = 1e3
+    nu = 0.1
+    mu_func, lambda_func = lame_parameters(False)
+    V0 = _fem.functionspace(mesh, ("DG", 0))
+    mu0 = _fem.Function(V0)
+    mu0.x.array[:] = mu_func(E, nu)
+    lmbda0 = _fem.Function(V0)
+    lmbda0.x.array[:] = lambda_func(E, nu)
+    fric = _fem.Function(V0)
+    fric.x.array[:] = 0.1
+    coefficients = {"u": _fem.Function(V), "du": u, "mu": mu0, "lambda": lmbda0, "fric": fric}
+    return V, facet_marker, surfaces, coefficients, E
+
+
+@pytest.mark.parametrize("ct", ["triangle", "tetrahedron"])
+@pytest.mark.parametrize("degree", [1, 2])
+@pytest.mark.parametrize("num_threads", [1, 3])
+def test_batched_kernels(ct, degree, num_threads):
+    # The kernels evaluating several facets at once have to agree with the kernels evaluating
+    # one facet at a time, both for the contact and the meshtie problem
+    V, facet_marker, surfaces, coefficients, E = create_opposite_surfaces(ct, degree)
+    mesh = V.mesh
+    u = coefficients["du"]
+    gamma = 10 * E
+    theta = 1
+
+    # Dummy forms for creating vector/matrix
+    v = ufl.TestFunction(V)
+    w = ufl.TrialFunction(V)
+    dx = ufl.Measure("dx", domain=mesh)
+    F = _fem.form(ufl.inner(u, v) * dx)
+    J = _fem.form(ufl.inner(ufl.grad(w), ufl.grad(v)) * dx)
+
+    def csr_values(A):
+        A.assemble()
+        _, _, av = A.getValuesCSR()
+        return av.copy()
+
+    # Contact
+    quadrature_degree = 2 * degree + 1
+    search = [ContactMode.ClosestPoint, ContactMode.ClosestPoint]
+    contact_problem = ContactProblem([facet_marker], surfaces, [(0, 1), (1, 0)], mesh,
+                                     quadrature_degree, search)
+    contact_problem.set_num_threads(num_threads)
+    A = contact_problem.create_matrix(J)
+    b = _fem.petsc.create_vector(F)
+    results = []
+    for batched in [True, False]:
+        contact_problem.generate_contact_data(FrictionLaw.Frictionless, V, coefficients, gamma, theta,
+                                              batched=batched)
+        assert all((kernel is not None) == batched for kernel in contact_problem._batched_kernels)
+        b.zeroEntries()
+        contact_problem.assemble_vector(b, V)
+        A.zeroEntries()
+        contact_problem.assemble_matrix(A, V)
+        A_values = csr_values(A)
+        contact_problem.direct_insertion = True
+        A.zeroEntries()
+        contact_problem.assemble_matrix(A, V)
+        assert np.allclose(csr_values(A), A_values)
+        contact_problem.direct_insertion = False
+        results.append((b.array.copy(), A_values))
+    assert not np.allclose(results[1][0], 0)
+    assert np.allclose(results[0][0], results[1][0])
+    assert np.allclose(results[0][1], results[1][1])
+
+    # Meshtie
+    meshties = MeshTie([facet_marker._cpp_object], surfaces, [(0, 1), (1, 0)],
+                       mesh._cpp_object, quadrature_degree=quadrature_degree)
+    meshties.set_num_threads(num_threads)
+    coeffs = {"u": u._cpp_object, "mu": coefficients["mu"]._cpp_object,
+              "lambda": coefficients["lambda"]._cpp_object}
+    meshties.generate_kernel_data(Problem.Elasticity, V._cpp_object, coeffs, gamma, theta)
+    A = meshties.create_matrix(J._cpp_object)
+    results = []
+    for batched in [True, False]:
+        meshties.set_batched_kernels(batched)
+        assert meshties.batched_kernels() == batched
+        A.zeroEntries()
+        meshties.assemble_matrix(A, V._cpp_object, Problem.Elasticity)
+        results.append(csr_values(A))
+    assert np.allclose(results[0], results[1])
+
+
+@pytest.mark.parametrize("ct", ["triangle", "tetrahedron"])
+@pytest.mark.parametrize("frictionlaw", [FrictionLaw.Frictionless, FrictionLaw.Coulomb, FrictionLaw.Tresca])
+@pytest.mark.parametrize("num_threads", [1, 3])
+def test_matrix_free_jacobian(ct, frictionlaw, num_threads):
+    # The matrix-free jacobian has to agree with the assembled jacobian. Run with several
+    # processes (mpirun -np 2 python3 -m pytest test_unbiased.py -k matrix_free) to check the
+    # ghost updates of the matrix-free product
+    V, facet_marker, surfaces, coefficients, E = create_opposite_surfaces(ct, 1)
+    mesh = V.mesh
+    contact_problem = ContactProblem([facet_marker], surfaces, [(0, 1), (1, 0)], mesh, 3,
+                                     [ContactMode.ClosestPoint, ContactMode.ClosestPoint])
+    contact_problem.set_num_threads(num_threads)
+    contact_problem.generate_contact_data(frictionlaw, V, coefficients, 10 * E, 1)
+
+    # Bulk matrix, and bulk matrix plus the assembled contact jacobian
+    v = ufl.TestFunction(V)
+    w = ufl.TrialFunction(V)
+    J = _fem.form(ufl.inner(ufl.grad(w), ufl.grad(v)) * ufl.dx)
+    A_bulk = contact_problem.create_matrix(J)
+    A_bulk.zeroEntries()
+    _fem.petsc.assemble_matrix(A_bulk, J)
+    A_bulk.assemble()
+    A = contact_problem.create_matrix(J)
+    A.zeroEntries()
+    _fem.petsc.assemble_matrix(A, J)
+    contact_problem.assemble_matrix(A, V)
+    A.assemble()
+
+    A_free = contact_problem.create_matrix_free_jacobian(A_bulk, V)
+    x = A.createVecRight()
+    x.setArray(np.random.default_rng(mesh.comm.rank).random(x.getLocalSize()))
+    y_free = A.createVecLeft()
+    A_free.mult(x, y_free)
+    y = A.createVecLeft()
+    A.mult(x, y)
+    y_bulk = A.createVecLeft()
+    A_bulk.mult(x, y_bulk)
+    y_bulk.axpy(-1.0, y)
+    assert y_bulk.norm() > 1e-6 * y.norm()
+    y_free.axpy(-1.0, y)
+    assert y_free.norm() < 1e-10 * y.norm()